@@ -0,0 +1,60 @@
+/**
+ * @file commWatchdog.c
+ * @author Tsugumi Murata (tmurata293)
+ * @date 15 Mar 2021
+ * @brief library for master communication watchdog 
+ *
+ * Counted in system timer ticks rather than main loop passes, so the
+ * failsafe latency does not depend on how long the main loop sleeps.
+ * Starts tripped, the motors stay stopped until master sends a valid frame.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>  
+#include <util/atomic.h>
+#include "commWatchdog.h"
+
+static volatile uint16_t comm_idle_ms          = AVR_DRIVER_COMM_TIMEOUT_MS;
+static volatile uint8_t  comm_tripped          = 1;
+static volatile uint8_t  comm_trip_pending     = 0;
+static comm_watchdog_callback_t comm_timeout_callback = NULL;
+
+// function
+void setupCommWatchdogConfig(comm_watchdog_callback_t timeout_callback){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        comm_timeout_callback = timeout_callback;
+        comm_idle_ms      = AVR_DRIVER_COMM_TIMEOUT_MS;
+        comm_tripped      = 1;
+        comm_trip_pending = 0;
+    }
+}
+
+void feedCommWatchdog(){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        comm_idle_ms = 0;
+        comm_tripped = 0;
+    }
+}
+
+uint8_t isCommWatchdogTripped(){
+    return comm_tripped;
+}
+
+uint8_t takeCommWatchdogTrip(){
+    uint8_t trip;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        trip = comm_trip_pending;
+        comm_trip_pending = 0;
+    }
+    return trip;
+}
+
+void updateCommWatchdog(){
+    if (comm_tripped) return;
+
+    if (++comm_idle_ms >= AVR_DRIVER_COMM_TIMEOUT_MS){
+        comm_tripped      = 1;
+        comm_trip_pending = 1;
+        if (comm_timeout_callback) comm_timeout_callback();
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * @file commWatchdog.h
+ * @author Tsugumi Murata (tmurata293)
+ * @date 15 Mar 2021
+ * @brief library for master communication watchdog 
+ *
+ */
+
+#ifndef _COMMWATCHDOG_H_
+#define _COMMWATCHDOG_H_
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif 
+
+#include <stdio.h>
+#include <stdint.h>
+#include "../../include/avr_driver_common.h"
+
+typedef void (*comm_watchdog_callback_t)(void);
+
+// timeout_callback runs inside the timer interrupt once per trip, keep it short 
+void setupCommWatchdogConfig(comm_watchdog_callback_t timeout_callback);
+// call on every valid frame from master 
+void feedCommWatchdog(); 
+uint8_t isCommWatchdogTripped(); 
+// returns 1 once after each trip, for reporting 
+uint8_t takeCommWatchdogTrip(); 
+
+// run at 1kHz from the system timer interrupt, trips AVR_DRIVER_COMM_TIMEOUT_MS
+// after the last feed, +1ms for the tick phase 
+void updateCommWatchdog(); 
+
+
+#ifdef __cplusplus  
+}
+#endif 
+
+#endif
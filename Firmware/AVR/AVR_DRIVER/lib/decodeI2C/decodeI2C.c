@@ -13,3 +13,10 @@
 uint8_t checkDataHeader(char byteData, data_frame_header_E frameNumber){
     return ( ((byteData & DATA_VALIDITY_MASK)  >> 6) == frameNumber);
 }
+
+// signed 12 bit speed setpoint split over the third and fourth byte 
+int16_t decodeSpeedSetpoint(char thirdByte, char fourthByte){
+    int16_t setpoint = ((int16_t)(thirdByte & SPEED_SETPOINT_REQ_MASK) << 6) | (fourthByte & SPEED_SETPOINT_REQ_MASK);
+    if (setpoint & _BV(11)) setpoint -= _BV(12);
+    return setpoint;
+}
@@ -20,6 +20,7 @@ extern "C"{
 #include "../../include/avr_driver_common.h"
 
 uint8_t checkDataHeader(char byteData, data_frame_header_E data_frame_header); 
+int16_t decodeSpeedSetpoint(char thirdByte, char fourthByte); 
 
 #ifdef __cplusplus  
 }
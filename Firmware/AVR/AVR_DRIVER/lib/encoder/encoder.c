@@ -9,13 +9,33 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>  
+#include <util/atomic.h>
 #include "encoder.h"
+#include "sysTimer.h"
 #include "../../include/avr_driver_common.h"
 
+// count step for each transition, indexed by (prev << 2 | curr)
+// 0 for no change or an invalid double step 
+static const int8_t encoder_transition_table[16] = {
+//  curr: 00  01  10  11        prev
+           0, -1, +1,  0,   //  00
+          +1,  0,  0, -1,   //  01
+          -1,  0,  0, +1,   //  10
+           0, +1, -1,  0    //  11
+};
+
 volatile int32_t encod_count           = 0x00;
-volatile encoder_state_E encod_curr    = ENCODER_PHASE_ZERO_ZERO;
 volatile encoder_state_E encod_prev    = ENCODER_PHASE_ZERO_ZERO;
 
+// edge timing, in system timer ticks (us)
+static volatile uint16_t encod_edge_time[ENCODER_PERIOD_EDGES];
+static volatile uint16_t encod_edge_stamp_ms[ENCODER_PERIOD_EDGES]; // same edges, in ms, for the span check
+static volatile uint8_t  encod_edge_index      = 0;
+static volatile uint8_t  encod_edge_valid      = 0;   // consecutive edges in the same direction
+static volatile uint16_t encod_edge_time_ms    = 0;
+static volatile uint16_t encod_edge_period     = ENCODER_PERIOD_INVALID;
+static volatile int8_t   encod_edge_direction  = 0;
+
 
 static encoder_state_E getCurrentPhase(){
     return ((PINA) & (ENCODER_SIG_MASK)); 
@@ -24,31 +44,39 @@ static encoder_state_E getCurrentPhase(){
 /*********************************
              ISR 
 **********************************/
+// interrupts stay disabled for the whole handler, nothing can preempt the update 
 ISR(PCINT0_vect){
-    cli(); 
-    encod_curr = getCurrentPhase(); 
-    switch(encod_prev){
-        case(ENCODER_PHASE_ZERO_ZERO):
-            if (encod_curr == ENCODER_PHASE_ONE_ZERO) encod_count ++; 
-            else if(encod_curr == ENCODER_PHASE_ZERO_ONE) encod_count --; 
-        break;
-        case(ENCODER_PHASE_ZERO_ONE):
-            if (encod_curr == ENCODER_PHASE_ZERO_ZERO) encod_count ++; 
-            else if(encod_curr == ENCODER_PHASE_ONE_ONE) encod_count --; 
-        break;
-        case(ENCODER_PHASE_ONE_ZERO):
-            if (encod_curr == ENCODER_PHASE_ONE_ONE) encod_count ++; 
-            else if(encod_curr == ENCODER_PHASE_ZERO_ZERO) encod_count --; 
-        break;
-        case(ENCODER_PHASE_ONE_ONE):
-            if (encod_curr == ENCODER_PHASE_ZERO_ONE) encod_count ++; 
-            else if(encod_curr == ENCODER_PHASE_ONE_ZERO) encod_count --; 
-        break;
-        default:
-        break;
-    }
+    uint16_t now = TCNT1;
+    uint16_t now_ms = getSysTimeMs();
+    encoder_state_E encod_curr = getCurrentPhase(); 
+    int8_t step = encoder_transition_table[(encod_prev << 2) | encod_curr];
     encod_prev = encod_curr;
-    sei();
+
+    if (step == 0) return;
+    encod_count += step;
+
+    // period over a full quadrature cycle, so A/B phase error cancels out
+    if (step != encod_edge_direction){
+        encod_edge_direction = step;
+        encod_edge_valid     = 0;
+        encod_edge_period    = ENCODER_PERIOD_INVALID;
+    }
+    uint16_t oldest = encod_edge_time[encod_edge_index];
+    uint16_t oldest_ms = encod_edge_stamp_ms[encod_edge_index];
+    encod_edge_time[encod_edge_index] = now;
+    encod_edge_stamp_ms[encod_edge_index] = now_ms;
+    encod_edge_index = (encod_edge_index + 1) & (ENCODER_PERIOD_EDGES - 1);
+    if (encod_edge_valid < ENCODER_PERIOD_EDGES){
+        encod_edge_valid ++;
+    }
+    else if ((uint16_t)(now_ms - oldest_ms) < ENCODER_PERIOD_SPAN_MS){
+        encod_edge_period = now - oldest;
+    }
+    else{
+        // whole span too long, 16 bit timer difference may have wrapped 
+        encod_edge_period = ENCODER_PERIOD_INVALID;
+    }
+    encod_edge_time_ms = now_ms;
 }
 
 // function
@@ -69,33 +97,63 @@ void setupEncoderConfig(){
     setEncoderCount(0);
 }
 
-void setEncoderCount(uint8_t count){
-    encod_count = count; 
+void setEncoderCount(int32_t count){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        encod_count = count; 
+    }
+}
+
+// free running count, 4 byte read must not be split by the ISR
+int32_t getEncoderCount32(){
+    int32_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        count = encod_count;
+    }
+    return count;
+}
+
+// time for ENCODER_PERIOD_EDGES edges in us, ENCODER_PERIOD_INVALID when stalled, reversing,
+// slower than ENCODER_PERIOD_TIMEOUT_MS per edge or ENCODER_PERIOD_SPAN_MS over the edges 
+uint16_t getEncoderEdgePeriod(){
+    uint16_t period, edge_time_ms;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        period       = encod_edge_period;
+        edge_time_ms = encod_edge_time_ms;
+    }
+    if ((uint16_t)(getSysTimeMs() - edge_time_ms) >= ENCODER_PERIOD_TIMEOUT_MS){
+        return ENCODER_PERIOD_INVALID;
+    }
+    return period;
+}
+
+// direction of the last edge, +1 counting up, -1 counting down 
+int8_t getEncoderDirection(){
+    return encod_edge_direction;
 }
 
 int8_t getEncoderCount8(){
-    return encod_count;
+    return getEncoderCount32();
 }
 
 int8_t getEncoderCount16_first_8bit(){
-    return ((encod_count & DATA_MASK_16BIT_FIRST_8BIT) >> 8);
+    return ((getEncoderCount32() & DATA_MASK_16BIT_FIRST_8BIT) >> 8);
 }
 int8_t getEncoderCount16_second_8bit(){
-    return (encod_count & DATA_MASK_16BIT_SECOND_8BIT);
+    return (getEncoderCount32() & DATA_MASK_16BIT_SECOND_8BIT);
 }
 
 int8_t getEncoderCount32_first_8bit(){
-    return ((encod_count & DATA_MASK_32BIT_FIRST_8BIT) >> 24);
+    return ((getEncoderCount32() & DATA_MASK_32BIT_FIRST_8BIT) >> 24);
 }
 
 int8_t getEncoderCount32_second_8bit(){
-    return ((encod_count & DATA_MASK_32BIT_SECOND_8BIT) >> 16);
+    return ((getEncoderCount32() & DATA_MASK_32BIT_SECOND_8BIT) >> 16);
 }
 
 int8_t getEncoderCount32_third_8bit(){
-    return ((encod_count & DATA_MASK_32BIT_THIRD_8BIT) >> 8);
+    return ((getEncoderCount32() & DATA_MASK_32BIT_THIRD_8BIT) >> 8);
 }
 
 int8_t getEncoderCount32_fourth_8bit(){
-    return (encod_count & DATA_MASK_32BIT_FOURTH_8BIT);
+    return (getEncoderCount32() & DATA_MASK_32BIT_FOURTH_8BIT);
 }
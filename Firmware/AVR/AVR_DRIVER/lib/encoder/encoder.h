@@ -20,6 +20,12 @@ extern "C"{
 
 #define ENCODER_SIG_MASK (_BV(ENCODER_SIG_A) | _BV(ENCODER_SIG_B) )
 
+// edge period is measured over one full quadrature cycle (power of 2)
+#define ENCODER_PERIOD_EDGES        (4U)
+#define ENCODER_PERIOD_TIMEOUT_MS   (50U)
+#define ENCODER_PERIOD_SPAN_MS      (64U) // the edges measured must span less than one TCNT1 wrap (65.5 ms at 1 MHz)
+#define ENCODER_PERIOD_INVALID      (0xFFFF)
+
 
 typedef enum {
     ENCODER_PHASE_ZERO_ZERO,
@@ -30,7 +36,10 @@ typedef enum {
 
 // public function
 void setupEncoderConfig();
-void setEncoderCount(uint8_t count); 
+void setEncoderCount(int32_t count); 
+int32_t getEncoderCount32();
+uint16_t getEncoderEdgePeriod();
+int8_t getEncoderDirection();
 int8_t getEncoderCount8(); 
 int8_t getEncoderCount16_first_8bit(); 
 int8_t getEncoderCount16_second_8bit(); 
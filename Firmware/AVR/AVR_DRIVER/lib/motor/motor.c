@@ -79,6 +79,18 @@ void setMotor(motor_mode_E motor_mode, motor_pwm_duty_E percent_pwm){
     }
 }
 
+// signed duty for the speed loop, positive turns CW, negative CCW (coast between pulses)
+void setMotorDuty(int16_t duty){
+    if (duty >= 0){
+        OCR0B = 0;
+        OCR0A = (duty > REG_MAX) ? REG_MAX : duty;
+    }
+    else{
+        OCR0A = 0;
+        OCR0B = (duty < -REG_MAX) ? REG_MAX : -duty;
+    }
+}
+
 void eStopMotor(){
     OCR0A = 255;
     OCR0B = 255;
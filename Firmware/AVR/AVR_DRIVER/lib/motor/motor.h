@@ -28,6 +28,7 @@ typedef enum pwm_mode{
 
 void setupMotorConfig(pwm_mode_E pwm_mode); 
 void setMotor(motor_mode_E motor_mode, motor_pwm_duty_E percent_pwm); 
+void setMotorDuty(int16_t duty); 
 void eStopMotor(); 
 void testMotorAll(); 
 
@@ -0,0 +1,125 @@
+/**
+ * @file speedControl.c
+ * @author Tsugumi Murata (tmurata293)
+ * @date 14 Mar 2021
+ * @brief library for closed loop wheel speed control 
+ *
+ * Fixed-point PI loop at 1kHz. Speed is the encoder count difference over
+ * the last AVR_DRIVER_SPEED_WINDOW_MS, in ticks per window, and is measured
+ * whether the loop is enabled or not so it can always be reported.
+ * At low speed the window holds only a few ticks, so the loop switches to
+ * the encoder edge period and runs on SPEED_FRACTION_BITS of fraction.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>  
+#include <util/atomic.h>
+#include "speedControl.h"
+#include "motor.h"
+#include "encoder.h"
+
+#define SPEED_CTRL_INTEGRAL_MAX     ((int32_t)REG_MAX << SPEED_CTRL_GAIN_SHIFT)
+#define SPEED_CTRL_SHIFT            (SPEED_CTRL_GAIN_SHIFT + SPEED_FRACTION_BITS)
+
+// ticks per window in Q(SPEED_FRACTION_BITS) for ENCODER_PERIOD_EDGES over one period (us)
+#define SPEED_PERIOD_SCALE          (((int32_t)ENCODER_PERIOD_EDGES * AVR_DRIVER_SPEED_WINDOW_MS * 1000L) << SPEED_FRACTION_BITS)
+
+static volatile uint8_t              speed_ctrl_enabled  = 0;
+static volatile int16_t              speed_setpoint      = 0;
+static volatile motor_command_mode_E speed_stop_mode     = MOTOR_COMMAND_MODE_BRAKE;
+static volatile int16_t              speed_measured      = 0;
+static int32_t                       speed_integral      = 0;
+static uint16_t                      speed_count_history[AVR_DRIVER_SPEED_WINDOW_MS];
+static uint8_t                       speed_history_index = 0;
+static uint8_t                       speed_invert        = 0;
+static uint16_t                      speed_period        = ENCODER_PERIOD_INVALID; // last edge period divided
+static int32_t                       speed_period_fine   = 0;
+
+// speed in Q(SPEED_FRACTION_BITS) ticks per window 
+static int32_t measureSpeed(int16_t window_count){
+    if ((window_count >= SPEED_PERIOD_ESTIMATE_MAX) || (window_count <= -SPEED_PERIOD_ESTIMATE_MAX)){
+        return (int32_t)window_count << SPEED_FRACTION_BITS;
+    }
+    uint16_t period = getEncoderEdgePeriod();
+    if (period == ENCODER_PERIOD_INVALID) return (int32_t)window_count << SPEED_FRACTION_BITS;
+    // the 32 bit division only when the ISR measured a new period, at low speed an edge is several ms apart
+    if (period != speed_period){
+        speed_period = period;
+        speed_period_fine = SPEED_PERIOD_SCALE / period;
+        // one period can not be faster than the window says, clamp against edge time jitter
+        if (speed_period_fine > ((int32_t)SPEED_PERIOD_ESTIMATE_MAX << SPEED_FRACTION_BITS)){
+            speed_period_fine = (int32_t)SPEED_PERIOD_ESTIMATE_MAX << SPEED_FRACTION_BITS;
+        }
+    }
+    return (getEncoderDirection() < 0) ? -speed_period_fine : speed_period_fine;
+}
+
+static int32_t clampSpeedCtrl(int32_t value, int32_t limit){
+    if (value > limit)          return limit;
+    else if (value < -limit)    return -limit;
+    return value;
+}
+
+// function
+void setupSpeedControlConfig(uint8_t invert_direction){
+    uint16_t count = (uint16_t)getEncoderCount32();
+    speed_invert = invert_direction;
+    for (uint8_t i = 0; i < AVR_DRIVER_SPEED_WINDOW_MS; i++){
+        speed_count_history[i] = count;
+    }
+    disableSpeedControl();
+}
+
+void setSpeedSetpoint(int16_t ticks_per_window, motor_command_mode_E stop_mode){
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        if (!speed_ctrl_enabled) speed_integral = 0;
+        speed_setpoint     = ticks_per_window;
+        speed_stop_mode    = stop_mode;
+        speed_ctrl_enabled = 1;
+    }
+}
+
+// caller owns the motor outputs again after this returns 
+void disableSpeedControl(){
+    speed_ctrl_enabled = 0;
+}
+
+uint8_t isSpeedControlEnabled(){
+    return speed_ctrl_enabled;
+}
+
+int16_t getMeasuredSpeed(){
+    int16_t speed;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        speed = speed_measured;
+    }
+    return speed;
+}
+
+void updateSpeedControl(){
+    // low 16 bits are enough, one window never moves more than 32767 ticks
+    uint16_t count = (uint16_t)getEncoderCount32();
+    int16_t measured = (int16_t)(count - speed_count_history[speed_history_index]);
+    speed_count_history[speed_history_index] = count;
+    speed_history_index = (speed_history_index + 1) & SPEED_WINDOW_MASK;
+    int32_t measured_fine = measureSpeed(measured);
+    speed_measured = (int16_t)((measured_fine + (1 << (SPEED_FRACTION_BITS - 1))) >> SPEED_FRACTION_BITS);
+
+    if (!speed_ctrl_enabled) return;
+
+    if (speed_setpoint == 0){
+        speed_integral = 0;
+        if (speed_stop_mode == MOTOR_COMMAND_MODE_BRAKE)    setMotor(MOTOR_MODE_BREAK, MOTOR_PWM_DUTY_0_PERCENT);
+        else                                                setMotor(MOTOR_MODE_COAST, MOTOR_PWM_DUTY_0_PERCENT);
+        return;
+    }
+
+    // 16 bit int on the AVR, widen before the shift
+    int32_t error = ((int32_t)speed_setpoint << SPEED_FRACTION_BITS) - measured_fine;
+    // integral is clamped to the output range (anti-windup)
+    speed_integral = clampSpeedCtrl(speed_integral + (int32_t)SPEED_CTRL_KI * error, SPEED_CTRL_INTEGRAL_MAX << SPEED_FRACTION_BITS);
+    int32_t output = ((int32_t)SPEED_CTRL_KP * error + speed_integral) >> SPEED_CTRL_SHIFT;
+    output = clampSpeedCtrl(output, REG_MAX);
+
+    setMotorDuty(speed_invert ? -output : output);
+}
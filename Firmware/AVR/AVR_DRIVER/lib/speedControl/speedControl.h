@@ -0,0 +1,52 @@
+/**
+ * @file speedControl.h
+ * @author Tsugumi Murata (tmurata293)
+ * @date 14 Mar 2021
+ * @brief library for closed loop wheel speed control 
+ *
+ */
+
+#ifndef _SPEEDCONTROL_H_
+#define _SPEEDCONTROL_H_
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif 
+
+#include <stdio.h>
+#include <stdint.h>
+#include "../../include/avr_driver_common.h"
+
+// PI gains in Q8, output is the signed OCR0x duty (+-REG_MAX), tune on hardware 
+#define SPEED_CTRL_GAIN_SHIFT       (8)
+#define SPEED_CTRL_KP               (384)   // 1.5 duty per (tick / window)
+#define SPEED_CTRL_KI               (16)    // 0.0625 duty per (tick / window) per ms 
+
+// low speed resolution, below SPEED_PERIOD_ESTIMATE_MAX ticks per window
+// the speed comes from the encoder edge period instead of the window count 
+#define SPEED_FRACTION_BITS         (4)
+#define SPEED_PERIOD_ESTIMATE_MAX   (16)
+
+// measurement window, must be a power of 2 
+#define SPEED_WINDOW_MASK           (AVR_DRIVER_SPEED_WINDOW_MS - 1U)
+#if (AVR_DRIVER_SPEED_WINDOW_MS & SPEED_WINDOW_MASK)
+#  error speed window is not a power of 2
+#endif
+
+// invert_direction: positive speed (encoder counting up) turns the motor CCW
+void setupSpeedControlConfig(uint8_t invert_direction);
+void setSpeedSetpoint(int16_t ticks_per_window, motor_command_mode_E stop_mode);
+void disableSpeedControl();
+uint8_t isSpeedControlEnabled();
+int16_t getMeasuredSpeed();
+
+// run at 1kHz from the system timer interrupt 
+void updateSpeedControl();
+
+
+#ifdef __cplusplus  
+}
+#endif 
+
+#endif
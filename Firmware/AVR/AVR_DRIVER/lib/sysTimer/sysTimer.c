@@ -0,0 +1,56 @@
+/**
+ * @file sysTimer.c
+ * @author Tsugumi Murata (tmurata293)
+ * @date 14 Mar 2021
+ * @brief library for system timer (Timer1), 1us free running count and 1kHz tick 
+ *
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>  
+#include "sysTimer.h"
+
+static volatile uint16_t sys_time_ms = 0;
+static sys_timer_callback_t sys_timer_callback = NULL;
+
+/*********************************
+             ISR 
+**********************************/
+ISR(TIM1_COMPA_vect){
+    // timer keeps counting, move the compare point one ms ahead 
+    OCR1A += SYS_TIMER_TICKS_PER_MS;
+    sys_time_ms ++;
+    if (sys_timer_callback) sys_timer_callback();
+}
+
+// function
+void setupSysTimerConfig(sys_timer_callback_t tick_callback){
+    sys_timer_callback = tick_callback;
+
+    // normal mode, prescaler of 8 
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11);
+    TCNT1  = 0;
+    OCR1A  = SYS_TIMER_TICKS_PER_MS;
+
+    // enable compare A interrupt 
+    TIFR1  = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+}
+
+uint16_t getSysTimeMs(){
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t time_ms = sys_time_ms;
+    SREG = sreg;
+    return time_ms;
+}
+
+uint16_t getSysTimerTicks(){
+    // 16 bit register read goes through the shared TEMP register 
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t ticks = TCNT1;
+    SREG = sreg;
+    return ticks;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file sysTimer.h
+ * @author Tsugumi Murata (tmurata293)
+ * @date 14 Mar 2021
+ * @brief library for system timer (Timer1), 1us free running count and 1kHz tick 
+ *
+ */
+
+#ifndef _SYSTIMER_H_
+#define _SYSTIMER_H_
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif 
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Timer1 runs free at F_CPU / 8 = 1MHz, one count per us 
+#define SYS_TIMER_TICKS_PER_MS  (1000U)
+
+typedef void (*sys_timer_callback_t)(void);
+
+// callback runs inside the 1kHz timer interrupt, keep it short 
+void setupSysTimerConfig(sys_timer_callback_t tick_callback);
+uint16_t getSysTimeMs(); 
+uint16_t getSysTimerTicks(); 
+
+
+#ifdef __cplusplus  
+}
+#endif 
+
+#endif
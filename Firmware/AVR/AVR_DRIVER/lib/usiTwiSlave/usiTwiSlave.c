@@ -22,6 +22,7 @@
  04 Jul 2007  Fixed USISIF in ATtiny45 def
  31 Jul 2009  Added support for ATtiny24, 44, 84
  20 Feb 2021  Modified by tmurata, add functin specific for TableUV robot 
+ 16 Mar 2021  Added register file mode with auto-increment
  ********************************************************************************/
 
 
@@ -258,6 +259,15 @@ static volatile uint8_t txHead = 0;
 //static volatile int16_t txTail = 0;
 static volatile uint8_t txTail = 0;
 
+// register file mode, replaces the buffers when regFile is set
+static volatile uint8_t *regFile = 0;
+static uint8_t          regFileSize = 0;
+static uint8_t          regWritableSize = 0;
+static uint8_t          regSnapshot[ TWI_REGISTER_FILE_MAX_SIZE ];
+static volatile uint8_t regPointer = 0;
+static volatile bool    regPointerPending = false;
+static volatile bool    regWriteCommitted = false;
+
 
 
 /********************************************************************************
@@ -343,6 +353,37 @@ usiTwiSlaveInit(
 
 
 
+// initialise USI for TWI slave mode with a register file instead of buffers
+// the first byte of a master write sets the register pointer, following bytes
+// are stored from there on with auto-increment, reads continue from the pointer
+// only the first writableSize registers accept writes, and writing the last of
+// them commits the write block (see usiTwiTakeRegisterWrite)
+
+void
+usiTwiSlaveInitRegisters(
+                uint8_t ownAddress,
+                volatile uint8_t *registers,
+                uint8_t size,
+                uint8_t writableSize
+                )
+{
+    
+    if ( size > TWI_REGISTER_FILE_MAX_SIZE ) size = TWI_REGISTER_FILE_MAX_SIZE;
+    if ( writableSize > size ) writableSize = size;
+    
+    regFile           = registers;
+    regFileSize       = size;
+    regWritableSize   = writableSize;
+    regPointer        = 0;
+    regPointerPending = false;
+    regWriteCommitted = false;
+    
+    usiTwiSlaveInit( ownAddress );
+    
+} // end usiTwiSlaveInitRegisters
+
+
+
 // put data in the transmission buffer, wait if buffer is full
 
 void
@@ -391,6 +432,70 @@ void
 
 
 
+// check if master has committed a new write block
+
+bool
+usiTwiRegisterWritePending(
+void
+)
+{
+    
+    return regWriteCommitted;
+    
+} // end usiTwiRegisterWritePending
+
+
+
+// copy the committed write block out, returns false if nothing new arrived
+
+bool
+usiTwiTakeRegisterWrite(
+                        uint8_t *data
+                        )
+{
+    
+    bool committed;
+    uint8_t sreg = SREG;
+    cli();
+    committed = regWriteCommitted;
+    if ( committed )
+    {
+        for ( uint8_t i = 0; i < regWritableSize; i++ )
+        {
+            data[ i ] = regFile[ i ];
+        }
+        regWriteCommitted = false;
+    }
+    SREG = sreg;
+    return committed;
+    
+} // end usiTwiTakeRegisterWrite
+
+
+
+// update registers for master to read, a block read started before or after
+// the update sees it completely or not at all
+
+void
+usiTwiWriteRegisters(
+                     uint8_t first,
+                     const uint8_t *data,
+                     uint8_t length
+                     )
+{
+    
+    uint8_t sreg = SREG;
+    cli();
+    for ( uint8_t i = 0; ( i < length ) && ( ( first + i ) < regFileSize ); i++ )
+    {
+        regFile[ first + i ] = data[ i ];
+    }
+    SREG = sreg;
+    
+} // end usiTwiWriteRegisters
+
+
+
 // check if there is data in the receive buffer
 
 bool
@@ -502,10 +607,16 @@ ISR( USI_OVERFLOW_VECTOR )
             if ( USIDR & 0x01 )
             {
                 overflowState = USI_SLAVE_SEND_DATA;
+                // a block read is served from a copy taken here, so it is never torn
+                for ( uint8_t i = 0; i < regFileSize; i++ )
+                {
+                    regSnapshot[ i ] = regFile[ i ];
+                }
             }
             else
             {
                 overflowState = USI_SLAVE_REQUEST_DATA;
+                regPointerPending = true;
             } // end if
             SET_USI_TO_SEND_ACK( );
         }
@@ -530,8 +641,21 @@ ISR( USI_OVERFLOW_VECTOR )
         // copy data from buffer to USIDR and set USI to shift byte
         // next USI_SLAVE_REQUEST_REPLY_FROM_SEND_DATA
         case USI_SLAVE_SEND_DATA:
+        if ( regFile )
+        {
+            // past the end of the register file reads as 0xFF
+            if ( regPointer < regFileSize )
+            {
+                USIDR = regSnapshot[ regPointer ];
+                regPointer++;
+            }
+            else
+            {
+                USIDR = 0xFF;
+            }
+        }
         // Get data from Buffer
-        if ( txHead != txTail )
+        else if ( txHead != txTail )
         {
             txTail = ( txTail + 1 ) & TWI_TX_BUFFER_MASK;
             USIDR = txBuf[ txTail ];
@@ -571,10 +695,34 @@ ISR( USI_OVERFLOW_VECTOR )
         // copy data from USIDR and send ACK
         // next USI_SLAVE_REQUEST_DATA
         case USI_SLAVE_GET_DATA_AND_SEND_ACK:
-        // put data into buffer
-        // Not necessary, but prevents warnings
-        rxHead = ( rxHead + 1 ) & TWI_RX_BUFFER_MASK;
-        rxBuf[ rxHead ] = USIDR;
+        if ( regFile )
+        {
+            if ( regPointerPending )
+            {
+                regPointer = USIDR;
+                regPointerPending = false;
+            }
+            else if ( regPointer < regFileSize )
+            {
+                // writes to read-only registers are acked and dropped
+                if ( regPointer < regWritableSize )
+                {
+                    regFile[ regPointer ] = USIDR;
+                    if ( regPointer == ( regWritableSize - 1 ) )
+                    {
+                        regWriteCommitted = true;
+                    }
+                }
+                regPointer++;
+            }
+        }
+        else
+        {
+            // put data into buffer
+            // Not necessary, but prevents warnings
+            rxHead = ( rxHead + 1 ) & TWI_RX_BUFFER_MASK;
+            rxBuf[ rxHead ] = USIDR;
+        }
         // next USI_SLAVE_REQUEST_DATA
         overflowState = USI_SLAVE_REQUEST_DATA;
         SET_USI_TO_SEND_ACK( );
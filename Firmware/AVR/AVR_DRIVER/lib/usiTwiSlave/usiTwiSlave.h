@@ -18,6 +18,7 @@
  ------      -------------
  15 Mar 2007  Created. 
  20 Feb 2021  Modified by tmurata, add functin specific for TableUV robot 
+ 16 Mar 2021  Added register file mode with auto-increment
  ********************************************************************************/
 
 
@@ -32,6 +33,7 @@
  ********************************************************************************/
 
 #include <stdbool.h>
+#include <stdint.h>
 //added by tmurata
 #include "../../include/pinConfig.h"
 
@@ -45,6 +47,12 @@ void    usiTwiTransmitByte( int16_t );
 uint8_t usiTwiReceiveByte( void );
 bool    usiTwiDataInReceiveBuffer( void );
 
+// register file mode
+void    usiTwiSlaveInitRegisters( uint8_t ownAddress, volatile uint8_t *registers, uint8_t size, uint8_t writableSize );
+bool    usiTwiRegisterWritePending( void );
+bool    usiTwiTakeRegisterWrite( uint8_t *data );
+void    usiTwiWriteRegisters( uint8_t first, const uint8_t *data, uint8_t length );
+
 // added by tmurata 
 void setupUsiTwiConfig(); 
 
@@ -73,4 +81,10 @@ void setupUsiTwiConfig();
 
 
 
+// register file mode, largest register file served (one snapshot of it is kept for reads)
+
+#define TWI_REGISTER_FILE_MAX_SIZE ( 32 )
+
+
+
 #endif  // ifndef _USI_TWI_SLAVE_H_
\ No newline at end of file
@@ -14,9 +14,20 @@
 
 void setupWaterLevelConfig(){
     DDRA &= ~_BV(WATER_LEVEL_SIG); 
+
+    // disable digital input buffer on the analog pin 
+    DIDR0 |= _BV(WATER_LEVEL_SIG); 
+
+    // enable adc, prescaler 64 for 125kHz adc clock at 8MHz
+    ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1);
+    // left adjust result, 8 bit is enough for the level signal
+    ADCSRB = _BV(ADLAR);
 }
 
 uint8_t getWaterLevelSignal(){
-    //tbd
-    return 0;
+    // single conversion on ADC5 (PA5), ~104us at 125kHz 
+    ADMUX   = WATER_LEVEL_ADC_MUX;
+    ADCSRA |= _BV(ADSC);
+    while (ADCSRA & _BV(ADSC));
+    return ADCH;
 }
\ No newline at end of file
@@ -18,6 +18,8 @@ extern "C"{
 #include <stdio.h>
 #include "../../include/pinConfig.h"
 
+// ADMUX channel select for WATER_LEVEL_SIG (PA5 = ADC5)
+#define WATER_LEVEL_ADC_MUX     (_BV(MUX2) | _BV(MUX0))
 
 void setupWaterLevelConfig();
 uint8_t getWaterLevelSignal(); 
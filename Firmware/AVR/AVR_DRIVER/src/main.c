@@ -8,6 +8,8 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>    
+#include <avr/sleep.h>
+#include <avr/wdt.h>
 #include <util/delay.h>      
 #include <stdint.h>                 
 #include "usiTwiSlave.h"            
@@ -18,8 +20,24 @@
 #include "mistActuator.h"
 #include "left_driver_peripherals.h"
 #include "decodeI2C.h"
+#include "sysTimer.h"
+#include "speedControl.h"
+#include "commWatchdog.h"
+#include "avr_driver_common.h"
 
-#define RESET_TIMEOUT_COUNT     1000
+// backup for a hung main loop, the comm watchdog covers a silent master 
+#define MAIN_LOOP_WDT_TIMEOUT   WDTO_250MS
+
+// status block refresh between commands 
+#define STATUS_REFRESH_MS       (4U)
+
+// command block followed by status block, see avr_driver_common.h
+static volatile uint8_t driver_registers[AVR_DRIVER_REG_COUNT];
+
+// flags raised until AVR_DRIVER_BOOT_FLAG_FRAMES commands were answered
+static uint8_t boot_status_flags = AVR_DRIVER_STATUS_FLAG_BOOT;
+static uint8_t boot_frames_left  = AVR_DRIVER_BOOT_FLAG_FRAMES;
+static uint8_t command_sequence  = 0;
 
 static uint8_t getDriverMode(){
     // check which driver avr it is 
@@ -28,12 +46,155 @@ static uint8_t getDriverMode(){
 }
 
 static void resetState(){
+    disableSpeedControl();
     eStopMotor(); 
     disableMistActuator();  
 }
 
+// runs in the system timer interrupt, mist is left to the main loop 
+static void stopOnCommTimeout(){
+    disableSpeedControl();
+    eStopMotor();
+}
+
+// 1kHz system tick 
+static void systemTick(){
+    updateSpeedControl();
+    updateCommWatchdog();
+}
+
+// refresh the status block master reads from the register file 
+static void updateStatusRegisters(uint8_t water_level, uint8_t status_flags){
+    uint8_t frame[AVR_DRIVER_FRAME_SIZE];
+
+    // encoder count keeps running, master takes the difference
+    int32_t encoder_count = getEncoderCount32();
+    int16_t speed         = getMeasuredSpeed();
+
+    if (isSpeedControlEnabled())    status_flags |= AVR_DRIVER_STATUS_FLAG_SPEED_CTRL;
+    if (isCommWatchdogTripped())    status_flags |= AVR_DRIVER_STATUS_FLAG_COMM_TIMEOUT;
+    if (boot_frames_left)           status_flags |= boot_status_flags;
+
+    frame[AVR_DRIVER_FRAME_INDEX_VERSION]       = AVR_DRIVER_PROTOCOL_VERSION;
+    frame[AVR_DRIVER_FRAME_INDEX_SEQUENCE]      = command_sequence;
+    frame[AVR_DRIVER_FRAME_INDEX_ENCODER_0]     = (encoder_count & DATA_MASK_32BIT_FIRST_8BIT) >> 24;
+    frame[AVR_DRIVER_FRAME_INDEX_ENCODER_1]     = (encoder_count & DATA_MASK_32BIT_SECOND_8BIT) >> 16;
+    frame[AVR_DRIVER_FRAME_INDEX_ENCODER_2]     = (encoder_count & DATA_MASK_32BIT_THIRD_8BIT) >> 8;
+    frame[AVR_DRIVER_FRAME_INDEX_ENCODER_3]     = (encoder_count & DATA_MASK_32BIT_FOURTH_8BIT);
+    frame[AVR_DRIVER_FRAME_INDEX_SPEED_0]       = (speed & DATA_MASK_16BIT_FIRST_8BIT) >> 8;
+    frame[AVR_DRIVER_FRAME_INDEX_SPEED_1]       = (speed & DATA_MASK_16BIT_SECOND_8BIT);
+    frame[AVR_DRIVER_FRAME_INDEX_WATER_LEVEL]   = water_level;
+    frame[AVR_DRIVER_FRAME_INDEX_STATUS]        = status_flags;
+    frame[AVR_DRIVER_FRAME_INDEX_CRC]           = avr_driver_crc8(frame, AVR_DRIVER_FRAME_INDEX_CRC);
+
+    usiTwiWriteRegisters(AVR_DRIVER_REG_STATUS_BLOCK, frame, AVR_DRIVER_FRAME_SIZE);
+}
+
+// decode and apply one command block, returns the status flags of the command 
+static uint8_t applyCommand(const uint8_t *command, uint8_t driver_mode){
+    uint8_t message_first_byte  = command[AVR_DRIVER_CMD_INDEX_CONTROL];
+    uint8_t message_second_byte = command[AVR_DRIVER_CMD_INDEX_MOTOR];
+    uint8_t status_flags        = AVR_DRIVER_STATUS_FLAG_NONE;
+
+    // torn or corrupted block, keep the last command 
+    if (command[AVR_DRIVER_CMD_INDEX_CRC] != avr_driver_crc8(command, AVR_DRIVER_CMD_INDEX_CRC)){
+        return AVR_DRIVER_STATUS_FLAG_CMD_INVALID;
+    }
+
+    // check if data is indeed the first data byte of message 
+    if (!checkDataHeader(message_first_byte, DATA_FRAME_HEADER_FIRST)){
+        return AVR_DRIVER_STATUS_FLAG_CMD_INVALID;
+    }
+
+    // check if eStop bit is enabled 
+    if (message_first_byte & ESTOP_COMMAND_REQ_MASK){
+        disableSpeedControl();
+        eStopMotor(); 
+        return AVR_DRIVER_STATUS_FLAG_ESTOPPED;
+    }
+
+    // decode for left driver 
+    if(driver_mode){
+        uint8_t tof_config = message_first_byte & TOF_XSHUT_EN_REQ_BIT_MASK;
+        switch(tof_config){
+            case(TOF_SENSOR_CONFIG_DISABLE_ALL):
+                enable_TOF_XSHUT_All();
+            break;
+            case(TOF_CONFIG_1):
+                disable_TOF_XSHUT_1();
+            break;
+            case(TOF_CONFIG_2):
+                disable_TOF_XSHUT_2();
+            break;
+            case(TOF_CONFIG_3):
+                disable_TOF_XSHUT_3();
+            break;
+            default:
+            break;
+        } 
+    }
+    // decode for right detector 
+    else{
+        // check if haptic req bit is enabled 
+        if (message_first_byte & HAPTIC_EN_REQ_MASK)    enableMistActuator(); 
+        else                                            disableMistActuator(); 
+    }
+
+    motor_command_mode_E motor_command_mode;
+    motor_command_direction_E motor_command_direction;
+    motor_pwm_duty_E motor_pwm_duty; 
+
+    // check if data is indeed the second data byte of message 
+    if (!checkDataHeader(message_second_byte, DATA_FRAME_HEADER_SECOND)){
+        return AVR_DRIVER_STATUS_FLAG_CMD_INVALID;
+    }
+
+    // check motor command mode  
+    if (message_second_byte & MOTOR_MODE_REQ_MASK)      motor_command_mode = MOTOR_COMMAND_MODE_BRAKE;
+    else                                                motor_command_mode = MOTOR_COMMAND_MODE_COAST; 
+
+    // closed loop speed request, mode only selects how a zero setpoint stops
+    if (message_first_byte & SPEED_CTRL_REQ_MASK){
+        char message_third_byte  = command[AVR_DRIVER_CMD_INDEX_SPEED_0];
+        char message_fourth_byte = command[AVR_DRIVER_CMD_INDEX_SPEED_1];
+        if (checkDataHeader(message_third_byte, DATA_FRAME_HEADER_THIRD) && checkDataHeader(message_fourth_byte, DATA_FRAME_HEADER_FOURTH)){
+            setSpeedSetpoint(decodeSpeedSetpoint(message_third_byte, message_fourth_byte), motor_command_mode);
+        }
+        else{
+            status_flags |= AVR_DRIVER_STATUS_FLAG_CMD_INVALID;
+        }
+    }
+    else{
+        // open loop pwm request 
+        disableSpeedControl();
+
+        // check motor command direction 
+        if (message_second_byte & MOTOR_DIRECTION_REQ_MASK) motor_command_direction = MOTOR_COMMAND_DIRECTION_CW; 
+        else                                                motor_command_direction = MOTOR_COMMAND_DIRECTION_CCW; 
+        
+        motor_pwm_duty = (message_second_byte & MOTOR_PWM_DUTY_REQ_MASK);
+
+        if (motor_command_direction == MOTOR_COMMAND_DIRECTION_CW){
+            if (motor_command_mode == MOTOR_COMMAND_MODE_COAST)           setMotor(MOTOR_MODE_CW_COAST, motor_pwm_duty);
+            else if (motor_command_mode == MOTOR_COMMAND_MODE_BRAKE)      setMotor(MOTOR_MODE_CW_BREAK, motor_pwm_duty);
+        }
+        else if (motor_command_direction == MOTOR_COMMAND_DIRECTION_CCW){
+            if (motor_command_mode == MOTOR_COMMAND_MODE_COAST)           setMotor(MOTOR_MODE_CCW_COAST, motor_pwm_duty);
+            else if (motor_command_mode == MOTOR_COMMAND_MODE_BRAKE)      setMotor(MOTOR_MODE_CCW_BREAK, motor_pwm_duty);
+        }
+    }
+
+    return status_flags;
+}
+
 int main(void)
 {
+    // keep the reset cause, watchdog stays on after a watchdog reset until WDRF is cleared 
+    uint8_t reset_flags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+    if (reset_flags & _BV(WDRF)) boot_status_flags |= AVR_DRIVER_STATUS_FLAG_WDT_RESET;
+
     // set system clock to 8MHz
     CLKPR  = _BV(CLKPCE);
     CLKPR  = 0;
@@ -67,118 +228,74 @@ int main(void)
     //setup motor config 
     setupMotorConfig(PWM_MODE_PHASE_CORRECT); 
 
+    //setup speed loop, forward counts up on both wheels, left wheel turns CCW for forward 
+    setupSpeedControlConfig(driver_mode);
+    //motors stay stopped until the first valid frame and stop again when master goes quiet 
+    setupCommWatchdogConfig(stopOnCommTimeout);
+    //run speed loop and comm watchdog from 1kHz system timer 
+    setupSysTimerConfig(systemTick);
 
-    //initialize the USI communicatin
-    usiTwiSlaveInit(slave_address);
-    char message_first_byte  = 0x00;
-    char message_second_byte = 0x00;
 
-    uint16_t time_out_count = 0; 
+    //initialize the USI communicatin, master talks to the register file 
+    uint8_t status_flags     = AVR_DRIVER_STATUS_FLAG_NONE;
+    uint8_t water_level      = 0x00;
+    uint8_t comm_lost        = 0;
+    uint8_t command[AVR_DRIVER_CMD_SIZE];
+    uint16_t status_refresh_ms = getSysTimeMs();
+
+    updateStatusRegisters(water_level, status_flags);
+    usiTwiSlaveInitRegisters(slave_address, driver_registers, AVR_DRIVER_REG_COUNT, AVR_DRIVER_CMD_SIZE);
+
+    // idle keeps timer0 pwm, timer1 and usi running, any of their interrupts wakes the cpu
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    wdt_enable(MAIN_LOOP_WDT_TIMEOUT);
 
     while(1)
     { 
-        
-        // increment count when data not received
-        time_out_count ++; 
-        if (time_out_count > 50000){
-            resetState(); 
-            time_out_count = 0; 
+        wdt_reset();
+
+        // checked with interrupts off, so a command landing in between still wakes us
+        cli();
+        if (!usiTwiRegisterWritePending()){
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
         }
+        sei();
 
-        //if data received from master
-        if(usiTwiDataInReceiveBuffer()){
-
-            // initialize message to 0 
-            message_first_byte  = 0x00;
-            message_second_byte = 0x00;
-            time_out_count = 0; 
-
-            // store the first byte of data 
-            message_first_byte = usiTwiReceiveByte();
-
-            // check if data is indeed the first data byte of message 
-            if (checkDataHeader(message_first_byte, DATA_FRAME_HEADER_FIRST)){
-                
-                // check if eStop bit is enabled 
-                if (message_first_byte & ESTOP_COMMAND_REQ_MASK){
-                    eStopMotor(); 
-                }
-                //resume if eStop bit is not enabled 
-                else{
-
-                    // decode for left driver 
-                    if(driver_mode){
-                        uint8_t tof_config = message_first_byte & TOF_XSHUT_EN_REQ_BIT_MASK;
-                        switch(tof_config){
-                            case(TOF_SENSOR_CONFIG_DISABLE_ALL):
-                                enable_TOF_XSHUT_All();
-                            break;
-                            case(TOF_CONFIG_1):
-                                disable_TOF_XSHUT_1();
-                            break;
-                            case(TOF_CONFIG_2):
-                                disable_TOF_XSHUT_2();
-                            break;
-                            case(TOF_CONFIG_3):
-                                disable_TOF_XSHUT_3();
-                            break;
-                            default:
-                            break;
-                        } 
-                    }
-                    // decode for right detector 
-                    else{
-                        // check if haptic req bit is enabled 
-                        // #define IS_HAPTICREQUESTED(fbyte) ((fbyte)|(HAPTIC_EN_REQ_MASK))
-                        if (message_first_byte & HAPTIC_EN_REQ_MASK)    enableMistActuator(); 
-                        else                                            disableMistActuator(); 
-
-                    }
-
-                    message_second_byte = usiTwiReceiveByte();
-                    motor_command_mode_E motor_command_mode;
-                    motor_command_direction_E motor_command_direction;
-                    motor_pwm_duty_E motor_pwm_duty; 
-
-                    // check if data is indeed the second data byte of message 
-                    if (checkDataHeader(message_second_byte, DATA_FRAME_HEADER_SECOND)){
-                        
-                        // check motor command mode  
-                        if (message_second_byte & MOTOR_MODE_REQ_MASK)      motor_command_mode = MOTOR_COMMAND_MODE_BRAKE;
-                        else                                                motor_command_mode = MOTOR_COMMAND_MODE_COAST; 
-
-                        // check motor command direction 
-                        if (message_second_byte & MOTOR_DIRECTION_REQ_MASK) motor_command_direction = MOTOR_COMMAND_DIRECTION_CW; 
-                        else                                                motor_command_direction = MOTOR_COMMAND_DIRECTION_CCW; 
-                            
-                        motor_pwm_duty = (message_second_byte & MOTOR_PWM_DUTY_REQ_MASK);
-
-                        if (motor_command_direction == MOTOR_COMMAND_DIRECTION_CW){
-                            if (motor_command_mode == MOTOR_COMMAND_MODE_COAST)           setMotor(MOTOR_MODE_CW_COAST, motor_pwm_duty);
-                            else if (motor_command_mode == MOTOR_COMMAND_MODE_BRAKE)      setMotor(MOTOR_MODE_CW_BREAK, motor_pwm_duty);
-                        }
-                        else if (motor_command_direction == MOTOR_COMMAND_DIRECTION_CCW){
-                            if (motor_command_mode == MOTOR_COMMAND_MODE_COAST)           setMotor(MOTOR_MODE_CCW_COAST, motor_pwm_duty);
-                            else if (motor_command_mode == MOTOR_COMMAND_MODE_BRAKE)      setMotor(MOTOR_MODE_CCW_BREAK, motor_pwm_duty);
-                        }
-                    }
-                }
-                // send data back to master
-                cli();
-
-                // send encoder data 
-                usiTwiTransmitByte(getEncoderCount16_first_8bit());
-                usiTwiTransmitByte(getEncoderCount16_second_8bit());
-                setEncoderCount(0);
-
-                //send water level signal 
-                //usiTwiTransmitByte(getWaterLevelSignal());
-                sei();
-            }     
+        // motors are already stopped by the timer, put the rest back to the safe state once
+        if (isCommWatchdogTripped()){
+            if (!comm_lost) resetState();
+            comm_lost = 1;
         }
-        
 
+        //if a command block was written by master
+        if (usiTwiTakeRegisterWrite(command)){
+
+            status_flags = applyCommand(command, driver_mode);
+
+            // only a fully valid command counts as master being alive 
+            if (!(status_flags & AVR_DRIVER_STATUS_FLAG_CMD_INVALID)){
+                feedCommWatchdog();
+                comm_lost = 0;
+            }
+            if (takeCommWatchdogTrip()) status_flags |= AVR_DRIVER_STATUS_FLAG_COMM_TIMEOUT;
+
+            // water level sensor only exists on the right driver 
+            if (!driver_mode)   water_level = getWaterLevelSignal();
+
+            command_sequence ++;
+            if (boot_frames_left) boot_frames_left --;
+
+            updateStatusRegisters(water_level, status_flags);
+            status_refresh_ms = getSysTimeMs();
+        }
+        // keep encoder and speed fresh between commands 
+        else if ((uint16_t)(getSysTimeMs() - status_refresh_ms) >= STATUS_REFRESH_MS){
+            updateStatusRegisters(water_level, status_flags);
+            status_refresh_ms = getSysTimeMs();
+        }
     }
     return 0;   /* never reached */
 }
-
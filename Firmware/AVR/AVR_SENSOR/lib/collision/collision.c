@@ -13,27 +13,20 @@
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
-#define COL_INT_ENABLED  0
-
-typedef enum{
-    BOTH_OPEN,
-    LEFT_PRESSED,
-    RIGHT_PRESSED,
-    BOTH_PRESSED
-} collision_status_t;
 
 
 /////////////////////////////////////////
 ///////   PRIVATE PROTOTYPE     /////////
 /////////////////////////////////////////
 static inline void collision_private_gpio_config(void);
+static inline collision_data_S collision_private_decode(uint8_t pinb_reg);
 
 
 
 ///////////////////////////
 ///////   DATA     ////////
 ///////////////////////////
-static collision_data_S col_data;
+static volatile collision_data_S col_data;
 
 #if (COL_INT_ENABLED)
 static volatile bool col_pressed = false;
@@ -44,32 +37,49 @@ static volatile bool col_pressed = false;
 ////////////////////////////////////////
 ///////   PRIVATE FUNCTION     /////////
 ////////////////////////////////////////
-#if (COL_INT_ENABLED)
-ISR(PCINT1_vect)
+// switches pull low when pressed
+static inline collision_data_S collision_private_decode(uint8_t pinb_reg)
 {
-    cli();
-
-    col_pressed = true;
-
-    uint8_t pinb_reg = PINB & (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION));
-    
-    switch(pinb_reg)
+    collision_data_S temp_struct;
+    switch(pinb_reg & (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION)))
     {
         case _BV(LEFT_COLLISION) :                          // Left collision open, right collision pressed
-            col_data.col_status = RIGHT_PRESSED;
+            temp_struct.right_col_pressed = true;
+            temp_struct.left_col_pressed = false;
             break;
         case _BV(RIGHT_COLLISION) :                         // Right collision open, left collision pressed
-            col_data.col_status = LEFT_PRESSED;
+            temp_struct.right_col_pressed = false;
+            temp_struct.left_col_pressed = true;
             break;
         case (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION)) : // Both switches open
-            col_data.col_status = BOTH_PRESSED;
+            temp_struct.right_col_pressed = false;
+            temp_struct.left_col_pressed = false;
             break;
-        case 0 :                                            // Both switches pressed
-            col_data.col_status = BOTH_OPEN;
+        default :                                           // Both switches pressed
+            temp_struct.right_col_pressed = true;
+            temp_struct.left_col_pressed = true;            
             break;
     }
+#if (COL_INT_ENABLED)
+    temp_struct.col_status = (temp_struct.left_col_pressed ? LEFT_PRESSED : BOTH_OPEN) | (temp_struct.right_col_pressed ? RIGHT_PRESSED : BOTH_OPEN);
+#endif //COL_INT_ENABLED
+    return temp_struct;
+}
 
-    sei();
+#if (COL_INT_ENABLED)
+// short and not nested, the software uart bit timing can take one of these
+ISR(PCINT1_vect)
+{
+    collision_data_S temp_struct = collision_private_decode(PINB);
+
+    // a press stays latched until the main loop takes it, a release is left to polling
+    if (temp_struct.left_col_pressed || temp_struct.right_col_pressed)
+    {
+        col_data.left_col_pressed  |= temp_struct.left_col_pressed;
+        col_data.right_col_pressed |= temp_struct.right_col_pressed;
+        col_pressed = true;
+    }
+    col_data.col_status = temp_struct.col_status;
 }
 #endif //COL_INT_ENABLED
 static inline void collision_private_gpio_config(void)
@@ -105,65 +115,17 @@ uint8_t collision_status_get(void)
 #endif //COL_INT_ENABLED    
 }
 
+// polled pin state
 collision_data_S collision_status_retrieve(void)
 {
-#if (COL_INT_ENABLED)
-    uint8_t pinb_reg = PINB & (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION));
-    uint8_t temp_col_status = 0;
-    collision_data_S temp_struct;
-    
-    switch(pinb_reg)
-    {
-        case _BV(LEFT_COLLISION) :                          // Left collision open, right collision pressed
-            temp_col_status = RIGHT_PRESSED;
-            break;
-        case _BV(RIGHT_COLLISION) :                         // Right collision open, left collision pressed
-            temp_col_status = LEFT_PRESSED;
-            break;
-        case (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION)) : // Both switches open
-            temp_col_status = BOTH_PRESSED;
-            break;
-        case 0 :                                            // Both switches pressed
-            temp_col_status = BOTH_OPEN;
-            break;
-    }
-    temp_struct.col_status = temp_col_status;
-    return temp_struct;
-#else
-    uint8_t pinb_reg = PINB & (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION));
-    switch(pinb_reg)
-    {
-        case _BV(LEFT_COLLISION) :                          // Left collision open, right collision pressed
-            col_data.right_col_pressed = true;
-            col_data.left_col_pressed = false;
-            break;
-        case _BV(RIGHT_COLLISION) :                         // Right collision open, left collision pressed
-            col_data.right_col_pressed = false;
-            col_data.left_col_pressed = true;
-            break;
-        case (_BV(LEFT_COLLISION) | _BV(RIGHT_COLLISION)) : // Both switches open
-            col_data.right_col_pressed = false;
-            col_data.left_col_pressed = false;
-            break;
-        case 0 :                                            // Both switches pressed
-            col_data.right_col_pressed = true;
-            col_data.left_col_pressed = true;            
-            break;
-    }
-    return col_data;
-
-#endif //COL_INT_ENABLED    
+    return collision_private_decode(PINB);
 }
 
 
 bool col_pressed_get(void)
 {
 #if (COL_INT_ENABLED)    
-    cli();
-    bool temp = col_pressed;
-    sei();
-
-    return temp;
+    return col_pressed;
 #else
     return false;    
 #endif //COL_INT_ENABLED   
@@ -172,12 +134,31 @@ bool col_pressed_get(void)
 void col_pressed_clear(void)
 {
 #if (COL_INT_ENABLED)    
+    uint8_t sreg = SREG;
     cli();
     col_pressed = false;
-    sei();
+    col_data.left_col_pressed  = false;
+    col_data.right_col_pressed = false;
+    SREG = sreg;
 #endif //COL_INT_ENABLED    
 }
 
+// presses latched by the interrupt since the last take
+collision_data_S col_pressed_take(void)
+{
+    collision_data_S temp_struct = {0};
+#if (COL_INT_ENABLED)    
+    uint8_t sreg = SREG;
+    cli();
+    temp_struct = col_data;
+    col_pressed = false;
+    col_data.left_col_pressed  = false;
+    col_data.right_col_pressed = false;
+    SREG = sreg;
+#endif //COL_INT_ENABLED    
+    return temp_struct;
+}
+
 void collision_test(void)
 {
     // collision_init();
@@ -16,6 +16,16 @@
 #define COLLISION_H
 #include "../../include/pinConfig.h"
 
+// bumper pin change interrupt, reports a press without waiting for the next poll
+#define COL_INT_ENABLED  1
+
+typedef enum{
+    BOTH_OPEN,
+    LEFT_PRESSED,
+    RIGHT_PRESSED,
+    BOTH_PRESSED
+} collision_status_t;
+
 typedef struct{
 #if (COL_INT_ENABLED)    
     volatile collision_status_t col_status;
@@ -29,6 +39,7 @@ uint8_t collision_status_get(void);
 collision_data_S collision_status_retrieve(void);
 bool col_pressed_get(void);
 void col_pressed_clear(void);
+collision_data_S col_pressed_take(void);
 void collision_test(void);
 
 
@@ -28,6 +28,21 @@ static inline void ir_private_gpio_config(void);
 ///////////////////////////
 static ir_data_S ir_data;
 
+static const uint8_t ir_channel_mux[IR_CHANNEL_COUNT] = {
+    IR_FRONT_1_MUX,
+    IR_FRONT_2_MUX,
+    IR_RIGHT_1_MUX,
+    IR_RIGHT_2_MUX,
+    IR_LEFT_1_MUX,
+    IR_LEFT_2_MUX
+};
+
+static volatile uint8_t ir_sample_buf[IR_CHANNEL_COUNT][IR_SAMPLE_BUFFER_SIZE];
+static volatile uint8_t ir_sample_index = 0;   // slot of the newest complete sweep
+static volatile uint8_t ir_write_index  = 0;   // slot the running sweep writes into
+static volatile uint8_t ir_channel      = 0;
+static ir_sweep_callback_t ir_sweep_callback = NULL;
+
 
 
 ////////////////////////////////////////
@@ -67,6 +82,30 @@ static inline void ir_private_gpio_config(void)
         
 }
 
+// ADC conversion complete
+// ISR_NOBLOCK: the software uart bit timing on timer0 must not wait behind this one,
+// it can not nest with itself since the next conversion is a full trigger period away
+ISR(ADC_vect, ISR_NOBLOCK)
+{
+    uint8_t channel = ir_channel;
+    ir_sample_buf[channel][ir_write_index] = ADCH;
+
+    channel++;
+    if (channel >= IR_CHANNEL_COUNT)
+    {
+        channel = 0;
+        ir_sample_index = ir_write_index;
+        ir_write_index = (ir_write_index + 1) & IR_SAMPLE_BUFFER_MASK;
+        if (ir_sweep_callback) ir_sweep_callback();
+    }
+    ir_channel = channel;
+
+    // mux is latched at conversion start, this one applies to the next trigger
+    ADMUX = ir_channel_mux[channel];
+    // conversion starts on the rising edge of OCF1B, clear it so the next compare match triggers again
+    TIFR1 = _BV(OCF1B);
+}
+
 ///////////////////////////////////////
 ///////   PUBLIC FUNCTION     /////////
 ///////////////////////////////////////
@@ -75,40 +114,40 @@ void ir_attiny_init(void)
     ir_private_gpio_config();
 }
 
+// Conversions are auto triggered by timer1 compare match B, one channel per trigger,
+// timer1 itself is set up by the scheduler in main
+void ir_sampling_start(ir_sweep_callback_t sweep_callback)
+{
+    ir_sweep_callback = sweep_callback;
+    ir_channel = 0;
+    ADMUX = ir_channel_mux[0];
+
+    ADCSRB = 
+            (1 << ADLAR) |     // left shift result (for 8-bit values)
+            (1 << ADTS2) |     // trigger source timer1 compare match B, bit 2
+            (0 << ADTS1) |     // trigger source timer1 compare match B, bit 1
+            (1 << ADTS0);      // trigger source timer1 compare match B, bit 0
+
+    ADCSRA |= 
+            (1 << ADIF)  |     // clear a stale conversion complete flag
+            (1 << ADATE) |     // enable auto trigger
+            (1 << ADIE);       // enable conversion complete interrupt
+}
+
+// ring of the latest samples of one channel, newest at ir_sample_index_get()
+const volatile uint8_t* ir_sample_buffer_get(ir_channel_E channel)
+{
+    return ir_sample_buf[channel];
+}
+
+uint8_t ir_sample_index_get(void)
+{
+    return ir_sample_index;
+}
+
 void ir_sensor_update(void)
 {
-    // Front IR sensors
-    ADMUX = IR_FRONT_1_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_data.ir_front_1_data = ADCH;
-
-    ADMUX = IR_FRONT_2_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_data.ir_front_2_data = ADCH;
-
-    // Right IR Sensors
-    ADMUX = IR_RIGHT_1_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_data.ir_right_1_data = ADCH;
-
-    ADMUX = IR_RIGHT_2_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_data.ir_right_2_data = ADCH;
-
-    // Left IR Sensors
-    ADMUX = IR_LEFT_1_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_data.ir_left_1_data = ADCH;
-
-    ADMUX = IR_LEFT_2_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_data.ir_left_2_data = ADCH;    
+    ir_data = ir_sensor_retrieve();
 }
 
 ir_data_S ir_sensor_get(void)
@@ -116,42 +155,18 @@ ir_data_S ir_sensor_get(void)
     return ir_data;
 }
 
+// newest sample of every channel, no longer blocks on the ADC
 ir_data_S ir_sensor_retrieve(void)
 {
     ir_data_S ir_temp_data;
-
-    // Front IR sensors
-    ADMUX = IR_FRONT_1_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_temp_data.ir_front_1_data = ADCH;
-
-    ADMUX = IR_FRONT_2_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_temp_data.ir_front_2_data = ADCH;
-
-    // Right IR Sensors
-    ADMUX = IR_RIGHT_1_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_temp_data.ir_right_1_data = ADCH;
-
-    ADMUX = IR_RIGHT_2_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_temp_data.ir_right_2_data = ADCH;
-
-    // Left IR Sensors
-    ADMUX = IR_LEFT_1_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_temp_data.ir_left_1_data = ADCH;
-
-    ADMUX = IR_LEFT_2_MUX;
-    ADCSRA |= (1 << ADSC);         // start ADC measurement
-    while (ADCSRA & (1 << ADSC) ); // wait till conversion complete 
-    ir_temp_data.ir_left_2_data = ADCH;
+    uint8_t index = ir_sample_index;
+
+    ir_temp_data.ir_front_1_data = ir_sample_buf[IR_CHANNEL_FRONT_1][index];
+    ir_temp_data.ir_front_2_data = ir_sample_buf[IR_CHANNEL_FRONT_2][index];
+    ir_temp_data.ir_right_1_data = ir_sample_buf[IR_CHANNEL_RIGHT_1][index];
+    ir_temp_data.ir_right_2_data = ir_sample_buf[IR_CHANNEL_RIGHT_2][index];
+    ir_temp_data.ir_left_1_data  = ir_sample_buf[IR_CHANNEL_LEFT_1][index];
+    ir_temp_data.ir_left_2_data  = ir_sample_buf[IR_CHANNEL_LEFT_2][index];
 
     return ir_temp_data;
 }
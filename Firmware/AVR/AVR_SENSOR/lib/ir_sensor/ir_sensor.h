@@ -18,6 +18,27 @@
 #include "../../include/pinConfig.h"
 
 
+// channels in sampling order
+typedef enum{
+    IR_CHANNEL_FRONT_1,
+    IR_CHANNEL_FRONT_2,
+    IR_CHANNEL_RIGHT_1,
+    IR_CHANNEL_RIGHT_2,
+    IR_CHANNEL_LEFT_1,
+    IR_CHANNEL_LEFT_2,
+    IR_CHANNEL_COUNT
+} ir_channel_E;
+
+// per channel ring of the latest samples, must be a power of 2
+#define IR_SAMPLE_BUFFER_SIZE       (8U)
+#define IR_SAMPLE_BUFFER_MASK       (IR_SAMPLE_BUFFER_SIZE - 1U)
+#if (IR_SAMPLE_BUFFER_SIZE & IR_SAMPLE_BUFFER_MASK)
+#  error IR sample buffer size is not a power of 2
+#endif
+
+// called from the ADC interrupt (interrupts enabled) after every channel got a new sample
+typedef void (*ir_sweep_callback_t)(void);
+
 typedef struct{
     volatile uint8_t ir_front_1_data;
     volatile uint8_t ir_front_2_data;
@@ -29,6 +50,9 @@ typedef struct{
 
 
 void ir_attiny_init(void);
+void ir_sampling_start(ir_sweep_callback_t sweep_callback);
+const volatile uint8_t* ir_sample_buffer_get(ir_channel_E channel);
+uint8_t ir_sample_index_get(void);
 void ir_sensor_update(void);
 ir_data_S ir_sensor_get(void);
 ir_data_S ir_sensor_retrieve(void);
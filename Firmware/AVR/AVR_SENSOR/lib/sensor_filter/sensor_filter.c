@@ -0,0 +1,259 @@
+/**
+ * @file sensor_filter.c
+ * @author Jerome Villapando
+ * @date 16 Mar 2021
+ * @brief IR and collision filter files
+ *
+ * Integer only. Each IR channel keeps a running sum over the last
+ * SENSOR_FILTER_WINDOW samples, updated in O(1) per sample. A channel trips
+ * on raw samples so a cliff edge is seen within trip_samples, and releases on
+ * the mean with its own level and count so it does not chatter on the edge.
+ */
+
+#include <avr/eeprom.h>
+#include "sensor_filter.h"
+
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SENSOR_FILTER_WINDOW_MASK           (SENSOR_FILTER_WINDOW - 1U)
+
+typedef struct{
+    uint8_t  history[SENSOR_FILTER_WINDOW];
+    uint16_t sum;
+    uint8_t  count;     // consecutive samples towards the opposite state
+    bool     tripped;
+} ir_filter_S;
+
+typedef struct{
+    uint8_t  integrator;
+    bool     tripped;
+} collision_filter_S;
+
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static uint8_t sensor_filter_private_checksum(const sensor_filter_config_S* config);
+static bool sensor_filter_private_config_valid(const sensor_filter_config_S* config);
+static void sensor_filter_private_config_default(sensor_filter_config_S* config);
+static void sensor_filter_private_ir_reset(uint8_t sample_fill);
+
+
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static sensor_filter_config_S EEMEM sensor_filter_eeprom_config;
+static sensor_filter_config_S sensor_filter_config;
+
+static ir_filter_S ir_filter[IR_CHANNEL_COUNT];
+static uint8_t ir_filter_index = 0;
+
+static collision_filter_S collision_filter[COLLISION_COUNT];
+
+// calibrated on the table, front channels are crossed with their bits in main
+static const uint8_t sensor_filter_default_trip_level[IR_CHANNEL_COUNT] = {
+    246,    // IR_CHANNEL_FRONT_1
+    249,    // IR_CHANNEL_FRONT_2
+    228,    // IR_CHANNEL_RIGHT_1
+    226,    // IR_CHANNEL_RIGHT_2
+    227,    // IR_CHANNEL_LEFT_1
+    223     // IR_CHANNEL_LEFT_2
+};
+
+
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static uint8_t sensor_filter_private_checksum(const sensor_filter_config_S* config)
+{
+    const uint8_t* bytes = (const uint8_t*) config;
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < (sizeof(sensor_filter_config_S) - 1U); i++)
+    {
+        sum += bytes[i];
+    }
+    return (uint8_t) ~sum;
+}
+
+static bool sensor_filter_private_config_valid(const sensor_filter_config_S* config)
+{
+    if ((config->magic != SENSOR_FILTER_CONFIG_MAGIC) || (config->version != SENSOR_FILTER_CONFIG_VERSION)) return false;
+    if (config->checksum != sensor_filter_private_checksum(config)) return false;
+    if ((config->trip_samples == 0) || (config->release_samples == 0)) return false;
+    for (uint8_t i = 0; i < IR_CHANNEL_COUNT; i++)
+    {
+        // release level above trip level would never let the channel settle
+        if (config->release_level[i] > config->trip_level[i]) return false;
+    }
+    return true;
+}
+
+static void sensor_filter_private_config_default(sensor_filter_config_S* config)
+{
+    config->magic           = SENSOR_FILTER_CONFIG_MAGIC;
+    config->version         = SENSOR_FILTER_CONFIG_VERSION;
+    config->trip_samples    = SENSOR_FILTER_DEFAULT_TRIP_SAMPLES;
+    config->release_samples = SENSOR_FILTER_DEFAULT_REL_SAMPLES;
+    for (uint8_t i = 0; i < IR_CHANNEL_COUNT; i++)
+    {
+        config->trip_level[i]    = sensor_filter_default_trip_level[i];
+        config->release_level[i] = sensor_filter_default_trip_level[i] - SENSOR_FILTER_DEFAULT_HYSTERESIS;
+    }
+    config->checksum = sensor_filter_private_checksum(config);
+}
+
+static void sensor_filter_private_ir_reset(uint8_t sample_fill)
+{
+    for (uint8_t ch = 0; ch < IR_CHANNEL_COUNT; ch++)
+    {
+        for (uint8_t i = 0; i < SENSOR_FILTER_WINDOW; i++)
+        {
+            ir_filter[ch].history[i] = sample_fill;
+        }
+        ir_filter[ch].sum     = (uint16_t) sample_fill << SENSOR_FILTER_WINDOW_SHIFT;
+        ir_filter[ch].count   = 0;
+        ir_filter[ch].tripped = false;
+    }
+    ir_filter_index = 0;
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sensor_filter_init(void)
+{
+    eeprom_read_block(&sensor_filter_config, &sensor_filter_eeprom_config, sizeof(sensor_filter_config_S));
+    if (!sensor_filter_private_config_valid(&sensor_filter_config))
+    {
+        sensor_filter_private_config_default(&sensor_filter_config);
+        eeprom_update_block(&sensor_filter_config, &sensor_filter_eeprom_config, sizeof(sensor_filter_config_S));
+    }
+
+    sensor_filter_private_ir_reset(0);
+    for (uint8_t i = 0; i < COLLISION_COUNT; i++)
+    {
+        collision_filter[i].integrator = 0;
+        collision_filter[i].tripped    = false;
+    }
+}
+
+sensor_filter_config_S sensor_filter_config_get(void)
+{
+    return sensor_filter_config;
+}
+
+// checksum is filled in here, returns false and keeps the old config if the levels are inconsistent
+bool sensor_filter_config_set(const sensor_filter_config_S* config)
+{
+    sensor_filter_config_S temp_config = *config;
+    temp_config.magic    = SENSOR_FILTER_CONFIG_MAGIC;
+    temp_config.version  = SENSOR_FILTER_CONFIG_VERSION;
+    temp_config.checksum = sensor_filter_private_checksum(&temp_config);
+    if (!sensor_filter_private_config_valid(&temp_config)) return false;
+
+    sensor_filter_config = temp_config;
+    eeprom_update_block(&sensor_filter_config, &sensor_filter_eeprom_config, sizeof(sensor_filter_config_S));
+    return true;
+}
+
+void sensor_filter_ir_update(const ir_data_S* ir_data)
+{
+    uint8_t sample[IR_CHANNEL_COUNT];
+    sample[IR_CHANNEL_FRONT_1] = ir_data->ir_front_1_data;
+    sample[IR_CHANNEL_FRONT_2] = ir_data->ir_front_2_data;
+    sample[IR_CHANNEL_RIGHT_1] = ir_data->ir_right_1_data;
+    sample[IR_CHANNEL_RIGHT_2] = ir_data->ir_right_2_data;
+    sample[IR_CHANNEL_LEFT_1]  = ir_data->ir_left_1_data;
+    sample[IR_CHANNEL_LEFT_2]  = ir_data->ir_left_2_data;
+
+    for (uint8_t ch = 0; ch < IR_CHANNEL_COUNT; ch++)
+    {
+        ir_filter_S* filter = &ir_filter[ch];
+
+        // running sum, drop the oldest sample and add the newest
+        filter->sum += sample[ch];
+        filter->sum -= filter->history[ir_filter_index];
+        filter->history[ir_filter_index] = sample[ch];
+
+        if (!filter->tripped)
+        {
+            if (sample[ch] > sensor_filter_config.trip_level[ch])
+            {
+                if (++filter->count >= sensor_filter_config.trip_samples)
+                {
+                    filter->tripped = true;
+                    filter->count = 0;
+                }
+            }
+            else
+            {
+                filter->count = 0;
+            }
+        }
+        else
+        {
+            uint8_t mean = filter->sum >> SENSOR_FILTER_WINDOW_SHIFT;
+            if (mean <= sensor_filter_config.release_level[ch])
+            {
+                if (++filter->count >= sensor_filter_config.release_samples)
+                {
+                    filter->tripped = false;
+                    filter->count = 0;
+                }
+            }
+            else
+            {
+                filter->count = 0;
+            }
+        }
+    }
+    ir_filter_index = (ir_filter_index + 1) & SENSOR_FILTER_WINDOW_MASK;
+}
+
+bool sensor_filter_ir_tripped_get(ir_channel_E channel)
+{
+    return ir_filter[channel].tripped;
+}
+
+uint8_t sensor_filter_ir_mean_get(ir_channel_E channel)
+{
+    return ir_filter[channel].sum >> SENSOR_FILTER_WINDOW_SHIFT;
+}
+
+// integrator debounce, trips when saturated high and releases at zero
+void sensor_filter_collision_update(bool left_pressed, bool right_pressed)
+{
+    bool pressed[COLLISION_COUNT];
+    pressed[COLLISION_LEFT]  = left_pressed;
+    pressed[COLLISION_RIGHT] = right_pressed;
+
+    for (uint8_t i = 0; i < COLLISION_COUNT; i++)
+    {
+        collision_filter_S* filter = &collision_filter[i];
+        if (pressed[i])
+        {
+            if (filter->integrator < COLLISION_DEBOUNCE_SAMPLES) filter->integrator++;
+            if (filter->integrator >= COLLISION_DEBOUNCE_SAMPLES) filter->tripped = true;
+        }
+        else
+        {
+            if (filter->integrator > 0) filter->integrator--;
+            if (filter->integrator == 0) filter->tripped = false;
+        }
+    }
+}
+
+void sensor_filter_collision_trip(collision_side_E side)
+{
+    collision_filter[side].integrator = COLLISION_DEBOUNCE_SAMPLES;
+    collision_filter[side].tripped    = true;
+}
+
+bool sensor_filter_collision_tripped_get(collision_side_E side)
+{
+    return collision_filter[side].tripped;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file sensor_filter.h
+ * @author Jerome Villapando
+ * @date 16 Mar 2021
+ * @brief IR and collision filter header files
+ *
+ * This document will contains the integer filters deciding on cliff edges and bumper hits
+ */
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ir_sensor.h"
+
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+// running mean window per IR channel, must be a power of 2
+#define SENSOR_FILTER_WINDOW_SHIFT          (3U)
+#define SENSOR_FILTER_WINDOW                (1U << SENSOR_FILTER_WINDOW_SHIFT)
+
+// default IR levels, a reading above trip level is a cliff edge
+#define SENSOR_FILTER_DEFAULT_HYSTERESIS    (4U)
+#define SENSOR_FILTER_DEFAULT_TRIP_SAMPLES  (1U)    // consecutive raw samples above trip level
+#define SENSOR_FILTER_DEFAULT_REL_SAMPLES   (20U)   // consecutive mean values at or below release level
+
+// bumper debounce, integrator saturating at this many samples
+#define COLLISION_DEBOUNCE_SAMPLES          (4U)
+
+#define SENSOR_FILTER_CONFIG_MAGIC          (0xA7)
+#define SENSOR_FILTER_CONFIG_VERSION        (1U)
+
+typedef enum{
+    COLLISION_LEFT,
+    COLLISION_RIGHT,
+    COLLISION_COUNT
+} collision_side_E;
+
+// stored in EEPROM, defaults are written on first boot or after a layout change
+typedef struct{
+    uint8_t magic;
+    uint8_t version;
+    uint8_t trip_samples;
+    uint8_t release_samples;
+    uint8_t trip_level[IR_CHANNEL_COUNT];
+    uint8_t release_level[IR_CHANNEL_COUNT];
+    uint8_t checksum;
+} sensor_filter_config_S;
+
+
+void sensor_filter_init(void);
+sensor_filter_config_S sensor_filter_config_get(void);
+bool sensor_filter_config_set(const sensor_filter_config_S* config);
+
+// feed one sweep of IR samples, O(1) per channel
+void sensor_filter_ir_update(const ir_data_S* ir_data);
+bool sensor_filter_ir_tripped_get(ir_channel_E channel);
+uint8_t sensor_filter_ir_mean_get(ir_channel_E channel);
+
+// feed one collision sample
+void sensor_filter_collision_update(bool left_pressed, bool right_pressed);
+// press seen by the pin change interrupt, trips right away, release still debounced
+void sensor_filter_collision_trip(collision_side_E side);
+bool sensor_filter_collision_tripped_get(collision_side_E side);
+
+
+#endif // SENSOR_FILTER_H
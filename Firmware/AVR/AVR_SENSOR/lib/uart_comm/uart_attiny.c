@@ -13,6 +13,13 @@
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
+#define UART_TX_BUFFER_MASK     (UART_TX_BUFFER_SIZE - 1U)
+#if (UART_TX_BUFFER_SIZE & UART_TX_BUFFER_MASK)
+#  error UART TX buffer size is not a power of 2
+#endif
+
+// start bit (1<<0) is already 0, stop bit (1<<9)
+#define UART_TX_FRAME(character) ((((uint16_t)(uint8_t)(character))<<1) | (1<<9))
 
 
 /////////////////////////////////////////
@@ -27,6 +34,10 @@ static inline void uart_private_gpio_config(void);
 ///////////////////////////
 static volatile uint16_t tx_shift_reg = 0;
 
+static volatile uint8_t tx_buf[UART_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+
 
 
 ////////////////////////////////////////
@@ -68,14 +79,33 @@ ISR(TIM0_COMPA_vect)
    local_tx_shift_reg >>= 1;
    tx_shift_reg = local_tx_shift_reg;
    //if the stop bit has been sent, the shift register will be 0
-   //and the transmission is completed, so we can stop & reset timer0
+   //continue with the next buffered character, the stop bit lasts exactly one bit
    if(!local_tx_shift_reg)
    {
-      TCCR0B = 0;
-      TCNT0 = 0;
+      if(tx_tail != tx_head)
+      {
+         tx_tail = (tx_tail + 1) & UART_TX_BUFFER_MASK;
+         tx_shift_reg = UART_TX_FRAME(tx_buf[tx_tail]);
+      }
+      //otherwise the transmission is completed, so we can stop & reset timer0
+      else
+      {
+         TCCR0B = 0;
+         TCNT0 = 0;
+      }
    }
 }
 
+//call with interrupts off, starts timer0 if the line is idle
+static inline void uart_private_tx_kick(void)
+{
+   if(tx_shift_reg || (tx_tail == tx_head)){return;}
+   tx_tail = (tx_tail + 1) & UART_TX_BUFFER_MASK;
+   tx_shift_reg = UART_TX_FRAME(tx_buf[tx_tail]);
+   //start timer0 with a prescaler of 1
+   TCCR0B = (1<<CS00);
+}
+
 ///////////////////////////////////////
 ///////   PUBLIC FUNCTION     /////////
 ///////////////////////////////////////
@@ -84,25 +114,43 @@ void uart_attiny_init(void)
     uart_private_gpio_config();
 }
 
+//queue one character, dropped if the buffer is full
 void UART_tx(char character)
 {
-   uint16_t local_tx_shift_reg = tx_shift_reg;
-   //if sending the previous character is not yet finished, return
-   //transmission is finished when tx_shift_reg == 0
-   if(local_tx_shift_reg){return;}
-   //fill the TX shift register witch the character to be sent and the start & stop bits (start bit (1<<0) is already 0)
-   local_tx_shift_reg = (character<<1) | (1<<9); //stop bit (1<<9)
-   tx_shift_reg = local_tx_shift_reg;
-   //start timer0 with a prescaler of 1
-   TCCR0B = (1<<CS00);
+   UART_tx_buffer((const uint8_t*) &character, 1);
+}
+
+//queue all bytes or none of them, never waits on the line
+bool UART_tx_buffer(const uint8_t* data, uint8_t len)
+{
+   uint8_t sreg = SREG;
+   cli();
+   uint8_t free_space = (tx_tail - tx_head - 1) & UART_TX_BUFFER_MASK;
+   if(len > free_space)
+   {
+      SREG = sreg;
+      return false;
+   }
+   for(uint8_t i = 0; i < len; i ++)
+   {
+      tx_head = (tx_head + 1) & UART_TX_BUFFER_MASK;
+      tx_buf[tx_head] = data[i];
+   }
+   uart_private_tx_kick();
+   SREG = sreg;
+   return true;
+}
+
+uint8_t UART_tx_free_get(void)
+{
+   return (tx_tail - tx_head - 1) & UART_TX_BUFFER_MASK;
 }
 
 void UART_tx_str(char* string, uint8_t len)
 {
     for(uint8_t i = 0; i < len; i ++){
-        UART_tx( string[i] );
-        //wait until transmission is finished
-        while(tx_shift_reg);
+        //wait until there is room in the buffer
+        while(!UART_tx_buffer((const uint8_t*) &string[i], 1));
     }
 }
 
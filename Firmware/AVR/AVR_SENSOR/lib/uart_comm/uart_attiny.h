@@ -12,13 +12,19 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <util/delay.h>
 
 #include "../../include/pinConfig.h"
 
 
+// transmit buffer, must be a power of 2
+#define UART_TX_BUFFER_SIZE     (32U)
+
 void uart_attiny_init(void);
 void UART_tx(char character);
+bool UART_tx_buffer(const uint8_t* data, uint8_t len);
+uint8_t UART_tx_free_get(void);
 void UART_tx_str(char* string, uint8_t len);
 void uart_test_code(void);
 
@@ -12,55 +12,81 @@
 #include <stdint.h>  
 
 #include "../include/pinConfig.h"
+#include "../include/avr_sensor_common.h"
 #include "collision.h"
 #include "uart_attiny.h"
 #include "ir_sensor.h"
+#include "sensor_filter.h"
 
-#define BUFFER_SIZE                     (10U)
-#define COLLISION_FILTER_THRESHOLD      (0.8F)
-#define SENSOR_READ_FREQ                (200U) // Max 7kHz otherwise change the timer prescaler
-#define FILTER_FREQ                     (20U)
+#define SENSOR_READ_FREQ                (1000U) // per IR channel, max 1.5kHz (one 104us conversion per trigger)
+#define COLLISION_READ_FREQ             (200U)
+#define FILTER_FREQ                     (AVR_SENSOR_FRAME_FREQ)  // frame cadence, edges are sent right away
+#define COLLISION_READ_RATIO            (SENSOR_READ_FREQ/COLLISION_READ_FREQ)
 #define SENSOR_FILTER_RATIO             (SENSOR_READ_FREQ/FILTER_FREQ)
-#define SCHEDULER_TIMER_COMPARE         (39U)//(8000000U/(SENSOR_READ_FREQ * 1024U))
-
-typedef enum {
-    LEFT_COLLISION_BIT,
-    RIGHT_COLLISION_BIT,
-    IR_FRONT_1_BIT,
-    IR_FRONT_2_BIT,
-    IR_RIGHT_1_BIT,
-    IR_RIGHT_2_BIT,
-    IR_LEFT_1_BIT,
-    IR_LEFT_2_BIT
-} uart_byte_bits_E;
-
-uint8_t ir_f1_data_buf[BUFFER_SIZE] = {0};
-uint8_t ir_f2_data_buf[BUFFER_SIZE] = {0};
-uint8_t ir_l1_data_buf[BUFFER_SIZE] = {0};
-uint8_t ir_l2_data_buf[BUFFER_SIZE] = {0};
-uint8_t ir_r1_data_buf[BUFFER_SIZE] = {0};
-uint8_t ir_r2_data_buf[BUFFER_SIZE] = {0};
-uint8_t ir_index = 0;
-
-uint8_t left_collision_count;
-uint8_t right_collision_count;
-
-uint8_t uart_byte_send = 0;
+#define ADC_TRIGGER_FREQ                (SENSOR_READ_FREQ * IR_CHANNEL_COUNT)
+#define SCHEDULER_TIMER_COMPARE         ((1000000UL / ADC_TRIGGER_FREQ) - 1U)  // timer1 at 8MHz/8 = 1MHz, 165
 
+volatile bool ir_sample_stage = false;
 volatile bool sensor_read_stage = false;
 volatile bool filter_stage = false;
+volatile uint8_t collision_counter = 0;
 volatile uint8_t filter_counter = 0;
 
-void IR_filter_check(uint8_t* ir_arr, uint8_t bit_num, uint8_t ir_threshold)
+uint8_t IR_filter_check(ir_channel_E channel, uint8_t bit_num)
 {
-    uint16_t ir_sum = 0;
-    for(uint8_t i = 0; i < BUFFER_SIZE; i++){
-        ir_sum += ir_arr[i];
-    }
-    if ((ir_sum/BUFFER_SIZE) > (ir_threshold) )
+    if (sensor_filter_ir_tripped_get(channel))
     {
-        uart_byte_send |= _BV(bit_num);
+        return _BV(bit_num);
     }    
+    return 0;
+}
+
+// flags byte from the filter states
+static uint8_t sensor_flags_get(void)
+{
+    uint8_t uart_byte_send = 0;
+
+    if (sensor_filter_collision_tripped_get(COLLISION_LEFT))
+    {
+        uart_byte_send |= _BV(LEFT_COLLISION_BIT);
+    }
+    if (sensor_filter_collision_tripped_get(COLLISION_RIGHT))
+    {
+        uart_byte_send |= _BV(RIGHT_COLLISION_BIT);
+    }
+
+    // front channels are wired crossed to their bits
+    uart_byte_send |= IR_filter_check(IR_CHANNEL_FRONT_2, IR_FRONT_1_BIT);
+    uart_byte_send |= IR_filter_check(IR_CHANNEL_FRONT_1, IR_FRONT_2_BIT);
+    uart_byte_send |= IR_filter_check(IR_CHANNEL_RIGHT_1, IR_RIGHT_1_BIT);
+    uart_byte_send |= IR_filter_check(IR_CHANNEL_RIGHT_2, IR_RIGHT_2_BIT);            
+    uart_byte_send |= IR_filter_check(IR_CHANNEL_LEFT_1, IR_LEFT_1_BIT);
+    uart_byte_send |= IR_filter_check(IR_CHANNEL_LEFT_2, IR_LEFT_2_BIT);
+
+    return uart_byte_send;
+}
+
+// queue one frame with the newest raw IR sweep, false if the uart is still busy
+static bool sensor_frame_send(uint8_t flags)
+{
+    static uint8_t sequence = 0;
+    uint8_t frame[AVR_SENSOR_FRAME_SIZE];
+    ir_data_S cur_ir_data = ir_sensor_retrieve();
+
+    frame[AVR_SENSOR_FRAME_INDEX_SYNC]          = AVR_SENSOR_FRAME_SYNC;
+    frame[AVR_SENSOR_FRAME_INDEX_SEQUENCE]      = sequence;
+    frame[AVR_SENSOR_FRAME_INDEX_FLAGS]         = flags;
+    frame[AVR_SENSOR_FRAME_INDEX_IR_FRONT_1]    = cur_ir_data.ir_front_1_data;
+    frame[AVR_SENSOR_FRAME_INDEX_IR_FRONT_2]    = cur_ir_data.ir_front_2_data;
+    frame[AVR_SENSOR_FRAME_INDEX_IR_RIGHT_1]    = cur_ir_data.ir_right_1_data;
+    frame[AVR_SENSOR_FRAME_INDEX_IR_RIGHT_2]    = cur_ir_data.ir_right_2_data;
+    frame[AVR_SENSOR_FRAME_INDEX_IR_LEFT_1]     = cur_ir_data.ir_left_1_data;
+    frame[AVR_SENSOR_FRAME_INDEX_IR_LEFT_2]     = cur_ir_data.ir_left_2_data;
+    frame[AVR_SENSOR_FRAME_INDEX_CRC]           = avr_sensor_crc8(frame, AVR_SENSOR_FRAME_INDEX_CRC);
+
+    if (!UART_tx_buffer(frame, AVR_SENSOR_FRAME_SIZE)) return false;
+    sequence++;
+    return true;
 }
 
 void timer_scheduler_init(void)
@@ -71,23 +97,30 @@ void timer_scheduler_init(void)
     TCCR1B = 0;// same for TCCR1B
     TCNT1  = 0;//initialize counter value to 0
     // set compare match register for xhz increments
-    OCR1A = SCHEDULER_TIMER_COMPARE; //(uint16_t) (8000000/ (SENSOR_READ_FREQ * 1024));//i.e. 39 = (8*10^6) / (200 Hz *1024) - 1 (must be <65536)
+    OCR1A = SCHEDULER_TIMER_COMPARE; // i.e. 165 = (8*10^6) / (6 * 1kHz * 8) - 1 (must be <65536)
+    // compare match B triggers the ADC once per period, no interrupt needed
+    OCR1B = 0;
 
     // turn on CTC mode
     TCCR1B |= (1 << WGM12);
-    // Set CS12 and CS10 bits for 1024 prescaler
-    TCCR1B |= (1 << CS12) | (1 << CS10);
-    // enable timer compare interrupt
-    TIMSK1 |= (1 << OCIE1A);    
+    // Set CS11 bit for 8 prescaler
+    TCCR1B |= (1 << CS11);
 
     //enable interrupts
     sei();
 }
 
-// Sensor read ISR
-ISR(TIM1_COMPA_vect)
+// Sensor sweep done, runs in the ADC ISR every SENSOR_READ_FREQ
+static void sensor_sweep_done(void)
 {
-    sensor_read_stage = true;
+    ir_sample_stage = true;
+
+    collision_counter++;
+    if(collision_counter >= COLLISION_READ_RATIO)
+    {
+        sensor_read_stage = true;
+        collision_counter = 0;
+    }
 
     filter_counter++;
     if(filter_counter >= SENSOR_FILTER_RATIO)
@@ -103,61 +136,54 @@ int main()
     CLKPR = 0;
 
     collision_init();
+    sensor_filter_init();
     uart_attiny_init();
     ir_attiny_init();
+    ir_sampling_start(sensor_sweep_done);
     timer_scheduler_init();
 
 
+    uint8_t last_flags = 0;
+    bool frame_pending = true;
+
     while(1)
     {
-        if (sensor_read_stage)
+        // bumper press from the pin change interrupt, no need to wait for the next poll
+        if (col_pressed_get())
         {
-            // Retreival stage
-            collision_data_S cur_col_data = collision_status_retrieve();
-            left_collision_count += (uint8_t) cur_col_data.left_col_pressed;
-            right_collision_count += (uint8_t) cur_col_data.right_col_pressed;
+            collision_data_S cur_col_data = col_pressed_take();
+            if (cur_col_data.left_col_pressed)  sensor_filter_collision_trip(COLLISION_LEFT);
+            if (cur_col_data.right_col_pressed) sensor_filter_collision_trip(COLLISION_RIGHT);
+        }
 
+        if (ir_sample_stage)
+        {
+            // IR samples are collected by the ADC interrupt, filter the newest sweep
+            ir_sample_stage = false;
             ir_data_S cur_ir_data = ir_sensor_retrieve();
-            ir_f2_data_buf[ir_index] = cur_ir_data.ir_front_1_data;
-            ir_f1_data_buf[ir_index] = cur_ir_data.ir_front_2_data;
-            ir_l1_data_buf[ir_index] = cur_ir_data.ir_left_1_data;
-            ir_l2_data_buf[ir_index] = cur_ir_data.ir_left_2_data;
-            ir_r1_data_buf[ir_index] = cur_ir_data.ir_right_1_data;
-            ir_r2_data_buf[ir_index] = cur_ir_data.ir_right_2_data;
-            ir_index++;
-            if(ir_index >= BUFFER_SIZE) ir_index = 0;
+            sensor_filter_ir_update(&cur_ir_data);
+        }
 
-            sensor_read_stage = false;
+        if (sensor_read_stage)
+        {
+            // Retreival stage, releases are debounced here
+            collision_data_S cur_col_data = collision_status_retrieve();
+            sensor_filter_collision_update(cur_col_data.left_col_pressed, cur_col_data.right_col_pressed);
 
-            
+            sensor_read_stage = false;
         }
 
-        if(filter_stage)
+        // Report stage, on cadence and on every flag edge
+        uint8_t flags = sensor_flags_get();
+        if (filter_stage || (flags != last_flags))
         {
-            // Filter stage
-            if (left_collision_count > COLLISION_FILTER_THRESHOLD * BUFFER_SIZE)
-            {
-                uart_byte_send |= _BV(LEFT_COLLISION_BIT);
-                left_collision_count = 0;
-            }
-            if (right_collision_count > COLLISION_FILTER_THRESHOLD * BUFFER_SIZE)
-            {
-                uart_byte_send |= _BV(RIGHT_COLLISION_BIT);
-                right_collision_count = 0;
-            }
-
-            IR_filter_check(ir_f1_data_buf, IR_FRONT_1_BIT, 249);
-            IR_filter_check(ir_f2_data_buf, IR_FRONT_2_BIT, 246);
-            IR_filter_check(ir_r1_data_buf, IR_RIGHT_1_BIT, 228);
-            IR_filter_check(ir_r2_data_buf, IR_RIGHT_2_BIT, 226);            
-            IR_filter_check(ir_l1_data_buf, IR_LEFT_1_BIT, 227);
-            IR_filter_check(ir_l2_data_buf, IR_LEFT_2_BIT, 223);
-
-
-            UART_tx(uart_byte_send);
-            uart_byte_send = 0;
-
+            frame_pending = true;
             filter_stage = false;
         }
+        if (frame_pending && sensor_frame_send(flags))
+        {
+            frame_pending = false;
+            last_flags = flags;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,48 @@
+/**
+ * @file    bench.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the host runner of the slam kernel benchmarks:
+ *      the same cases and report as [env:esp32dev_bench] on the target, timed with the monotonic clock,
+ *      pin it to one core of an idle machine for numbers worth comparing (taskset -c 2 bench).
+ *      The checks of app_slam_bench_check() follow, the exit status is 1 when one fails.
+ *
+ *  usage: bench
+ */
+
+// Std. Lib
+#include <stdio.h>
+
+// TableUV Lib
+#include "common.h"
+#include "sys_bench.h"
+#include "app_slam.h"
+
+// Host
+#include "host_rtos.h"
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void bench_report(const char * line)
+{
+    puts(line);
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: %s\n", argv[0]);
+        return 2;
+    }
+    host_rtos_init(0);
+    app_slam_init();
+    app_slam_bench(bench_report);
+    return app_slam_bench_check(bench_report) ? 0 : 1;
+}
@@ -0,0 +1,577 @@
+/**
+ * @file    dev_host.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host device layer
+ *
+ * This document will contains the host side of lib/DEV, the logic after each bus transfer is kept as in the device files
+ */
+
+#include "dev_host.h"
+
+// Std. Lib
+#include <string.h>
+#include <math.h>
+
+// TableUV Lib
+#include "common.h"
+#include "dev_avr_sensor.h"
+#include "dev_ToF_Lidar.h"
+#include "dev_battery.h"
+#include "dev_led.h"
+#include "dev_uv.h"
+#include "dev_imu.h"
+#include "host_trace.h"
+
+// Host port
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+// dev_battery.c
+#define DEV_BATTERY_RAW_TO_VOLTAGE(raw_adc) (float)( ((int32_t)(raw_adc) * (DEV_BATTERY_PULLUP_KOHMS + DEV_BATTERY_PULLDOWN_KOHMS) * DEV_BATTERY_ESP_ADC_TO_VOLT) / (DEV_BATTERY_PULLDOWN_KOHMS) )
+
+typedef struct{
+    dev_avr_sensor_frame_S  frame[DEV_AVR_SENSOR_SUB_QUEUE_SIZE];
+    uint32_t                head;
+    uint32_t                tail;
+    uint32_t                dropCount;
+    TaskHandle_t            notify_task;
+    uint32_t                notify_bit;
+} dev_host_sub_queue_S;
+
+typedef struct{
+    // avr driver
+    uint8_t                 reqEstop;
+    bool                    estopLatched;
+    uint32_t                estopNowCount;
+    robot_motion_mode_E     reqRobotMotion;
+    motor_pwm_duty_E        pwm_duty[NUM_AVR_DRIVER];
+    uint8_t                 reqSpeedControl;
+    int16_t                 speedSetpoint[NUM_AVR_DRIVER];
+    int32_t                 encoderCount[NUM_AVR_DRIVER];
+    int16_t                 measuredSpeed[NUM_AVR_DRIVER];
+    int32_t                 encoderCountQueued[NUM_AVR_DRIVER];
+    bool                    encoderSynced[NUM_AVR_DRIVER];
+    uint8_t                 statusFlags[NUM_AVR_DRIVER];
+    uint8_t                 waterLevelSig;
+    int16_t                 l_enc_q[DEV_AVR_DRIVER_ENC_BUFFER_SIZE];
+    int16_t                 r_enc_q[DEV_AVR_DRIVER_ENC_BUFFER_SIZE];
+    uint8_t                 enc_buf_index;
+    dev_host_drive_S        traced_drive;
+    // avr sensor
+    dev_avr_sensor_frame_S  latest;
+    bool                    received;
+    dev_host_sub_queue_S    sub[DEV_AVR_SENSOR_SUB_COUNT];
+    // tof
+    dev_tof_lidar_sensor_data_S tof;
+    // imu
+    float                   imu[IMU_AXIS_IMU_COUNT];
+    bool                    imu_new;
+    // battery
+    float                   battery_voltage;
+    TaskHandle_t            battery_notify_task;
+    uint32_t                battery_notify_bit;
+    float                   battery_notify_threshold_v;
+    bool                    battery_below_threshold;
+    dev_host_battery_source_t battery_source;
+    // button, leds, uv
+    bool                    button_press_pending;
+    TaskHandle_t            button_notify_task;
+    uint32_t                button_notify_bit;
+    bool                    green_led_on;
+    bool                    red_led_on;
+    bool                    orange_led_on;
+    int                     uv_pwm[DEV_UV_LED_COUNT];
+    uint8_t                 uv_dac[DEV_UV_LED_COUNT];
+    bool                    uv_shutdown;
+} dev_host_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static int16_t  dev_host_private_takeEncoderDelta(uint8_t driver_side);
+static int16_t  dev_host_private_mmsToSetpoint(int16_t speed_mm_s, float mm_per_tick);
+static void     dev_host_private_traceLeds(void);
+static void     dev_host_private_setUv(DEV_UV_E led, int pwm_duty, uint8_t dac_duty);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static dev_host_data_S host_data;
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static int16_t dev_host_private_takeEncoderDelta(uint8_t driver_side)
+{
+    int32_t delta = (int32_t)((uint32_t)host_data.encoderCount[driver_side] - (uint32_t)host_data.encoderCountQueued[driver_side]);
+    if (delta > INT16_MAX)
+    {
+        delta = INT16_MAX;
+    }
+    else if (delta < INT16_MIN)
+    {
+        delta = INT16_MIN;
+    }
+    host_data.encoderCountQueued[driver_side] += delta;
+    return (int16_t)delta;
+}
+
+static int16_t dev_host_private_mmsToSetpoint(int16_t speed_mm_s, float mm_per_tick)
+{
+    float setpoint = (float)speed_mm_s * DEV_AVR_DRIVER_SPEED_WINDOW_S / mm_per_tick;
+    if (setpoint > AVR_DRIVER_SPEED_SETPOINT_MAX)
+    {
+        setpoint = AVR_DRIVER_SPEED_SETPOINT_MAX;
+    }
+    else if (setpoint < AVR_DRIVER_SPEED_SETPOINT_MIN)
+    {
+        setpoint = AVR_DRIVER_SPEED_SETPOINT_MIN;
+    }
+    return (int16_t)lroundf(setpoint);
+}
+
+static void dev_host_private_traceLeds(void)
+{
+    host_trace_printf("[ HOST:LED ] green: %d red: %d orange: %d\n",
+        host_data.green_led_on, host_data.red_led_on, host_data.orange_led_on);
+}
+
+static void dev_host_private_setUv(DEV_UV_E led, int pwm_duty, uint8_t dac_duty)
+{
+    if ((host_data.uv_pwm[led] != pwm_duty) || (host_data.uv_dac[led] != dac_duty))
+    {
+        host_data.uv_pwm[led] = pwm_duty;
+        host_data.uv_dac[led] = dac_duty;
+        host_trace_printf("[ HOST:UV ] led: %d pwm: %d dac: %d\n", led, pwm_duty, dac_duty);
+    }
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void dev_host_init(void)
+{
+    memset(&host_data, 0, sizeof(host_data));
+    host_data.reqEstop       = 1;
+    host_data.reqRobotMotion = ROBOT_MOTION_BREAK;
+    dev_host_get_drive(&host_data.traced_drive);
+}
+
+void dev_host_run50ms(void)
+{
+    dev_host_drive_S drive;
+    dev_host_get_drive(&drive);
+    if (memcmp(&drive, &host_data.traced_drive, sizeof(drive)) != 0)
+    {
+        host_data.traced_drive = drive;
+        host_trace_printf("[ HOST:DRIVER ] estop: %d speed: %d (%.1f, %.1f) motion: %d pwm: %d, %d\n",
+            drive.estop, drive.speed_control, (double)drive.speed_mm_s[LEFT_AVR_DRIVER], (double)drive.speed_mm_s[RIGHT_AVR_DRIVER],
+            drive.motion, drive.pwm[LEFT_AVR_DRIVER], drive.pwm[RIGHT_AVR_DRIVER]);
+    }
+}
+
+void dev_host_run1000ms(void)
+{
+    if (host_data.battery_source != NULL)
+    {
+        dev_host_battery_raw(host_data.battery_source());
+    }
+}
+
+void dev_host_set_battery_source(dev_host_battery_source_t source)
+{
+    host_data.battery_source = source;
+}
+
+void dev_host_get_drive(dev_host_drive_S * drive)
+{
+    memset(drive, 0, sizeof(*drive)); // padding is compared
+    drive->estop         = (host_data.reqEstop != 0U) || host_data.estopLatched;
+    drive->speed_control = (host_data.reqSpeedControl != 0U) && (!drive->estop);
+    // a break request without speed control goes out as an e-stop
+    drive->estop        |= (!drive->speed_control) && (host_data.reqRobotMotion == ROBOT_MOTION_BREAK);
+    drive->motion        = host_data.reqRobotMotion;
+    drive->pwm[LEFT_AVR_DRIVER]  = (uint8_t)host_data.pwm_duty[LEFT_AVR_DRIVER];
+    drive->pwm[RIGHT_AVR_DRIVER] = (uint8_t)host_data.pwm_duty[RIGHT_AVR_DRIVER];
+    drive->speed_mm_s[LEFT_AVR_DRIVER]  = (float)host_data.speedSetpoint[LEFT_AVR_DRIVER]  * DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK / DEV_AVR_DRIVER_SPEED_WINDOW_S;
+    drive->speed_mm_s[RIGHT_AVR_DRIVER] = (float)host_data.speedSetpoint[RIGHT_AVR_DRIVER] * DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK / DEV_AVR_DRIVER_SPEED_WINDOW_S;
+}
+
+uint32_t dev_host_get_estop_now_count(void)
+{
+    return host_data.estopNowCount;
+}
+
+void dev_host_avr_driver_status(uint8_t side, const uint8_t * frame)
+{
+    const int32_t count = (int32_t)(((uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_0] << 24)
+                                  | ((uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_1] << 16)
+                                  | ((uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_2] << 8)
+                                  |  (uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_3]);
+    const uint8_t flags = frame[AVR_DRIVER_FRAME_INDEX_STATUS];
+    if (side >= NUM_AVR_DRIVER)
+    {
+        return;
+    }
+
+    if ((!host_data.encoderSynced[side]) || (flags & AVR_DRIVER_STATUS_FLAG_BOOT))
+    {
+        host_data.encoderCountQueued[side] = count;
+        host_data.encoderSynced[side] = true;
+    }
+    host_data.statusFlags[side]   = flags;
+    host_data.encoderCount[side]  = count;
+    host_data.measuredSpeed[side] = (int16_t)((frame[AVR_DRIVER_FRAME_INDEX_SPEED_0] << 8) | frame[AVR_DRIVER_FRAME_INDEX_SPEED_1]);
+    if (side == RIGHT_AVR_DRIVER)
+    {
+        host_data.waterLevelSig = frame[AVR_DRIVER_FRAME_INDEX_WATER_LEVEL];
+
+        // both sides are read, the 20ms update queues the encoder deltas
+        if (host_data.enc_buf_index < DEV_AVR_DRIVER_ENC_BUFFER_SIZE)
+        {
+            host_data.l_enc_q[host_data.enc_buf_index] = dev_host_private_takeEncoderDelta(LEFT_AVR_DRIVER);
+            host_data.r_enc_q[host_data.enc_buf_index] = dev_host_private_takeEncoderDelta(RIGHT_AVR_DRIVER);
+            host_data.enc_buf_index ++;
+        }
+    }
+}
+
+void dev_host_avr_sensor_frame(const uint8_t * raw)
+{
+    dev_avr_sensor_frame_S frame;
+    frame.stamp_us = esp_timer_get_time();
+    frame.sequence = raw[AVR_SENSOR_FRAME_INDEX_SEQUENCE];
+    frame.flags    = raw[AVR_SENSOR_FRAME_INDEX_FLAGS];
+    memcpy(frame.ir_raw, &raw[AVR_SENSOR_FRAME_INDEX_IR_FRONT_1], AVR_SENSOR_FRAME_IR_COUNT);
+    host_data.latest   = frame;
+    host_data.received = true;
+
+    // push to every subscriber queue, a full queue keeps its oldest frames
+    for (uint8_t i = 0; i < DEV_AVR_SENSOR_SUB_COUNT; i++)
+    {
+        dev_host_sub_queue_S * sub = &host_data.sub[i];
+        if ((sub->head - sub->tail) >= DEV_AVR_SENSOR_SUB_QUEUE_SIZE)
+        {
+            sub->dropCount ++;
+        }
+        else
+        {
+            sub->frame[sub->head & (DEV_AVR_SENSOR_SUB_QUEUE_SIZE - 1U)] = frame;
+            sub->head ++;
+        }
+        if (sub->notify_task != NULL)
+        {
+            xTaskNotify(sub->notify_task, sub->notify_bit, eSetBits);
+        }
+    }
+}
+
+void dev_host_tof_sample(uint8_t sensor, uint8_t label, uint8_t status, uint16_t dist_mm)
+{
+    (void)sensor;
+    if ((status == DEV_TOF_RANGE_STATUS_SIGNAL_FAILURE) || (status == DEV_TOF_RANGE_STATUS_NO_ERROR))
+    {
+        uint8_t data_index = host_data.tof.data_counter;
+        if (data_index >= DEV_TOF_BUFFER_SIZE)
+        {
+            data_index = 0U; // reset index & override data
+        }
+        host_data.tof.dist_mm[data_index] = dist_mm;
+        host_data.tof.keyframe_label[data_index] = label;
+        host_data.tof.data_counter = data_index + 1;
+    }
+}
+
+void dev_host_imu_sample(const float * values)
+{
+    memcpy(host_data.imu, values, sizeof(host_data.imu));
+    host_data.imu_new = true;
+}
+
+void dev_host_battery_raw(int32_t raw_adc)
+{
+    host_data.battery_voltage = DEV_BATTERY_RAW_TO_VOLTAGE(raw_adc);
+    const bool below_threshold = (host_data.battery_voltage < host_data.battery_notify_threshold_v);
+    if ((below_threshold != host_data.battery_below_threshold) && (host_data.battery_notify_task != NULL))
+    {
+        xTaskNotify(host_data.battery_notify_task, host_data.battery_notify_bit, eSetBits);
+    }
+    host_data.battery_below_threshold = below_threshold;
+}
+
+void dev_host_button_press(void)
+{
+    host_data.button_press_pending = true;
+    if (host_data.button_notify_task != NULL)
+    {
+        xTaskNotifyFromISR(host_data.button_notify_task, host_data.button_notify_bit, eSetBits, NULL);
+    }
+}
+
+// dev_avr_driver //
+uint8_t dev_avr_driver_Estop_now(int64_t * side_done_us)
+{
+    host_data.estopLatched = true;
+    host_data.estopNowCount ++;
+    host_trace_printf("[ HOST:DRIVER ] estop now\n");
+    for (uint8_t side = LEFT_AVR_DRIVER; side < NUM_AVR_DRIVER; side++)
+    {
+        if (side_done_us != NULL)
+        {
+            side_done_us[side] = esp_timer_get_time();
+        }
+    }
+    return NUM_AVR_DRIVER;
+}
+
+void dev_avr_driver_release_Estop_latch()
+{
+    host_data.estopLatched = false;
+}
+
+bool dev_avr_driver_is_Estop_latched()
+{
+    return host_data.estopLatched;
+}
+
+void dev_avr_driver_set_req_Estop()
+{
+    host_data.reqEstop = 1;
+}
+
+void dev_avr_driver_set_req_Robot_motion(robot_motion_mode_E robot_motion_mode, motor_pwm_duty_E motor_pwm_duty_left, motor_pwm_duty_E motor_pwm_duty_right)
+{
+    host_data.reqEstop = 0;
+    host_data.reqSpeedControl = 0;
+    host_data.reqRobotMotion = robot_motion_mode;
+    host_data.pwm_duty[LEFT_AVR_DRIVER]  = motor_pwm_duty_left;
+    host_data.pwm_duty[RIGHT_AVR_DRIVER] = motor_pwm_duty_right;
+}
+
+void dev_avr_driver_set_req_Robot_speed(int16_t left_speed_mm_s, int16_t right_speed_mm_s)
+{
+    host_data.speedSetpoint[LEFT_AVR_DRIVER]  = dev_host_private_mmsToSetpoint(left_speed_mm_s,  DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK);
+    host_data.speedSetpoint[RIGHT_AVR_DRIVER] = dev_host_private_mmsToSetpoint(right_speed_mm_s, DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK);
+    host_data.reqEstop = 0;
+    host_data.reqSpeedControl = 1;
+}
+
+void dev_avr_driver_reset_req_Estop()
+{
+    host_data.reqEstop = 0;
+}
+
+void dev_avr_driver_reset_req_Robot_motion()
+{
+    dev_avr_driver_set_req_Estop();
+    host_data.reqSpeedControl = 0;
+    host_data.reqRobotMotion = ROBOT_MOTION_BREAK;
+    host_data.pwm_duty[LEFT_AVR_DRIVER]  = MOTOR_PWM_DUTY_0_PERCENT;
+    host_data.pwm_duty[RIGHT_AVR_DRIVER] = MOTOR_PWM_DUTY_0_PERCENT;
+}
+
+int32_t dev_avr_driver_get_EncoderCount(uint8_t driver_side)
+{
+    return host_data.encoderCount[driver_side];
+}
+
+uint8_t dev_avr_driver_get_encoder_buffers(int16_t* l_enc_buf, int16_t* r_enc_buf)
+{
+    memcpy(l_enc_buf, host_data.l_enc_q, sizeof(int16_t) * DEV_AVR_DRIVER_ENC_BUFFER_SIZE);
+    memcpy(r_enc_buf, host_data.r_enc_q, sizeof(int16_t) * DEV_AVR_DRIVER_ENC_BUFFER_SIZE);
+    const uint8_t buffer_size = host_data.enc_buf_index;
+    host_data.enc_buf_index = 0;
+    return buffer_size;
+}
+
+uint8_t dev_avr_driver_get_WaterLevelSig()
+{
+    return host_data.waterLevelSig;
+}
+
+uint8_t dev_avr_driver_get_StatusFlags(uint8_t driver_side)
+{
+    return host_data.statusFlags[driver_side];
+}
+
+float dev_avr_driver_get_WheelSpeed_mm_s(uint8_t driver_side)
+{
+    const float mm_per_tick = (driver_side == LEFT_AVR_DRIVER) ? DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK : DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK;
+    return (float)host_data.measuredSpeed[driver_side] * mm_per_tick / DEV_AVR_DRIVER_SPEED_WINDOW_S;
+}
+
+// dev_avr_sensor //
+uint8_t dev_avr_sensor_uart_get(void)
+{
+    if (host_data.received && ((esp_timer_get_time() - host_data.latest.stamp_us) <= DEV_AVR_SENSOR_STALE_TIMEOUT_US))
+    {
+        return host_data.latest.flags;
+    }
+    return DEV_AVR_NO_SENSOR;
+}
+
+bool dev_avr_sensor_is_stale(void)
+{
+    return (!host_data.received) || ((esp_timer_get_time() - host_data.latest.stamp_us) > DEV_AVR_SENSOR_STALE_TIMEOUT_US);
+}
+
+uint8_t dev_avr_sensor_ir_raw_get(uint8_t index)
+{
+    return (index < AVR_SENSOR_FRAME_IR_COUNT) ? host_data.latest.ir_raw[index] : 0U;
+}
+
+void dev_avr_sensor_register_notify(dev_avr_sensor_sub_E sub, TaskHandle_t task, uint32_t bit)
+{
+    if (sub < DEV_AVR_SENSOR_SUB_COUNT)
+    {
+        host_data.sub[sub].notify_bit  = bit;
+        host_data.sub[sub].notify_task = task;
+    }
+}
+
+bool dev_avr_sensor_frame_pop(dev_avr_sensor_sub_E sub, dev_avr_sensor_frame_S * frame)
+{
+    if (sub >= DEV_AVR_SENSOR_SUB_COUNT)
+    {
+        return false;
+    }
+    dev_host_sub_queue_S * queue = &host_data.sub[sub];
+    if (queue->tail == queue->head)
+    {
+        return false;
+    }
+    *frame = queue->frame[queue->tail & (DEV_AVR_SENSOR_SUB_QUEUE_SIZE - 1U)];
+    queue->tail ++;
+    return true;
+}
+
+// dev_ToF_Lidar //
+bool dev_ToF_Lidar_dampDataBuffer(dev_tof_lidar_sensor_data_S* buffer)
+{
+    memcpy(buffer, &host_data.tof, sizeof(dev_tof_lidar_sensor_data_S));
+    host_data.tof.data_counter = 0;
+    return TRUE;
+}
+
+// dev_imu //
+bool dev_imu_get_values(float* data_ptr)
+{
+    if (!host_data.imu_new)
+    {
+        return false;
+    }
+    memcpy(data_ptr, host_data.imu, sizeof(host_data.imu));
+    host_data.imu_new = false;
+    return true;
+}
+
+// dev_battery //
+float dev_battery_get(void)
+{
+    return host_data.battery_voltage;
+}
+
+void dev_battery_register_notify(TaskHandle_t task, uint32_t bit, float threshold_v)
+{
+    host_data.battery_notify_bit = bit;
+    host_data.battery_notify_threshold_v = threshold_v;
+    host_data.battery_below_threshold = (host_data.battery_voltage < threshold_v);
+    host_data.battery_notify_task = task;
+}
+
+// dev_led //
+bool dev_button_take_press(void)
+{
+    const bool pressed = host_data.button_press_pending;
+    host_data.button_press_pending = false;
+    return pressed;
+}
+
+void dev_button_register_notify(TaskHandle_t task, uint32_t bit)
+{
+    host_data.button_notify_bit  = bit;
+    host_data.button_notify_task = task;
+}
+
+void dev_led_green_set(bool led_on)
+{
+    if (host_data.green_led_on != led_on)
+    {
+        host_data.green_led_on = led_on;
+        dev_host_private_traceLeds();
+    }
+}
+
+void dev_led_red_set(bool led_on)
+{
+    if (host_data.red_led_on != led_on)
+    {
+        host_data.red_led_on = led_on;
+        dev_host_private_traceLeds();
+    }
+}
+
+void dev_led_orange_set(bool led_on)
+{
+    if (host_data.orange_led_on != led_on)
+    {
+        host_data.orange_led_on = led_on;
+        dev_host_private_traceLeds();
+    }
+}
+
+void dev_led_clear_leds(void)
+{
+    if (host_data.green_led_on || host_data.red_led_on || host_data.orange_led_on)
+    {
+        host_data.green_led_on  = false;
+        host_data.red_led_on    = false;
+        host_data.orange_led_on = false;
+        dev_host_private_traceLeds();
+    }
+}
+
+// dev_uv //
+void dev_uv_set_both(int pwm_duty, uint8_t dac_duty)
+{
+    dev_host_private_setUv(DEV_UV_LED_ROW,  pwm_duty, dac_duty);
+    dev_host_private_setUv(DEV_UV_LED_SIDE, pwm_duty, dac_duty);
+}
+
+void dev_uv_set_row(int pwm_duty, uint8_t dac_duty)
+{
+    dev_host_private_setUv(DEV_UV_LED_ROW, pwm_duty, dac_duty);
+}
+
+void dev_uv_set_side(int pwm_duty, uint8_t dac_duty)
+{
+    dev_host_private_setUv(DEV_UV_LED_SIDE, pwm_duty, dac_duty);
+}
+
+void dev_uv_stop()
+{
+    dev_uv_set_both(0, 0U);
+}
+
+void dev_uv_fw_shutdown()
+{
+    if (!host_data.uv_shutdown)
+    {
+        host_data.uv_shutdown = true;
+        host_trace_printf("[ HOST:UV ] fw shutdown\n");
+    }
+}
+
+void dev_uv_fw_shutdown_clear()
+{
+    if (host_data.uv_shutdown)
+    {
+        host_data.uv_shutdown = false;
+        host_trace_printf("[ HOST:UV ] fw shutdown clear\n");
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file    dev_host.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host device layer
+ *
+ * This document will contains the host side of lib/DEV:
+ *      the api the app layer calls is kept, the hardware reads are replaced by the inject functions below,
+ *      each one does what the device file does once the bus transfer is done (same queues, notifications and latches),
+ *      actuator commands are written to the trace when they change.
+ */
+
+#ifndef DEV_HOST_H
+#define DEV_HOST_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dev_avr_driver.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+// actuator side of the avr drivers, as the next command write would send it
+typedef struct{
+    bool                estop;          // requested or latched
+    bool                speed_control;
+    robot_motion_mode_E motion;
+    uint8_t             pwm[NUM_AVR_DRIVER];            // motor_pwm_duty_E
+    float               speed_mm_s[NUM_AVR_DRIVER];     // closed loop setpoint, quantized to ticks per speed window
+} dev_host_drive_S;
+
+typedef int32_t (*dev_host_battery_source_t)(void);
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void dev_host_init(void);
+/**
+ * @brief what dev_run50ms() does besides the bus transfers, trace the drive command on change
+ */
+void dev_host_run50ms(void);
+/**
+ * @brief what dev_run1000ms() does, the battery is read from the source when one is set
+ */
+void dev_host_run1000ms(void);
+/**
+ * @brief closed loop runs read the battery adc from here at 1Hz, a replay injects its recorded reads instead
+ */
+void dev_host_set_battery_source(dev_host_battery_source_t source);
+void dev_host_get_drive(dev_host_drive_S * drive);
+/**
+ * @brief dev_avr_driver_Estop_now() calls, the fast path e-stops
+ */
+uint32_t dev_host_get_estop_now_count(void);
+
+// inputs, call from a task at the time the firmware would have read them //
+/**
+ * @brief one status frame read from a driver, the encoder queue is pushed after the right side as in the 20ms update
+ */
+void dev_host_avr_driver_status(uint8_t side, const uint8_t * frame);
+/**
+ * @brief one good frame from the sensor avr, sync to crc
+ */
+void dev_host_avr_sensor_frame(const uint8_t * frame);
+void dev_host_tof_sample(uint8_t sensor, uint8_t label, uint8_t status, uint16_t dist_mm);
+void dev_host_imu_sample(const float * values);
+void dev_host_battery_raw(int32_t raw_adc);
+void dev_host_button_press(void);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //DEV_HOST_H
@@ -0,0 +1,276 @@
+/**
+ * @file    host_app.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the app task bodies of main.cpp on the host scheduler
+ */
+
+#include "host_app.h"
+
+// Std. Lib
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// TableUV Lib
+#include "common.h"
+#include "sys_telemetry.h"
+#include "sys_log.h"
+#include "sys_time.h"
+#include "APP/app_slam.h"
+#include "APP/app_supervisor.h"
+#include "APP/app_hazard.h"
+#include "APP/app_motion_script.h"
+
+// Host
+#include "dev_host.h"
+#include "host_trace.h"
+#include "host_rtos.h"
+
+// Host port
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define HOST_APP_50MS_TICK              (SYS_TIME_HZ_TO_TICK(20U))
+#define HOST_APP_1000MS_TICK            (SYS_TIME_HZ_TO_TICK(1U))
+#define HOST_APP_SLAM_TICK              (SYS_TIME_HZ_TO_TICK(10U))
+#define HOST_APP_TELEMETRY_DRAIN_MS     (10U) // as the cli poll
+#define HOST_APP_LOG_DRAIN_MS           (20U)
+#define HOST_APP_SETUP_STAGGER_MS       (50U)
+
+#if (FEATURE_SYS_TIME_FAULT)
+typedef struct{
+    sys_time_period_E   period;
+    int64_t             at_us;
+    uint32_t            late_ms;
+    uint16_t            count;
+} host_app_fault_S;
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+typedef struct{
+    FILE *              telemetry;
+    bool                log;
+#if (FEATURE_SYS_TIME_FAULT)
+    host_app_fault_S    fault[HOST_APP_FAULT_MAX];
+    uint8_t             fault_count;
+#endif // (FEATURE_SYS_TIME_FAULT)
+} host_app_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void host_app_private_drainTelemetry(void);
+static void host_app_task_hazard(void * param);
+static void host_app_task_supervisor(void * param);
+static void host_app_task_50ms(void * param);
+static void host_app_task_1000ms(void * param);
+static void host_app_task_slam(void * param);
+static void host_app_task_telemetry(void * param);
+static void host_app_task_log(void * param);
+#if (FEATURE_SYS_TIME_FAULT)
+static int  host_app_private_compareFault(const void * a, const void * b);
+static void host_app_task_fault(void * param);
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static host_app_data_S app_data;
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void host_app_private_drainTelemetry(void)
+{
+    const uint8_t * data;
+    size_t size;
+    while ((size = sys_telemetry_peek(&data, SIZE_MAX)) != 0U)
+    {
+        host_trace_digest(data, size);
+        if (app_data.telemetry != NULL)
+        {
+            fwrite(data, 1, size, app_data.telemetry);
+        }
+        sys_telemetry_consume(size);
+    }
+}
+
+static void host_app_task_hazard(void * param)
+{
+    app_hazard_run();
+}
+
+static void host_app_task_supervisor(void * param)
+{
+    app_supervisor_registerTask();
+    for( ;; )
+    {
+        app_supervisor_process(app_supervisor_waitForEvents());
+    }
+}
+
+static void host_app_task_50ms(void * param)
+{
+    sys_time_period_S period;
+    sys_time_period_start(&period, SYS_TIME_PERIOD_50MS, HOST_APP_50MS_TICK);
+    for( ;; )
+    {
+        dev_host_run50ms();
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+        app_motion_script_update();
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
+        sys_time_period_wait(&period);
+    }
+}
+
+static void host_app_task_1000ms(void * param)
+{
+    sys_time_period_S period;
+    sys_time_period_start(&period, SYS_TIME_PERIOD_1000MS, HOST_APP_1000MS_TICK);
+    for( ;; )
+    {
+        dev_host_run1000ms();
+        sys_time_period_wait(&period);
+    }
+}
+
+static void host_app_task_slam(void * param)
+{
+    sys_time_period_S period;
+    sys_time_period_start(&period, SYS_TIME_PERIOD_SLAM, HOST_APP_SLAM_TICK);
+    for( ;; )
+    {
+        app_slam_run100ms();
+        sys_time_period_wait(&period);
+    }
+}
+
+static void host_app_task_telemetry(void * param)
+{
+    for( ;; )
+    {
+        host_app_private_drainTelemetry();
+        sys_time_delay_ms(HOST_APP_TELEMETRY_DRAIN_MS);
+    }
+}
+
+static void host_app_task_log(void * param)
+{
+    for( ;; )
+    {
+        sys_log_drain();
+        sys_time_delay_ms(HOST_APP_LOG_DRAIN_MS);
+    }
+}
+
+#if (FEATURE_SYS_TIME_FAULT)
+static int host_app_private_compareFault(const void * a, const void * b)
+{
+    const int64_t at_a = ((const host_app_fault_S *)a)->at_us;
+    const int64_t at_b = ((const host_app_fault_S *)b)->at_us;
+    return (at_a > at_b) - (at_a < at_b);
+}
+
+// above the app tasks, a fault is armed before the release it targets
+static void host_app_task_fault(void * param)
+{
+    qsort(app_data.fault, app_data.fault_count, sizeof(app_data.fault[0]), host_app_private_compareFault);
+    for (uint8_t i = 0U; i < app_data.fault_count; i++)
+    {
+        const host_app_fault_S * fault = &app_data.fault[i];
+        host_rtos_sleep_until_us(fault->at_us);
+        host_trace_printf("[ HOST:TIME ] %s late %u ms x%u\n", sys_time_period_name(fault->period), (unsigned)fault->late_ms, fault->count);
+        sys_time_fault_late(fault->period, fault->late_ms, fault->count);
+    }
+    vTaskDelay(portMAX_DELAY);
+}
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void host_app_init(void)
+{
+    sys_telemetry_init();
+    sys_telemetry_enable(true);
+    app_slam_init();
+    app_supervisor_init();
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+    app_motion_script_init();
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
+#if (FEATURE_HAZARD_FAST_ESTOP)
+    app_hazard_init();
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
+}
+
+void host_app_start(bool log, FILE * telemetry)
+{
+    app_data.log       = log;
+    app_data.telemetry = telemetry;
+#if (FEATURE_SYS_TIME_FAULT)
+    if (app_data.fault_count > 0U)
+    {
+        xTaskCreate(host_app_task_fault,    "host_app_task_fault",      0U, NULL, HOST_APP_INPUT_PRIORITY + 1U, NULL);
+    }
+#endif // (FEATURE_SYS_TIME_FAULT)
+#if (FEATURE_HAZARD_FAST_ESTOP)
+    xTaskCreate(host_app_task_hazard,       "core0_task_runHazard",     0U, NULL, 6, NULL);
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
+    xTaskCreate(host_app_task_supervisor,   "core0_task_runSupervisor", 0U, NULL, 4, NULL);
+    xTaskCreate(host_app_task_50ms,         "core0_task_run50ms",       0U, NULL, 1, NULL);
+    sys_time_delay_ms(HOST_APP_SETUP_STAGGER_MS);
+    xTaskCreate(host_app_task_1000ms,       "core0_task_run1000ms",     0U, NULL, 3, NULL);
+    sys_time_delay_ms(HOST_APP_SETUP_STAGGER_MS);
+    xTaskCreate(host_app_task_slam,         "core1_task_runSLAM",       0U, NULL, 1, NULL);
+    sys_time_delay_ms(HOST_APP_SETUP_STAGGER_MS);
+    xTaskCreate(host_app_task_telemetry,    "loopTask",                 0U, NULL, 1, NULL);
+    if (log)
+    {
+        xTaskCreate(host_app_task_log,      "core0_task_runLog",        0U, NULL, tskIDLE_PRIORITY, NULL);
+    }
+}
+
+void host_app_flush(void)
+{
+    host_app_private_drainTelemetry();
+    if (app_data.log)
+    {
+        sys_log_drain();
+    }
+}
+
+bool host_app_add_fault(const char * spec)
+{
+#if (FEATURE_SYS_TIME_FAULT)
+    char name[16];
+    double at_s;
+    unsigned late_ms;
+    unsigned count = 1U;
+    const int fields = sscanf(spec, "%15[^,],%lf,%u,%u", name, &at_s, &late_ms, &count);
+    if ((fields < 3) || (app_data.fault_count >= HOST_APP_FAULT_MAX))
+    {
+        return false;
+    }
+    for (uint8_t id = 0U; id < SYS_TIME_PERIOD_COUNT; id++)
+    {
+        if (strcmp(name, sys_time_period_name((sys_time_period_E)id)) == 0)
+        {
+            host_app_fault_S * fault = &app_data.fault[app_data.fault_count++];
+            fault->period  = (sys_time_period_E)id;
+            fault->at_us   = (int64_t)(at_s * 1e6);
+            fault->late_ms = late_ms;
+            fault->count   = (uint16_t)count;
+            return true;
+        }
+    }
+    return false;
+#else
+    (void)spec;
+    return false;
+#endif // (FEATURE_SYS_TIME_FAULT)
+}
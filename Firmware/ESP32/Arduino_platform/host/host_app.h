@@ -0,0 +1,51 @@
+/**
+ * @file    host_app.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the app layer bring up shared by the host tools, as setup() and esp32_task_init() do it
+ */
+
+#ifndef HOST_APP_H
+#define HOST_APP_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define HOST_APP_INPUT_PRIORITY         (7U) // above the hazard task, an input lands before anyone reacts to it
+#define HOST_APP_FAULT_MAX              (8U)
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+/**
+ * @brief sys and app level init, call from the first task
+ */
+void host_app_init(void);
+/**
+ * @brief create the app tasks with the staggers of esp32_task_init(), blocks the caller ~150ms
+ * @param log: also drain sys_log to stdout
+ * @param telemetry: the telemetry stream is written here when not NULL, always digested
+ */
+void host_app_start(bool log, FILE * telemetry);
+/**
+ * @brief schedule a late release fault before host_app_start(), false if 'spec' does not parse
+ * @param spec: "<50ms|1000ms|slam>,<at_s>,<late_ms>[,<count>]", at_s is esp_timer time
+ */
+bool host_app_add_fault(const char * spec);
+/**
+ * @brief what is left in the telemetry ring and the log, at the end of a run
+ */
+void host_app_flush(void);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_APP_H
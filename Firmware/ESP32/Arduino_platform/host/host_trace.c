@@ -0,0 +1,102 @@
+/**
+ * @file    host_trace.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the output trace of a host run, digested with 64 bit FNV-1a
+ */
+
+#include "host_trace.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <stdarg.h>
+#include <inttypes.h>
+
+// Host port
+#include "host_rtos.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define HOST_TRACE_FNV_OFFSET           (0xCBF29CE484222325ULL)
+#define HOST_TRACE_FNV_PRIME            (0x00000100000001B3ULL)
+#define HOST_TRACE_LINE_SIZE            (256U)
+
+typedef struct{
+    FILE *      file;
+    uint64_t    digest;
+} host_trace_data_S;
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static host_trace_data_S trace_data = {
+    .file   = NULL,
+    .digest = HOST_TRACE_FNV_OFFSET,
+};
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void host_trace_open(const char * path)
+{
+    host_trace_close();
+    trace_data.digest = HOST_TRACE_FNV_OFFSET;
+    if (path != NULL)
+    {
+        trace_data.file = fopen(path, "w");
+        if (trace_data.file == NULL)
+        {
+            fprintf(stderr, "[ TRACE ] cannot open %s\n", path);
+        }
+    }
+}
+
+void host_trace_close(void)
+{
+    if (trace_data.file != NULL)
+    {
+        fclose(trace_data.file);
+        trace_data.file = NULL;
+    }
+}
+
+void host_trace_printf(const char * format, ...)
+{
+    char line[HOST_TRACE_LINE_SIZE];
+    const int64_t now_us = host_rtos_now_us();
+    int length = snprintf(line, sizeof(line), "%" PRId64 ".%06" PRId64 " ", now_us / 1000000, now_us % 1000000);
+
+    va_list args;
+    va_start(args, format);
+    const int written = vsnprintf(&line[length], sizeof(line) - (size_t)length, format, args);
+    va_end(args);
+    length += written;
+    if (length >= (int)sizeof(line))
+    {
+        length = sizeof(line) - 1;
+    }
+
+    host_trace_digest(line, (size_t)length);
+    if (trace_data.file != NULL)
+    {
+        fwrite(line, 1, (size_t)length, trace_data.file);
+    }
+}
+
+void host_trace_digest(const void * data, size_t size)
+{
+    const uint8_t * bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        trace_data.digest ^= bytes[i];
+        trace_data.digest *= HOST_TRACE_FNV_PRIME;
+    }
+}
+
+uint64_t host_trace_get_digest(void)
+{
+    return trace_data.digest;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file    host_trace.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the output trace of a host run:
+ *      every actuator command and every telemetry byte is folded into one digest,
+ *      two runs of the same input log agree on it or the firmware is not deterministic.
+ */
+
+#ifndef HOST_TRACE_H
+#define HOST_TRACE_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+/**
+ * @brief reset the digest, lines are also written to 'path' when it is not NULL
+ */
+void        host_trace_open(const char * path);
+void        host_trace_close(void);
+/**
+ * @brief one line stamped with the virtual time, part of the digest
+ */
+void        host_trace_printf(const char * format, ...) __attribute__((format(printf, 1, 2)));
+void        host_trace_digest(const void * data, size_t size);
+uint64_t    host_trace_get_digest(void);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_TRACE_H
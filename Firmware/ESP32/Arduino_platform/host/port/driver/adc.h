@@ -0,0 +1,12 @@
+/**
+ * @file    adc.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains nothing, dev headers include it but the host dev layer does not touch the pins
+ */
+
+#ifndef HOST_DRIVER_ADC_H
+#define HOST_DRIVER_ADC_H
+#endif //HOST_DRIVER_ADC_H
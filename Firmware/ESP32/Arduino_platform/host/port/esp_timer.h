@@ -0,0 +1,53 @@
+/**
+ * @file    esp_timer.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains the esp_timer api on the virtual clock of the host scheduler
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+typedef int esp_err_t;
+#define ESP_OK                      (0)
+#define ESP_FAIL                    (-1)
+#define ESP_ERR_INVALID_STATE       (0x103)
+
+typedef struct host_timer_S * esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void * arg);
+
+typedef enum{
+    ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct{
+    esp_timer_cb_t          callback;
+    void *                  arg;
+    esp_timer_dispatch_t    dispatch_method;
+    const char *            name;
+} esp_timer_create_args_t;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+int64_t     esp_timer_get_time(void);
+esp_err_t   esp_timer_create(const esp_timer_create_args_t * args, esp_timer_handle_t * handle);
+esp_err_t   esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t   esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+esp_err_t   esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t   esp_timer_delete(esp_timer_handle_t timer);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_ESP_TIMER_H
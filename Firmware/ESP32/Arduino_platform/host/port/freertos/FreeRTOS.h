@@ -0,0 +1,57 @@
+/**
+ * @file    FreeRTOS.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains the FreeRTOS types and port macros the app and sys layer use,
+ * backed by the single threaded discrete event scheduler of host_rtos.c
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define configTICK_RATE_HZ                  (1000U) // CONFIG_FREERTOS_HZ of the arduino-esp32 sdk
+#define configSUPPORT_STATIC_ALLOCATION     (1U)
+#define portTICK_PERIOD_MS                  (1000U / configTICK_RATE_HZ)
+#define portMAX_DELAY                       (0xFFFFFFFFU)
+#define portNUM_PROCESSORS                  (1U)    // one core, tasks only switch where they block
+#define pdMS_TO_TICKS(ms)                   ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000U))
+#define pdTRUE                              (1)
+#define pdFALSE                             (0)
+#define pdPASS                              (pdTRUE)
+#define pdFAIL                              (pdFALSE)
+#define tskIDLE_PRIORITY                    (0U)
+
+typedef uint32_t    TickType_t;
+typedef int         BaseType_t;
+typedef unsigned    UBaseType_t;
+typedef uint8_t     StackType_t;
+typedef int         portMUX_TYPE;
+
+// nothing preempts a running task, critical sections and interrupt masks are no-ops
+#define portMUX_INITIALIZER_UNLOCKED        (0)
+#define portENTER_CRITICAL(mux)             ((void)(mux))
+#define portEXIT_CRITICAL(mux)              ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux)         ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)          ((void)(mux))
+#define portSET_INTERRUPT_MASK_FROM_ISR()   (0U)
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(state) ((void)(state))
+#define portYIELD_FROM_ISR()                do {} while (0)
+#define xPortGetCoreID()                    (0)
+#define IRAM_ATTR
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_FREERTOS_H
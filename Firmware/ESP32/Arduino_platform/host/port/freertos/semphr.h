@@ -0,0 +1,34 @@
+/**
+ * @file    semphr.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains the binary semaphore and mutex api of the host scheduler
+ */
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include "FreeRTOS.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+typedef struct host_semaphore_S * SemaphoreHandle_t;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+SemaphoreHandle_t   xSemaphoreCreateBinary(void);   // created empty, as on the target
+SemaphoreHandle_t   xSemaphoreCreateMutex(void);    // created available
+BaseType_t          xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t          xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_SEMPHR_H
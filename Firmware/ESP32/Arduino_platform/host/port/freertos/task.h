@@ -0,0 +1,48 @@
+/**
+ * @file    task.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains the task and task notification api of the host scheduler
+ */
+
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include "FreeRTOS.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+typedef struct host_task_S * TaskHandle_t;
+typedef void (*TaskFunction_t)(void * param);
+
+typedef enum{
+    eNoAction,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+} eNotifyAction;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+BaseType_t  xTaskCreate(TaskFunction_t function, const char * name, uint32_t stack_size, void * param,
+                UBaseType_t priority, TaskHandle_t * handle);
+void        vTaskDelay(TickType_t ticks);
+void        vTaskDelayUntil(TickType_t * last_wake, TickType_t increment);
+TickType_t  xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char * pcTaskGetTaskName(TaskHandle_t task);
+BaseType_t  xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t  xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t * woken);
+BaseType_t  xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t * value, TickType_t ticks);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_TASK_H
@@ -0,0 +1,518 @@
+/**
+ * @file    host_rtos.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port files
+ *
+ * This document will contains the discrete event scheduler:
+ *      the highest priority ready task runs first, equal priorities in the order they became ready,
+ *      a notification to a higher priority task switches to it right away as the target would,
+ *      esp_timer callbacks run from the scheduler before any task due at the same time.
+ */
+
+#define _GNU_SOURCE
+#include "host_rtos.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+// Host port
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define HOST_RTOS_FOREVER               (INT64_MAX)
+#define HOST_RTOS_US_PER_TICK           (1000LL * portTICK_PERIOD_MS)
+
+struct host_task_S{
+    ucontext_t          context;
+    void *              stack;
+    TaskFunction_t      function;
+    void *              param;
+    const char *        name;
+    UBaseType_t         priority;
+    bool                blocked;
+    bool                finished;       // the task function returned
+    bool                wait_notify;    // blocked in xTaskNotifyWait, a notification wakes it
+    int64_t             wake_us;        // blocked until, HOST_RTOS_FOREVER for no timeout
+    uint64_t            ready_order;    // first in first out among equal priorities
+    uint32_t            notify_value;
+    bool                notify_pending;
+    uint32_t            runs;
+    double              cpu_s;
+};
+
+struct host_timer_S{
+    esp_timer_cb_t      callback;
+    void *              arg;
+    bool                armed;
+    int64_t             expiry_us;
+    int64_t             period_us;      // 0 for one shot
+};
+
+struct host_semaphore_S{
+    bool                available;
+};
+
+typedef struct{
+    ucontext_t          scheduler;
+    struct host_task_S  task[HOST_RTOS_TASK_MAX];
+    uint8_t             task_count;
+    struct host_timer_S timer[HOST_RTOS_TIMER_MAX];
+    uint8_t             timer_count;
+    struct host_task_S * current;       // NULL while the scheduler or a timer callback runs
+    int64_t             now_us;
+    uint64_t            order;
+    bool                stop;
+} host_rtos_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void     host_rtos_private_entry(int index);
+static void     host_rtos_private_ready(struct host_task_S * task);
+static void     host_rtos_private_block(int64_t wake_us, bool wait_notify);
+static void     host_rtos_private_yield(void);
+static int64_t  host_rtos_private_tickToUs(TickType_t tick);
+static bool     host_rtos_private_fireTimer(void);
+static struct host_task_S * host_rtos_private_pick(void);
+static double   host_rtos_private_wallClock(void);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static host_rtos_data_S rtos_data;
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void host_rtos_private_entry(int index)
+{
+    struct host_task_S * task = &rtos_data.task[index];
+    task->function(task->param);
+    // a returning task is deleted on the target, here it never runs again
+    task->finished = true;
+    task->blocked  = true;
+    task->wake_us  = HOST_RTOS_FOREVER;
+    swapcontext(&task->context, &rtos_data.scheduler);
+}
+
+static void host_rtos_private_ready(struct host_task_S * task)
+{
+    task->blocked     = false;
+    task->wait_notify = false;
+    task->wake_us     = HOST_RTOS_FOREVER;
+    task->ready_order = rtos_data.order ++;
+}
+
+static void host_rtos_private_block(int64_t wake_us, bool wait_notify)
+{
+    struct host_task_S * task = rtos_data.current;
+    task->blocked     = true;
+    task->wait_notify = wait_notify;
+    task->wake_us     = wake_us;
+    swapcontext(&task->context, &rtos_data.scheduler);
+}
+
+// stays ready at its place in the order, a higher priority task runs first
+static void host_rtos_private_yield(void)
+{
+    swapcontext(&rtos_data.current->context, &rtos_data.scheduler);
+}
+
+static int64_t host_rtos_private_tickToUs(TickType_t tick)
+{
+    return (int64_t)tick * HOST_RTOS_US_PER_TICK;
+}
+
+// the earliest due timer, timers due at the same time in creation order
+static bool host_rtos_private_fireTimer(void)
+{
+    struct host_timer_S * due = NULL;
+    for (uint8_t i = 0; i < rtos_data.timer_count; i++)
+    {
+        struct host_timer_S * timer = &rtos_data.timer[i];
+        if (timer->armed && (timer->expiry_us <= rtos_data.now_us) && ((due == NULL) || (timer->expiry_us < due->expiry_us)))
+        {
+            due = timer;
+        }
+    }
+    if (due == NULL)
+    {
+        return false;
+    }
+    if (due->period_us != 0)
+    {
+        due->expiry_us += due->period_us;
+    }
+    else
+    {
+        due->armed = false;
+    }
+    due->callback(due->arg);
+    return true;
+}
+
+static struct host_task_S * host_rtos_private_pick(void)
+{
+    struct host_task_S * pick = NULL;
+    for (uint8_t i = 0; i < rtos_data.task_count; i++)
+    {
+        struct host_task_S * task = &rtos_data.task[i];
+        if (task->blocked && (!task->finished) && (task->wake_us <= rtos_data.now_us))
+        {
+            host_rtos_private_ready(task);
+        }
+    }
+    for (uint8_t i = 0; i < rtos_data.task_count; i++)
+    {
+        struct host_task_S * task = &rtos_data.task[i];
+        if (task->blocked)
+        {
+            continue;
+        }
+        if ((pick == NULL) || (task->priority > pick->priority)
+            || ((task->priority == pick->priority) && (task->ready_order < pick->ready_order)))
+        {
+            pick = task;
+        }
+    }
+    return pick;
+}
+
+static double host_rtos_private_wallClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void host_rtos_init(int64_t start_us)
+{
+    for (uint8_t i = 0; i < rtos_data.task_count; i++)
+    {
+        free(rtos_data.task[i].stack);
+    }
+    memset(&rtos_data, 0, sizeof(rtos_data));
+    rtos_data.now_us = start_us;
+}
+
+void host_rtos_run(void)
+{
+    while (!rtos_data.stop)
+    {
+        if (host_rtos_private_fireTimer())
+        {
+            continue;
+        }
+        struct host_task_S * task = host_rtos_private_pick();
+        if (task != NULL)
+        {
+            const double start_s = host_rtos_private_wallClock();
+            rtos_data.current = task;
+            task->runs ++;
+            swapcontext(&rtos_data.scheduler, &task->context);
+            rtos_data.current = NULL;
+            task->cpu_s += host_rtos_private_wallClock() - start_s;
+            continue;
+        }
+
+        // everyone is blocked, jump to the next wake up
+        int64_t next_us = HOST_RTOS_FOREVER;
+        for (uint8_t i = 0; i < rtos_data.task_count; i++)
+        {
+            if ((!rtos_data.task[i].finished) && (rtos_data.task[i].wake_us < next_us))
+            {
+                next_us = rtos_data.task[i].wake_us;
+            }
+        }
+        for (uint8_t i = 0; i < rtos_data.timer_count; i++)
+        {
+            if (rtos_data.timer[i].armed && (rtos_data.timer[i].expiry_us < next_us))
+            {
+                next_us = rtos_data.timer[i].expiry_us;
+            }
+        }
+        if (next_us == HOST_RTOS_FOREVER)
+        {
+            break;
+        }
+        rtos_data.now_us = next_us;
+    }
+}
+
+void host_rtos_stop(void)
+{
+    rtos_data.stop = true;
+}
+
+int64_t host_rtos_now_us(void)
+{
+    return rtos_data.now_us;
+}
+
+void host_rtos_sleep_until_us(int64_t wake_us)
+{
+    if (wake_us > rtos_data.now_us)
+    {
+        host_rtos_private_block(wake_us, false);
+    }
+}
+
+uint8_t host_rtos_get_task_stats(host_rtos_task_stats_S * stats, uint8_t max)
+{
+    uint8_t count = 0U;
+    for (; (count < rtos_data.task_count) && (count < max); count++)
+    {
+        stats[count].name     = rtos_data.task[count].name;
+        stats[count].priority = (uint8_t)rtos_data.task[count].priority;
+        stats[count].runs     = rtos_data.task[count].runs;
+        stats[count].cpu_s    = rtos_data.task[count].cpu_s;
+    }
+    return count;
+}
+
+// FreeRTOS //
+BaseType_t xTaskCreate(TaskFunction_t function, const char * name, uint32_t stack_size, void * param,
+    UBaseType_t priority, TaskHandle_t * handle)
+{
+    (void)stack_size;
+    if (rtos_data.task_count >= HOST_RTOS_TASK_MAX)
+    {
+        return pdFAIL;
+    }
+    const uint8_t index = rtos_data.task_count ++;
+    struct host_task_S * task = &rtos_data.task[index];
+    memset(task, 0, sizeof(*task));
+    task->stack    = malloc(HOST_RTOS_STACK_SIZE);
+    task->function = function;
+    task->param    = param;
+    task->name     = name;
+    task->priority = priority;
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp   = task->stack;
+    task->context.uc_stack.ss_size = HOST_RTOS_STACK_SIZE;
+    task->context.uc_link          = &rtos_data.scheduler;
+    makecontext(&task->context, (void (*)(void))host_rtos_private_entry, 1, (int)index);
+    host_rtos_private_ready(task);
+    if (handle != NULL)
+    {
+        *handle = task;
+    }
+    if ((rtos_data.current != NULL) && (priority > rtos_data.current->priority))
+    {
+        host_rtos_private_yield();
+    }
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0U)
+    {
+        rtos_data.current->ready_order = rtos_data.order ++; // behind the equal priorities
+        host_rtos_private_yield();
+        return;
+    }
+    host_rtos_private_block(host_rtos_private_tickToUs(xTaskGetTickCount() + ticks), false);
+}
+
+void vTaskDelayUntil(TickType_t * last_wake, TickType_t increment)
+{
+    const TickType_t wake = *last_wake + increment;
+    *last_wake = wake;
+    if ((TickType_t)(wake - xTaskGetTickCount() - 1U) < increment)
+    {
+        host_rtos_private_block(host_rtos_private_tickToUs(wake), false);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(rtos_data.now_us / HOST_RTOS_US_PER_TICK);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return rtos_data.current;
+}
+
+const char * pcTaskGetTaskName(TaskHandle_t task)
+{
+    return (task != NULL) ? task->name : rtos_data.current->name;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    switch (action)
+    {
+        case (eSetBits):
+            task->notify_value |= value;
+            break;
+        case (eIncrement):
+            task->notify_value ++;
+            break;
+        case (eSetValueWithOverwrite):
+            task->notify_value = value;
+            break;
+        case (eNoAction):
+        default:
+            break;
+    }
+    task->notify_pending = true;
+    if (task->blocked && task->wait_notify)
+    {
+        host_rtos_private_ready(task);
+        if ((rtos_data.current != NULL) && (task->priority > rtos_data.current->priority))
+        {
+            host_rtos_private_yield();
+        }
+    }
+    return pdPASS;
+}
+
+// interrupts are delivered from the scheduler, the switch happens when it picks the next task
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t * woken)
+{
+    struct host_task_S * current = rtos_data.current;
+    rtos_data.current = NULL;
+    xTaskNotify(task, value, action);
+    rtos_data.current = current;
+    if (woken != NULL)
+    {
+        *woken = pdFALSE;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t * value, TickType_t ticks)
+{
+    struct host_task_S * task = rtos_data.current;
+    if (!task->notify_pending)
+    {
+        task->notify_value &= ~clear_on_entry;
+        if (ticks != 0U)
+        {
+            const int64_t wake_us = (ticks == portMAX_DELAY) ? HOST_RTOS_FOREVER
+                : host_rtos_private_tickToUs(xTaskGetTickCount() + ticks);
+            host_rtos_private_block(wake_us, true);
+        }
+    }
+    if (value != NULL)
+    {
+        *value = task->notify_value;
+    }
+    if (!task->notify_pending)
+    {
+        return pdFALSE;
+    }
+    task->notify_value  &= ~clear_on_exit;
+    task->notify_pending = false;
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    SemaphoreHandle_t semaphore = calloc(1U, sizeof(*semaphore));
+    semaphore->available = false;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t semaphore = calloc(1U, sizeof(*semaphore));
+    semaphore->available = true;
+    return semaphore;
+}
+
+// the holder only lets go at its next block, a waiter re-checks every tick
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    const TickType_t start = xTaskGetTickCount();
+    while (!semaphore->available)
+    {
+        if ((rtos_data.current == NULL) || ((TickType_t)(xTaskGetTickCount() - start) >= ticks))
+        {
+            return pdFALSE;
+        }
+        host_rtos_private_block(host_rtos_private_tickToUs(xTaskGetTickCount() + 1U), false);
+    }
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    semaphore->available = true;
+    return pdTRUE;
+}
+
+// esp_timer //
+int64_t esp_timer_get_time(void)
+{
+    return rtos_data.now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t * args, esp_timer_handle_t * handle)
+{
+    if (rtos_data.timer_count >= HOST_RTOS_TIMER_MAX)
+    {
+        return ESP_FAIL;
+    }
+    struct host_timer_S * timer = &rtos_data.timer[rtos_data.timer_count ++];
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = args->callback;
+    timer->arg      = args->arg;
+    *handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed     = true;
+    timer->expiry_us = rtos_data.now_us + (int64_t)timeout_us;
+    timer->period_us = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed     = true;
+    timer->expiry_us = rtos_data.now_us + (int64_t)period_us;
+    timer->period_us = (int64_t)period_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    timer->armed    = false;
+    timer->callback = NULL;
+    return ESP_OK;
+}
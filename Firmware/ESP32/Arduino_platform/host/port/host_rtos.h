@@ -0,0 +1,60 @@
+/**
+ * @file    host_rtos.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains the discrete event scheduler behind the host FreeRTOS and esp_timer api:
+ *      tasks are coroutines on one thread, a task runs until it blocks and no time passes while it runs,
+ *      the virtual clock jumps to the next wake up, so a run is deterministic and as fast as the cpu allows.
+ */
+
+#ifndef HOST_RTOS_H
+#define HOST_RTOS_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define HOST_RTOS_TASK_MAX              (16U)
+#define HOST_RTOS_TIMER_MAX             (8U)
+#define HOST_RTOS_STACK_SIZE            (256U * 1024U) // the target budgets do not apply here
+
+typedef struct{
+    const char *    name;
+    uint8_t         priority;
+    uint32_t        runs;           // times the task was switched in
+    double          cpu_s;          // wall clock spent in the task
+} host_rtos_task_stats_S;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+/**
+ * @brief reset the scheduler, the virtual clock starts at 'start_us' (esp_timer time)
+ */
+void    host_rtos_init(int64_t start_us);
+/**
+ * @brief run the created tasks until host_rtos_stop() or until nothing can wake up anymore
+ */
+void    host_rtos_run(void);
+void    host_rtos_stop(void);
+int64_t host_rtos_now_us(void);
+/**
+ * @brief block the calling task until 'wake_us', finer than a tick, for input injection
+ */
+void    host_rtos_sleep_until_us(int64_t wake_us);
+uint8_t host_rtos_get_task_stats(host_rtos_task_stats_S * stats, uint8_t max);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //HOST_RTOS_H
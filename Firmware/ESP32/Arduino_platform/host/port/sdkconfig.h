@@ -0,0 +1,17 @@
+/**
+ * @file    sdkconfig.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host port
+ *
+ * This document will contains the sdk options the host build reads, values of the esp32dev target
+ */
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_FREERTOS_HZ                      (1000)
+#define CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ       (240)
+#define CONFIG_SUPPORT_STATIC_ALLOCATION        (1)
+
+#endif //HOST_SDKCONFIG_H
@@ -0,0 +1,283 @@
+/**
+ * @file    replay.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the replay of a sys_recorder log through the real app layer:
+ *      the recorded inputs are injected at their recorded esp_timer time, the app tasks run on the
+ *      discrete event scheduler of host_rtos.c, the actuator commands and telemetry are traced and digested.
+ *
+ *  usage: replay <recorder.bin> [--trace <file>] [--telemetry <file>] [--late <period>,<at_s>,<late_ms>[,<count>]]... [--verbose]
+ *      recorder.bin is what tools/telemetry_decoder.py writes for "rec serial" or "rec dump",
+ *      record from boot, the replay starts the app layer from its boot state,
+ *      --late releases a periodic body (50ms, 1000ms, slam) late from 'at_s' esp_timer time on.
+ */
+
+// Std. Lib
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+// TableUV Lib
+#include "common.h"
+#include "sys_recorder.h"
+
+// Host
+#include "dev_host.h"
+#include "host_app.h"
+#include "host_trace.h"
+#include "host_rtos.h"
+
+// Host port
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define REPLAY_LEAD_IN_US               (100000LL)  // boot before the first record
+#define REPLAY_TAIL_US                  (1000000LL) // run on after the last record
+
+typedef struct{
+    const sys_recorder_block_S *    blocks;
+    uint32_t                        block_count;
+    uint32_t                        records[SYS_RECORDER_TYPE_COUNT];
+    uint32_t                        lost_blocks;
+    uint32_t                        dropped_records;
+    uint32_t                        bad_records;
+    FILE *                          telemetry;
+    bool                            verbose;
+} replay_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static bool replay_private_load(const char * path);
+static void replay_private_inject(sys_recorder_type_E type, const uint8_t * payload);
+static void replay_task_feeder(void * param);
+static void replay_task_setup(void * param);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static replay_data_S replay_data;
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+// blocks back to back, the log ends at the first block without the magic (erased flash)
+static bool replay_private_load(const char * path)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "[ REPLAY ] cannot open %s\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    sys_recorder_block_S * blocks = malloc((size_t)size + sizeof(sys_recorder_block_S));
+    const uint32_t count = (uint32_t)(fread(blocks, 1, (size_t)size, file) / sizeof(sys_recorder_block_S));
+    fclose(file);
+
+    uint32_t block = 0U;
+    for (; block < count; block++)
+    {
+        if (blocks[block].magic != SYS_RECORDER_BLOCK_MAGIC)
+        {
+            break;
+        }
+        if (block > 0U)
+        {
+            replay_data.lost_blocks += (uint16_t)(blocks[block].sequence - blocks[block - 1U].sequence - 1U);
+        }
+        replay_data.dropped_records += blocks[block].dropped;
+    }
+    replay_data.blocks      = blocks;
+    replay_data.block_count = block;
+    return (block > 0U);
+}
+
+static void replay_private_inject(sys_recorder_type_E type, const uint8_t * payload)
+{
+    switch (type)
+    {
+        case (SYS_RECORDER_DRIVER_STATUS):
+            dev_host_avr_driver_status(payload[0], &payload[1]);
+            break;
+        case (SYS_RECORDER_TOF):
+        {
+            sys_recorder_tof_S tof;
+            memcpy(&tof, payload, sizeof(tof));
+            dev_host_tof_sample(tof.sensor, tof.label, tof.status, tof.dist_mm);
+            break;
+        }
+        case (SYS_RECORDER_AVR_SENSOR):
+            dev_host_avr_sensor_frame(payload);
+            break;
+        case (SYS_RECORDER_IMU):
+        {
+            float values[SYS_RECORDER_IMU_AXIS_COUNT];
+            memcpy(values, payload, sizeof(values));
+            dev_host_imu_sample(values);
+            break;
+        }
+        case (SYS_RECORDER_BATTERY):
+        {
+            int32_t raw;
+            memcpy(&raw, payload, sizeof(raw));
+            dev_host_battery_raw(raw);
+            break;
+        }
+        case (SYS_RECORDER_BUTTON):
+            dev_host_button_press();
+            break;
+        default:
+            break;
+    }
+}
+
+// highest priority, an input lands at its recorded time before anyone reacts to it
+static void replay_task_feeder(void * param)
+{
+    int64_t last_us = 0;
+    for (uint32_t block = 0U; block < replay_data.block_count; block++)
+    {
+        const sys_recorder_block_S * b = &replay_data.blocks[block];
+        int64_t stamp_us = b->stamp_us;
+        uint8_t offset = 0U;
+        while (offset < b->length)
+        {
+            const sys_recorder_type_E type = (sys_recorder_type_E)b->records[offset++];
+            const uint8_t size = sys_recorder_payload_size(type);
+            uint32_t delta = 0U;
+            uint8_t shift = 0U;
+            while ((offset < b->length) && (b->records[offset] & 0x80U))
+            {
+                delta |= (uint32_t)(b->records[offset++] & 0x7FU) << shift;
+                shift += 7U;
+            }
+            if ((size == 0xFFU) || (offset >= b->length) || ((uint32_t)offset + 1U + size > b->length))
+            {
+                replay_data.bad_records ++;
+                break;
+            }
+            delta |= (uint32_t)b->records[offset++] << shift;
+            stamp_us += delta;
+
+            host_rtos_sleep_until_us(stamp_us);
+            replay_private_inject(type, &b->records[offset]);
+            replay_data.records[type] ++;
+            offset += size;
+            last_us = stamp_us;
+        }
+    }
+    host_rtos_sleep_until_us(last_us + REPLAY_TAIL_US);
+    host_rtos_stop();
+}
+
+// the feeder comes first so no input is late
+static void replay_task_setup(void * param)
+{
+    host_app_init();
+    xTaskCreate(replay_task_feeder, "replay_task_feeder", 0U, NULL, HOST_APP_INPUT_PRIORITY, NULL);
+    host_app_start(replay_data.verbose, replay_data.telemetry);
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    const char * input = NULL;
+    const char * trace = NULL;
+    const char * telemetry = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+        {
+            trace = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--telemetry") == 0) && (i + 1 < argc))
+        {
+            telemetry = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--late") == 0) && (i + 1 < argc))
+        {
+            if (!host_app_add_fault(argv[++i]))
+            {
+                input = NULL;
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--verbose") == 0)
+        {
+            replay_data.verbose = true;
+        }
+        else if (input == NULL)
+        {
+            input = argv[i];
+        }
+    }
+    if (input == NULL)
+    {
+        fprintf(stderr, "usage: %s <recorder.bin> [--trace <file>] [--telemetry <file>] [--late <period>,<at_s>,<late_ms>[,<count>]]... [--verbose]\n", argv[0]);
+        return 2;
+    }
+    if (!replay_private_load(input))
+    {
+        fprintf(stderr, "[ REPLAY ] no recorder block in %s\n", input);
+        return 1;
+    }
+    if (telemetry != NULL)
+    {
+        replay_data.telemetry = fopen(telemetry, "wb");
+    }
+
+    const int64_t start_us = replay_data.blocks[0].stamp_us - REPLAY_LEAD_IN_US;
+    host_rtos_init(start_us);
+    host_trace_open(trace);
+    dev_host_init();
+    xTaskCreate(replay_task_setup, "setup", 0U, NULL, 8, NULL);
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    host_rtos_run();
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    host_app_flush();
+
+    const double wall_s = (double)(wall_end.tv_sec - wall_start.tv_sec) + (double)(wall_end.tv_nsec - wall_start.tv_nsec) * 1e-9;
+    const double virtual_s = (double)(host_rtos_now_us() - start_us) * 1e-6;
+    static const char * const type_name[SYS_RECORDER_TYPE_COUNT] = {
+        "driver", "tof", "avr_sensor", "imu", "battery", "button",
+    };
+    printf("[ REPLAY ] blocks: %" PRIu32 " lost: %" PRIu32 " dropped records: %" PRIu32 " bad: %" PRIu32 "\n",
+        replay_data.block_count, replay_data.lost_blocks, replay_data.dropped_records, replay_data.bad_records);
+    for (uint8_t type = 0U; type < SYS_RECORDER_TYPE_COUNT; type++)
+    {
+        printf("[ REPLAY ] %-10s %8" PRIu32 "\n", type_name[type], replay_data.records[type]);
+    }
+    printf("[ REPLAY ] %.3f s replayed in %.3f s (x%.0f)\n", virtual_s, wall_s, (wall_s > 0.0) ? (virtual_s / wall_s) : 0.0);
+
+    host_rtos_task_stats_S stats[HOST_RTOS_TASK_MAX];
+    const uint8_t tasks = host_rtos_get_task_stats(stats, HOST_RTOS_TASK_MAX);
+    for (uint8_t task = 0U; task < tasks; task++)
+    {
+        printf("[ REPLAY ] %-26s prio: %d runs: %8" PRIu32 " cpu: %8.3f ms\n",
+            stats[task].name, stats[task].priority, stats[task].runs, stats[task].cpu_s * 1e3);
+    }
+    printf("[ REPLAY ] digest: %016" PRIx64 "\n", host_trace_get_digest());
+
+    host_trace_close();
+    if (replay_data.telemetry != NULL)
+    {
+        fclose(replay_data.telemetry);
+    }
+    free((void *)replay_data.blocks);
+    return 0;
+}
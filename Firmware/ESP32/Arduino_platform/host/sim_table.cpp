@@ -0,0 +1,620 @@
+/**
+ * @file    sim_table.cpp
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host simulator
+ *
+ * This document will contains the tabletop world of the host simulator, stepped by one task on the virtual clock:
+ *      - drive: each wheel follows the command of dev_host_get_drive() with a first order lag,
+ *               open loop duty is scaled by SIM_TABLE_MOTOR_FULL_DUTY_MM_S, speed control reaches its setpoint
+ *      - sensor avr: the six cliff channels at their edge node mounts, raw 8 bit readings tripped with the
+ *               levels and hysteresis of AVR_SENSOR/lib/sensor_filter, bumpers on front contact, a frame every 20ms and on change
+ *      - avr drivers: status frames every 50ms with the free running encoder count of each wheel
+ *      - ToF: one sample per sensor per dev cycle, the firing frame ray cast against the obstacles
+ *      - battery: a fixed voltage read by the 1000ms body
+ *
+ *  The wheel speed at full duty, the motor lag and the ToF mount angles are not measured on the robot,
+ *  they are the SIM_TABLE_* constants below.
+ */
+
+#include "sim_table.h"
+
+// Std. Lib
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// TableUV Lib
+#include "avr_driver_common.h"
+#include "avr_sensor_common.h"
+#include "dev_avr_driver.h"
+#include "dev_avr_sensor.h"
+#include "dev_ToF_Lidar.h"
+#include "dev_battery.h"
+
+// Host
+#include "dev_host.h"
+#include "host_trace.h"
+#include "host_rtos.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SIM_TABLE_STEP_US                   (2000LL)
+#define SIM_TABLE_STEP_S                    (SIM_TABLE_STEP_US * 1e-6F)
+#define SIM_TABLE_SENSOR_PERIOD_US          (1000000LL / AVR_SENSOR_FRAME_FREQ)
+#define SIM_TABLE_DRIVER_PERIOD_US          (50000LL)   // 20Hz, DEV_AVR_DRIVER_ENC_BUFFER_SIZE
+#define SIM_TABLE_TOF_PERIOD_US             (50000LL)   // one firing frame per dev cycle
+#define SIM_TABLE_COVERAGE_PERIOD_US        (10000LL)
+#define SIM_TABLE_PATH_PERIOD_US            (50000LL)
+#define SIM_TABLE_BUTTON_AT_US              (500000LL)  // after the start of the run
+
+// robot
+#define SIM_TABLE_ROBOT_RADIUS_MM           (50.0F)     // ROBOT_SIZE_D_MM / 2, the edge nodes sit on it
+#define SIM_TABLE_WHEEL_BASE_MM             (1.0F / DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM)
+#define SIM_TABLE_EDGE_NODE_COUNT           (28U)       // VEHICLE_EDGE_NODE_SIZE, node 0 in front, CCW
+#define SIM_TABLE_MOTOR_FULL_DUTY_MM_S      (250.0F)    // assumed, no load
+#define SIM_TABLE_MOTOR_TAU_S               (0.05F)     // assumed, duty or speed control
+#define SIM_TABLE_BRAKE_TAU_S               (0.02F)     // e-stop and brake modes
+#define SIM_TABLE_COAST_TAU_S               (0.15F)     // coast with no duty
+#define SIM_TABLE_BATTERY_V                 (11.1F)
+
+// sensor avr
+#define SIM_TABLE_IR_ON_TABLE_RAW           (150)
+#define SIM_TABLE_IR_OFF_TABLE_RAW          (255)
+#define SIM_TABLE_IR_NOISE_RAW              (3)
+#define SIM_TABLE_IR_HYSTERESIS             (4)         // SENSOR_FILTER_DEFAULT_HYSTERESIS
+#define SIM_TABLE_BUMPER_MARGIN_MM          (0.5F)
+
+// tof, VL53L1X: 16 spad columns over a 27 degree field of view, ROI center columns of dev_ToF_Lidar.cpp
+#define SIM_TABLE_TOF_SPAD_COLUMNS          (16U)
+#define SIM_TABLE_TOF_FOV_RAD               (27.0F * (float)M_PI / 180.0F)
+#define SIM_TABLE_TOF_ROI_COLUMNS           (5U)        // TOF_WIDTH_OF_SPADS_PER_ZONE
+#define SIM_TABLE_TOF_RAYS                  (3U)        // across the ROI, the nearest return wins
+#define SIM_TABLE_TOF_RANGE_MM              (1300U)     // short distance mode
+#define SIM_TABLE_TOF_NOISE_MM              (2)
+#define SIM_TABLE_TOF_MOUNT_RAD             (25.0F * (float)M_PI / 180.0F) // assumed, L and R off the center
+
+typedef enum{
+    SIM_TABLE_IR_FRONT_1,
+    SIM_TABLE_IR_FRONT_2,
+    SIM_TABLE_IR_RIGHT_1,
+    SIM_TABLE_IR_RIGHT_2,
+    SIM_TABLE_IR_LEFT_1,
+    SIM_TABLE_IR_LEFT_2,
+    SIM_TABLE_IR_COUNT
+} sim_table_ir_E;
+
+typedef struct{
+    uint8_t     edge_node;      // mount, app_slam edge_node_ir
+    uint8_t     flag_bit;       // uart_byte_bits_E, front channels are crossed
+    uint8_t     trip_level;     // sensor_filter_default_trip_level
+} sim_table_ir_S;
+
+typedef struct{
+    sim_table_config_S      config;
+    sim_table_stats_S       stats;
+    int64_t                 start_us;
+
+    // pose and wheels
+    float                   x_mm;
+    float                   y_mm;
+    float                   heading_rad;
+    float                   wheel_mm_s[NUM_AVR_DRIVER];
+    double                  wheel_ticks[NUM_AVR_DRIVER];
+
+    // sensor avr
+    uint8_t                 ir_raw[SIM_TABLE_IR_COUNT];
+    uint8_t                 flags;
+    uint8_t                 sensor_sequence;
+
+    // avr drivers
+    uint8_t                 driver_sequence[NUM_AVR_DRIVER];
+    uint8_t                 driver_frames;
+
+    // tof
+    uint8_t                 tof_frame;
+
+    bool                    estop;
+    std::vector<uint8_t>    covered;    // 0: free, 1: swept, 2: obstacle
+    uint32_t                free_cells;
+    uint32_t                covered_cells;
+    uint16_t                cols;
+    uint16_t                rows;
+    uint32_t                rng;
+} sim_table_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static int      sim_table_private_noise(int amplitude);
+static bool     sim_table_private_onTable(float x_mm, float y_mm);
+static bool     sim_table_private_contact(float x_mm, float y_mm, float margin_mm, float * bearing_rad);
+static void     sim_table_private_stepDrive(void);
+static void     sim_table_private_sense(void);
+static void     sim_table_private_sendSensorFrame(void);
+static void     sim_table_private_sendDriverStatus(void);
+static void     sim_table_private_sampleTof(void);
+static float    sim_table_private_castRay(float x_mm, float y_mm, float angle_rad);
+static int32_t  sim_table_private_readBattery(void);
+static void     sim_table_private_sweepCoverage(float now_s);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+// app_slam edge_node_ir and the sensor avr wiring
+static const sim_table_ir_S sim_table_ir[SIM_TABLE_IR_COUNT] = {
+    /* SIM_TABLE_IR_FRONT_1 */ { 1U,  IR_FRONT_2_BIT, 246U},
+    /* SIM_TABLE_IR_FRONT_2 */ {27U,  IR_FRONT_1_BIT, 249U},
+    /* SIM_TABLE_IR_RIGHT_1 */ {20U,  IR_RIGHT_1_BIT, 228U},
+    /* SIM_TABLE_IR_RIGHT_2 */ {22U,  IR_RIGHT_2_BIT, 226U},
+    /* SIM_TABLE_IR_LEFT_1  */ { 8U,  IR_LEFT_1_BIT,  227U},
+    /* SIM_TABLE_IR_LEFT_2  */ { 6U,  IR_LEFT_2_BIT,  223U},
+};
+
+// spad column of the ROI center per firing frame (197, 149, 237, 173, 213), a higher column looks further left
+static const uint8_t sim_table_tof_column[DEV_TOF_FIRING_KEYFRAME_COUNT] = {8U, 2U, 13U, 5U, 10U};
+static const float sim_table_tof_mount_rad[DEV_TOF_LIDAR_COUNT] = {
+    /* DEV_TOF_LIDAR_C */ 0.0F,
+    /* DEV_TOF_LIDAR_L */ SIM_TABLE_TOF_MOUNT_RAD,
+    /* DEV_TOF_LIDAR_R */ -SIM_TABLE_TOF_MOUNT_RAD,
+};
+// dev_ToF_Lidar.cpp firing_sequence_label
+static const uint8_t sim_table_tof_label[DEV_TOF_LIDAR_COUNT][DEV_TOF_FIRING_KEYFRAME_COUNT] = {
+    /* DEV_TOF_LIDAR_C */ {DEV_TOF_FIRING_GEOMETRICAL_8,  DEV_TOF_FIRING_GEOMETRICAL_6,  DEV_TOF_FIRING_GEOMETRICAL_10, DEV_TOF_FIRING_GEOMETRICAL_7,  DEV_TOF_FIRING_GEOMETRICAL_9},
+    /* DEV_TOF_LIDAR_L */ {DEV_TOF_FIRING_GEOMETRICAL_13, DEV_TOF_FIRING_GEOMETRICAL_11, DEV_TOF_FIRING_GEOMETRICAL_15, DEV_TOF_FIRING_GEOMETRICAL_12, DEV_TOF_FIRING_GEOMETRICAL_14},
+    /* DEV_TOF_LIDAR_R */ {DEV_TOF_FIRING_GEOMETRICAL_3,  DEV_TOF_FIRING_GEOMETRICAL_1,  DEV_TOF_FIRING_GEOMETRICAL_5,  DEV_TOF_FIRING_GEOMETRICAL_2,  DEV_TOF_FIRING_GEOMETRICAL_4},
+};
+
+static sim_table_data_S sim_data;
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+// xorshift32, seeded per run so a run is repeatable
+static int sim_table_private_noise(int amplitude)
+{
+    uint32_t x = sim_data.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim_data.rng = x;
+    return (int)(x % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+static bool sim_table_private_onTable(float x_mm, float y_mm)
+{
+    return (x_mm >= 0.0F) && (x_mm <= sim_data.config.width_mm) && (y_mm >= 0.0F) && (y_mm <= sim_data.config.depth_mm);
+}
+
+// footprint against the boxes, bearing of the contact point from the heading
+static bool sim_table_private_contact(float x_mm, float y_mm, float margin_mm, float * bearing_rad)
+{
+    for (uint8_t i = 0U; i < sim_data.config.obstacle_count; i++)
+    {
+        const sim_table_box_S * box = &sim_data.config.obstacle[i];
+        const float cx = fminf(fmaxf(x_mm, box->x_mm), box->x_mm + box->w_mm);
+        const float cy = fminf(fmaxf(y_mm, box->y_mm), box->y_mm + box->h_mm);
+        const float dx = cx - x_mm;
+        const float dy = cy - y_mm;
+        if ((dx * dx + dy * dy) < (SIM_TABLE_ROBOT_RADIUS_MM + margin_mm) * (SIM_TABLE_ROBOT_RADIUS_MM + margin_mm))
+        {
+            if (bearing_rad != NULL)
+            {
+                *bearing_rad = remainderf(atan2f(dy, dx) - sim_data.heading_rad, 2.0F * (float)M_PI);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// wheel direction per motion as dev_avr_driver.cpp builds the motor byte: CCW drives the left wheel forward, CW the right
+static void sim_table_private_stepDrive(void)
+{
+    dev_host_drive_S drive;
+    dev_host_get_drive(&drive);
+
+    float target[NUM_AVR_DRIVER] = {0.0F, 0.0F};
+    float tau = SIM_TABLE_BRAKE_TAU_S;
+    if (drive.speed_control)
+    {
+        target[LEFT_AVR_DRIVER]  = drive.speed_mm_s[LEFT_AVR_DRIVER];
+        target[RIGHT_AVR_DRIVER] = drive.speed_mm_s[RIGHT_AVR_DRIVER];
+        tau = SIM_TABLE_MOTOR_TAU_S;
+    }
+    else if (!drive.estop)
+    {
+        float direction[NUM_AVR_DRIVER] = {1.0F, 1.0F};
+        switch (drive.motion)
+        {
+            case (ROBOT_MOTION_REV_COAST):
+            case (ROBOT_MOTION_REV_BREAK):
+            case (ROBOT_MOTION_REV_DIFF_ROTATION):
+                direction[LEFT_AVR_DRIVER]  = -1.0F;
+                direction[RIGHT_AVR_DRIVER] = -1.0F;
+                break;
+            case (ROBOT_MOTION_CW_ROTATION):
+                direction[LEFT_AVR_DRIVER]  = -1.0F;
+                break;
+            case (ROBOT_MOTION_CCW_ROTATION):
+                direction[RIGHT_AVR_DRIVER] = -1.0F;
+                break;
+            default:
+                break;
+        }
+        for (uint8_t side = 0U; side < NUM_AVR_DRIVER; side++)
+        {
+            target[side] = direction[side] * SIM_TABLE_MOTOR_FULL_DUTY_MM_S * (float)drive.pwm[side] / (float)MOTOR_PWM_DUTY_100_PERCENT;
+        }
+        const bool brake = (drive.motion == ROBOT_MOTION_FW_BREAK) || (drive.motion == ROBOT_MOTION_REV_BREAK);
+        tau = ((drive.pwm[LEFT_AVR_DRIVER] == 0U) && (drive.pwm[RIGHT_AVR_DRIVER] == 0U) && (!brake)) ? SIM_TABLE_COAST_TAU_S : SIM_TABLE_MOTOR_TAU_S;
+    }
+    sim_data.estop = drive.estop;
+
+    const float alpha = SIM_TABLE_STEP_S / (tau + SIM_TABLE_STEP_S);
+    for (uint8_t side = 0U; side < NUM_AVR_DRIVER; side++)
+    {
+        sim_data.wheel_mm_s[side] += alpha * (target[side] - sim_data.wheel_mm_s[side]);
+    }
+
+    // the wheels turn even when the body is held by an obstacle, so do the encoders; a wheel off its nominal
+    // size travels more or less per tick than the firmware assumes
+    const float left_mm  = sim_data.wheel_mm_s[LEFT_AVR_DRIVER]  * SIM_TABLE_STEP_S;
+    const float right_mm = sim_data.wheel_mm_s[RIGHT_AVR_DRIVER] * SIM_TABLE_STEP_S;
+    sim_data.wheel_ticks[LEFT_AVR_DRIVER]  += left_mm  / (DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK * sim_data.config.wheel_scale[LEFT_AVR_DRIVER]);
+    sim_data.wheel_ticks[RIGHT_AVR_DRIVER] += right_mm / (DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK * sim_data.config.wheel_scale[RIGHT_AVR_DRIVER]);
+
+    const float d_mm = 0.5F * (left_mm + right_mm);
+    const float d_rad = (right_mm - left_mm) / SIM_TABLE_WHEEL_BASE_MM;
+    const float mid_rad = sim_data.heading_rad + 0.5F * d_rad;
+    const float x_mm = sim_data.x_mm + d_mm * cosf(mid_rad);
+    const float y_mm = sim_data.y_mm + d_mm * sinf(mid_rad);
+    sim_data.heading_rad = remainderf(sim_data.heading_rad + d_rad, 2.0F * (float)M_PI);
+    if (!sim_table_private_contact(x_mm, y_mm, 0.0F, NULL))
+    {
+        sim_data.stats.distance_mm += fabsf(d_mm);
+        sim_data.x_mm = x_mm;
+        sim_data.y_mm = y_mm;
+    }
+}
+
+static void sim_table_private_sense(void)
+{
+    uint8_t flags = 0U;
+    for (uint8_t ir = 0U; ir < SIM_TABLE_IR_COUNT; ir++)
+    {
+        const float angle = sim_data.heading_rad + 2.0F * (float)M_PI * (float)sim_table_ir[ir].edge_node / (float)SIM_TABLE_EDGE_NODE_COUNT;
+        const bool on_table = sim_table_private_onTable(sim_data.x_mm + SIM_TABLE_ROBOT_RADIUS_MM * cosf(angle),
+                                                        sim_data.y_mm + SIM_TABLE_ROBOT_RADIUS_MM * sinf(angle));
+        int raw = (on_table ? SIM_TABLE_IR_ON_TABLE_RAW : SIM_TABLE_IR_OFF_TABLE_RAW) + sim_table_private_noise(SIM_TABLE_IR_NOISE_RAW);
+        sim_data.ir_raw[ir] = (uint8_t)((raw > UINT8_MAX) ? UINT8_MAX : raw);
+
+        const uint8_t bit = (uint8_t)(1U << sim_table_ir[ir].flag_bit);
+        const bool tripped = (sim_data.flags & bit) ? (sim_data.ir_raw[ir] > sim_table_ir[ir].trip_level - SIM_TABLE_IR_HYSTERESIS)
+                                                    : (sim_data.ir_raw[ir] > sim_table_ir[ir].trip_level);
+        if (tripped)
+        {
+            flags |= bit;
+        }
+    }
+    if ((flags & ~sim_data.flags) & DEV_AVR_ALL_IR_SENSORS)
+    {
+        sim_data.stats.ir_trips ++;
+    }
+
+    float bearing;
+    if (sim_table_private_contact(sim_data.x_mm, sim_data.y_mm, SIM_TABLE_BUMPER_MARGIN_MM, &bearing) && (fabsf(bearing) <= 0.5F * (float)M_PI))
+    {
+        flags |= (bearing >= 0.0F) ? (1U << LEFT_COLLISION_BIT) : (1U << RIGHT_COLLISION_BIT);
+    }
+    if ((flags & ~sim_data.flags) & (DEV_AVR_LEFT_COLLISION | DEV_AVR_RIGHT_COLLISION))
+    {
+        sim_data.stats.bumper_contacts ++;
+        host_trace_printf("[ SIM ] bumper at (%.0f, %.0f)\n", (double)sim_data.x_mm, (double)sim_data.y_mm);
+    }
+
+    const bool changed = (flags != sim_data.flags);
+    sim_data.flags = flags;
+    if (changed)
+    {
+        sim_table_private_sendSensorFrame();
+    }
+}
+
+static void sim_table_private_sendSensorFrame(void)
+{
+    uint8_t frame[AVR_SENSOR_FRAME_SIZE];
+    frame[AVR_SENSOR_FRAME_INDEX_SYNC]     = AVR_SENSOR_FRAME_SYNC;
+    frame[AVR_SENSOR_FRAME_INDEX_SEQUENCE] = sim_data.sensor_sequence++;
+    frame[AVR_SENSOR_FRAME_INDEX_FLAGS]    = sim_data.flags;
+    memcpy(&frame[AVR_SENSOR_FRAME_INDEX_IR_FRONT_1], sim_data.ir_raw, AVR_SENSOR_FRAME_IR_COUNT);
+    frame[AVR_SENSOR_FRAME_INDEX_CRC]      = avr_sensor_crc8(frame, AVR_SENSOR_FRAME_INDEX_CRC);
+    dev_host_avr_sensor_frame(frame);
+}
+
+static void sim_table_private_sendDriverStatus(void)
+{
+    dev_host_drive_S drive;
+    dev_host_get_drive(&drive);
+    const float mm_per_tick[NUM_AVR_DRIVER] = {DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK, DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK};
+    for (uint8_t side = 0U; side < NUM_AVR_DRIVER; side++)
+    {
+        const int32_t count = (int32_t)floor(sim_data.wheel_ticks[side]);
+        const int16_t speed = (int16_t)lroundf(sim_data.wheel_mm_s[side] * DEV_AVR_DRIVER_SPEED_WINDOW_S / mm_per_tick[side]);
+        uint8_t status = AVR_DRIVER_STATUS_FLAG_NONE;
+        if (sim_data.driver_frames < AVR_DRIVER_BOOT_FLAG_FRAMES)
+        {
+            status |= AVR_DRIVER_STATUS_FLAG_BOOT;
+        }
+        if (drive.estop)
+        {
+            status |= AVR_DRIVER_STATUS_FLAG_ESTOPPED;
+        }
+        else if (drive.speed_control)
+        {
+            status |= AVR_DRIVER_STATUS_FLAG_SPEED_CTRL;
+        }
+
+        uint8_t frame[AVR_DRIVER_FRAME_SIZE];
+        frame[AVR_DRIVER_FRAME_INDEX_VERSION]     = AVR_DRIVER_PROTOCOL_VERSION;
+        frame[AVR_DRIVER_FRAME_INDEX_SEQUENCE]    = sim_data.driver_sequence[side]++;
+        frame[AVR_DRIVER_FRAME_INDEX_ENCODER_0]   = (uint8_t)((uint32_t)count >> 24);
+        frame[AVR_DRIVER_FRAME_INDEX_ENCODER_1]   = (uint8_t)((uint32_t)count >> 16);
+        frame[AVR_DRIVER_FRAME_INDEX_ENCODER_2]   = (uint8_t)((uint32_t)count >> 8);
+        frame[AVR_DRIVER_FRAME_INDEX_ENCODER_3]   = (uint8_t)count;
+        frame[AVR_DRIVER_FRAME_INDEX_SPEED_0]     = (uint8_t)((uint16_t)speed >> 8);
+        frame[AVR_DRIVER_FRAME_INDEX_SPEED_1]     = (uint8_t)speed;
+        frame[AVR_DRIVER_FRAME_INDEX_WATER_LEVEL] = 1U;
+        frame[AVR_DRIVER_FRAME_INDEX_STATUS]      = status;
+        frame[AVR_DRIVER_FRAME_INDEX_CRC]         = avr_driver_crc8(frame, AVR_DRIVER_FRAME_INDEX_CRC);
+        dev_host_avr_driver_status(side, frame);
+    }
+    if (sim_data.driver_frames < AVR_DRIVER_BOOT_FLAG_FRAMES)
+    {
+        sim_data.driver_frames ++;
+    }
+}
+
+static void sim_table_private_sampleTof(void)
+{
+    const float column_rad = SIM_TABLE_TOF_FOV_RAD / (float)SIM_TABLE_TOF_SPAD_COLUMNS;
+    const uint8_t frame = sim_data.tof_frame;
+    for (uint8_t sensor = 0U; sensor < DEV_TOF_LIDAR_COUNT; sensor++)
+    {
+        const float mount = sim_data.heading_rad + sim_table_tof_mount_rad[sensor];
+        const float x_mm = sim_data.x_mm + SIM_TABLE_ROBOT_RADIUS_MM * cosf(mount);
+        const float y_mm = sim_data.y_mm + SIM_TABLE_ROBOT_RADIUS_MM * sinf(mount);
+        // the optical center is the pad right and above the middle of the ROI
+        const float center = ((float)sim_table_tof_column[frame] - 0.5F * (float)(SIM_TABLE_TOF_SPAD_COLUMNS - 1U)) * column_rad;
+        float dist_mm = (float)SIM_TABLE_TOF_RANGE_MM;
+        for (uint8_t ray = 0U; ray < SIM_TABLE_TOF_RAYS; ray++)
+        {
+            const float spread = ((float)ray - 0.5F * (float)(SIM_TABLE_TOF_RAYS - 1U)) * column_rad * (float)(SIM_TABLE_TOF_ROI_COLUMNS - 1U) / (float)(SIM_TABLE_TOF_RAYS - 1U);
+            dist_mm = fminf(dist_mm, sim_table_private_castRay(x_mm, y_mm, mount + center + spread));
+        }
+
+        if (dist_mm >= (float)SIM_TABLE_TOF_RANGE_MM)
+        {
+            dev_host_tof_sample(sensor, sim_table_tof_label[sensor][frame], DEV_TOF_RANGE_STATUS_SIGNAL_FAILURE, SIM_TABLE_TOF_RANGE_MM);
+        }
+        else
+        {
+            const int noisy = (int)lroundf(dist_mm) + sim_table_private_noise(SIM_TABLE_TOF_NOISE_MM);
+            dev_host_tof_sample(sensor, sim_table_tof_label[sensor][frame], DEV_TOF_RANGE_STATUS_NO_ERROR, (uint16_t)((noisy < 0) ? 0 : noisy));
+        }
+    }
+    sim_data.tof_frame = (uint8_t)((frame + 1U) % DEV_TOF_FIRING_KEYFRAME_COUNT);
+}
+
+// slab test against each box, the table edge gives no return
+static float sim_table_private_castRay(float x_mm, float y_mm, float angle_rad)
+{
+    const float dx = cosf(angle_rad);
+    const float dy = sinf(angle_rad);
+    float nearest = (float)SIM_TABLE_TOF_RANGE_MM;
+    for (uint8_t i = 0U; i < sim_data.config.obstacle_count; i++)
+    {
+        const sim_table_box_S * box = &sim_data.config.obstacle[i];
+        float t_min = 0.0F;
+        float t_max = nearest;
+        const float origin[2] = {x_mm, y_mm};
+        const float dir[2]    = {dx, dy};
+        const float lo[2]     = {box->x_mm, box->y_mm};
+        const float hi[2]     = {box->x_mm + box->w_mm, box->y_mm + box->h_mm};
+        bool hit = true;
+        for (uint8_t axis = 0U; (axis < 2U) && hit; axis++)
+        {
+            if (fabsf(dir[axis]) < 1e-6F)
+            {
+                hit = (origin[axis] >= lo[axis]) && (origin[axis] <= hi[axis]);
+                continue;
+            }
+            float t0 = (lo[axis] - origin[axis]) / dir[axis];
+            float t1 = (hi[axis] - origin[axis]) / dir[axis];
+            if (t0 > t1)
+            {
+                const float t = t0;
+                t0 = t1;
+                t1 = t;
+            }
+            t_min = fmaxf(t_min, t0);
+            t_max = fminf(t_max, t1);
+            hit = (t_min <= t_max);
+        }
+        if (hit)
+        {
+            nearest = t_min;
+        }
+    }
+    return nearest;
+}
+
+// divider of dev_battery.h, read by the 1000ms body
+static int32_t sim_table_private_readBattery(void)
+{
+    return (int32_t)lroundf(SIM_TABLE_BATTERY_V * DEV_BATTERY_PULLDOWN_KOHMS
+                / ((DEV_BATTERY_PULLUP_KOHMS + DEV_BATTERY_PULLDOWN_KOHMS) * DEV_BATTERY_ESP_ADC_TO_VOLT));
+}
+
+static void sim_table_private_sweepCoverage(float now_s)
+{
+    const int reach = (int)ceilf(SIM_TABLE_ROBOT_RADIUS_MM / SIM_TABLE_CELL_MM);
+    const int col0 = (int)floorf(sim_data.x_mm / SIM_TABLE_CELL_MM);
+    const int row0 = (int)floorf(sim_data.y_mm / SIM_TABLE_CELL_MM);
+    for (int row = row0 - reach; row <= row0 + reach; row++)
+    {
+        for (int col = col0 - reach; col <= col0 + reach; col++)
+        {
+            if ((row < 0) || (col < 0) || (row >= sim_data.rows) || (col >= sim_data.cols))
+            {
+                continue;
+            }
+            uint8_t * cell = &sim_data.covered[(size_t)row * sim_data.cols + (size_t)col];
+            const float dx = ((float)col + 0.5F) * SIM_TABLE_CELL_MM - sim_data.x_mm;
+            const float dy = ((float)row + 0.5F) * SIM_TABLE_CELL_MM - sim_data.y_mm;
+            if ((*cell == 0U) && ((dx * dx + dy * dy) <= SIM_TABLE_ROBOT_RADIUS_MM * SIM_TABLE_ROBOT_RADIUS_MM))
+            {
+                *cell = 1U;
+                sim_data.covered_cells ++;
+            }
+        }
+    }
+
+    sim_data.stats.coverage = (sim_data.free_cells > 0U) ? ((float)sim_data.covered_cells / (float)sim_data.free_cells) : 0.0F;
+    if ((sim_data.stats.coverage >= 0.5F) && (sim_data.stats.coverage_50_s < 0.0F))
+    {
+        sim_data.stats.coverage_50_s = now_s;
+        host_trace_printf("[ SIM ] coverage 50%%\n");
+    }
+    if ((sim_data.stats.coverage >= 0.9F) && (sim_data.stats.coverage_90_s < 0.0F))
+    {
+        sim_data.stats.coverage_90_s = now_s;
+        host_trace_printf("[ SIM ] coverage 90%%\n");
+    }
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sim_table_init(const sim_table_config_S * config)
+{
+    sim_data = sim_table_data_S();
+    sim_data.config      = *config;
+    sim_data.x_mm        = config->start_x_mm;
+    sim_data.y_mm        = config->start_y_mm;
+    sim_data.heading_rad = config->start_heading_rad;
+    for (uint8_t side = 0U; side < NUM_AVR_DRIVER; side++)
+    {
+        sim_data.config.wheel_scale[side] = (config->wheel_scale[side] > 0.0F) ? config->wheel_scale[side] : 1.0F;
+    }
+    sim_data.rng         = (config->seed != 0U) ? config->seed : 1U;
+    sim_data.stats.coverage_50_s = -1.0F;
+    sim_data.stats.coverage_90_s = -1.0F;
+
+    // cells with their center inside an obstacle are not to be covered
+    sim_data.cols = (uint16_t)ceilf(config->width_mm / SIM_TABLE_CELL_MM);
+    sim_data.rows = (uint16_t)ceilf(config->depth_mm / SIM_TABLE_CELL_MM);
+    sim_data.covered.assign((size_t)sim_data.cols * sim_data.rows, 0U);
+    for (uint16_t row = 0U; row < sim_data.rows; row++)
+    {
+        for (uint16_t col = 0U; col < sim_data.cols; col++)
+        {
+            const float x = ((float)col + 0.5F) * SIM_TABLE_CELL_MM;
+            const float y = ((float)row + 0.5F) * SIM_TABLE_CELL_MM;
+            bool blocked = false;
+            for (uint8_t i = 0U; i < config->obstacle_count; i++)
+            {
+                const sim_table_box_S * box = &config->obstacle[i];
+                blocked |= (x >= box->x_mm) && (x <= box->x_mm + box->w_mm) && (y >= box->y_mm) && (y <= box->y_mm + box->h_mm);
+            }
+            if (blocked)
+            {
+                sim_data.covered[(size_t)row * sim_data.cols + col] = 2U;
+            }
+            else
+            {
+                sim_data.free_cells ++;
+            }
+        }
+    }
+    for (uint8_t ir = 0U; ir < SIM_TABLE_IR_COUNT; ir++)
+    {
+        sim_data.ir_raw[ir] = SIM_TABLE_IR_ON_TABLE_RAW;
+    }
+    dev_host_set_battery_source(sim_table_private_readBattery);
+}
+
+void sim_table_run(void * param)
+{
+    const int64_t end_us = *(const int64_t *)param;
+    sim_data.start_us = host_rtos_now_us();
+    int64_t now_us = sim_data.start_us;
+    int64_t next_sensor_us   = now_us;
+    int64_t next_driver_us   = now_us;
+    int64_t next_tof_us      = now_us;
+    int64_t next_coverage_us = now_us;
+    int64_t next_path_us     = now_us;
+    bool button = false;
+
+    while (now_us < end_us)
+    {
+        sim_table_private_stepDrive();
+        if (!sim_table_private_onTable(sim_data.x_mm, sim_data.y_mm))
+        {
+            sim_data.stats.fell = true;
+            host_trace_printf("[ SIM ] fell off the table at (%.0f, %.0f)\n", (double)sim_data.x_mm, (double)sim_data.y_mm);
+            break;
+        }
+        sim_table_private_sense();
+
+        if (now_us >= next_sensor_us)
+        {
+            sim_table_private_sendSensorFrame();
+            next_sensor_us += SIM_TABLE_SENSOR_PERIOD_US;
+        }
+        if (now_us >= next_driver_us)
+        {
+            sim_table_private_sendDriverStatus();
+            next_driver_us += SIM_TABLE_DRIVER_PERIOD_US;
+        }
+        if (now_us >= next_tof_us)
+        {
+            sim_table_private_sampleTof();
+            next_tof_us += SIM_TABLE_TOF_PERIOD_US;
+        }
+        if ((!button) && (now_us >= sim_data.start_us + SIM_TABLE_BUTTON_AT_US))
+        {
+            dev_host_button_press();
+            button = true;
+        }
+        if (now_us >= next_coverage_us)
+        {
+            sim_table_private_sweepCoverage((float)(now_us - sim_data.start_us) * 1e-6F);
+            next_coverage_us += SIM_TABLE_COVERAGE_PERIOD_US;
+        }
+        if ((sim_data.config.path != NULL) && (now_us >= next_path_us))
+        {
+            fprintf(sim_data.config.path, "%.3f,%.1f,%.1f,%.4f,%d,%u\n", (double)(now_us - sim_data.start_us) * 1e-6,
+                (double)sim_data.x_mm, (double)sim_data.y_mm, (double)sim_data.heading_rad, sim_data.estop, sim_data.flags);
+            next_path_us += SIM_TABLE_PATH_PERIOD_US;
+        }
+
+        now_us += SIM_TABLE_STEP_US;
+        host_rtos_sleep_until_us(now_us);
+    }
+    host_rtos_stop();
+}
+
+void sim_table_get_stats(sim_table_stats_S * stats)
+{
+    *stats = sim_data.stats;
+    stats->estops = dev_host_get_estop_now_count();
+}
+
+void sim_table_get_pose(sim_table_pose_S * pose)
+{
+    pose->x_mm          = sim_data.x_mm;
+    pose->y_mm          = sim_data.y_mm;
+    pose->heading_rad   = sim_data.heading_rad;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file    sim_table.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host simulator
+ *
+ * This document will contains the tabletop world of the host simulator:
+ *      a rectangular table with box obstacles, the differential drive of the robot, and the sensor avr,
+ *      both avr drivers and the three ToF sensors rendered from it into the dev_host inject functions.
+ *      The table frame has its origin at a corner, x along the width, y along the depth, heading CCW from x.
+ */
+
+#ifndef SIM_TABLE_H
+#define SIM_TABLE_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SIM_TABLE_OBSTACLE_MAX          (8U)
+#define SIM_TABLE_CELL_MM               (10.0F) // coverage grid, as the slam map pixel
+
+typedef struct{
+    float x_mm;
+    float y_mm;
+    float w_mm;
+    float h_mm;
+} sim_table_box_S;
+
+typedef struct{
+    float           width_mm;
+    float           depth_mm;
+    sim_table_box_S obstacle[SIM_TABLE_OBSTACLE_MAX];
+    uint8_t         obstacle_count;
+    float           start_x_mm;
+    float           start_y_mm;
+    float           start_heading_rad;
+    uint32_t        seed;           // sensor noise
+    float           wheel_scale[2]; // true over nominal travel per encoder tick, left and right, 0 is taken as 1
+    FILE *          path;           // pose csv when not NULL
+} sim_table_config_S;
+
+typedef struct{
+    float       x_mm;               // table frame, heading CCW from x
+    float       y_mm;
+    float       heading_rad;
+} sim_table_pose_S;
+
+typedef struct{
+    float       coverage;           // of the free table area, swept by the footprint
+    float       coverage_50_s;      // virtual time to reach 50% and 90%, negative if never
+    float       coverage_90_s;
+    float       distance_mm;        // travelled by the center
+    uint32_t    bumper_contacts;
+    uint32_t    ir_trips;           // any cliff channel tripping
+    uint32_t    estops;             // fast path e-stops of the hazard task
+    bool        fell;               // the center left the table, the run ends there
+} sim_table_stats_S;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void sim_table_init(const sim_table_config_S * config);
+/**
+ * @brief physics and sensor task, runs at the input priority until 'end_us' or a fall, then stops the scheduler
+ * @param param: (int64_t *) esp_timer time the run ends
+ */
+void sim_table_run(void * param);
+void sim_table_get_stats(sim_table_stats_S * stats);
+void sim_table_get_pose(sim_table_pose_S * pose);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SIM_TABLE_H
@@ -0,0 +1,285 @@
+/**
+ * @file    simulate.cpp
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   Host tools
+ *
+ * This document will contains the closed loop run of the app layer on a simulated tabletop:
+ *      the world of sim_table.cpp feeds the dev_host inputs and follows the drive commands,
+ *      everything runs on the virtual clock of host_rtos.c, a run is repeatable for a given seed.
+ *
+ *  usage: simulate [--duration <s>] [--table <w>x<d>] [--obstacle <x>,<y>,<w>,<h>]... [--start <x>,<y>,<deg>]
+ *                  [--seed <n>] [--wheels <left>,<right>] [--late <period>,<at_s>,<late_ms>[,<count>]]...
+ *                  [--path <csv>] [--trace <file>] [--telemetry <file>] [--check <mm>,<rad>] [--verbose]
+ *      lengths in mm, the default is a 1200x700 table started in its middle facing +x, for 600 s,
+ *      --wheels scales the true travel of each wheel per encoder tick (1.01,0.99: the odometry turns left of the truth),
+ *      --late releases a periodic body (50ms, 1000ms, slam) late from 'at_s' on, see sys_time_fault_late(),
+ *      --check fails the run (exit 1) when the mean slam pose error against the truth is over either bound.
+ */
+
+// Std. Lib
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cinttypes>
+#include <ctime>
+
+// Host
+#include "sim_table.h"
+#include "dev_host.h"
+#include "host_app.h"
+#include "host_trace.h"
+#include "host_rtos.h"
+
+// TableUV Lib
+#include "app_slam.h"
+
+// Host port
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SIMULATE_DEFAULT_DURATION_S     (600.0)
+#define SIMULATE_DEFAULT_WIDTH_MM       (1200.0F)
+#define SIMULATE_DEFAULT_DEPTH_MM       (700.0F)
+#define SIMULATE_POSE_PERIOD_MS         (100U) // one slam cycle
+
+typedef struct{
+    double          position_sum_mm;
+    double          position_max_mm;
+    double          heading_sum_rad;
+    double          heading_max_rad;
+    uint32_t        count;
+} simulate_error_S;
+
+typedef struct{
+    int64_t         end_us;
+    bool            verbose;
+    FILE *          telemetry;
+    sim_table_pose_S start;
+    simulate_error_S error;
+} simulate_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void simulate_private_poseError(void);
+static void simulate_task_setup(void * param);
+static void simulate_task_pose(void * param);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static simulate_data_S simulate_data;
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+/**
+ * the slam pose against the truth, as tools/telemetry_decoder.py --truth:
+ * the slam map starts at the vehicle, x to its left, y behind it, theta CCW from its start heading
+ */
+static void simulate_private_poseError(void)
+{
+    sim_table_pose_S truth;
+    float x_mm, y_mm, theta_rad;
+    sim_table_get_pose(&truth);
+    app_slam_getVehiclePose(&x_mm, &y_mm, &theta_rad);
+
+    const double dx = (double)(truth.x_mm - simulate_data.start.x_mm);
+    const double dy = (double)(truth.y_mm - simulate_data.start.y_mm);
+    const double c = cos((double)simulate_data.start.heading_rad);
+    const double s = sin((double)simulate_data.start.heading_rad);
+    const double forward = dx * c + dy * s;
+    const double left = dy * c - dx * s;
+    const double position_mm = hypot((double)x_mm - left, (double)y_mm + forward);
+    const double heading_rad = fabs(remainder((double)theta_rad - (double)(truth.heading_rad - simulate_data.start.heading_rad), 2.0 * M_PI));
+
+    simulate_error_S * error = &simulate_data.error;
+    error->position_sum_mm += position_mm;
+    error->position_max_mm = fmax(error->position_max_mm, position_mm);
+    error->heading_sum_rad += heading_rad;
+    error->heading_max_rad = fmax(error->heading_max_rad, heading_rad);
+    error->count++;
+}
+
+// the world comes first so no input is late
+static void simulate_task_setup(void * param)
+{
+    host_app_init();
+    xTaskCreate(sim_table_run, "sim_table_run", 0U, &simulate_data.end_us, HOST_APP_INPUT_PRIORITY, NULL);
+    host_app_start(simulate_data.verbose, simulate_data.telemetry);
+    xTaskCreate(simulate_task_pose, "simulate_task_pose", 0U, NULL, tskIDLE_PRIORITY, NULL);
+}
+
+// lowest priority, so a slam cycle due on the same tick has run
+static void simulate_task_pose(void * param)
+{
+    TickType_t wake = xTaskGetTickCount();
+    for( ;; )
+    {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(SIMULATE_POSE_PERIOD_MS));
+        simulate_private_poseError();
+    }
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    sim_table_config_S config;
+    memset(&config, 0, sizeof(config));
+    config.width_mm = SIMULATE_DEFAULT_WIDTH_MM;
+    config.depth_mm = SIMULATE_DEFAULT_DEPTH_MM;
+    config.seed     = 1U;
+    bool start_set = false;
+    double duration_s = SIMULATE_DEFAULT_DURATION_S;
+    const char * trace = NULL;
+    const char * telemetry = NULL;
+    const char * path = NULL;
+    double check_mm = 0.0;
+    double check_rad = 0.0;
+    bool check = false;
+
+    bool usage = false;
+    for (int i = 1; (i < argc) && (!usage); i++)
+    {
+        const bool value = (i + 1 < argc);
+        if ((strcmp(argv[i], "--duration") == 0) && value)
+        {
+            duration_s = atof(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--table") == 0) && value)
+        {
+            usage = (sscanf(argv[++i], "%fx%f", &config.width_mm, &config.depth_mm) != 2);
+        }
+        else if ((strcmp(argv[i], "--obstacle") == 0) && value && (config.obstacle_count < SIM_TABLE_OBSTACLE_MAX))
+        {
+            sim_table_box_S * box = &config.obstacle[config.obstacle_count++];
+            usage = (sscanf(argv[++i], "%f,%f,%f,%f", &box->x_mm, &box->y_mm, &box->w_mm, &box->h_mm) != 4);
+        }
+        else if ((strcmp(argv[i], "--start") == 0) && value)
+        {
+            float heading_deg = 0.0F;
+            usage = (sscanf(argv[++i], "%f,%f,%f", &config.start_x_mm, &config.start_y_mm, &heading_deg) != 3);
+            config.start_heading_rad = heading_deg * (float)M_PI / 180.0F;
+            start_set = true;
+        }
+        else if ((strcmp(argv[i], "--seed") == 0) && value)
+        {
+            config.seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if ((strcmp(argv[i], "--wheels") == 0) && value)
+        {
+            usage = (sscanf(argv[++i], "%f,%f", &config.wheel_scale[0], &config.wheel_scale[1]) != 2)
+                || (config.wheel_scale[0] <= 0.0F) || (config.wheel_scale[1] <= 0.0F);
+        }
+        else if ((strcmp(argv[i], "--late") == 0) && value)
+        {
+            usage = !host_app_add_fault(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--path") == 0) && value)
+        {
+            path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--trace") == 0) && value)
+        {
+            trace = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--telemetry") == 0) && value)
+        {
+            telemetry = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--check") == 0) && value)
+        {
+            usage = (sscanf(argv[++i], "%lf,%lf", &check_mm, &check_rad) != 2);
+            check = true;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0)
+        {
+            simulate_data.verbose = true;
+        }
+        else
+        {
+            usage = true;
+        }
+    }
+    if (usage || (duration_s <= 0.0))
+    {
+        fprintf(stderr, "usage: %s [--duration <s>] [--table <w>x<d>] [--obstacle <x>,<y>,<w>,<h>]... [--start <x>,<y>,<deg>]\n"
+                        "       [--seed <n>] [--wheels <left>,<right>] [--late <period>,<at_s>,<late_ms>[,<count>]]...\n"
+                        "       [--path <csv>] [--trace <file>] [--telemetry <file>] [--check <mm>,<rad>] [--verbose]\n", argv[0]);
+        return 2;
+    }
+    if (!start_set)
+    {
+        config.start_x_mm = 0.5F * config.width_mm;
+        config.start_y_mm = 0.5F * config.depth_mm;
+    }
+    if (path != NULL)
+    {
+        config.path = fopen(path, "w");
+        if (config.path != NULL)
+        {
+            fprintf(config.path, "t_s,x_mm,y_mm,heading_rad,estop,flags\n");
+        }
+    }
+    if (telemetry != NULL)
+    {
+        simulate_data.telemetry = fopen(telemetry, "wb");
+    }
+
+    host_rtos_init(0);
+    host_trace_open(trace);
+    dev_host_init();
+    sim_table_init(&config);
+    simulate_data.start.x_mm        = config.start_x_mm;
+    simulate_data.start.y_mm        = config.start_y_mm;
+    simulate_data.start.heading_rad = config.start_heading_rad;
+    simulate_data.end_us = (int64_t)llround(duration_s * 1e6);
+    xTaskCreate(simulate_task_setup, "setup", 0U, NULL, 8, NULL);
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    host_rtos_run();
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    host_app_flush();
+
+    sim_table_stats_S stats;
+    sim_table_get_stats(&stats);
+    const double wall_s = (double)(wall_end.tv_sec - wall_start.tv_sec) + (double)(wall_end.tv_nsec - wall_start.tv_nsec) * 1e-9;
+    const double virtual_s = (double)host_rtos_now_us() * 1e-6;
+    printf("[ SIM ] table: %.0f x %.0f mm obstacles: %d seed: %" PRIu32 "\n",
+        (double)config.width_mm, (double)config.depth_mm, config.obstacle_count, config.seed);
+    printf("[ SIM ] coverage: %.1f %% 50%%: %.1f s 90%%: %.1f s\n",
+        (double)stats.coverage * 100.0, (double)stats.coverage_50_s, (double)stats.coverage_90_s);
+    printf("[ SIM ] distance: %.0f mm bumper contacts: %" PRIu32 " ir trips: %" PRIu32 " estops: %" PRIu32 " fell: %s\n",
+        (double)stats.distance_mm, stats.bumper_contacts, stats.ir_trips, stats.estops, stats.fell ? "yes" : "no");
+    const simulate_error_S * error = &simulate_data.error;
+    const double position_mean_mm = (error->count > 0U) ? (error->position_sum_mm / error->count) : 0.0;
+    const double heading_mean_rad = (error->count > 0U) ? (error->heading_sum_rad / error->count) : 0.0;
+    printf("[ SIM ] pose error: position mean %.0f max %.0f mm, heading mean %.3f max %.3f rad\n",
+        position_mean_mm, error->position_max_mm, heading_mean_rad, error->heading_max_rad);
+    const bool drift = check && ((position_mean_mm > check_mm) || (heading_mean_rad > check_rad));
+    if (check)
+    {
+        printf("[ SIM ] check: position mean <= %.0f mm, heading mean <= %.3f rad: %s\n", check_mm, check_rad, drift ? "FAIL" : "ok");
+    }
+    printf("[ SIM ] %.3f s simulated in %.3f s (x%.0f)\n", virtual_s, wall_s, (wall_s > 0.0) ? (virtual_s / wall_s) : 0.0);
+    printf("[ SIM ] digest: %016" PRIx64 "\n", host_trace_get_digest());
+
+    host_trace_close();
+    if (simulate_data.telemetry != NULL)
+    {
+        fclose(simulate_data.telemetry);
+    }
+    if (config.path != NULL)
+    {
+        fclose(config.path);
+    }
+    return (stats.fell || drift) ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+"""
+Writes recorder_short.bin, the sys_recorder log the replay regression test of host/CMakeLists.txt runs.
+
+    python recorder_fixture.py recorder_short.bin
+
+6 s from boot at 50 ms driver status per side, 20 ms avr sensor frames, 3 ToF samples per 20 ms,
+the battery every second and one button press: parked for 1 s, then both wheels forward,
+with a cliff flag on the avr sensor from 3.0 s to 3.2 s.
+The block layout follows sys_recorder_block_S in lib/SYS/sys_recorder.h.
+Rewriting the fixture changes the replay digest, update REPLAY_DIGEST in host/CMakeLists.txt with it.
+"""
+
+import struct
+import sys
+
+BLOCK_MAGIC = 0x5255
+BLOCK_RECORDS = 128 - 14
+
+DRIVER_STATUS, TOF, AVR_SENSOR, IMU, BATTERY, BUTTON = range(6)
+
+BOOT_US = 2000000
+DURATION_US = 6000000
+MOVE_US = 1000000
+CLIFF_US = (3000000, 3200000)
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def varint(value):
+    out = b''
+    while value >= 0x80:
+        out += bytes([(value & 0x7F) | 0x80])
+        value >>= 7
+    return out + bytes([value])
+
+
+def events():
+    encoder = [0, 0]
+    sequence = [0, 0]
+    sensor_sequence = 0
+    out = []
+    for stamp in range(BOOT_US, BOOT_US + DURATION_US, 1000):
+        t = stamp - BOOT_US
+        if t % 50000 == 0:
+            for side in (0, 1):
+                encoder[side] += 40 if t > MOVE_US else 0
+                sequence[side] = (sequence[side] + 1) & 0xFF
+                frame = bytes([4, sequence[side]]) + struct.pack('>i', encoder[side]) + struct.pack('>h', 12) + bytes([1, 8 if t < 400000 else 0])
+                frame = frame[:10]
+                out.append((stamp, DRIVER_STATUS, bytes([side]) + frame + bytes([crc8(frame)])))
+        if t % 20000 == 0:
+            sensor_sequence = (sensor_sequence + 1) & 0xFF
+            flags = 0x04 if CLIFF_US[0] <= t < CLIFF_US[1] else 0
+            frame = bytes([0xA5, sensor_sequence, flags, 10, 10, 10, 10, 10, 10])
+            out.append((stamp + 300, AVR_SENSOR, frame + bytes([crc8(frame)])))
+        if t % 20000 == 5000:
+            step = t // 20000
+            for sensor in range(3):
+                out.append((stamp + sensor * 10, TOF, struct.pack('<BBBBH', sensor, step % 5, (sensor * 5 + step % 5) % 15, 0, 300 + sensor * 100 + step % 50)))
+        if t % 1000000 == 0:
+            out.append((stamp + 700, BATTERY, struct.pack('<i', 2800)))
+        if t == 2000000:
+            out.append((stamp + 123, BUTTON, b''))
+    return sorted(out, key=lambda event: event[0])
+
+
+def main():
+    log = events()
+    with open(sys.argv[1], 'wb') as out:
+        block = 0
+        i = 0
+        while i < len(log):
+            records = b''
+            stamp = last = log[i][0]
+            while i < len(log):
+                t, kind, payload = log[i]
+                record = bytes([kind]) + varint(t - last if records else 0) + payload
+                if len(records) + len(record) > BLOCK_RECORDS:
+                    break
+                records += record
+                last = t
+                i += 1
+            out.write(struct.pack('<HHqBB', BLOCK_MAGIC, block, stamp, len(records), 0) + records.ljust(BLOCK_RECORDS, b'\xff'))
+            block += 1
+
+
+if __name__ == '__main__':
+    main()
@@ -3,7 +3,7 @@
  * @author Tsugmui Murata
  * @date 1 Mar 2021
  * @brief AVR DRIVER COMMON HEADER FILE
- * @version V1.2
+ * @version V3.0
  *
  * This document will contains ping definitions
  */
@@ -48,6 +48,8 @@ extern "C"{
 // data mask for first incoming data byte 
 #define ESTOP_COMMAND_REQ_MASK          (_BV(5))
 
+#define SPEED_CTRL_REQ_MASK             (_BV(4))    // third and fourth byte carry a speed setpoint
+
 #define HAPTIC_EN_REQ_MASK              (_BV(3))
 
 #define TOF_XSHUT_EN_REQ_BIT_MASK       (_BV(1) | _BV(0))
@@ -57,6 +59,15 @@ extern "C"{
 #define MOTOR_DIRECTION_REQ_MASK        (_BV(4))
 #define MOTOR_PWM_DUTY_REQ_MASK         (_BV(3) | _BV(2) | _BV(1) | _BV(0))
 
+// data mask for third and fourth incoming data byte (speed control only)
+// signed 12 bit setpoint in ticks per speed window, bits [11:6] in third byte, [5:0] in fourth
+#define SPEED_SETPOINT_REQ_MASK         (0x3F)
+#define AVR_DRIVER_SPEED_SETPOINT_MAX   (2047)
+#define AVR_DRIVER_SPEED_SETPOINT_MIN   (-2048)
+
+// speed is measured as encoder ticks over this window, positive when the count goes up
+#define AVR_DRIVER_SPEED_WINDOW_MS      (16U)
+
 
 
 // data frame header
@@ -126,6 +137,87 @@ typedef enum tof_sensor_config{
 } tof_sensor_config_E; 
 
 
+/////////////////////////////////
+/////   PROTOCOL FRAME      /////
+/////////////////////////////////
+// The avr driver is a register file (v4): a master write starts with the register
+// address, registers auto-increment, and a read continues from the last address.
+// Master writes the whole command block, it is applied when its crc byte lands.
+// The status block is refreshed after each command and every few ms, and any
+// contiguous part of it can be fetched in one read (crc covers the full block only).
+// The encoder count is free running (never reset by a read), so the master
+// computes deltas itself and a failed read only delays ticks, never loses them.
+#define AVR_DRIVER_PROTOCOL_VERSION     (4U)
+
+// number of status frames the boot flag stays raised after a reset, so a
+// single failed read cannot hide the reset from the master
+#define AVR_DRIVER_BOOT_FLAG_FRAMES     (8U)
+
+// driver stops the motors this long after the last valid command, master polls every 20ms
+#define AVR_DRIVER_COMM_TIMEOUT_MS      (100U)
+
+// crc-8 (poly x^8 + x^2 + x + 1, SMBus PEC), computed over the frame without its crc byte
+#define AVR_DRIVER_CRC8_POLYNOMIAL      (0x07)
+#define AVR_DRIVER_CRC8_INIT            (0x00)
+
+// command block layout, control byte (first), motor byte (second), speed setpoint
+// (third and fourth, header only when not in speed control) and crc over the four
+typedef enum avr_driver_cmd_index{
+    AVR_DRIVER_CMD_INDEX_CONTROL,
+    AVR_DRIVER_CMD_INDEX_MOTOR,
+    AVR_DRIVER_CMD_INDEX_SPEED_0,
+    AVR_DRIVER_CMD_INDEX_SPEED_1,
+    AVR_DRIVER_CMD_INDEX_CRC,
+    AVR_DRIVER_CMD_SIZE
+} avr_driver_cmd_index_E;
+
+// status frame byte layout, encoder count and measured speed are sent MSB first
+typedef enum avr_driver_frame_index{
+    AVR_DRIVER_FRAME_INDEX_VERSION,
+    AVR_DRIVER_FRAME_INDEX_SEQUENCE,
+    AVR_DRIVER_FRAME_INDEX_ENCODER_0,
+    AVR_DRIVER_FRAME_INDEX_ENCODER_1,
+    AVR_DRIVER_FRAME_INDEX_ENCODER_2,
+    AVR_DRIVER_FRAME_INDEX_ENCODER_3,
+    AVR_DRIVER_FRAME_INDEX_SPEED_0,
+    AVR_DRIVER_FRAME_INDEX_SPEED_1,
+    AVR_DRIVER_FRAME_INDEX_WATER_LEVEL,
+    AVR_DRIVER_FRAME_INDEX_STATUS,
+    AVR_DRIVER_FRAME_INDEX_CRC,
+    AVR_DRIVER_FRAME_SIZE
+} avr_driver_frame_index_E;
+
+// status frame flags
+typedef enum avr_driver_status_flag{
+    AVR_DRIVER_STATUS_FLAG_NONE         = 0U,
+    AVR_DRIVER_STATUS_FLAG_BOOT         = (1U << 0), // driver was reset recently, master shall re-sync its encoder reference
+    AVR_DRIVER_STATUS_FLAG_ESTOPPED     = (1U << 1), // last command was an e-stop
+    AVR_DRIVER_STATUS_FLAG_CMD_INVALID  = (1U << 2), // last command failed the header check
+    AVR_DRIVER_STATUS_FLAG_SPEED_CTRL   = (1U << 3), // closed loop speed control is driving the motor
+    AVR_DRIVER_STATUS_FLAG_COMM_TIMEOUT = (1U << 4), // motors were stopped by the comm watchdog since the last frame
+    AVR_DRIVER_STATUS_FLAG_WDT_RESET    = (1U << 5), // raised with the boot flag when the reset came from the avr watchdog
+} avr_driver_status_flag_E;
+
+// register map, command block (read/write) followed by the status block (read only)
+#define AVR_DRIVER_REG_CMD_BLOCK        (0x00)
+#define AVR_DRIVER_REG_STATUS_BLOCK     (AVR_DRIVER_REG_CMD_BLOCK + AVR_DRIVER_CMD_SIZE)
+#define AVR_DRIVER_REG_STATUS(index)    (AVR_DRIVER_REG_STATUS_BLOCK + (index))
+#define AVR_DRIVER_REG_COUNT            (AVR_DRIVER_REG_STATUS_BLOCK + AVR_DRIVER_FRAME_SIZE)
+
+static inline uint8_t avr_driver_crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = AVR_DRIVER_CRC8_INIT;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ AVR_DRIVER_CRC8_POLYNOMIAL) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
 #ifdef __cplusplus  
 }
 #endif 
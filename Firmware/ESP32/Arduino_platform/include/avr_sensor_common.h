@@ -0,0 +1,82 @@
+/**
+ * @file avr_sensor_common.h
+ * @author Jerome Villapando
+ * @date 17 Mar 2021
+ * @brief AVR SENSOR COMMON HEADER FILE
+ * @version V1.0
+ *
+ * This document will contains the uart frame shared with the ESP32
+ */
+
+#ifndef AVR_SENSOR_COMMON_H
+#define AVR_SENSOR_COMMON_H
+#ifdef __cplusplus
+extern "C"{
+#endif 
+
+/////////////////////////////////
+/////////   INCLUDE     /////////
+/////////////////////////////////
+#include <stdint.h>
+
+
+/////////////////////////////////
+/////////   MACRO     ///////////
+/////////////////////////////////
+
+// Sensor avr sends one frame on a fixed cadence, and right away whenever a
+// flag changes, so a bumper hit or cliff edge does not wait for the next slot.
+#define AVR_SENSOR_FRAME_SYNC           (0xA5)
+#define AVR_SENSOR_FRAME_FREQ           (50U)
+
+// crc-8 (poly x^8 + x^2 + x + 1), computed over the frame from sync up to its crc byte
+#define AVR_SENSOR_CRC8_POLYNOMIAL      (0x07)
+#define AVR_SENSOR_CRC8_INIT            (0x00)
+
+// frame byte layout, IR values are the raw 8 bit readings per channel
+typedef enum avr_sensor_frame_index{
+    AVR_SENSOR_FRAME_INDEX_SYNC,
+    AVR_SENSOR_FRAME_INDEX_SEQUENCE,
+    AVR_SENSOR_FRAME_INDEX_FLAGS,
+    AVR_SENSOR_FRAME_INDEX_IR_FRONT_1,
+    AVR_SENSOR_FRAME_INDEX_IR_FRONT_2,
+    AVR_SENSOR_FRAME_INDEX_IR_RIGHT_1,
+    AVR_SENSOR_FRAME_INDEX_IR_RIGHT_2,
+    AVR_SENSOR_FRAME_INDEX_IR_LEFT_1,
+    AVR_SENSOR_FRAME_INDEX_IR_LEFT_2,
+    AVR_SENSOR_FRAME_INDEX_CRC,
+    AVR_SENSOR_FRAME_SIZE
+} avr_sensor_frame_index_E;
+
+#define AVR_SENSOR_FRAME_IR_COUNT       (AVR_SENSOR_FRAME_INDEX_CRC - AVR_SENSOR_FRAME_INDEX_IR_FRONT_1)
+
+// flags byte, a set bit is a tripped sensor (front IR bits are crossed with the raw front channels)
+typedef enum {
+    LEFT_COLLISION_BIT,
+    RIGHT_COLLISION_BIT,
+    IR_FRONT_1_BIT,
+    IR_FRONT_2_BIT,
+    IR_RIGHT_1_BIT,
+    IR_RIGHT_2_BIT,
+    IR_LEFT_1_BIT,
+    IR_LEFT_2_BIT
+} uart_byte_bits_E;
+
+static inline uint8_t avr_sensor_crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = AVR_SENSOR_CRC8_INIT;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ AVR_SENSOR_CRC8_POLYNOMIAL) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#ifdef __cplusplus  
+}
+#endif 
+#endif //AVR_SENSOR_COMMON_H
@@ -44,6 +44,11 @@ extern "C"{
 #   define FEATURE_LIDAR                   (ENABLE) // (WIP)
 #   define FEATURE_LIDAR_CALIBRATION_MODE  (DISABLE) // TODO: implement calibration strategy
 #   define FEATURE_LIDAR                          ( ENABLE)
+#   ifndef FEATURE_SLAM_SCAN_MATCH
+#       define FEATURE_SLAM_SCAN_MATCH            (DISABLE) // Correct the odometry pose against the global map, off: adds drift in host/simulate (see host/CMakeLists.txt)
+#   endif // (FEATURE_SLAM_SCAN_MATCH)
+#   define FEATURE_SLAM_TABLE_MODEL               (FEATURE_SLAM) // Table edges fitted to the IR edge hits: heading relocalization, map clipped to the table
+#   define FEATURE_SUPER_USE_MOTION_SCRIPT        ( ENABLE) // E-stop recovery runs as a timed motion script
 #   define FEATURE_PERIPHERALS                    ( ENABLE)
 #   define FEATURE_UV                             ( ENABLE)
 #   define FEATURE_IMU                            ( ENABLE)
@@ -55,6 +60,20 @@ extern "C"{
 #       define FEATURE_AVR_HAPTIC                 ( ENABLE) //
 #       define FEATURE_AVR_ENCODER                ( ENABLE) //
 #   endif // (FEATURE_AVR_DRIVER_ALL)
+#   define FEATURE_HAZARD_FAST_ESTOP              (FEATURE_SENSOR_AVR && FEATURE_AVR_DRIVER_ALL)
+#   define FEATURE_SYS_PERF                       ( ENABLE) // Task runtime instrumentation, "perf" on the serial cli
+#   ifndef FEATURE_SYS_PROBE
+#       define FEATURE_SYS_PROBE                  ( ENABLE) // Cycle counter probes on the hot paths, "probe" on the serial cli
+#   endif // (FEATURE_SYS_PROBE)
+#   define FEATURE_SYS_STACK_WATERMARK            (DISABLE) // Log the stack high water mark of every task each second
+#   define FEATURE_SYS_TELEMETRY                  ( ENABLE) // COBS framed binary records on the monitor port, replaces the hot path prints
+#   define FEATURE_SYS_CLI          (FEATURE_SYS_PERF || FEATURE_SYS_PROBE || FEATURE_SYS_TELEMETRY) // Serial commands, owns the monitor port
+#   define FEATURE_SYS_LOG                        ( ENABLE) // PRINTF records raw arguments, formatted and printed by the low priority log task
+#   define FEATURE_SYS_RECORDER    (FEATURE_SYS_TELEMETRY) // Raw input log for the host replay, "rec" on the serial cli
+#   define FEATURE_SYS_TIME_FAULT                 (DISABLE) // Late periodic releases on demand, "time late" on the serial cli
+#   ifndef FEATURE_BENCH_MODE
+#       define FEATURE_BENCH_MODE                 (DISABLE) // Boot into the slam kernel benchmarks instead of the app, [env:esp32dev_bench]
+#   endif // (FEATURE_BENCH_MODE)
 
 /*****   DEBUG PRINT FLAGS  ****/
 #   define DEBUG_FPRINT                           (DISABLE)
@@ -76,10 +95,14 @@ extern "C"{
 #   define FEATURE_SLAM                           ( ENABLE) // APP SLAM
 #   define FEATURE_LIDAR                          ( ENABLE)
 #   define FEATURE_SLAM_ENCODER                   ( ENABLE)
+#   ifndef FEATURE_SLAM_SCAN_MATCH
+#       define FEATURE_SLAM_SCAN_MATCH            (DISABLE) // Correct the odometry pose against the global map, off: adds drift in host/simulate (see host/CMakeLists.txt)
+#   endif // (FEATURE_SLAM_SCAN_MATCH)
+#   define FEATURE_SLAM_TABLE_MODEL               (FEATURE_SLAM) // Table edges fitted to the IR edge hits: heading relocalization, map clipped to the table
 #   define FEATURE_DEMO_TOF_OBSTACLE        (FEATURE_LIDAR) // DEV avr driver: motor, mist, encoder feedback
 #   define FEATURE_LIDAR_CALIBRATION_MODE         (   TODO) // TODO: implement calibration strategy
-#   define FEATURE_SUPER_USE_PROFILED_MOTIONS     (   TODO) // TODO: implement calibration strategy
-#   define FEATURE_SUPER_USE_HARDCODE_CHORE       ( ENABLE)
+#   define FEATURE_SUPER_USE_PROFILED_MOTIONS     (   TODO) // Follow slam motion profile with avr closed loop wheel speed
+#   define FEATURE_SUPER_USE_MOTION_SCRIPT        ( ENABLE) // E-stop recovery runs as a timed motion script
 #   define FEATURE_SUPER_CMD_DEV_DRIVER           ( ENABLE) // Super command on actuators
 #   define FEATURE_PERIPHERALS                    ( ENABLE)
 #   define FEATURE_UV                             (DISABLE)
@@ -94,6 +117,20 @@ extern "C"{
 #   endif // (FEATURE_AVR_DRIVER_ALL)
 #   define FEATURE_SLAM_AVR_SENSOR           (FEATURE_SLAM)
 #   define FEATURE_BATTERY                        ( ENABLE)
+#   define FEATURE_HAZARD_FAST_ESTOP              (FEATURE_SENSOR_AVR && FEATURE_AVR_DRIVER_ALL) // e-stop straight from the sensor frame, bypassing the supervisor tick
+#   define FEATURE_SYS_PERF                       ( ENABLE) // Task runtime instrumentation, "perf" on the serial cli
+#   ifndef FEATURE_SYS_PROBE
+#       define FEATURE_SYS_PROBE                  ( ENABLE) // Cycle counter probes on the hot paths, "probe" on the serial cli
+#   endif // (FEATURE_SYS_PROBE)
+#   define FEATURE_SYS_STACK_WATERMARK            (DISABLE) // Log the stack high water mark of every task each second
+#   define FEATURE_SYS_TELEMETRY                  ( ENABLE) // COBS framed binary records on the monitor port, replaces the hot path prints
+#   define FEATURE_SYS_CLI          (FEATURE_SYS_PERF || FEATURE_SYS_PROBE || FEATURE_SYS_TELEMETRY) // Serial commands, owns the monitor port
+#   define FEATURE_SYS_LOG                        ( ENABLE) // PRINTF records raw arguments, formatted and printed by the low priority log task
+#   define FEATURE_SYS_RECORDER    (FEATURE_SYS_TELEMETRY) // Raw input log for the host replay, "rec" on the serial cli
+#   define FEATURE_SYS_TIME_FAULT                 ( ENABLE) // Late periodic releases on demand, "time late" on the serial cli
+#   ifndef FEATURE_BENCH_MODE
+#       define FEATURE_BENCH_MODE                 (DISABLE) // Boot into the slam kernel benchmarks instead of the app, [env:esp32dev_bench]
+#   endif // (FEATURE_BENCH_MODE)
 
 /*****   DEBUG PRINT FLAGS  ****/
 #   define DEBUG_FPRINT                           ( ENABLE)
@@ -103,11 +140,12 @@ extern "C"{
 #       define DEBUG_FPRINT_APP_SLAM_PRINT              ( ENABLE) // Live feed of supervisor state
 #       define DEBUG_FPRINT_APP_SUPER_STATE             ( ENABLE) // Live feed of supervisor state
 #       define DEBUG_FPRINT_APP_SUPER_AVR_SENSOR        ( ENABLE) // Live feed of collision status
-#       define DEBUG_FPRINT_APP_SUPER_CHOREOGRAPHY      ( ENABLE) // Live feed of choreography status
+#       define DEBUG_FPRINT_APP_SUPER_CHOREOGRAPHY      ( ENABLE) // Live feed of motion script steps
 #       define DEBUG_FPRINT_FEATURE_MAP                 (DISABLE) // Live feed of global map
 #       define DEBUG_FPRINT_FEATURE_MAP_CENTERED        (  FALSE) // Map Feeding Mode: true->memory_map, false->center_map
 #       define DEBUG_FPRINT_FEATURE_OBSTACLES           (DISABLE) // Live feed of obstacle detection
 #       define DEBUG_FPRINT_FEATURE_CHOREOGRAPHY        (DISABLE) // Live feed of choreography
+#       define DEBUG_FPRINT_APP_HAZARD                  ( ENABLE) // Hazard e-stop latency histograms, every second
 #   else
 #       define DEBUG_FPRINT_FEATURE_LIDAR               (DISABLE)
 #       define DEBUG_FPRINT_APP_SUPER_STATE             (DISABLE)
@@ -117,6 +155,7 @@ extern "C"{
 #       define DEBUG_FPRINT_FEATURE_MAP_CENTERED        (DISABLE)
 #       define DEBUG_FPRINT_FEATURE_OBSTACLES           (DISABLE)
 #       define DEBUG_FPRINT_FEATURE_CHOREOGRAPHY        (DISABLE)
+#       define DEBUG_FPRINT_APP_HAZARD                  (DISABLE)
 #   endif
 
 /***********************************
@@ -129,7 +168,10 @@ extern "C"{
 ///////////////////////////////////////////
 ///////   MACRO FUNC DEFINITION     ///////
 ///////////////////////////////////////////
-#if (DEBUG_FPRINT)
+#if (DEBUG_FPRINT && FEATURE_SYS_LOG)
+#   include "../lib/SYS/sys_log.h"
+#   define PRINTF(f_, ...) SYS_LOG_PRINTF((f_), __VA_ARGS__) // %s arguments must be literals or static
+#elif (DEBUG_FPRINT)
 #   define PRINTF(f_, ...) printf((f_), __VA_ARGS__)
 #else
 #   define PRINTF(f_, ...) // Do Nothing
@@ -0,0 +1,52 @@
+/**
+ * @file mem_budget.h
+ * @author Jianxiang (Jack) Xu
+ * @date 26 Mar 2021
+ * @brief Static RAM budget
+ *
+ * This document will contains the task stack sizes and the budget of the static slam / log buffers,
+ * all in bytes (esp-idf takes the stack depth in bytes, not words)
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+// task stacks, right-size with FEATURE_SYS_STACK_WATERMARK under worst-case load, keep ~1KB margin
+#define MEM_BUDGET_STACK_AVR_SENSOR_RX      (3072U)
+#define MEM_BUDGET_STACK_HAZARD             (3072U)
+#define MEM_BUDGET_STACK_SUPERVISOR         (4096U)
+#define MEM_BUDGET_STACK_50MS               (6144U)  // tof lidar + avr driver i2c
+#define MEM_BUDGET_STACK_1000MS             (4096U)
+#define MEM_BUDGET_STACK_SLAM               (12288U) // map debug prints are the deepest path
+#define MEM_BUDGET_STACK_LOG                (3072U)  // sys_log drain, the only PRINTF formatting left
+#define MEM_BUDGET_STACK_TOTAL              (MEM_BUDGET_STACK_AVR_SENSOR_RX + MEM_BUDGET_STACK_HAZARD \
+                                           + MEM_BUDGET_STACK_SUPERVISOR + MEM_BUDGET_STACK_50MS \
+                                           + MEM_BUDGET_STACK_1000MS + MEM_BUDGET_STACK_SLAM \
+                                           + MEM_BUDGET_STACK_LOG)
+
+// what the tasks (4096 + 4096 + 8192 + 15000 + 10000 + 20000) and the 1m map (101 x 101) used to take
+#define MEM_BUDGET_LEGACY_STACK_TOTAL       (61384U)
+#define MEM_BUDGET_LEGACY_GMAP              (10201U)
+
+// the reclaimed stack goes to these buffers, each checked against its budget where it is declared
+#define MEM_BUDGET_GMAP_EDGE_MM             (1600U)  // 161 x 161 cells of 10mm
+#define MEM_BUDGET_GMAP                     (25921U)
+#define MEM_BUDGET_SCAN_MATCH               (2560U)  // likelihood pyramid of the global map + the tof sweep
+#define MEM_BUDGET_TABLE_MODEL              (1280U)  // IR edge hits + the fitted table edges
+#define MEM_BUDGET_LOG_RING                 (3392U)  // sys_log records, one ring per core
+
+#if ((MEM_BUDGET_STACK_TOTAL + MEM_BUDGET_GMAP + MEM_BUDGET_SCAN_MATCH + MEM_BUDGET_TABLE_MODEL + MEM_BUDGET_LOG_RING) \
+    > (MEM_BUDGET_LEGACY_STACK_TOTAL + MEM_BUDGET_LEGACY_GMAP))
+#   error "RAM budget exceeds what the stacks and the map used to take"
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif // MEM_BUDGET_H
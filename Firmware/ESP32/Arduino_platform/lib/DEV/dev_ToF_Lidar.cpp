@@ -19,6 +19,10 @@
 #include "../IO/io_ping_map.h"
 #include "../../include/common.h"
 #include "dev_avr_driver.h"
+#include "../SYS/sys_telemetry.h"
+#include "../SYS/sys_recorder.h"
+#include "../SYS/sys_time.h"
+#include "../SYS/sys_probe.h"
 
 // Arduino Lib
 #include <SparkFun_VL53L1X.h>
@@ -32,7 +36,7 @@
 #define TOF_HEIGHT_OF_SPADS_PER_ZONE        (5U) // MIN: 4 pix
 #define TOF_MAX_DIST_MM                     (1300U) // 1.3 [m] in short range mode
 #define TOF_INTERMEDIATE_SETTING_DELAY_MS   (10U)
-#define MP_MUTEX_BLOCK_TIME_MS              ((1U)/portTICK_PERIOD_MS)
+#define MP_MUTEX_BLOCK_TIME_MS              (SYS_TIME_MS_TO_TICK(1U))
 #define TOF_SENSOR_COUNT                    (DEV_TOF_LIDAR_COUNT)
 
 typedef struct{
@@ -164,7 +168,7 @@ void dev_ToF_reset_all_sensors(void)
     // Take down all sensors : DEFAULT: off on AVR
     dev_avr_driver_set_req_Tof_config(TOF_SENSOR_CONFIG_DISABLE_ALL);
     dev_driver_avr_update20ms(); // Force update
-    delay(TOF_INTERMEDIATE_SETTING_DELAY_MS);
+    sys_time_delay_ms(TOF_INTERMEDIATE_SETTING_DELAY_MS);
 
     // read sensor initial values & set address & activate sensor
     for (int sensor_id = 0U; sensor_id < TOF_SENSOR_COUNT; sensor_id ++)
@@ -174,7 +178,7 @@ void dev_ToF_reset_all_sensors(void)
         // turn on sensor | WARNING: Do not call: sensor->sensorOn();
         dev_avr_driver_set_req_Tof_config(lidar_data.avr_config[sensor_id]);
         dev_driver_avr_update20ms(); // Force update
-        delay(TOF_INTERMEDIATE_SETTING_DELAY_MS);
+        sys_time_delay_ms(TOF_INTERMEDIATE_SETTING_DELAY_MS);
 
         const int8_t boot = sensor->checkBootState();
         
@@ -197,7 +201,7 @@ void dev_ToF_reset_all_sensors(void)
         
         // begin firing
         sensor->startRanging();
-        delay(TOF_INTERMEDIATE_SETTING_DELAY_MS);
+        sys_time_delay_ms(TOF_INTERMEDIATE_SETTING_DELAY_MS);
         sensor->clearInterrupt();
     }
 }
@@ -230,17 +234,23 @@ void dev_ToF_Lidar_update20ms(void)
     uint8_t firing_frame;
     uint8_t firing_frame_new;
     uint8_t geo_label;
+    bool ready;
 
     // firing
     for (uint8_t sensor_id = 0U; sensor_id < TOF_SENSOR_COUNT; sensor_id ++)
     {
         sensor = & (lidar_data.tofs[sensor_id]);
         // if data ready
-        if (sensor->checkForDataReady()) 
+        SYS_PROBE_BEGIN(SYS_PROBE_TOF_I2C_READY);
+        ready = sensor->checkForDataReady();
+        SYS_PROBE_END(SYS_PROBE_TOF_I2C_READY);
+        if (ready) 
         {
             // fetch data
+            SYS_PROBE_BEGIN(SYS_PROBE_TOF_I2C_READ);
             error = sensor->getRangeStatus();
             dist_mm = sensor->getDistance();
+            SYS_PROBE_END(SYS_PROBE_TOF_I2C_READ);
 
             // set new firing pattern
             firing_frame = lidar_data.prev_firingframe[sensor_id];
@@ -250,15 +260,39 @@ void dev_ToF_Lidar_update20ms(void)
                 firing_frame_new = DEV_TOF_FIRING_KEYFRAME_0;
             }
 
-# if (DEBUG_FPRINT_FEATURE_LIDAR)
+# if (FEATURE_SYS_RECORDER)
+            const sys_recorder_tof_S raw = {
+                .sensor  = sensor_id,
+                .frame   = firing_frame,
+                .label   = lidar_data.firing_sequence_label[sensor_id][firing_frame],
+                .status  = (uint8_t)error,
+                .dist_mm = dist_mm,
+            };
+            sys_recorder_record(SYS_RECORDER_TOF, &raw);
+# endif
+
+# if (FEATURE_SYS_TELEMETRY)
+            sys_telemetry_tof_S sample;
+            sample.sensor  = sensor_id;
+            sample.frame   = firing_frame;
+            sample.label   = lidar_data.firing_sequence_label[sensor_id][firing_frame];
+            sample.status  = (uint8_t)error;
+            sample.dist_mm = dist_mm;
+            sys_telemetry_publish(SYS_TELEMETRY_TOF, &sample, sizeof(sample));
+# elif (DEBUG_FPRINT_FEATURE_LIDAR)
             PRINTF("[ DEV:TOF ] Sensor[%d]: %3d [mm] F:[%d] Label:(%2d) Status:(%d) \n", sensor_id, dist_mm, firing_frame, lidar_data.firing_sequence_label[sensor_id][firing_frame], error);
 # endif
             // update new firing pattern
-            if (sensor->setCenter(lidar_data.firing_sequence[firing_frame_new]) == VL53L1_ERROR_NONE)
+            SYS_PROBE_BEGIN(SYS_PROBE_TOF_I2C_ROI);
+            const VL53L1X_ERROR roi_error = sensor->setCenter(lidar_data.firing_sequence[firing_frame_new]);
+            SYS_PROBE_END(SYS_PROBE_TOF_I2C_ROI);
+            if (roi_error == VL53L1_ERROR_NONE)
             {
                 lidar_data.prev_firingframe[sensor_id] = firing_frame_new;
             }
+            SYS_PROBE_BEGIN(SYS_PROBE_TOF_I2C_CLEAR);
             sensor->clearInterrupt();
+            SYS_PROBE_END(SYS_PROBE_TOF_I2C_CLEAR);
 
             // store data
             if ((error == DEV_TOF_RANGE_STATUS_SIGNAL_FAILURE) || (error == DEV_TOF_RANGE_STATUS_NO_ERROR))
@@ -13,11 +13,19 @@
 #include "../../include/avr_driver_common.h"
 #include "../../include/common.h"
 #include <stdbool.h>
+#include "../SYS/sys_telemetry.h"
+#include "../SYS/sys_recorder.h"
+#include "../SYS/sys_time.h"
+#include "../SYS/sys_probe.h"
 
 #define I2C_RECIEVE_TIMEOUT_MILLI_SEC                                       10
-#define MP_MUTEX_BLOCK_TIME_MS                                              ((1U)/portTICK_PERIOD_MS)
+#define MP_MUTEX_BLOCK_TIME_MS                                              (SYS_TIME_MS_TO_TICK(1U))
+// one status read plus one command write is ~2ms at 100kHz, the e-stop path waits at most that
+#define I2C_MUTEX_BLOCK_TIME_MS                                             (SYS_TIME_MS_TO_TICK(5U))
 
 #define SET_MESSAGE_ESTOP_EN()                                              (1 << 13)
+#define SET_MESSAGE_SPEED_CTRL_EN()                                         (1 << 12)
+#define SET_MESSAGE_MOTOR_BRAKE_EN()                                        (1 << 5)
 #define SET_MESSAGE_HAPTIC_EN()                                             (1 << 11)
 #define SET_MESSAGE_TOF_CONFIG_EN(tof_sensor_config)                        (tof_sensor_config << 8)
 
@@ -26,19 +34,35 @@
 #define RESET_MESSAGE_HAPTIC_EN()                                           ~(1 << 11)
 #define RESET_MESSAGE_TOF_CONFIG_EN(tof_sensor_config)                      ~(tof_sensor_config << 8)
 
+// third and fourth byte with headers only, sent when not in speed control
+#define SPEED_MESSAGE_EMPTY                                                 ((DATA_FRAME_HEADER_THIRD << 14) | (DATA_FRAME_HEADER_FOURTH << 6))
+
 typedef struct{
     TwoWire                     I2C;
     const uint8_t               address[NUM_AVR_DRIVER];
     const data_frame_header_E   dataFrameHeader[DATA_FRAME_HEADER_COUNT];
     uint16_t                    i2c_message[NUM_AVR_DRIVER];
     uint8_t                     reqEstop;
+    volatile bool               estopLatched;                       // set by the fast e-stop path, overrides all requests
     uint8_t                     reqHaptic;
     tof_sensor_config_E         reqConfigTof;
     robot_motion_mode_E         reqRobotMotion;
     motor_pwm_duty_E            pwm_duty[NUM_AVR_DRIVER];
-    uint16_t                    encoderCount[NUM_AVR_DRIVER];
+    uint8_t                     reqSpeedControl;
+    int16_t                     speedSetpoint[NUM_AVR_DRIVER];      // ticks per speed window
+    uint16_t                    i2c_speed_message[NUM_AVR_DRIVER];  // third and fourth byte
+    int32_t                     encoderCount[NUM_AVR_DRIVER];       // latest free running count reported by driver
+    int16_t                     measuredSpeed[NUM_AVR_DRIVER];      // ticks per speed window
+    int32_t                     encoderCountQueued[NUM_AVR_DRIVER]; // part of the count already pushed to the encoder queue
+    bool                        encoderSynced[NUM_AVR_DRIVER];
+    uint8_t                     sequence[NUM_AVR_DRIVER];
+    uint8_t                     statusFlags[NUM_AVR_DRIVER];
+    uint32_t                    frameErrorCount[NUM_AVR_DRIVER];    // failed transfers, bad version or crc
+    uint32_t                    frameLostCount[NUM_AVR_DRIVER];     // commands the driver did not apply
+    uint32_t                    commTimeoutCount[NUM_AVR_DRIVER];   // motors stopped by the driver side comm watchdog
     uint8_t                     waterLevelSig; 
     SemaphoreHandle_t           mp_mutex;
+    SemaphoreHandle_t           i2c_mutex;                          // bus lock, shared with the fast e-stop path
     int16_t                     l_enc_q[DEV_AVR_DRIVER_ENC_BUFFER_SIZE];
     int16_t                     r_enc_q[DEV_AVR_DRIVER_ENC_BUFFER_SIZE];
     uint8_t                     enc_buf_index;
@@ -64,6 +88,7 @@ static dev_avr_driver_data_S dev_avr_driver_data = {
         0x0000
     },
     .reqEstop   = 1,
+    .estopLatched = false,
     .reqHaptic  = 0,
     .reqConfigTof = TOF_SENSOR_CONFIG_DISABLE_ALL,
     .reqRobotMotion = ROBOT_MOTION_BREAK,
@@ -71,12 +96,33 @@ static dev_avr_driver_data_S dev_avr_driver_data = {
         MOTOR_PWM_DUTY_0_PERCENT, 
         MOTOR_PWM_DUTY_0_PERCENT 
     },
+    .reqSpeedControl = 0,
+    .speedSetpoint = {0},
+    .i2c_speed_message = {
+        SPEED_MESSAGE_EMPTY,
+        SPEED_MESSAGE_EMPTY
+    },
     .encoderCount = {
         0,
         0
     },
+    .measuredSpeed = {0},
+    .encoderCountQueued = {
+        0,
+        0
+    },
+    .encoderSynced = {
+        false,
+        false
+    },
+    .sequence = {0},
+    .statusFlags = {0},
+    .frameErrorCount = {0},
+    .frameLostCount = {0},
+    .commTimeoutCount = {0},
     .waterLevelSig = 0,
     .mp_mutex = xSemaphoreCreateBinary(),
+    .i2c_mutex = xSemaphoreCreateMutex(),
     .l_enc_q = {0},
     .r_enc_q = {0},
     .enc_buf_index = 0
@@ -87,41 +133,125 @@ static dev_avr_driver_data_S dev_avr_driver_data = {
 ///////   PRIVATE FUNCTION     /////////
 ////////////////////////////////////////
 
-// I2C transmit two byte 
-static uint8_t dev_avr_driver_transmit_two_byte(uint8_t address, uint16_t message){
+// I2C write the command block, driver applies it once the crc byte is written 
+static uint8_t dev_avr_driver_transmit_message(uint8_t address, uint16_t message, uint16_t speed_message){
 	uint8_t status = 0;
+    uint8_t command[AVR_DRIVER_CMD_SIZE];
+    command[AVR_DRIVER_CMD_INDEX_CONTROL] = (message & DATA_MASK_16BIT_FIRST_8BIT) >> 8;
+    command[AVR_DRIVER_CMD_INDEX_MOTOR]   =  message & DATA_MASK_16BIT_SECOND_8BIT;
+    command[AVR_DRIVER_CMD_INDEX_SPEED_0] = (speed_message & DATA_MASK_16BIT_FIRST_8BIT) >> 8;
+    command[AVR_DRIVER_CMD_INDEX_SPEED_1] =  speed_message & DATA_MASK_16BIT_SECOND_8BIT;
+    command[AVR_DRIVER_CMD_INDEX_CRC]     = avr_driver_crc8(command, AVR_DRIVER_CMD_INDEX_CRC);
+
+    SYS_PROBE_SCOPE(SYS_PROBE_AVR_DRIVER_I2C_WRITE);
     dev_avr_driver_data.I2C.beginTransmission(address);
-    dev_avr_driver_data.I2C.write((message & DATA_MASK_16BIT_FIRST_8BIT) >> 8);
-    dev_avr_driver_data.I2C.write( message & DATA_MASK_16BIT_SECOND_8BIT);
-    status = dev_avr_driver_data.I2C.endTransmission(false);
+    dev_avr_driver_data.I2C.write(AVR_DRIVER_REG_CMD_BLOCK);
+    dev_avr_driver_data.I2C.write(command, AVR_DRIVER_CMD_SIZE);
+    status = dev_avr_driver_data.I2C.endTransmission();
     return status;
 }
 
-// I2C receive one byte 
-static uint8_t  dev_avr_driver_receive_one_byte(uint8_t address){
-    uint8_t receive_first_byte;
-    dev_avr_driver_data.I2C.requestFrom(address, 1, false); 
-    receive_first_byte = dev_avr_driver_data.I2C.read(); 
-    return receive_first_byte;
+// I2C read a contiguous block of registers in one transaction
+static bool dev_avr_driver_read_registers(uint8_t address, uint8_t first_register, uint8_t* data, uint8_t length){
+    SYS_PROBE_SCOPE(SYS_PROBE_AVR_DRIVER_I2C_READ);
+    uint8_t i = 0;
+    dev_avr_driver_data.I2C.beginTransmission(address);
+    dev_avr_driver_data.I2C.write(first_register);
+    if (dev_avr_driver_data.I2C.endTransmission(false) != 0)
+    {
+        return false;
+    }
+    dev_avr_driver_data.I2C.requestFrom(address, length); 
+    while (dev_avr_driver_data.I2C.available() && i < length)
+    {
+        data[i] = dev_avr_driver_data.I2C.read();
+        i ++;
+    }
+    return (i == length);
 }
 
-// I2C receive two byte 
-static uint16_t dev_avr_driver_receive_two_byte(uint8_t address){
-    uint8_t buffer[2];
-    int i = 0;
-    dev_avr_driver_data.I2C.requestFrom(address, 2); 
-    while (dev_avr_driver_data.I2C.available() && i < 2)
-	{
-        buffer[i] = dev_avr_driver_data.I2C.read();
-		i ++;
-	}
-    return ((buffer[0] << 8) | buffer[1]);
+// I2C receive status block, returns true only if the frame is complete and intact
+static bool dev_avr_driver_receive_status_frame(uint8_t address, uint8_t* frame){
+    return dev_avr_driver_read_registers(address, AVR_DRIVER_REG_STATUS_BLOCK, frame, AVR_DRIVER_FRAME_SIZE)
+        && (frame[AVR_DRIVER_FRAME_INDEX_VERSION] == AVR_DRIVER_PROTOCOL_VERSION)
+        && (frame[AVR_DRIVER_FRAME_INDEX_CRC] == avr_driver_crc8(frame, AVR_DRIVER_FRAME_INDEX_CRC));
+}
+
+static void dev_avr_driver_process_status_frame(uint8_t driver_side, const uint8_t* frame){
+    int32_t count = (int32_t)(((uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_0] << 24) 
+                            | ((uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_1] << 16)
+                            | ((uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_2] << 8)
+                            |  (uint32_t)frame[AVR_DRIVER_FRAME_INDEX_ENCODER_3]);
+    uint8_t sequence = frame[AVR_DRIVER_FRAME_INDEX_SEQUENCE];
+    uint8_t flags    = frame[AVR_DRIVER_FRAME_INDEX_STATUS];
+
+#if (FEATURE_SYS_RECORDER)
+    uint8_t record[1U + AVR_DRIVER_FRAME_SIZE];
+    record[0] = driver_side;
+    memcpy(&record[1], frame, AVR_DRIVER_FRAME_SIZE);
+    sys_recorder_record(SYS_RECORDER_DRIVER_STATUS, record);
+#endif // (FEATURE_SYS_RECORDER)
+
+    // the boot flag is held for AVR_DRIVER_BOOT_FLAG_FRAMES frames, only its rising edge is a new reset
+    const bool boot_edge = (flags & AVR_DRIVER_STATUS_FLAG_BOOT)
+                        && !(dev_avr_driver_data.statusFlags[driver_side] & AVR_DRIVER_STATUS_FLAG_BOOT);
+    if (boot_edge)
+    {
+        dev_avr_driver_data.encoderSynced[driver_side] = false;
+    }
+    if (!dev_avr_driver_data.encoderSynced[driver_side])
+    {
+        // first contact or driver got reset: take its count as the new reference
+        dev_avr_driver_data.encoderCountQueued[driver_side] = count;
+        dev_avr_driver_data.encoderSynced[driver_side] = true;
+    }
+    else
+    {
+        // status is read before each command, so exactly the previous command shall have been applied,
+        // no ticks are lost either way since the count is absolute, only kept as link statistics
+        if ((uint8_t)(sequence - dev_avr_driver_data.sequence[driver_side]) != 1U)
+        {
+            dev_avr_driver_data.frameLostCount[driver_side] ++;
+        }
+    }
+
+    if (flags & AVR_DRIVER_STATUS_FLAG_COMM_TIMEOUT)
+    {
+        dev_avr_driver_data.commTimeoutCount[driver_side] ++;
+    }
+
+    dev_avr_driver_data.sequence[driver_side]     = sequence;
+    dev_avr_driver_data.statusFlags[driver_side]  = flags;
+    dev_avr_driver_data.encoderCount[driver_side] = count;
+    dev_avr_driver_data.measuredSpeed[driver_side] = (int16_t)((frame[AVR_DRIVER_FRAME_INDEX_SPEED_0] << 8) | frame[AVR_DRIVER_FRAME_INDEX_SPEED_1]);
+
+    if (driver_side == RIGHT_AVR_DRIVER)
+    {
+        dev_avr_driver_data.waterLevelSig = frame[AVR_DRIVER_FRAME_INDEX_WATER_LEVEL];
+    }
+}
+
+// take the ticks not yet queued, anything beyond int16 stays pending for the next slot
+static int16_t dev_avr_driver_take_encoder_delta(uint8_t driver_side){
+    int32_t delta = (int32_t)((uint32_t)dev_avr_driver_data.encoderCount[driver_side] - (uint32_t)dev_avr_driver_data.encoderCountQueued[driver_side]);
+    if (delta > INT16_MAX)
+    {
+        delta = INT16_MAX;
+    }
+    else if (delta < INT16_MIN)
+    {
+        delta = INT16_MIN;
+    }
+    dev_avr_driver_data.encoderCountQueued[driver_side] += delta;
+    return (int16_t)delta;
 }
 
 // initialize I2C message
 static inline void dev_avr_driver_init_message_two_byte(){
     dev_avr_driver_data.i2c_message[LEFT_AVR_DRIVER]   = 0b0000000001000000;
     dev_avr_driver_data.i2c_message[RIGHT_AVR_DRIVER]  = 0b0000000001000000;
+    dev_avr_driver_data.i2c_speed_message[LEFT_AVR_DRIVER]  = SPEED_MESSAGE_EMPTY;
+    dev_avr_driver_data.i2c_speed_message[RIGHT_AVR_DRIVER] = SPEED_MESSAGE_EMPTY;
 }
 
 static void avr_driver_update_i2c_message_two_byte(){  
@@ -132,7 +262,7 @@ static void avr_driver_update_i2c_message_two_byte(){
     robot_motion_mode_E temp_reqRobotMotion  = ROBOT_MOTION_BREAK; 
     motor_pwm_duty_E temp_left_motor_speed = MOTOR_PWM_DUTY_0_PERCENT, temp_right_motor_speed = MOTOR_PWM_DUTY_0_PERCENT; 
 
-    temp_reqEstop  = dev_avr_driver_data.reqEstop ;
+    temp_reqEstop  = dev_avr_driver_data.reqEstop || dev_avr_driver_data.estopLatched;
     temp_reqHaptic = dev_avr_driver_data.reqHaptic;
     temp_reqConfigTof = dev_avr_driver_data.reqConfigTof;
     temp_reqRobotMotion = dev_avr_driver_data.reqRobotMotion; 
@@ -165,8 +295,20 @@ static void avr_driver_update_i2c_message_two_byte(){
         temp_message_left &= (~(1 << 9) & ~(1 << 8)) ;
     }
 
+    // req speed control, setpoint goes out in the third (header 0b10) and fourth (header 0b11) byte
+    if (dev_avr_driver_data.reqSpeedControl && (!temp_reqEstop)){
+        for (uint8_t side = LEFT_AVR_DRIVER; side < NUM_AVR_DRIVER; side++)
+        {
+            uint16_t setpoint = (uint16_t)dev_avr_driver_data.speedSetpoint[side];
+            dev_avr_driver_data.i2c_speed_message[side] = (DATA_FRAME_HEADER_THIRD  << 14) | (((setpoint >> 6) & SPEED_SETPOINT_REQ_MASK) << 8)
+                                                        | (DATA_FRAME_HEADER_FOURTH << 6)  | (setpoint & SPEED_SETPOINT_REQ_MASK);
+        }
+        // brake when the setpoint is zero
+        temp_message_left  |= SET_MESSAGE_SPEED_CTRL_EN() | SET_MESSAGE_MOTOR_BRAKE_EN();
+        temp_message_right |= SET_MESSAGE_SPEED_CTRL_EN() | SET_MESSAGE_MOTOR_BRAKE_EN();
+    }
     // req RobotMotion
-    if (temp_reqRobotMotion){
+    else if (temp_reqRobotMotion){
         switch(temp_reqRobotMotion){
 
             case(ROBOT_MOTION_FW_COAST):
@@ -237,39 +379,106 @@ void dev_avr_driver_init()
 
 void dev_driver_avr_update20ms()
 {
-    uint16_t temp_left_encoder = 0, temp_right_encoder = 0;
-    uint16_t temp_message_left = 0, temp_message_right = 0;
+    uint8_t frame[AVR_DRIVER_FRAME_SIZE];
     uint8_t status = 0;
     avr_driver_update_i2c_message_two_byte(); 
 
-    status = dev_avr_driver_transmit_two_byte( dev_avr_driver_data.address[LEFT_AVR_DRIVER] , dev_avr_driver_data.i2c_message[LEFT_AVR_DRIVER] );
-    if (status == 0)
-    {
-        temp_left_encoder = dev_avr_driver_receive_two_byte(dev_avr_driver_data.address[LEFT_AVR_DRIVER]);
-    }
-
-    status = dev_avr_driver_transmit_two_byte( dev_avr_driver_data.address[RIGHT_AVR_DRIVER] , dev_avr_driver_data.i2c_message[RIGHT_AVR_DRIVER] );
-    if (status == 0)
+    for (uint8_t side = LEFT_AVR_DRIVER; side < NUM_AVR_DRIVER; side++)
     {
-        temp_right_encoder = dev_avr_driver_receive_two_byte(dev_avr_driver_data.address[RIGHT_AVR_DRIVER]);
+        // bus is locked per side, so a fast e-stop never waits behind both drivers
+        if (xSemaphoreTake(dev_avr_driver_data.i2c_mutex, I2C_MUTEX_BLOCK_TIME_MS) != pdTRUE)
+        {
+            dev_avr_driver_data.frameErrorCount[side] ++;
+            continue;
+        }
+        // status first, it never waits on the driver decoding the command just sent
+        if (dev_avr_driver_receive_status_frame(dev_avr_driver_data.address[side], frame))
+        {
+            dev_avr_driver_process_status_frame(side, frame);
+        }
+        else
+        {
+            // the free running count catches up on the next good frame
+            dev_avr_driver_data.frameErrorCount[side] ++;
+        }
+
+        // a latch raised after the message was built still wins
+        if (dev_avr_driver_data.estopLatched)
+        {
+            dev_avr_driver_data.i2c_message[side] |= SET_MESSAGE_ESTOP_EN();
+        }
+        status = dev_avr_driver_transmit_message( dev_avr_driver_data.address[side] , dev_avr_driver_data.i2c_message[side], 
+                    dev_avr_driver_data.i2c_speed_message[side] );
+        xSemaphoreGive(dev_avr_driver_data.i2c_mutex);
+        if (status != 0)
+        {
+            dev_avr_driver_data.frameErrorCount[side] ++;
+        }
     }
-    //dev_avr_driver_data.waterLevelSig = dev_avr_driver_receive_one_byte(dev_avr_driver_data.address[RIGHT_AVR_DRIVER]);
-    
-    dev_avr_driver_data.encoderCount[LEFT_AVR_DRIVER]  = temp_left_encoder; 
-    dev_avr_driver_data.encoderCount[RIGHT_AVR_DRIVER] = temp_right_encoder;
 
     if (xSemaphoreTake(dev_avr_driver_data.mp_mutex, MP_MUTEX_BLOCK_TIME_MS) == pdTRUE) {
-        dev_avr_driver_data.l_enc_q[dev_avr_driver_data.enc_buf_index] = temp_left_encoder;
-        dev_avr_driver_data.r_enc_q[dev_avr_driver_data.enc_buf_index] = temp_right_encoder;
-        dev_avr_driver_data.enc_buf_index = (dev_avr_driver_data.enc_buf_index == (DEV_AVR_DRIVER_ENC_BUFFER_SIZE - 1)) ? 0 : dev_avr_driver_data.enc_buf_index + 1;
+        // when the queue is full the ticks stay pending until the consumer catches up 
+        if (dev_avr_driver_data.enc_buf_index < DEV_AVR_DRIVER_ENC_BUFFER_SIZE)
+        {
+            dev_avr_driver_data.l_enc_q[dev_avr_driver_data.enc_buf_index] = dev_avr_driver_take_encoder_delta(LEFT_AVR_DRIVER);
+            dev_avr_driver_data.r_enc_q[dev_avr_driver_data.enc_buf_index] = dev_avr_driver_take_encoder_delta(RIGHT_AVR_DRIVER);
+            dev_avr_driver_data.enc_buf_index ++;
+        }
         //release the mutex 
         xSemaphoreGive(dev_avr_driver_data.mp_mutex); 
     }
-#if (DEBUG_FPRINT_FEATURE_AVR_DRIVER)
-    PRINTF("[ AVR:DRIVER ] left: %d, right: %d \n", dev_avr_driver_data.i2c_message[LEFT_AVR_DRIVER], dev_avr_driver_data.i2c_message[RIGHT_AVR_DRIVER]);
+#if (FEATURE_SYS_TELEMETRY)
+    sys_telemetry_driver_S driver;
+    for (uint8_t side = LEFT_AVR_DRIVER; side < NUM_AVR_DRIVER; side++)
+    {
+        driver.message[side]      = dev_avr_driver_data.i2c_message[side];
+        driver.encoder[side]      = dev_avr_driver_data.encoderCount[side];
+        driver.frame_error[side]  = (uint16_t)dev_avr_driver_data.frameErrorCount[side];
+        driver.frame_lost[side]   = (uint16_t)dev_avr_driver_data.frameLostCount[side];
+        driver.comm_timeout[side] = (uint16_t)dev_avr_driver_data.commTimeoutCount[side];
+    }
+    sys_telemetry_publish(SYS_TELEMETRY_DRIVER, &driver, sizeof(driver));
+#elif (DEBUG_FPRINT_FEATURE_AVR_DRIVER)
+    PRINTF("[ AVR:DRIVER ] left: %d, right: %d | enc: %d, %d | err: %d, %d | lost: %d, %d | timeout: %d, %d \n", 
+        dev_avr_driver_data.i2c_message[LEFT_AVR_DRIVER], dev_avr_driver_data.i2c_message[RIGHT_AVR_DRIVER],
+        dev_avr_driver_data.encoderCount[LEFT_AVR_DRIVER], dev_avr_driver_data.encoderCount[RIGHT_AVR_DRIVER],
+        dev_avr_driver_data.frameErrorCount[LEFT_AVR_DRIVER], dev_avr_driver_data.frameErrorCount[RIGHT_AVR_DRIVER],
+        dev_avr_driver_data.frameLostCount[LEFT_AVR_DRIVER], dev_avr_driver_data.frameLostCount[RIGHT_AVR_DRIVER],
+        dev_avr_driver_data.commTimeoutCount[LEFT_AVR_DRIVER], dev_avr_driver_data.commTimeoutCount[RIGHT_AVR_DRIVER]);
 #endif // (DEBUG_FPRINT_FEATURE_AVR_DRIVER)
 }
 
+// fast path: latch the e-stop and write it to both drivers right away, outside the 20ms update
+uint8_t dev_avr_driver_Estop_now(int64_t * side_done_us){
+    uint8_t written = 0;
+    const uint16_t message = 0b0000000001000000 | SET_MESSAGE_ESTOP_EN();
+    dev_avr_driver_data.estopLatched = true;
+    for (uint8_t side = LEFT_AVR_DRIVER; side < NUM_AVR_DRIVER; side++)
+    {
+        if (xSemaphoreTake(dev_avr_driver_data.i2c_mutex, I2C_MUTEX_BLOCK_TIME_MS) == pdTRUE)
+        {
+            if (dev_avr_driver_transmit_message(dev_avr_driver_data.address[side], message, SPEED_MESSAGE_EMPTY) == 0)
+            {
+                written ++;
+            }
+            xSemaphoreGive(dev_avr_driver_data.i2c_mutex);
+        }
+        if (side_done_us != NULL)
+        {
+            side_done_us[side] = sys_time_us();
+        }
+    }
+    return written;
+}
+
+void dev_avr_driver_release_Estop_latch(){
+    dev_avr_driver_data.estopLatched = false;
+}
+
+bool dev_avr_driver_is_Estop_latched(){
+    return dev_avr_driver_data.estopLatched;
+}
+
 void dev_avr_driver_set_timeout(uint8_t milliSec){
     dev_avr_driver_data.I2C.setTimeout(milliSec); 
 }
@@ -287,11 +496,32 @@ void dev_avr_driver_set_req_Tof_config(tof_sensor_config_E tof_sensor_config){
 }
 void dev_avr_driver_set_req_Robot_motion(robot_motion_mode_E robot_motion_mode, motor_pwm_duty_E motor_pwm_duty_left, motor_pwm_duty_E motor_pwm_duty_right){
     dev_avr_driver_data.reqEstop = 0;
+    dev_avr_driver_data.reqSpeedControl = 0;
     dev_avr_driver_data.reqRobotMotion = robot_motion_mode;
     dev_avr_driver_data.pwm_duty[LEFT_AVR_DRIVER] = motor_pwm_duty_left;
     dev_avr_driver_data.pwm_duty[RIGHT_AVR_DRIVER] = motor_pwm_duty_right;
 }
 
+static int16_t dev_avr_driver_mm_s_to_setpoint(int16_t speed_mm_s, float mm_per_tick){
+    float setpoint = (float)speed_mm_s * DEV_AVR_DRIVER_SPEED_WINDOW_S / mm_per_tick;
+    if (setpoint > AVR_DRIVER_SPEED_SETPOINT_MAX)
+    {
+        setpoint = AVR_DRIVER_SPEED_SETPOINT_MAX;
+    }
+    else if (setpoint < AVR_DRIVER_SPEED_SETPOINT_MIN)
+    {
+        setpoint = AVR_DRIVER_SPEED_SETPOINT_MIN;
+    }
+    return (int16_t)lroundf(setpoint);
+}
+
+void dev_avr_driver_set_req_Robot_speed(int16_t left_speed_mm_s, int16_t right_speed_mm_s){
+    dev_avr_driver_data.speedSetpoint[LEFT_AVR_DRIVER]  = dev_avr_driver_mm_s_to_setpoint(left_speed_mm_s,  DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK);
+    dev_avr_driver_data.speedSetpoint[RIGHT_AVR_DRIVER] = dev_avr_driver_mm_s_to_setpoint(right_speed_mm_s, DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK);
+    dev_avr_driver_data.reqEstop = 0;
+    dev_avr_driver_data.reqSpeedControl = 1;
+}
+
 void dev_avr_driver_reset_req_Estop(){
     dev_avr_driver_data.reqEstop = 0;
 }
@@ -306,13 +536,14 @@ void dev_avr_driver_reset_req_Tof_config(){
 
 void dev_avr_driver_reset_req_Robot_motion(){
     dev_avr_driver_set_req_Estop();
+    dev_avr_driver_data.reqSpeedControl = 0;
     dev_avr_driver_data.reqRobotMotion = ROBOT_MOTION_BREAK;
     dev_avr_driver_data.pwm_duty[LEFT_AVR_DRIVER] = MOTOR_PWM_DUTY_0_PERCENT;
     dev_avr_driver_data.pwm_duty[RIGHT_AVR_DRIVER] = MOTOR_PWM_DUTY_0_PERCENT;
 }
 
-uint16_t dev_avr_driver_get_EncoderCount(uint8_t driver_side){
-    uint16_t data = 0; 
+int32_t dev_avr_driver_get_EncoderCount(uint8_t driver_side){
+    int32_t data = 0; 
     data = dev_avr_driver_data.encoderCount[driver_side];
     return data;
 }
@@ -337,3 +568,12 @@ uint8_t  dev_avr_driver_get_WaterLevelSig(){
     return data;
 }
 
+float dev_avr_driver_get_WheelSpeed_mm_s(uint8_t driver_side){
+    const float mm_per_tick = (driver_side == LEFT_AVR_DRIVER) ? DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK : DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK;
+    return (float)dev_avr_driver_data.measuredSpeed[driver_side] * mm_per_tick / DEV_AVR_DRIVER_SPEED_WINDOW_S;
+}
+
+uint8_t dev_avr_driver_get_StatusFlags(uint8_t driver_side){
+    return dev_avr_driver_data.statusFlags[driver_side];
+}
+
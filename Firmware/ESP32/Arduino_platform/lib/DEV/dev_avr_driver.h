@@ -32,6 +32,7 @@ extern "C"{
 #define DEV_AVR_DRIVER_WHEEL_MM_PER_TICK_SCALED             (0.00920163F) // (0.5 * (AVG: 0.01840326))
 #define DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM_SCALED     (0.0001192168704F) // (DEV_AVR_DRIVER_WHEEL_MM_PER_TICK_HALF * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM)
 #define DEV_AVR_DRIVER_ENC_BUFFER_SIZE                      (3U) // = 20Hz/10Hz + 1
+#define DEV_AVR_DRIVER_SPEED_WINDOW_S                       (AVR_DRIVER_SPEED_WINDOW_MS / 1000.0F)
 
 
 /////////////////////////////////
@@ -61,6 +62,22 @@ void dev_avr_driver_set_req_Estop();
 void dev_avr_driver_set_req_Haptic();
 void dev_avr_driver_set_req_Tof_config(tof_sensor_config_E tof_sensor_config);
 void dev_avr_driver_set_req_Robot_motion(robot_motion_mode_E robot_motion_mode, motor_pwm_duty_E motor_pwm_duty_left, motor_pwm_duty_E motor_pwm_duty_right);
+/**
+ * @brief Request closed loop wheel speed, regulated by the avr drivers at 1kHz
+ * @param left_speed_mm_s  signed wheel speed, positive drives forward
+ * @param right_speed_mm_s signed wheel speed, positive drives forward
+ */
+void dev_avr_driver_set_req_Robot_speed(int16_t left_speed_mm_s, int16_t right_speed_mm_s);
+
+/**
+ * @brief Fast e-stop, latches the e-stop and writes it to both drivers immediately
+ * @param side_done_us optional [NUM_AVR_DRIVER] esp_timer time each write finished
+ * @return number of drivers that acknowledged the write
+ * @note the latch overrides every motion request until released
+ */
+uint8_t dev_avr_driver_Estop_now(int64_t * side_done_us);
+void dev_avr_driver_release_Estop_latch();
+bool dev_avr_driver_is_Estop_latched();
 
 void dev_avr_driver_reset_req_Estop();
 void dev_avr_driver_reset_req_Haptic();
@@ -71,9 +88,9 @@ void dev_avr_driver_reset_req_Robot_motion();
  * @brief Accesses encoder value from specified motor
  * @param driver_side LEFT_AVR_DRIVER or RIGHT_AVR_DRIVER
  * @see avr_driver_common.h
- * @return 16 bit encoder value
+ * @return free running 32 bit encoder count from the last valid status frame
  */
-uint16_t dev_avr_driver_get_EncoderCount(uint8_t driver_side);
+int32_t dev_avr_driver_get_EncoderCount(uint8_t driver_side);
 /**
  * @brief Accesses left and right encoder value buffers 
  * @param l_enc_buf Left encoder buffer of size DEV_AVR_DRIVER_ENC_BUFFER_SIZE
@@ -82,6 +99,18 @@ uint16_t dev_avr_driver_get_EncoderCount(uint8_t driver_side);
  */
 uint8_t dev_avr_driver_get_encoder_buffers(int16_t* l_enc_buf, int16_t* r_enc_buf);
 uint8_t  dev_avr_driver_get_WaterLevelSig();
+/**
+ * @brief Status flags of the last valid status frame
+ * @param driver_side LEFT_AVR_DRIVER or RIGHT_AVR_DRIVER
+ * @return avr_driver_status_flag_E bits
+ */
+uint8_t dev_avr_driver_get_StatusFlags(uint8_t driver_side);
+/**
+ * @brief Wheel speed measured by the avr driver over its speed window
+ * @param driver_side LEFT_AVR_DRIVER or RIGHT_AVR_DRIVER
+ * @return signed wheel speed in mm/s, positive forward
+ */
+float dev_avr_driver_get_WheelSpeed_mm_s(uint8_t driver_side);
 
 # ifdef __cplusplus  
 }
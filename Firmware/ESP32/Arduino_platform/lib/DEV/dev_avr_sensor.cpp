@@ -10,41 +10,179 @@
 #include "dev_avr_sensor.h"
 
 #include "io_ping_map.h"
-#include <HardwareSerial.h>
 
 #include "../../include/common.h"
+#include "../../include/avr_sensor_common.h"
+#include "../SYS/sys_recorder.h"
+#include "../SYS/sys_time.h"
+#include <string.h>
+
+// ESP-IDF
+#include "driver/uart.h"
 
 
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
+#define SENSOR_AVR_UART_NUM             (UART_NUM_1)
+#define SENSOR_AVR_UART_RX_BUFFER_SIZE  (256U) // driver minimum is the 128 byte hw fifo
+#define SENSOR_AVR_UART_EVENT_QUEUE     (16U)
+// raise a data event after 2 idle symbols, or once a whole frame sits in the fifo
+#define SENSOR_AVR_UART_RX_TIMEOUT      (2U)
+#define SENSOR_AVR_UART_RX_FULL_THRESH  (AVR_SENSOR_FRAME_SIZE)
+
+// single producer (rx task), single consumer (subscriber), head/tail are free running
+typedef struct{
+    dev_avr_sensor_frame_S  frame[DEV_AVR_SENSOR_SUB_QUEUE_SIZE];
+    volatile uint32_t       head;       // written by the producer only
+    volatile uint32_t       tail;       // written by the consumer only
+    uint32_t                dropCount;  // frames lost on a full queue
+    TaskHandle_t            notify_task;
+    uint32_t                notify_bit;
+} dev_avr_sensor_sub_queue_S;
+
 typedef struct{
-    bool newData;
-    uint8_t sensor_rx_data;
-} dev_tof_lidar_data_S;
+    QueueHandle_t               uart_queue;
+    portMUX_TYPE                latest_mux;
+    dev_avr_sensor_frame_S      latest;     // Protected By: 'latest_mux'
+    bool                        received;   // Protected By: 'latest_mux'
+    uint8_t                     frame[AVR_SENSOR_FRAME_SIZE];
+    uint8_t                     frame_index;
+    uint8_t                     sequence;
+    bool                        synced;
+    uint32_t                    frameErrorCount;    // crc failures
+    uint32_t                    frameLostCount;     // gaps in sequence number
+    uint32_t                    uartOverflowCount;  // bytes dropped by the uart driver
+    dev_avr_sensor_sub_queue_S  sub[DEV_AVR_SENSOR_SUB_COUNT];
+} dev_avr_sensor_data_S;
 
 /////////////////////////////////////////
 ///////   PRIVATE PROTOTYPE     /////////
 /////////////////////////////////////////
 static inline void dev_avr_sensor_private_gpio_config(void);
+static void dev_avr_sensor_private_parse_byte(uint8_t byte, int64_t stamp_us);
+static void dev_avr_sensor_private_publish(const dev_avr_sensor_frame_S * frame);
 
 ///////////////////////////
 ///////   DATA     ////////
 ///////////////////////////
-dev_tof_lidar_data_S sensor_avr_data = {
-    false,
-    0
+static dev_avr_sensor_data_S sensor_avr_data = {
+    .uart_queue         = NULL,
+    .latest_mux         = portMUX_INITIALIZER_UNLOCKED,
+    .latest             = {0},
+    .received           = false,
+    .frame              = {0},
+    .frame_index        = 0,
+    .sequence           = 0,
+    .synced             = false,
+    .frameErrorCount    = 0,
+    .frameLostCount     = 0,
+    .uartOverflowCount  = 0,
+    .sub                = {},
 };
 
-HardwareSerial MySerial(1);
-
 
 ////////////////////////////////////////
 ///////   PRIVATE FUNCTION     /////////
 ////////////////////////////////////////
 static inline void dev_avr_sensor_private_gpio_config(void)
 {
-    MySerial.begin(SENSOR_AVR_BAUD, SERIAL_8N1, SENSOR_AVR_UART_RX, SENSOR_AVR_UART_TX);
+    const uart_config_t uart_config = {
+        .baud_rate  = SENSOR_AVR_BAUD,
+        .data_bits  = UART_DATA_8_BITS,
+        .parity     = UART_PARITY_DISABLE,
+        .stop_bits  = UART_STOP_BITS_1,
+        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
+    };
+    uart_param_config(SENSOR_AVR_UART_NUM, &uart_config);
+    uart_set_pin(SENSOR_AVR_UART_NUM, SENSOR_AVR_UART_TX, SENSOR_AVR_UART_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_driver_install(SENSOR_AVR_UART_NUM, SENSOR_AVR_UART_RX_BUFFER_SIZE, 0,
+        SENSOR_AVR_UART_EVENT_QUEUE, &sensor_avr_data.uart_queue, 0);
+
+    // default thresholds (10 symbols, 120 bytes) would hold a frame back for ~1ms
+    uart_intr_config_t intr_config = {
+        .intr_enable_mask = UART_RXFIFO_FULL_INT_ENA_M | UART_RXFIFO_TOUT_INT_ENA_M
+            | UART_FRM_ERR_INT_ENA_M | UART_RXFIFO_OVF_INT_ENA_M,
+        .rx_timeout_thresh          = SENSOR_AVR_UART_RX_TIMEOUT,
+        .txfifo_empty_intr_thresh   = 0,
+        .rxfifo_full_thresh         = SENSOR_AVR_UART_RX_FULL_THRESH,
+    };
+    uart_intr_config(SENSOR_AVR_UART_NUM, &intr_config);
+}
+
+// push to every subscriber queue, a full queue keeps its oldest frames
+static void dev_avr_sensor_private_publish(const dev_avr_sensor_frame_S * frame)
+{
+    for (uint8_t i = 0; i < DEV_AVR_SENSOR_SUB_COUNT; i++)
+    {
+        dev_avr_sensor_sub_queue_S * sub = &sensor_avr_data.sub[i];
+        const uint32_t head = sub->head;
+        if ((head - __atomic_load_n(&sub->tail, __ATOMIC_ACQUIRE)) >= DEV_AVR_SENSOR_SUB_QUEUE_SIZE)
+        {
+            sub->dropCount ++;
+        }
+        else
+        {
+            sub->frame[head & (DEV_AVR_SENSOR_SUB_QUEUE_SIZE - 1U)] = *frame;
+            __atomic_store_n(&sub->head, head + 1U, __ATOMIC_RELEASE);
+        }
+        if (sub->notify_task != NULL)
+        {
+            xTaskNotify(sub->notify_task, sub->notify_bit, eSetBits);
+        }
+    }
+}
+
+// frame hunting, a byte stream with a bad crc is rescanned for the next sync byte
+static void dev_avr_sensor_private_parse_byte(uint8_t byte, int64_t stamp_us)
+{
+    if ((sensor_avr_data.frame_index == 0) && (byte != AVR_SENSOR_FRAME_SYNC))
+    {
+        return;
+    }
+    sensor_avr_data.frame[sensor_avr_data.frame_index++] = byte;
+    if (sensor_avr_data.frame_index < AVR_SENSOR_FRAME_SIZE)
+    {
+        return;
+    }
+
+    if (sensor_avr_data.frame[AVR_SENSOR_FRAME_INDEX_CRC] != avr_sensor_crc8(sensor_avr_data.frame, AVR_SENSOR_FRAME_INDEX_CRC))
+    {
+        sensor_avr_data.frameErrorCount ++;
+        uint8_t next = 1;
+        while ((next < AVR_SENSOR_FRAME_SIZE) && (sensor_avr_data.frame[next] != AVR_SENSOR_FRAME_SYNC))
+        {
+            next ++;
+        }
+        sensor_avr_data.frame_index = AVR_SENSOR_FRAME_SIZE - next;
+        memmove(sensor_avr_data.frame, &sensor_avr_data.frame[next], sensor_avr_data.frame_index);
+        return;
+    }
+    sensor_avr_data.frame_index = 0;
+#if (FEATURE_SYS_RECORDER)
+    sys_recorder_record(SYS_RECORDER_AVR_SENSOR, sensor_avr_data.frame);
+#endif // (FEATURE_SYS_RECORDER)
+
+    uint8_t sequence = sensor_avr_data.frame[AVR_SENSOR_FRAME_INDEX_SEQUENCE];
+    if (sensor_avr_data.synced)
+    {
+        sensor_avr_data.frameLostCount += (uint8_t)(sequence - sensor_avr_data.sequence - 1U);
+    }
+    sensor_avr_data.synced = true;
+    sensor_avr_data.sequence = sequence;
+
+    dev_avr_sensor_frame_S frame;
+    frame.stamp_us = stamp_us;
+    frame.sequence = sequence;
+    frame.flags    = sensor_avr_data.frame[AVR_SENSOR_FRAME_INDEX_FLAGS];
+    memcpy(frame.ir_raw, &sensor_avr_data.frame[AVR_SENSOR_FRAME_INDEX_IR_FRONT_1], AVR_SENSOR_FRAME_IR_COUNT);
+
+    portENTER_CRITICAL(&sensor_avr_data.latest_mux);
+    sensor_avr_data.latest   = frame;
+    sensor_avr_data.received = true;
+    portEXIT_CRITICAL(&sensor_avr_data.latest_mux);
+
+    dev_avr_sensor_private_publish(&frame);
 }
 
 ///////////////////////////////////////
@@ -55,33 +193,107 @@ void dev_avr_sensor_init(void)
     dev_avr_sensor_private_gpio_config();
 }
 
-void dev_avr_sensor_uart_update(void)
+// blocks on the uart event queue, call from the sensor rx task only
+void dev_avr_sensor_uart_process(TickType_t timeout)
 {
-    while (MySerial.available() > 0) 
+    uart_event_t event;
+    if (xQueueReceive(sensor_avr_data.uart_queue, &event, timeout) != pdTRUE)
+    {
+        return;
+    }
+
+    switch (event.type)
     {
-        sensor_avr_data.sensor_rx_data = MySerial.read();
-        sensor_avr_data.newData = true;
+        case UART_DATA:
+        {
+            // stamp once per event, bytes in one event arrived within a few symbols
+            const int64_t stamp_us = sys_time_us();
+            uint8_t buffer[SENSOR_AVR_UART_RX_BUFFER_SIZE];
+            int length = uart_read_bytes(SENSOR_AVR_UART_NUM, buffer, sizeof(buffer), 0);
+            for (int i = 0; i < length; i++)
+            {
+                dev_avr_sensor_private_parse_byte(buffer[i], stamp_us);
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // bytes are gone, restart frame hunting on a clean buffer
+            sensor_avr_data.uartOverflowCount ++;
+            sensor_avr_data.frame_index = 0;
+            uart_flush_input(SENSOR_AVR_UART_NUM);
+            xQueueReset(sensor_avr_data.uart_queue);
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            sensor_avr_data.frameErrorCount ++;
+            break;
+        default:
+            break;
     }
 }
 
+// latest flags, no sensor when nothing arrived within the stale timeout
 uint8_t dev_avr_sensor_uart_get(void)
 {
-    if (sensor_avr_data.newData == true) 
+    uint8_t flags = DEV_AVR_NO_SENSOR;
+    portENTER_CRITICAL(&sensor_avr_data.latest_mux);
+    if (sensor_avr_data.received
+        && ((sys_time_us() - sensor_avr_data.latest.stamp_us) <= DEV_AVR_SENSOR_STALE_TIMEOUT_US))
     {
-        return sensor_avr_data.sensor_rx_data;
-        sensor_avr_data.newData = false;
+        flags = sensor_avr_data.latest.flags;
     }
-    return 0;
+    portEXIT_CRITICAL(&sensor_avr_data.latest_mux);
+    return flags;
+}
+
+bool dev_avr_sensor_is_stale(void)
+{
+    bool stale;
+    portENTER_CRITICAL(&sensor_avr_data.latest_mux);
+    stale = (!sensor_avr_data.received)
+        || ((sys_time_us() - sensor_avr_data.latest.stamp_us) > DEV_AVR_SENSOR_STALE_TIMEOUT_US);
+    portEXIT_CRITICAL(&sensor_avr_data.latest_mux);
+    return stale;
 }
 
-uint8_t dev_avr_sensor_uart_read(void)
+// raw 8 bit IR reading, index in frame order (front 1, front 2, right 1, right 2, left 1, left 2)
+uint8_t dev_avr_sensor_ir_raw_get(uint8_t index)
 {
-    dev_avr_sensor_uart_update();
-    return dev_avr_sensor_uart_get();
+    uint8_t raw = 0;
+    if (index < AVR_SENSOR_FRAME_IR_COUNT)
+    {
+        portENTER_CRITICAL(&sensor_avr_data.latest_mux);
+        raw = sensor_avr_data.latest.ir_raw[index];
+        portEXIT_CRITICAL(&sensor_avr_data.latest_mux);
+    }
+    return raw;
 }
 
-// void dev_avr_test_code(void)
-// {
-//     // printf("Avr Sensor Readings: %c%c%c%c%c%c%c%c\n", BYTE_TO_BINARY(dev_avr_sensor_uart_read()));
-//     // delay(500);    
-// }
+// set 'bit' in the notification value of 'task' on every frame pushed to the 'sub' queue
+void dev_avr_sensor_register_notify(dev_avr_sensor_sub_E sub, TaskHandle_t task, uint32_t bit)
+{
+    if (sub < DEV_AVR_SENSOR_SUB_COUNT)
+    {
+        sensor_avr_data.sub[sub].notify_bit  = bit;
+        sensor_avr_data.sub[sub].notify_task = task; // publish the task last, the rx task may be running
+    }
+}
+
+// oldest unread frame of the subscriber, false when its queue is empty
+bool dev_avr_sensor_frame_pop(dev_avr_sensor_sub_E sub, dev_avr_sensor_frame_S * frame)
+{
+    if (sub >= DEV_AVR_SENSOR_SUB_COUNT)
+    {
+        return false;
+    }
+    dev_avr_sensor_sub_queue_S * queue = &sensor_avr_data.sub[sub];
+    const uint32_t tail = queue->tail;
+    if (tail == __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+    *frame = queue->frame[tail & (DEV_AVR_SENSOR_SUB_QUEUE_SIZE - 1U)];
+    __atomic_store_n(&queue->tail, tail + 1U, __ATOMIC_RELEASE);
+    return true;
+}
@@ -12,15 +12,27 @@
 #define DEV_AVR_SENSOR_H
 # ifdef __cplusplus
 extern "C"{
-# endif 
+# endif
 
 #include <stdint.h>
+#include <stdbool.h>
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "../../include/avr_sensor_common.h"
 
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
 #define SENSOR_AVR_BAUD 115200
 
+// a frame is sent at least every 20ms, data older than a few frames is stale
+#define DEV_AVR_SENSOR_STALE_TIMEOUT_US     (100000LL)
+// frames each subscriber can hold before the newest is dropped (power of 2)
+#define DEV_AVR_SENSOR_SUB_QUEUE_SIZE       (8U)
+
 typedef enum{
     DEV_AVR_NO_SENSOR           = (0U),
     DEV_AVR_LEFT_COLLISION      = (1<<0U),
@@ -32,21 +44,39 @@ typedef enum{
     DEV_AVR_LEFT_IR_1           = (1<<6U),
     DEV_AVR_LEFT_IR_2           = (1<<7U),
     DEV_AVR_ALL_IR_SENSORS      = (
-        DEV_AVR_FRONT_IR_1 | DEV_AVR_FRONT_IR_2 | DEV_AVR_RIGHT_IR_1 
+        DEV_AVR_FRONT_IR_1 | DEV_AVR_FRONT_IR_2 | DEV_AVR_RIGHT_IR_1
         | DEV_AVR_RIGHT_IR_2 | DEV_AVR_LEFT_IR_1 | DEV_AVR_LEFT_IR_2
     ),
     DEV_AVR_ALL_SENSORS         = (0xFF)
 } DEV_AVR_SENSOR_E;
 
+// frame consumers, each one owns a single producer single consumer queue
+typedef enum{
+    DEV_AVR_SENSOR_SUB_SUPERVISOR,
+    DEV_AVR_SENSOR_SUB_SLAM,
+    DEV_AVR_SENSOR_SUB_HAZARD,
+    DEV_AVR_SENSOR_SUB_COUNT
+} dev_avr_sensor_sub_E;
+
+typedef struct{
+    int64_t stamp_us;                           // esp_timer time the frame was received
+    uint8_t sequence;
+    uint8_t flags;                              // DEV_AVR_SENSOR_E bits
+    uint8_t ir_raw[AVR_SENSOR_FRAME_IR_COUNT];
+} dev_avr_sensor_frame_S;
+
 ///////////////////////////////////////
 ///////   PUBLIC PROTOTYPE    /////////
 ///////////////////////////////////////
 void dev_avr_sensor_init(void);
-void dev_avr_sensor_uart_update(void);
+void dev_avr_sensor_uart_process(TickType_t timeout);
 uint8_t dev_avr_sensor_uart_get(void);
-uint8_t dev_avr_sensor_uart_read(void);
+bool dev_avr_sensor_is_stale(void);
+uint8_t dev_avr_sensor_ir_raw_get(uint8_t index);
+void dev_avr_sensor_register_notify(dev_avr_sensor_sub_E sub, TaskHandle_t task, uint32_t bit);
+bool dev_avr_sensor_frame_pop(dev_avr_sensor_sub_E sub, dev_avr_sensor_frame_S * frame);
 
-# ifdef __cplusplus  
+# ifdef __cplusplus
 }
-# endif 
-#endif //DEV_AVR_SENSOR_H
\ No newline at end of file
+# endif
+#endif //DEV_AVR_SENSOR_H
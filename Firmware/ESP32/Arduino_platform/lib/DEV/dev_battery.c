@@ -9,6 +9,10 @@
 
 #include "dev_battery.h"
 
+// TableUV Lib
+#include "../../include/common.h"
+#include "../SYS/sys_recorder.h"
+
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
@@ -17,6 +21,10 @@ typedef struct {
     float battery_voltage;              // Volts
     int32_t battery_voltage_raw;        // 0 - 4096
     charger_ic_status_E charger_status;
+    TaskHandle_t notify_task;           // notified when the voltage crosses 'notify_threshold_v'
+    uint32_t notify_bit;
+    float notify_threshold_v;
+    bool below_threshold;
 } dev_battery_data_S;
 
 /////////////////////////////////////////
@@ -80,8 +88,17 @@ void dev_battery_update(void)
         printf("ADC2 used by Wi-Fi.\n");
     }
 
+#if (FEATURE_SYS_RECORDER)
+    sys_recorder_record(SYS_RECORDER_BATTERY, &battery_data.battery_voltage_raw);
+#endif // (FEATURE_SYS_RECORDER)
     battery_data.battery_voltage = DEV_BATTERY_RAW_TO_VOLTAGE(battery_data.battery_voltage_raw);
 
+    const bool below_threshold = (battery_data.battery_voltage < battery_data.notify_threshold_v);
+    if ((below_threshold != battery_data.below_threshold) && (battery_data.notify_task != NULL))
+    {
+        xTaskNotify(battery_data.notify_task, battery_data.notify_bit, eSetBits);
+    }
+    battery_data.below_threshold = below_threshold;
 }
 
 float dev_battery_get(void)
@@ -132,6 +149,14 @@ charger_ic_status_E dev_charger_status_read(void)
     return battery_data.charger_status;
 }
 
+void dev_battery_register_notify(TaskHandle_t task, uint32_t bit, float threshold_v)
+{
+    battery_data.notify_bit = bit;
+    battery_data.notify_threshold_v = threshold_v;
+    battery_data.below_threshold = (battery_data.battery_voltage < threshold_v);
+    battery_data.notify_task = task;
+}
+
 void dev_battery_test_code(void)
 {
     dev_battery_update();
@@ -46,6 +46,7 @@ void dev_charger_status_update(void);
 charger_ic_status_E dev_charger_status_get(void);
 charger_ic_status_E dev_charger_status_read(void);
 void dev_battery_test_code(void);
+void dev_battery_register_notify(TaskHandle_t task, uint32_t bit, float threshold_v);
 
 # ifdef __cplusplus  
 }
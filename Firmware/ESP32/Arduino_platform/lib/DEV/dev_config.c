@@ -72,9 +72,6 @@ void dev_init(void)
 
 void dev_run50ms(void)
 {
-#if (FEATURE_SENSOR_AVR)
-    dev_avr_sensor_uart_update();
-#endif
 #if (FEATURE_LIDAR)
     dev_ToF_Lidar_update20ms();
 #endif
@@ -12,6 +12,8 @@
 // TableUV Lib
 #include "../IO/io_ping_map.h"
 #include "../../include/common.h"
+#include "../SYS/sys_recorder.h"
+#include "../SYS/sys_time.h"
 
 // Arduino Lib
 #include <ICM_20948.h>
@@ -20,6 +22,9 @@
 ///////   DEFINITION     ////////
 /////////////////////////////////
 #define ACC_CONST 		(9.80665) // [m/s^2]
+#if (FEATURE_SYS_RECORDER)
+static_assert(IMU_AXIS_IMU_COUNT == SYS_RECORDER_IMU_AXIS_COUNT, "recorder imu payload follows IMU_AXIS_E");
+#endif // (FEATURE_SYS_RECORDER)
 
 typedef struct
 {
@@ -55,7 +60,7 @@ static inline void dev_imu_private_setup(void)
         imu_data.sensor.begin(CS_3V3, imu_data.spi);
         if (imu_data.sensor.status != ICM_20948_Stat_Ok)
         {
-              delay(100);
+              sys_time_delay_ms(100);
         }
         else
         {
@@ -96,6 +101,9 @@ bool dev_imu_get_values(float* data_ptr)
     data_ptr[IMU_AXIS_MAG_X] = imu_data.sensor.magX();					  // [uT]
     data_ptr[IMU_AXIS_MAG_Y] = imu_data.sensor.magY();					  // [uT]
     data_ptr[IMU_AXIS_MAG_Z] = imu_data.sensor.magZ();					  // [uT]
+#if (FEATURE_SYS_RECORDER)
+    sys_recorder_record(SYS_RECORDER_IMU, data_ptr);
+#endif // (FEATURE_SYS_RECORDER)
 
     return true;
 }
@@ -11,6 +11,9 @@
 
 // TableUV Lib
 #include "../IO/io_ping_map.h"
+#include "../../include/common.h"
+#include "../SYS/sys_recorder.h"
+#include "../SYS/sys_time.h"
 
 // External Lib
 #include "driver/gpio.h"
@@ -21,10 +24,15 @@
 #define CHECK_MSEC          50   // Read hardware every 5 msec
 #define PRESS_MSEC          100  // Stable time before registering pressed
 #define RELEASE_MSEC        100 // Stable time before registering released
+#define PRESS_LOCKOUT_US    (250000LL) // edges within this time of a press are bounce
 
 typedef struct{
     volatile bool button_pressed;
     volatile uint32_t button_count;
+    volatile bool button_press_pending;
+    int64_t button_press_stamp_us;
+    TaskHandle_t button_notify_task;
+    uint32_t button_notify_bit;
     bool green_led_on;
     bool red_led_on;
     bool orange_led_on;
@@ -41,6 +49,10 @@ static inline void dev_led_private_gpio_config(void);
 static dev_led_peripherals_data_S peripheral_data = {
     .button_pressed = false,
     .button_count = 0,
+    .button_press_pending = false,
+    .button_press_stamp_us = 0,
+    .button_notify_task = NULL,
+    .button_notify_bit = 0,
     .green_led_on = false,
     .red_led_on = false,
     .orange_led_on = false
@@ -53,6 +65,26 @@ static dev_led_peripherals_data_S peripheral_data = {
 static void IRAM_ATTR button_isr_handler(void)
 {
     peripheral_data.button_count++;    
+
+    // first edge is the press, the bounce after it is ignored
+    const int64_t now_us = sys_time_us();
+    if ((now_us - peripheral_data.button_press_stamp_us) >= PRESS_LOCKOUT_US)
+    {
+        peripheral_data.button_press_stamp_us = now_us;
+        __atomic_store_n(&peripheral_data.button_press_pending, true, __ATOMIC_RELEASE);
+#if (FEATURE_SYS_RECORDER)
+        sys_recorder_record_from_isr(SYS_RECORDER_BUTTON, NULL);
+#endif // (FEATURE_SYS_RECORDER)
+        if (peripheral_data.button_notify_task != NULL)
+        {
+            BaseType_t woken = pdFALSE;
+            xTaskNotifyFromISR(peripheral_data.button_notify_task, peripheral_data.button_notify_bit, eSetBits, &woken);
+            if (woken == pdTRUE)
+            {
+                portYIELD_FROM_ISR();
+            }
+        }
+    }
 }
 
 static inline void dev_led_private_gpio_config(void)
@@ -119,6 +151,19 @@ bool dev_button_get(void)
     return temp_button_pressed;
 }
 
+// debounced press from the isr, cleared once taken; one exchange, a press from the other core in between is kept
+bool dev_button_take_press(void)
+{
+    return __atomic_exchange_n(&peripheral_data.button_press_pending, false, __ATOMIC_ACQ_REL);
+}
+
+// set 'bit' in the notification value of 'task' on every debounced press
+void dev_button_register_notify(TaskHandle_t task, uint32_t bit)
+{
+    peripheral_data.button_notify_bit  = bit;
+    peripheral_data.button_notify_task = task;
+}
+
 bool dev_button_read(void)
 {
     return !(gpio_get_level(BUTTON));
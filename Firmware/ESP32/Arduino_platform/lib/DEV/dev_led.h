@@ -15,11 +15,18 @@ extern "C"{
 # endif 
 
 #include <stdbool.h>
+#include <stdint.h>
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 void dev_led_init(void);
 void dev_button_update(void);
 bool dev_button_update_50ms(void);
 bool dev_button_get(void);
+bool dev_button_take_press(void);
+void dev_button_register_notify(TaskHandle_t task, uint32_t bit);
 void dev_led_update(void);
 void dev_led_green_set(bool led_on);
 void dev_led_red_set(bool led_on);
@@ -5,6 +5,9 @@
  * @brief Math algorithm
  *
  * This document will contains math algo.
+ *
+ * Single precision only: the esp32 fpu has no double, a promoted operand falls back to soft float,
+ * so double promotion is an error here and trig goes through the tables below.
  */
 
 #include "slam_math.h"
@@ -13,53 +16,85 @@
 
 // External Lib
 
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
+#define SLAM_MATH_SIN_STEP_PER_RAD      ((float)(SLAM_MATH_LUT_SIZE) / (SLAM_MATH_PI_2))
+#define SLAM_MATH_SIN_STEP_MASK         ((4U * (SLAM_MATH_LUT_SIZE)) - 1U)
 
+_Static_assert((SLAM_MATH_LUT_SIZE & (SLAM_MATH_LUT_SIZE - 1U)) == 0U, "the quadrant split masks the lut size");
 
 /////////////////////////////////////////
 ///////   PRIVATE PROTOTYPE     /////////
 /////////////////////////////////////////
-
+static float slam_math_private_sinStep(float step);
 
 ///////////////////////////
 ///////   DATA     ////////
 ///////////////////////////
-
+// one guard entry each, so the interpolation never reads past the end; in dram, off the flash cache
+static float slam_math_sin_lut[SLAM_MATH_LUT_SIZE + 1U];    // sin over [0, pi/2]
+static float slam_math_atan_lut[SLAM_MATH_LUT_SIZE + 1U];   // atan over [0, 1]
 
 ////////////////////////////////////////
 ///////   PRIVATE FUNCTION     /////////
 ////////////////////////////////////////
+// 'step' in quarter turns times SLAM_MATH_LUT_SIZE, quadrants mirror the first one
+static float slam_math_private_sinStep(float step)
+{
+    int32_t whole = (int32_t)step;
+    if (step < (float)whole)
+    {
+        whole --; // floor for negative angles
+    }
+    const float frac = step - (float)whole;
+    const uint32_t wrapped = (uint32_t)whole & SLAM_MATH_SIN_STEP_MASK;
+    const uint32_t quadrant = wrapped / SLAM_MATH_LUT_SIZE;
+    const uint32_t index = wrapped % SLAM_MATH_LUT_SIZE;
+
+    float value;
+    if ((quadrant & 1U) == 0U)
+    {
+        value = slam_math_sin_lut[index] + frac * (slam_math_sin_lut[index + 1U] - slam_math_sin_lut[index]);
+    }
+    else
+    {
+        const uint32_t mirror = SLAM_MATH_LUT_SIZE - index;
+        value = slam_math_sin_lut[mirror] + frac * (slam_math_sin_lut[mirror - 1U] - slam_math_sin_lut[mirror]);
+    }
+    return (quadrant < 2U) ? value : -value;
+}
 
 ///////////////////////////////////////
 ///////   PUBLIC FUNCTION     /////////
 ///////////////////////////////////////
-math_cart_coord_float_S slam_math_get_enc_pose(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size) 
+math_cart_coord_float_S slam_math_get_enc_pose(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size)
 {
     float r_wheel_disp, l_wheel_disp, robot_disp, robot_theta;
-    math_cart_coord_float_S total_sum = {0, 0};
+    math_cart_coord_float_S total_sum = {0.0F, 0.0F};
 
     for (uint8_t i = 0; i < buffer_size; i ++)
     {
         r_wheel_disp = r_enc_buf[i] * DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK;
         l_wheel_disp = l_enc_buf[i] * DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK;
 
-        robot_disp = (r_wheel_disp + l_wheel_disp) * 0.5;
-        robot_theta = (r_wheel_disp - l_wheel_disp) * 0.5 * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM;
-        total_sum.x = total_sum.x + robot_disp * cos(robot_theta);
-        total_sum.y = total_sum.y + robot_disp * sin(robot_theta);
+        robot_disp = (r_wheel_disp + l_wheel_disp) * 0.5F;
+        robot_theta = (r_wheel_disp - l_wheel_disp) * 0.5F * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM;
+        total_sum.x = total_sum.x + robot_disp * slam_math_cosf(robot_theta);
+        total_sum.y = total_sum.y + robot_disp * slam_math_sinf(robot_theta);
     }
 
     return total_sum;
 }
 
-math_cart_coord_float_S slam_math_get_enc_pose_optimized(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size) 
+math_cart_coord_float_S slam_math_get_enc_pose_optimized(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size)
 {
     float robot_disp, robot_theta;
     int32_t delta_disp, sum_disp;
-    float x = 0;
-    float y = 0;
+    float x = 0.0F;
+    float y = 0.0F;
 
     for (uint8_t i = 0; i < buffer_size; i ++)
     {
@@ -69,15 +104,15 @@ math_cart_coord_float_S slam_math_get_enc_pose_optimized(int16_t* l_enc_buf, int
         robot_disp = sum_disp * DEV_AVR_DRIVER_WHEEL_MM_PER_TICK_SCALED;
         robot_theta = delta_disp *  DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM_SCALED;
 
-        x = x + robot_disp * cos(robot_theta);
-        y = y + robot_disp * sin(robot_theta);
+        x = x + robot_disp * slam_math_cosf(robot_theta);
+        y = y + robot_disp * slam_math_sinf(robot_theta);
     }
 
     math_cart_coord_float_S total_sum = {x, y};
     return total_sum;
 }
 
-math_cart_coord_float_S slam_math_get_enc_pose_reduced(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size) 
+math_cart_coord_float_S slam_math_get_enc_pose_reduced(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size)
 {
     float r_wheel_disp, l_wheel_disp, robot_disp, robot_theta;
     math_cart_coord_float_S total_sum;
@@ -89,16 +124,87 @@ math_cart_coord_float_S slam_math_get_enc_pose_reduced(int16_t* l_enc_buf, int16
         r_wheel_disp = r_enc_buf[i] * DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK;
         l_wheel_disp = l_enc_buf[i] * DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK;
 
-        robot_disp += (r_wheel_disp + l_wheel_disp) * 0.5;
-        robot_theta += (r_wheel_disp - l_wheel_disp) * 0.5 * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM;
+        robot_disp += (r_wheel_disp + l_wheel_disp) * 0.5F;
+        robot_theta += (r_wheel_disp - l_wheel_disp) * 0.5F * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM;
     }
 
-    total_sum.x = robot_disp * cos(robot_theta);
-    total_sum.y = robot_disp * sin(robot_theta);
+    total_sum.x = robot_disp * slam_math_cosf(robot_theta);
+    total_sum.y = robot_disp * slam_math_sinf(robot_theta);
     return total_sum;
 }
 
 float slam_math_get_theta(math_cart_coord_float_S input_coord)
 {
-    return atan2f(input_coord.y, input_coord.x);
-}
\ No newline at end of file
+    return slam_math_atan2f(input_coord.y, input_coord.x);
+}
+
+math_cart_coord_float_S slam_math_get_enc_odometry(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size, float * dtheta_rad)
+{
+    float r_wheel_disp, l_wheel_disp, robot_disp, robot_half_theta;
+    float heading = 0.0F;
+    math_cart_coord_float_S total_sum = {0.0F, 0.0F};
+
+    for (uint8_t i = 0; i < buffer_size; i ++)
+    {
+        r_wheel_disp = r_enc_buf[i] * DEV_AVR_DRIVER_R_WHEEL_MM_PER_TICK;
+        l_wheel_disp = l_enc_buf[i] * DEV_AVR_DRIVER_L_WHEEL_MM_PER_TICK;
+
+        robot_disp = (r_wheel_disp + l_wheel_disp) * 0.5F;
+        robot_half_theta = (r_wheel_disp - l_wheel_disp) * 0.5F * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM;
+        // the chord of an arc leaves at half its turn
+        total_sum.x = total_sum.x + robot_disp * slam_math_cosf(heading + robot_half_theta);
+        total_sum.y = total_sum.y + robot_disp * slam_math_sinf(heading + robot_half_theta);
+        heading += 2.0F * robot_half_theta;
+    }
+
+    *dtheta_rad = heading;
+    return total_sum;
+}
+
+void slam_math_init(void)
+{
+    for (uint32_t i = 0U; i <= SLAM_MATH_LUT_SIZE; i ++)
+    {
+        slam_math_sin_lut[i]  = sinf((float)i * (SLAM_MATH_PI_2 / (float)SLAM_MATH_LUT_SIZE));
+        slam_math_atan_lut[i] = atanf((float)i / (float)SLAM_MATH_LUT_SIZE);
+    }
+}
+
+float slam_math_sinf(float rad)
+{
+    return slam_math_private_sinStep(rad * SLAM_MATH_SIN_STEP_PER_RAD);
+}
+
+float slam_math_cosf(float rad)
+{
+    return slam_math_private_sinStep(rad * SLAM_MATH_SIN_STEP_PER_RAD + (float)SLAM_MATH_LUT_SIZE);
+}
+
+// octant reduction onto atan over [0, 1], one division
+float slam_math_atan2f(float y, float x)
+{
+    const float ax = fabsf(x);
+    const float ay = fabsf(y);
+    if ((ax == 0.0F) && (ay == 0.0F))
+    {
+        return 0.0F;
+    }
+    const bool steep = (ay > ax);
+    const float step = (steep ? (ax / ay) : (ay / ax)) * (float)SLAM_MATH_LUT_SIZE;
+    uint32_t index = (uint32_t)step;
+    if (index >= SLAM_MATH_LUT_SIZE)
+    {
+        index = SLAM_MATH_LUT_SIZE - 1U;
+    }
+    const float frac = step - (float)index;
+    float angle = slam_math_atan_lut[index] + frac * (slam_math_atan_lut[index + 1U] - slam_math_atan_lut[index]);
+    if (steep)
+    {
+        angle = SLAM_MATH_PI_2 - angle;
+    }
+    if (x < 0.0F)
+    {
+        angle = SLAM_MATH_PI - angle;
+    }
+    return (y < 0.0F) ? -angle : angle;
+}
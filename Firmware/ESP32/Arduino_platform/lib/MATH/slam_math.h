@@ -24,6 +24,10 @@ extern "C"{
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
+#define SLAM_MATH_LUT_SIZE              (256U)  // steps per quarter turn (sin) and per unit slope (atan), a power of 2
+#define SLAM_MATH_PI                    (3.14159265358979323846F)
+#define SLAM_MATH_PI_2                  (1.57079632679489661923F)
+
 typedef struct{
     int32_t x;
     int32_t y;
@@ -52,6 +56,35 @@ math_cart_coord_float_S slam_math_get_enc_pose_reduced(int16_t* l_enc_buf, int16
 
 float slam_math_get_theta(math_cart_coord_float_S input_coord);
 
+/**
+ * @brief Integrates the encoder buffer into one chord and the heading change over it
+ * 
+ * Each sample runs along its own arc from the heading the samples before it left, so a turn on the spot
+ * still turns and a curve spread over the buffer still curves.
+ * 
+ * @param l_enc_buf: Input left encoder buffer of size 'buffer_size'
+ * @param r_enc_buf: Input right encoder buffer of size 'buffer_size'
+ * @param buffer_size: the buffer size 
+ * @param dtheta_rad: Output heading change over the buffer, + turns left
+ * 
+ * @return returns the chord in the robot frame at the start of the buffer (x forward, y left)
+ */
+math_cart_coord_float_S slam_math_get_enc_odometry(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size, float * dtheta_rad);
+
+/**
+ * @brief fill the trig tables, once before any other call
+ */
+void slam_math_init(void);
+/**
+ * @brief single precision, table driven trig, linear interpolation between the entries
+ * 
+ * sin / cos: |error| < 1e-5 up to ~100 rad, the float resolution of the angle dominates beyond
+ * atan2: |error| < 2e-6 rad, result in [-pi, pi], 0 for (0, 0)
+ */
+float slam_math_sinf(float rad);
+float slam_math_cosf(float rad);
+float slam_math_atan2f(float y, float x);
+
 # ifdef __cplusplus  
 }
 # endif 
@@ -0,0 +1,161 @@
+/**
+ * @file    sys_bench.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the kernel microbenchmark harness,
+ * the timings include the indirect call of the body, compare kernels with each other rather than to zero
+ */
+
+#include "sys_bench.h"
+
+// Std. Lib
+#include <stdio.h>
+
+#if defined(__XTENSA__)
+// TableUV Lib
+#include "sys_perf.h"
+// SDK config
+#include "sdkconfig.h"
+#else
+// Std. Lib
+#include <time.h>
+#endif // defined(__XTENSA__)
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#if defined(__XTENSA__)
+#define SYS_BENCH_COUNTER_NAME          "ccount"
+#define SYS_BENCH_NS_PER_TICK           (1000.0F / (float)(CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ))
+#else
+#define SYS_BENCH_COUNTER_NAME          "clock_monotonic"
+#define SYS_BENCH_NS_PER_TICK           (1.0F)
+#endif // defined(__XTENSA__)
+
+#define SYS_BENCH_P90_INDEX             ((SYS_BENCH_SAMPLE_COUNT * 9U) / 10U)
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static inline uint32_t sys_bench_private_counter(void);
+static uint32_t sys_bench_private_sample(const sys_bench_case_S * bench_case, uint32_t iterations);
+static void sys_bench_private_sort(uint32_t * values, uint32_t count);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static uint32_t sys_bench_sample[SYS_BENCH_SAMPLE_COUNT];
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+// cpu cycles on the esp32, ns on the host, differences are taken modulo 2^32
+static inline uint32_t sys_bench_private_counter(void)
+{
+#if defined(__XTENSA__)
+    return sys_perf_ccount();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+#endif // defined(__XTENSA__)
+}
+
+static uint32_t sys_bench_private_sample(const sys_bench_case_S * bench_case, uint32_t iterations)
+{
+    if (bench_case->setup != NULL)
+    {
+        bench_case->setup(bench_case->arg);
+    }
+    const uint32_t start = sys_bench_private_counter();
+    for (uint32_t n = 0U; n < iterations; n ++)
+    {
+        bench_case->body(bench_case->arg);
+    }
+    return sys_bench_private_counter() - start;
+}
+
+// insertion sort, a handful of samples
+static void sys_bench_private_sort(uint32_t * values, uint32_t count)
+{
+    for (uint32_t i = 1U; i < count; i ++)
+    {
+        const uint32_t value = values[i];
+        uint32_t j = i;
+        while ((j > 0U) && (values[j - 1U] > value))
+        {
+            values[j] = values[j - 1U];
+            j --;
+        }
+        values[j] = value;
+    }
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_bench_run(const sys_bench_case_S * bench_case, sys_bench_result_S * result)
+{
+    // double the calls per sample until one sample is long enough to swamp the counter resolution
+    uint32_t iterations = bench_case->iterations;
+    if (iterations == 0U)
+    {
+        iterations = 1U;
+        while ((iterations < SYS_BENCH_ITERATION_MAX)
+            && ((float)sys_bench_private_sample(bench_case, iterations) * SYS_BENCH_NS_PER_TICK < (float)SYS_BENCH_SAMPLE_MIN_NS))
+        {
+            iterations <<= 1U;
+        }
+    }
+
+    for (uint32_t s = 0U; s < SYS_BENCH_SAMPLE_COUNT; s ++)
+    {
+        sys_bench_sample[s] = sys_bench_private_sample(bench_case, iterations);
+    }
+    sys_bench_private_sort(sys_bench_sample, SYS_BENCH_SAMPLE_COUNT);
+
+    const uint32_t ops = (bench_case->ops > 0U) ? bench_case->ops : 1U;
+    const float scale = SYS_BENCH_NS_PER_TICK / ((float)iterations * (float)ops);
+    result->name        = bench_case->name;
+    result->samples     = SYS_BENCH_SAMPLE_COUNT;
+    result->iterations  = iterations;
+    result->min_ns      = (float)sys_bench_sample[0U] * scale;
+    result->median_ns   = (float)sys_bench_sample[SYS_BENCH_SAMPLE_COUNT / 2U] * scale;
+    result->p90_ns      = (float)sys_bench_sample[SYS_BENCH_P90_INDEX] * scale;
+    result->max_ns      = (float)sys_bench_sample[SYS_BENCH_SAMPLE_COUNT - 1U] * scale;
+}
+
+void sys_bench_report_header(sys_bench_report_t report)
+{
+    char line[SYS_BENCH_LINE_SIZE];
+#if defined(__XTENSA__)
+    snprintf(line, sizeof(line), "[ BENCH ] counter: %s @ %u MHz samples: %u", SYS_BENCH_COUNTER_NAME,
+        (unsigned)CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ, (unsigned)SYS_BENCH_SAMPLE_COUNT);
+#else
+    snprintf(line, sizeof(line), "[ BENCH ] counter: %s samples: %u", SYS_BENCH_COUNTER_NAME, (unsigned)SYS_BENCH_SAMPLE_COUNT);
+#endif // defined(__XTENSA__)
+    report(line);
+    snprintf(line, sizeof(line), "[ BENCH ] %-36s %7s %9s %9s %9s %9s", "kernel [ns per op]", "iters", "min", "median", "p90", "max");
+    report(line);
+}
+
+void sys_bench_report_result(const sys_bench_result_S * result, sys_bench_report_t report)
+{
+    char line[SYS_BENCH_LINE_SIZE];
+    snprintf(line, sizeof(line), "[ BENCH ] %-36s %7u %9.1f %9.1f %9.1f %9.1f", result->name, (unsigned)result->iterations,
+        (double)result->min_ns, (double)result->median_ns, (double)result->p90_ns, (double)result->max_ns);
+    report(line);
+}
+
+void sys_bench_run_all(const sys_bench_case_S * cases, uint8_t count, sys_bench_report_t report)
+{
+    sys_bench_result_S result;
+    sys_bench_report_header(report);
+    for (uint8_t c = 0U; c < count; c ++)
+    {
+        sys_bench_run(&cases[c], &result);
+        sys_bench_report_result(&result, report);
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * @file    sys_bench.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the kernel microbenchmark harness:
+ *      a kernel is timed over repeated samples with the cpu cycle counter on the esp32
+ *      and the monotonic clock on the host, both report the same line per kernel.
+ */
+
+#ifndef SYS_BENCH_H
+#define SYS_BENCH_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// TableUV Lib
+#include "../../include/common.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_BENCH_SAMPLE_COUNT          (31U)       // odd, the median is a sample
+#define SYS_BENCH_SAMPLE_MIN_NS         (100000U)   // calibrated samples last at least 100 us
+#define SYS_BENCH_ITERATION_MAX         (1UL << 20U)
+#define SYS_BENCH_LINE_SIZE             (128U)
+
+typedef void (*sys_bench_fn_t)(void * arg);
+typedef void (*sys_bench_report_t)(const char * line);
+
+typedef struct{
+    const char *    name;
+    sys_bench_fn_t  setup;          // untimed, before every sample, may be NULL
+    sys_bench_fn_t  body;           // timed, 'iterations' calls per sample
+    void *          arg;
+    uint32_t        iterations;     // 0: calibrated to SYS_BENCH_SAMPLE_MIN_NS, 1 for a kernel that consumes its setup
+    uint32_t        ops;            // units of work per body call, the times are per unit, 0 is taken as 1
+} sys_bench_case_S;
+
+typedef struct{
+    const char *    name;
+    uint32_t        samples;
+    uint32_t        iterations;
+    float           min_ns;         // per unit of work
+    float           median_ns;
+    float           p90_ns;
+    float           max_ns;
+} sys_bench_result_S;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void sys_bench_run(const sys_bench_case_S * bench_case, sys_bench_result_S * result);
+/**
+ * @brief the counter in use and the column names, once before the results
+ */
+void sys_bench_report_header(sys_bench_report_t report);
+void sys_bench_report_result(const sys_bench_result_S * result, sys_bench_report_t report);
+/**
+ * @brief run and report every case of 'cases' in order
+ */
+void sys_bench_run_all(const sys_bench_case_S * cases, uint8_t count, sys_bench_report_t report);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_BENCH_H
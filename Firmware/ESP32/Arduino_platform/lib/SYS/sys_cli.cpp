@@ -0,0 +1,405 @@
+/**
+ * @file    sys_cli.cpp
+ * @author  Jianxiang (Jack) Xu
+ * @date    25 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the serial command line:
+ *      line based commands on the monitor port, polled from the arduino loop,
+ *      which also owns draining the telemetry ring into the port.
+ */
+
+#include <Arduino.h>
+#include "sys_cli.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <string.h>
+
+// TableUV Lib
+#include "../../include/common.h"
+#include "sys_perf.h"
+#include "sys_probe.h"
+#include "sys_telemetry.h"
+#include "sys_recorder.h"
+#include "sys_time.h"
+
+// SDK config
+#include "sdkconfig.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_CLI_BAUD_RATE               (115200U)
+#define SYS_CLI_LINE_SIZE               (32U)
+#define SYS_CLI_DUMP_SIZE               ((SYS_PROBE_DUMP_SIZE > SYS_PERF_DUMP_SIZE) ? SYS_PROBE_DUMP_SIZE : SYS_PERF_DUMP_SIZE)
+
+typedef struct{
+    char        line[SYS_CLI_LINE_SIZE];
+    uint8_t     length;
+    bool        overflow;       // drop the rest of a line that did not fit
+    uint8_t     dump[SYS_CLI_DUMP_SIZE];
+    uint16_t    dump_length;    // 0 when no dump is being sent
+    uint16_t    dump_offset;
+} sys_cli_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void sys_cli_private_execute(const char * line);
+#if (FEATURE_SYS_PERF) || (FEATURE_SYS_PROBE)
+static void sys_cli_private_sendDump(size_t length);
+#endif // (FEATURE_SYS_PERF) || (FEATURE_SYS_PROBE)
+#if (FEATURE_SYS_PERF)
+static void sys_cli_private_printPerf(void);
+static void sys_cli_private_dumpPerf(void);
+#endif // (FEATURE_SYS_PERF)
+#if (FEATURE_SYS_PROBE)
+static void sys_cli_private_printProbe(void);
+static void sys_cli_private_dumpProbe(void);
+#endif // (FEATURE_SYS_PROBE)
+#if (FEATURE_SYS_TELEMETRY)
+static void sys_cli_private_printTelemetry(void);
+static void sys_cli_private_dumpStep(void);
+static void sys_cli_private_drainTelemetry(void);
+#endif // (FEATURE_SYS_TELEMETRY)
+#if (FEATURE_SYS_RECORDER)
+static void sys_cli_private_printRecorder(void);
+#endif // (FEATURE_SYS_RECORDER)
+#if (FEATURE_SYS_TIME_FAULT)
+static void sys_cli_private_timeLate(const char * args);
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static sys_cli_data_S sys_cli_data = {
+    .line           = {0},
+    .length         = 0U,
+    .overflow       = false,
+    .dump           = {0},
+    .dump_length    = 0U,
+    .dump_offset    = 0U,
+};
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void sys_cli_private_execute(const char * line)
+{
+    if (line[0] == '\0')
+    {
+        // empty line
+    }
+#if (FEATURE_SYS_PERF)
+    else if (strcmp(line, "perf") == 0)
+    {
+        sys_cli_private_printPerf();
+    }
+    else if (strcmp(line, "perf dump") == 0)
+    {
+        sys_cli_private_dumpPerf();
+    }
+    else if (strcmp(line, "perf reset") == 0)
+    {
+        sys_perf_reset();
+        Serial.println("[ CLI ] perf reset");
+    }
+#endif // (FEATURE_SYS_PERF)
+#if (FEATURE_SYS_PROBE)
+    else if (strcmp(line, "probe") == 0)
+    {
+        sys_cli_private_printProbe();
+    }
+    else if (strcmp(line, "probe dump") == 0)
+    {
+        sys_cli_private_dumpProbe();
+    }
+    else if (strcmp(line, "probe reset") == 0)
+    {
+        sys_probe_reset();
+        Serial.println("[ CLI ] probe reset");
+    }
+#endif // (FEATURE_SYS_PROBE)
+#if (FEATURE_SYS_TELEMETRY)
+    else if (strcmp(line, "tlm on") == 0)
+    {
+        sys_telemetry_enable(true);
+    }
+    else if (strcmp(line, "tlm off") == 0)
+    {
+        sys_telemetry_enable(false);
+    }
+    else if (strcmp(line, "tlm") == 0)
+    {
+        sys_cli_private_printTelemetry();
+    }
+#endif // (FEATURE_SYS_TELEMETRY)
+#if (FEATURE_SYS_RECORDER)
+    else if (strcmp(line, "rec") == 0)
+    {
+        sys_cli_private_printRecorder();
+    }
+    else if (strcmp(line, "rec serial") == 0)
+    {
+        sys_recorder_start(SYS_RECORDER_SINK_SERIAL);
+    }
+    else if (strcmp(line, "rec flash") == 0)
+    {
+        Serial.println("[ REC ] erasing the log partition...");
+        Serial.println(sys_recorder_start(SYS_RECORDER_SINK_FLASH) ? "[ REC ] recording to flash" : "[ REC ] no log partition");
+    }
+    else if (strcmp(line, "rec off") == 0)
+    {
+        sys_recorder_stop();
+    }
+    else if (strcmp(line, "rec dump") == 0)
+    {
+        sys_recorder_dump();
+    }
+#endif // (FEATURE_SYS_RECORDER)
+#if (FEATURE_SYS_TIME_FAULT)
+    else if (strncmp(line, "time late ", 10U) == 0)
+    {
+        sys_cli_private_timeLate(&line[10]);
+    }
+#endif // (FEATURE_SYS_TIME_FAULT)
+    else if (strcmp(line, "help") == 0)
+    {
+        Serial.println("[ CLI ] perf | perf dump | perf reset | probe | probe dump | probe reset | tlm | tlm on | tlm off"
+            " | rec | rec serial | rec flash | rec off | rec dump | time late <period> <ms> [count] | help");
+    }
+    else
+    {
+        Serial.printf("[ CLI ] unknown: %s\n", line);
+    }
+}
+
+#if (FEATURE_SYS_PERF)
+// cycles are printed in us, at the configured cpu clock
+static void sys_cli_private_printPerf(void)
+{
+    const float mhz = (float)CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+    Serial.printf("[ PERF ] %-18s %8s %8s %8s %8s %8s %6s %8s\n",
+        "slot", "n", "min_us", "avg_us", "max_us", "p99_us", "miss", "late_us");
+    for (uint8_t slot = 0; slot < SYS_PERF_SLOT_COUNT; slot++)
+    {
+        sys_perf_record_S record;
+        sys_perf_get_record((sys_perf_slot_E)slot, &record);
+        Serial.printf("[ PERF ] %-18s %8u %8.1f %8.1f %8.1f %8.1f %6u %8u\n",
+            sys_perf_get_name((sys_perf_slot_E)slot), record.count,
+            record.min_cycles / mhz, record.avg_cycles / mhz, record.max_cycles / mhz, record.p99_cycles / mhz,
+            record.deadline_miss, record.max_late_us);
+        if (record.period_us != 0U)
+        {
+            Serial.printf("[ PERF ] %-18s log2(late us):", "");
+            for (uint8_t i = 0; i < SYS_PERF_JITTER_BUCKETS; i++)
+            {
+                Serial.printf(" %u", record.jitter[i]);
+            }
+            Serial.println();
+        }
+    }
+}
+
+static void sys_cli_private_dumpPerf(void)
+{
+    if (sys_cli_data.dump_length == 0U)
+    {
+        sys_cli_private_sendDump(sys_perf_dump(sys_cli_data.dump, sizeof(sys_cli_data.dump)));
+    }
+}
+#endif // (FEATURE_SYS_PERF)
+
+#if (FEATURE_SYS_PROBE)
+// cycles are printed in us, the histogram only for probes that ran
+static void sys_cli_private_printProbe(void)
+{
+    const float mhz = (float)CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+    Serial.printf("[ PROBE ] %-22s %8s %9s %9s %9s\n", "probe", "n", "min_us", "avg_us", "max_us");
+    for (uint8_t probe = 0; probe < SYS_PROBE_COUNT; probe++)
+    {
+        sys_probe_record_S record;
+        sys_probe_get_record((sys_probe_E)probe, &record);
+        const uint32_t avg_cycles = (record.count > 0U) ? (uint32_t)(record.sum_cycles / record.count) : 0U;
+        Serial.printf("[ PROBE ] %-22s %8u %9.1f %9.1f %9.1f\n",
+            sys_probe_get_name((sys_probe_E)probe), record.count,
+            record.min_cycles / mhz, avg_cycles / mhz, record.max_cycles / mhz);
+        if (record.count > 0U)
+        {
+            Serial.printf("[ PROBE ] %-22s log2(cycles):", "");
+            for (uint8_t i = 0; i < SYS_PROBE_HIST_BUCKETS; i++)
+            {
+                Serial.printf(" %u", record.hist[i]);
+            }
+            Serial.println();
+        }
+    }
+}
+
+static void sys_cli_private_dumpProbe(void)
+{
+    if (sys_cli_data.dump_length == 0U)
+    {
+        sys_cli_private_sendDump(sys_probe_dump(sys_cli_data.dump, sizeof(sys_cli_data.dump)));
+    }
+}
+#endif // (FEATURE_SYS_PROBE)
+
+#if (FEATURE_SYS_PERF) || (FEATURE_SYS_PROBE)
+// a raw write would land in the middle of the cobs stream, with telemetry on the dump goes as its records
+static void sys_cli_private_sendDump(size_t length)
+{
+#if (FEATURE_SYS_TELEMETRY)
+    if (sys_telemetry_is_enabled())
+    {
+        sys_cli_data.dump_length = (uint16_t)length;
+        sys_cli_data.dump_offset = 0U;
+        return;
+    }
+#endif // (FEATURE_SYS_TELEMETRY)
+    // one write, so the dump is not split by other serial output
+    Serial.write(sys_cli_data.dump, length);
+}
+#endif // (FEATURE_SYS_PERF) || (FEATURE_SYS_PROBE)
+
+#if (FEATURE_SYS_TELEMETRY)
+static void sys_cli_private_printTelemetry(void)
+{
+    static const char * const name[SYS_TELEMETRY_COUNT] = {
+        "pose", "encoder", "tof", "super_state", "map_tile", "driver", "recorder", "dump",
+    };
+    Serial.printf("[ TLM ] %s\n", sys_telemetry_is_enabled() ? "on" : "off");
+    for (uint8_t type = 0; type < SYS_TELEMETRY_COUNT; type++)
+    {
+        sys_telemetry_stats_S stats;
+        sys_telemetry_get_stats((sys_telemetry_type_E)type, &stats);
+        Serial.printf("[ TLM ] %-12s sent: %8u rate drop: %8u full drop: %8u\n",
+            name[type], stats.sent, stats.rate_drop, stats.full_drop);
+    }
+}
+
+// as many chunks as the rate limiter lets through, the rest on the next poll
+static void sys_cli_private_dumpStep(void)
+{
+    if (!sys_telemetry_is_enabled())
+    {
+        sys_cli_data.dump_length = 0U; // turned off half way, the host drops the partial dump
+        return;
+    }
+    while (sys_cli_data.dump_offset < sys_cli_data.dump_length)
+    {
+        sys_telemetry_dump_S chunk;
+        const uint16_t remain = sys_cli_data.dump_length - sys_cli_data.dump_offset;
+        const uint16_t length = (remain < SYS_TELEMETRY_DUMP_CHUNK) ? remain : (uint16_t)SYS_TELEMETRY_DUMP_CHUNK;
+        memcpy(&chunk.magic, sys_cli_data.dump, sizeof(chunk.magic));
+        chunk.offset = sys_cli_data.dump_offset;
+        chunk.total  = sys_cli_data.dump_length;
+        memcpy(chunk.data, &sys_cli_data.dump[sys_cli_data.dump_offset], length);
+        if (!sys_telemetry_publish(SYS_TELEMETRY_DUMP, &chunk, (uint8_t)SYS_TELEMETRY_DUMP_SIZE(length)))
+        {
+            return; // retry on the next poll
+        }
+        sys_cli_data.dump_offset += length;
+    }
+    sys_cli_data.dump_length = 0U;
+}
+
+// only what fits in the uart tx fifo, so the loop task never spins on the port
+static void sys_cli_private_drainTelemetry(void)
+{
+    const uint8_t * data;
+    size_t room = Serial.availableForWrite();
+    while (room > 0U)
+    {
+        const size_t length = sys_telemetry_peek(&data, room);
+        if (length == 0U)
+        {
+            break;
+        }
+        Serial.write(data, length);
+        sys_telemetry_consume(length);
+        room -= length;
+    }
+}
+#endif // (FEATURE_SYS_TELEMETRY)
+
+#if (FEATURE_SYS_RECORDER)
+static void sys_cli_private_printRecorder(void)
+{
+    static const char * const sink[] = {"off", "serial", "flash"};
+    sys_recorder_stats_S stats;
+    sys_recorder_get_stats(&stats);
+    Serial.printf("[ REC ] %s records: %u blocks: %u dropped: %u flash: %u / %u bytes\n",
+        sink[stats.sink], stats.records, stats.blocks, stats.dropped, stats.flash_offset, stats.flash_size);
+}
+#endif // (FEATURE_SYS_RECORDER)
+
+#if (FEATURE_SYS_TIME_FAULT)
+// "<50ms|1000ms|slam> <ms> [count]", one late release by default
+static void sys_cli_private_timeLate(const char * args)
+{
+    char name[8] = {0};
+    unsigned late_ms = 0U;
+    unsigned count = 1U;
+    if (sscanf(args, "%7s %u %u", name, &late_ms, &count) < 2)
+    {
+        Serial.println("[ CLI ] time late <50ms|1000ms|slam> <ms> [count]");
+        return;
+    }
+    for (uint8_t id = 0U; id < SYS_TIME_PERIOD_COUNT; id++)
+    {
+        if (strcmp(name, sys_time_period_name((sys_time_period_E)id)) == 0)
+        {
+            sys_time_fault_late((sys_time_period_E)id, (uint32_t)late_ms, (uint16_t)count);
+            Serial.printf("[ TIME ] %s late %u ms x%u\n", name, late_ms, count);
+            return;
+        }
+    }
+    Serial.printf("[ CLI ] unknown period: %s\n", name);
+}
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_cli_init(void)
+{
+    Serial.begin(SYS_CLI_BAUD_RATE);
+}
+
+void sys_cli_poll(void)
+{
+    while (Serial.available() > 0)
+    {
+        const char c = (char)Serial.read();
+        if ((c == '\n') || (c == '\r'))
+        {
+            if (!sys_cli_data.overflow)
+            {
+                sys_cli_data.line[sys_cli_data.length] = '\0';
+                sys_cli_private_execute(sys_cli_data.line);
+            }
+            sys_cli_data.length   = 0U;
+            sys_cli_data.overflow = false;
+        }
+        else if (sys_cli_data.length < (SYS_CLI_LINE_SIZE - 1U))
+        {
+            sys_cli_data.line[sys_cli_data.length++] = c;
+        }
+        else
+        {
+            sys_cli_data.overflow = true;
+        }
+    }
+#if (FEATURE_SYS_RECORDER)
+    sys_recorder_poll();
+#endif // (FEATURE_SYS_RECORDER)
+#if (FEATURE_SYS_TELEMETRY)
+    if (sys_cli_data.dump_length > 0U)
+    {
+        sys_cli_private_dumpStep();
+    }
+    sys_cli_private_drainTelemetry();
+#endif // (FEATURE_SYS_TELEMETRY)
+}
@@ -0,0 +1,30 @@
+/**
+ * @file    sys_cli.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    25 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the serial command line
+ */
+
+#ifndef SYS_CLI_H
+#define SYS_CLI_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void sys_cli_init(void);
+/**
+ * @brief read pending serial input and run complete command lines, then drain telemetry, never blocks
+ *        commands: "perf", "perf dump" (binary, see sys_perf.h, as dump records while telemetry is on), "perf reset",
+ *                  "tlm" (stats), "tlm on", "tlm off", "help"
+ */
+void sys_cli_poll(void);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_CLI_H
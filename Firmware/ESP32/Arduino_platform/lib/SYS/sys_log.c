@@ -0,0 +1,356 @@
+/**
+ * @file    sys_log.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    27 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the deferred formatting log backend:
+ *      PRINTF only stores the format pointer and the raw arguments into a ring
+ *      per core, the libc formatting and the uart output run in the log task.
+ *      The argument types are read off the format once per call site, on its first call.
+ */
+
+#include "sys_log.h"
+#include "../../include/mem_budget.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_LOG_RING_MASK               (SYS_LOG_RING_SIZE - 1U)
+#define SYS_LOG_SPEC_SIZE               (24U)
+#define SYS_LOG_SITE_VALID              (0x80000000UL)
+#define SYS_LOG_SITE_NARGS_SHIFT        (24U)   // 4 bits of argument count over the 2 bit types, first argument lowest
+#define SYS_LOG_SITE_TYPE_BITS          (2U)
+#define SYS_LOG_SITE_TYPE_MASK          (0x3U)
+
+_Static_assert((SYS_LOG_RING_SIZE & SYS_LOG_RING_MASK) == 0U, "log ring size is a power of 2");
+_Static_assert((SYS_LOG_ARGS_MAX * SYS_LOG_SITE_TYPE_BITS) <= SYS_LOG_SITE_NARGS_SHIFT, "site descriptor holds SYS_LOG_ARGS_MAX types");
+
+typedef enum{
+    LOG_ARG_INT,        // the 4 stored in a site descriptor
+    LOG_ARG_LONG_LONG,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_POINTER,    // %s, %p
+    LOG_ARG_NONE,       // "%%"
+} sys_log_arg_E;
+
+typedef struct{
+    const char *        format;
+    uint8_t             nargs;
+    volatile uint8_t    committed;  // set last by the producer, cleared by the drain
+    uint64_t            args[SYS_LOG_ARGS_MAX];
+} sys_log_record_S;
+
+// one producer side per core, reserving a slot masks interrupts on that core only
+typedef struct{
+    sys_log_record_S    record[SYS_LOG_RING_SIZE];
+    volatile uint32_t   head;       // written by the producers of the core
+    volatile uint32_t   tail;       // written by the drain
+    volatile uint32_t   dropped;
+} sys_log_ring_S;
+
+typedef struct{
+    sys_log_ring_S      ring[portNUM_PROCESSORS];
+    uint32_t            reported_dropped;
+} sys_log_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static IRAM_ATTR const char * sys_log_private_parseSpec(const char * p, sys_log_arg_E * type, uint8_t * stars);
+static IRAM_ATTR sys_log_site_t sys_log_private_describe(const char * format);
+static void          sys_log_private_print(const sys_log_record_S * record);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+// zero initialized, .bss is in DRAM already
+static sys_log_data_S log_data;
+
+_Static_assert(sizeof(log_data) <= MEM_BUDGET_LOG_RING, "log rings exceed their RAM budget");
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+// 'p' is past the '%', returns past the conversion character; in IRAM, the producer walks the format with it
+static IRAM_ATTR const char * sys_log_private_parseSpec(const char * p, sys_log_arg_E * type, uint8_t * stars)
+{
+    uint8_t longs = 0U;
+    *stars = 0U;
+    if (*p == '%')
+    {
+        *type = LOG_ARG_NONE;
+        return p + 1;
+    }
+    while ((*p == '-') || (*p == '+') || (*p == ' ') || (*p == '#') || (*p == '0'))
+    {
+        p++;
+    }
+    // width and precision
+    for (uint8_t field = 0; field < 2U; field++)
+    {
+        if (*p == '*')
+        {
+            (*stars) ++;
+            p++;
+        }
+        while ((*p >= '0') && (*p <= '9'))
+        {
+            p++;
+        }
+        if ((field == 0U) && (*p == '.'))
+        {
+            p++;
+        }
+        else
+        {
+            break;
+        }
+    }
+    while ((*p == 'h') || (*p == 'l') || (*p == 'z') || (*p == 'j') || (*p == 't') || (*p == 'L'))
+    {
+        longs += (*p == 'l') ? 1U : 0U;
+        p++;
+    }
+    switch (*p)
+    {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            *type = LOG_ARG_DOUBLE;
+            break;
+        case 's': case 'p':
+            *type = LOG_ARG_POINTER;
+            break;
+        case '\0':
+            *type = LOG_ARG_NONE;
+            return p;
+        default:
+            *type = (longs >= 2U) ? LOG_ARG_LONG_LONG : LOG_ARG_INT;
+            break;
+    }
+    return p + 1;
+}
+
+// the arguments the format takes, '*' fields as ints ahead of their value; in IRAM, the first call of a site runs it
+static IRAM_ATTR sys_log_site_t sys_log_private_describe(const char * format)
+{
+    sys_log_site_t site = 0U;
+    uint32_t nargs = 0U;
+    for (const char * p = format; *p != '\0'; )
+    {
+        if (*p++ != '%')
+        {
+            continue;
+        }
+        sys_log_arg_E type;
+        uint8_t stars;
+        p = sys_log_private_parseSpec(p, &type, &stars);
+        for (uint8_t i = 0; (i <= stars) && (nargs < SYS_LOG_ARGS_MAX); i++)
+        {
+            const sys_log_arg_E arg = (i < stars) ? LOG_ARG_INT : type;
+            if (arg != LOG_ARG_NONE)
+            {
+                site |= (sys_log_site_t)arg << (nargs * SYS_LOG_SITE_TYPE_BITS);
+                nargs ++;
+            }
+        }
+    }
+    return SYS_LOG_SITE_VALID | (nargs << SYS_LOG_SITE_NARGS_SHIFT) | site;
+}
+
+// re-walks the format, each conversion is handed to snprintf with its own spec
+static void sys_log_private_print(const sys_log_record_S * record)
+{
+    char line[SYS_LOG_LINE_SIZE];
+    char spec[SYS_LOG_SPEC_SIZE];
+    size_t length = 0U;
+    uint8_t arg = 0U;
+    const char * p = record->format;
+
+    while (*p != '\0')
+    {
+        if ((*p != '%') || (p[1] == '%'))
+        {
+            if (length >= (sizeof(line) - 1U))
+            {
+                fwrite(line, 1, length, stdout);
+                length = 0U;
+            }
+            line[length++] = *p;
+            p += (*p == '%') ? 2 : 1;
+            continue;
+        }
+        sys_log_arg_E type;
+        uint8_t stars;
+        const char * start = p;
+        p = sys_log_private_parseSpec(p + 1, &type, &stars);
+
+        // render '*' from the captured ints, so snprintf only ever takes the value
+        size_t spec_length = 0U;
+        for (const char * s = start; (s < p) && (spec_length < (sizeof(spec) - 12U)); s++)
+        {
+            if (*s == '*')
+            {
+                const int star = (arg < record->nargs) ? (int)record->args[arg] : 0;
+                arg ++;
+                spec_length += (size_t)snprintf(&spec[spec_length], sizeof(spec) - spec_length, "%d", star);
+            }
+            else
+            {
+                spec[spec_length++] = *s;
+            }
+        }
+        spec[spec_length] = '\0';
+
+        const uint64_t value = (arg < record->nargs) ? record->args[arg] : 0U;
+        arg ++;
+        for (uint8_t attempt = 0; attempt < 2U; attempt++)
+        {
+            const size_t room = sizeof(line) - length;
+            int written = 0;
+            switch (type)
+            {
+                case (LOG_ARG_DOUBLE):
+                {
+                    double d;
+                    memcpy(&d, &value, sizeof(d));
+                    written = snprintf(&line[length], room, spec, d);
+                    break;
+                }
+                case (LOG_ARG_POINTER):
+                    written = snprintf(&line[length], room, spec, (const void *)(uintptr_t)value);
+                    break;
+                case (LOG_ARG_LONG_LONG):
+                    written = snprintf(&line[length], room, spec, (long long)value);
+                    break;
+                case (LOG_ARG_INT):
+                    written = snprintf(&line[length], room, spec, (int)value);
+                    break;
+                case (LOG_ARG_NONE):
+                default:
+                    break;
+            }
+            if ((written >= 0) && ((size_t)written < room))
+            {
+                length += (size_t)written;
+                break;
+            }
+            // did not fit, flush and retry on an empty line, a second miss is truncated
+            fwrite(line, 1, length, stdout);
+            length = 0U;
+            if (attempt == 1U)
+            {
+                length = sizeof(line) - 1U;
+            }
+        }
+    }
+    fwrite(line, 1, length, stdout);
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void IRAM_ATTR sys_log_printf(sys_log_site_t * site, const char * format, ...)
+{
+    // a site first called on both cores at once is described twice, to the same value
+    sys_log_site_t types = __atomic_load_n(site, __ATOMIC_RELAXED);
+    if ((types & SYS_LOG_SITE_VALID) == 0U)
+    {
+        types = sys_log_private_describe(format);
+        __atomic_store_n(site, types, __ATOMIC_RELAXED);
+    }
+
+    const uint32_t irq_state = portSET_INTERRUPT_MASK_FROM_ISR();
+    sys_log_ring_S * ring = &log_data.ring[xPortGetCoreID()];
+    const uint32_t head = ring->head;
+    if ((head - ring->tail) >= SYS_LOG_RING_SIZE)
+    {
+        ring->dropped ++;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(irq_state);
+        return;
+    }
+    ring->head = head + 1U;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq_state);
+
+    // the slot is ours, fill it with interrupts on
+    sys_log_record_S * record = &ring->record[head & SYS_LOG_RING_MASK];
+    const uint8_t nargs = (uint8_t)((types >> SYS_LOG_SITE_NARGS_SHIFT) & 0xFU);
+    va_list ap;
+    va_start(ap, format);
+    for (uint8_t i = 0; i < nargs; i++)
+    {
+        uint64_t value;
+        switch ((sys_log_arg_E)((types >> (i * SYS_LOG_SITE_TYPE_BITS)) & SYS_LOG_SITE_TYPE_MASK))
+        {
+            case (LOG_ARG_DOUBLE):
+            {
+                const double d = va_arg(ap, double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            }
+            case (LOG_ARG_POINTER):
+                value = (uint64_t)(uintptr_t)va_arg(ap, const void *);
+                break;
+            case (LOG_ARG_LONG_LONG):
+                value = (uint64_t)va_arg(ap, long long);
+                break;
+            case (LOG_ARG_INT):
+            default:
+                value = (uint64_t)(int64_t)va_arg(ap, int);
+                break;
+        }
+        record->args[i] = value;
+    }
+    va_end(ap);
+    record->format = format;
+    record->nargs  = nargs;
+    __atomic_store_n(&record->committed, 1U, __ATOMIC_RELEASE);
+}
+
+// per core order is kept, lines of the two cores may interleave differently than they were logged
+void sys_log_drain(void)
+{
+    uint32_t dropped = 0U;
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        sys_log_ring_S * ring = &log_data.ring[core];
+        uint32_t tail = ring->tail;
+        while (tail != ring->head)
+        {
+            sys_log_record_S * record = &ring->record[tail & SYS_LOG_RING_MASK];
+            if (!__atomic_load_n(&record->committed, __ATOMIC_ACQUIRE))
+            {
+                break; // reserved, still being filled by a preempted producer
+            }
+            sys_log_private_print(record);
+            record->committed = 0U;
+            tail ++;
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        }
+        dropped += ring->dropped;
+    }
+    if (dropped != log_data.reported_dropped)
+    {
+        printf("[ LOG ] dropped: %u\n", (unsigned)(dropped - log_data.reported_dropped));
+        log_data.reported_dropped = dropped;
+    }
+}
+
+uint32_t sys_log_get_dropped(void)
+{
+    uint32_t dropped = 0U;
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        dropped += log_data.ring[core].dropped;
+    }
+    return dropped;
+}
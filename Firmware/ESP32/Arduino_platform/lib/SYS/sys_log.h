@@ -0,0 +1,55 @@
+/**
+ * @file    sys_log.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    27 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the deferred formatting log backend of PRINTF
+ */
+
+#ifndef SYS_LOG_H
+#define SYS_LOG_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_LOG_RING_SIZE               (16U)  // records per core, power of 2, the rings count in MEM_BUDGET_LOG_RING
+#define SYS_LOG_ARGS_MAX                (12U)  // arguments beyond are printed as 0
+#define SYS_LOG_LINE_SIZE               (160U)
+
+// argument types of one call site, 0 until its first call walked the format
+typedef uint32_t sys_log_site_t;
+
+/**
+ * @brief PRINTF backend, each call site keeps its own descriptor so the format is walked once, not per call
+ */
+#define SYS_LOG_PRINTF(f_, ...) \
+    do { static sys_log_site_t sys_log_site; sys_log_printf(&sys_log_site, (f_), __VA_ARGS__); } while (0)
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+/**
+ * @brief record the format and its raw arguments into the ring of the calling core, never blocks
+ * @param site: the argument types of this format, filled on the first call, use SYS_LOG_PRINTF()
+ * @note  only the pointers are kept: the format and any %s argument must be string literals or static,
+ *        records are dropped and counted when the ring is full, safe from ISRs: the producer is in IRAM
+ *        and the rings in DRAM, an ESP_INTR_FLAG_IRAM handler that logs while the flash cache is off
+ *        also needs its format in DRAM_STR()
+ */
+void sys_log_printf(sys_log_site_t * site, const char * format, ...) __attribute__((format(printf, 2, 3)));
+/**
+ * @brief format and print every committed record, call from the low priority log task
+ */
+void sys_log_drain(void);
+uint32_t sys_log_get_dropped(void);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_LOG_H
@@ -0,0 +1,270 @@
+/**
+ * @file    sys_perf.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    25 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the task runtime instrumentation:
+ *      execution cycles (min/avg/max/p99), release jitter histograms and
+ *      deadline misses per task and per called function.
+ */
+
+#include "sys_perf.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// SDK config
+#include "sdkconfig.h"
+
+// TableUV Lib
+#include "sys_time.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+typedef struct{
+    const char *    name;
+    uint32_t        period_us;      // 0: not periodic, no jitter nor deadline
+} sys_perf_slot_config_S;
+
+typedef struct{
+    uint32_t        count;
+    uint32_t        min_cycles;
+    uint32_t        max_cycles;
+    uint64_t        sum_cycles;
+    uint32_t        window[SYS_PERF_WINDOW_SIZE];
+    uint8_t         window_head;
+    int64_t         release_us;     // expected start of the current period, 0 until the first run
+    uint32_t        deadline_miss;
+    uint32_t        max_late_us;
+    uint16_t        jitter[SYS_PERF_JITTER_BUCKETS];
+} sys_perf_slot_S;
+
+typedef struct{
+    portMUX_TYPE        mux;        // slot writer vs. the cli reader
+    sys_perf_slot_S     slot[SYS_PERF_SLOT_COUNT];
+} sys_perf_data_S;
+
+_Static_assert(SYS_PERF_WINDOW_SIZE <= 256U, "window head is a uint8_t");
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void sys_perf_private_resetSlot(sys_perf_slot_S * slot);
+static void sys_perf_private_recordRelease(sys_perf_slot_S * slot, uint32_t period_us, int64_t start_us, int64_t end_us);
+static int  sys_perf_private_compare(const void * a, const void * b);
+static uint16_t sys_perf_private_fletcher16(const uint8_t * data, size_t size);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static const sys_perf_slot_config_S sys_perf_slot_config[SYS_PERF_SLOT_COUNT] = {
+    [SYS_PERF_TASK_50MS              ] = {"task_50ms",           50000U},
+    [SYS_PERF_TASK_1000MS            ] = {"task_1000ms",       1000000U},
+    [SYS_PERF_TASK_SLAM              ] = {"task_slam",          100000U},
+    [SYS_PERF_FUNC_DEV_RUN50MS       ] = {"dev_run50ms",             0U},
+    [SYS_PERF_FUNC_DEV_RUN1000MS     ] = {"dev_run1000ms",           0U},
+    [SYS_PERF_FUNC_SUPERVISOR_PROCESS] = {"supervisor_process",      0U},
+    [SYS_PERF_FUNC_SLAM_RUN100MS     ] = {"app_slam_run100ms",       0U},
+};
+
+static sys_perf_data_S sys_perf_data = {
+    .mux    = portMUX_INITIALIZER_UNLOCKED,
+    .slot   = {{0}},
+};
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void sys_perf_private_resetSlot(sys_perf_slot_S * slot)
+{
+    memset(slot, 0, sizeof(sys_perf_slot_S));
+    slot->min_cycles = UINT32_MAX;
+}
+
+// releases follow vTaskDelayUntil, a late run keeps the original grid
+static void sys_perf_private_recordRelease(sys_perf_slot_S * slot, uint32_t period_us, int64_t start_us, int64_t end_us)
+{
+    if (slot->release_us == 0)
+    {
+        slot->release_us = start_us;
+    }
+    const int64_t late_us = start_us - slot->release_us;
+    const uint32_t late = (late_us > 0) ? (uint32_t)late_us : 0U;
+    uint8_t bucket = (uint8_t)(31 - __builtin_clz(late | 1U));
+    if (bucket >= SYS_PERF_JITTER_BUCKETS)
+    {
+        bucket = SYS_PERF_JITTER_BUCKETS - 1U;
+    }
+    if (slot->jitter[bucket] < UINT16_MAX)
+    {
+        slot->jitter[bucket] ++;
+    }
+    if (late > slot->max_late_us)
+    {
+        slot->max_late_us = late;
+    }
+    slot->release_us += period_us;
+    if (end_us > slot->release_us)
+    {
+        slot->deadline_miss ++;
+    }
+    // a stall of several periods is one miss, not one per skipped release
+    while (slot->release_us < end_us)
+    {
+        slot->release_us += period_us;
+    }
+}
+
+static int sys_perf_private_compare(const void * a, const void * b)
+{
+    const uint32_t lhs = *(const uint32_t *)a;
+    const uint32_t rhs = *(const uint32_t *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static uint16_t sys_perf_private_fletcher16(const uint8_t * data, size_t size)
+{
+    uint16_t sum1 = 0U;
+    uint16_t sum2 = 0U;
+    for (size_t i = 0; i < size; i++)
+    {
+        sum1 = (sum1 + data[i]) % 255U;
+        sum2 = (sum2 + sum1) % 255U;
+    }
+    return (uint16_t)((sum2 << 8) | sum1);
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_perf_init(void)
+{
+    sys_perf_reset();
+}
+
+void sys_perf_begin(sys_perf_slot_E slot, sys_perf_stamp_S * stamp)
+{
+    (void)slot;
+    stamp->start_us     = sys_time_us();
+    stamp->start_ccount = sys_perf_ccount();
+}
+
+void sys_perf_end(sys_perf_slot_E slot, const sys_perf_stamp_S * stamp)
+{
+    const uint32_t cycles = sys_perf_ccount() - stamp->start_ccount; // wraps every ~17s at 240MHz
+    const int64_t end_us  = sys_time_us();
+    if (slot >= SYS_PERF_SLOT_COUNT)
+    {
+        return;
+    }
+    sys_perf_slot_S * data = &sys_perf_data.slot[slot];
+    const uint32_t period_us = sys_perf_slot_config[slot].period_us;
+
+    portENTER_CRITICAL(&sys_perf_data.mux);
+    data->count ++;
+    data->sum_cycles += cycles;
+    if (cycles < data->min_cycles)
+    {
+        data->min_cycles = cycles;
+    }
+    if (cycles > data->max_cycles)
+    {
+        data->max_cycles = cycles;
+    }
+    data->window[data->window_head] = cycles;
+    data->window_head = (uint8_t)((data->window_head + 1U) % SYS_PERF_WINDOW_SIZE);
+    if (period_us != 0U)
+    {
+        sys_perf_private_recordRelease(data, period_us, stamp->start_us, end_us);
+    }
+    portEXIT_CRITICAL(&sys_perf_data.mux);
+}
+
+void sys_perf_reset(void)
+{
+    portENTER_CRITICAL(&sys_perf_data.mux);
+    for (uint8_t slot = 0; slot < SYS_PERF_SLOT_COUNT; slot++)
+    {
+        sys_perf_private_resetSlot(&sys_perf_data.slot[slot]);
+    }
+    portEXIT_CRITICAL(&sys_perf_data.mux);
+}
+
+// copies under the lock, the p99 sort runs on the caller's stack outside of it
+bool sys_perf_get_record(sys_perf_slot_E slot, sys_perf_record_S * record)
+{
+    uint32_t window[SYS_PERF_WINDOW_SIZE];
+    uint32_t samples;
+    uint64_t sum_cycles;
+    if (slot >= SYS_PERF_SLOT_COUNT)
+    {
+        return false;
+    }
+    const sys_perf_slot_S * data = &sys_perf_data.slot[slot];
+
+    portENTER_CRITICAL(&sys_perf_data.mux);
+    record->slot            = (uint8_t)slot;
+    record->period_us       = sys_perf_slot_config[slot].period_us;
+    record->count           = data->count;
+    record->min_cycles      = (data->count > 0U) ? data->min_cycles : 0U;
+    record->max_cycles      = data->max_cycles;
+    record->deadline_miss   = data->deadline_miss;
+    record->max_late_us     = data->max_late_us;
+    memcpy(record->jitter, data->jitter, sizeof(record->jitter));
+    sum_cycles = data->sum_cycles;
+    samples = (data->count < SYS_PERF_WINDOW_SIZE) ? data->count : SYS_PERF_WINDOW_SIZE;
+    memcpy(window, data->window, samples * sizeof(uint32_t));
+    portEXIT_CRITICAL(&sys_perf_data.mux);
+
+    record->avg_cycles = (record->count > 0U) ? (uint32_t)(sum_cycles / record->count) : 0U;
+    record->p99_cycles = 0U;
+    if (samples > 0U)
+    {
+        qsort(window, samples, sizeof(uint32_t), sys_perf_private_compare);
+        record->p99_cycles = window[(samples * 99U + 99U) / 100U - 1U];
+    }
+    return true;
+}
+
+const char * sys_perf_get_name(sys_perf_slot_E slot)
+{
+    return (slot < SYS_PERF_SLOT_COUNT) ? sys_perf_slot_config[slot].name : "unknown";
+}
+
+size_t sys_perf_dump(uint8_t * buffer, size_t size)
+{
+    size_t length = 0U;
+    if (size < SYS_PERF_DUMP_SIZE)
+    {
+        return 0U;
+    }
+    const uint16_t magic = SYS_PERF_DUMP_MAGIC;
+    const uint16_t cpu_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+    memcpy(&buffer[length], &magic, sizeof(magic));
+    length += sizeof(magic);
+    buffer[length++] = SYS_PERF_DUMP_VERSION;
+    buffer[length++] = SYS_PERF_SLOT_COUNT;
+    memcpy(&buffer[length], &cpu_mhz, sizeof(cpu_mhz));
+    length += sizeof(cpu_mhz);
+
+    for (uint8_t slot = 0; slot < SYS_PERF_SLOT_COUNT; slot++)
+    {
+        sys_perf_record_S record;
+        sys_perf_get_record((sys_perf_slot_E)slot, &record);
+        memcpy(&buffer[length], &record, sizeof(record));
+        length += sizeof(record);
+    }
+
+    const uint16_t checksum = sys_perf_private_fletcher16(buffer, length);
+    memcpy(&buffer[length], &checksum, sizeof(checksum));
+    length += sizeof(checksum);
+    return length;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file    sys_perf.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    25 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the task runtime instrumentation
+ */
+
+#ifndef SYS_PERF_H
+#define SYS_PERF_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// TableUV Lib
+#include "../../include/common.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_PERF_WINDOW_SIZE            (128U) // latest samples kept per slot for the p99
+#define SYS_PERF_JITTER_BUCKETS         (16U)  // bucket i counts a release lateness in [2^i, 2^(i+1)) us
+#define SYS_PERF_DUMP_MAGIC             (0x4650U) // "PF" little endian
+#define SYS_PERF_DUMP_VERSION           (1U)
+
+// task slots measure the whole loop body against its period, function slots one call
+typedef enum{
+    SYS_PERF_TASK_50MS,
+    SYS_PERF_TASK_1000MS,
+    SYS_PERF_TASK_SLAM,
+    SYS_PERF_FUNC_DEV_RUN50MS,
+    SYS_PERF_FUNC_DEV_RUN1000MS,
+    SYS_PERF_FUNC_SUPERVISOR_PROCESS,
+    SYS_PERF_FUNC_SLAM_RUN100MS,
+    SYS_PERF_SLOT_COUNT
+} sys_perf_slot_E;
+
+typedef struct{
+    uint32_t    start_ccount;
+    int64_t     start_us;
+} sys_perf_stamp_S;
+
+// one slot of the binary dump, little endian
+typedef struct __attribute__((packed)){
+    uint8_t     slot;
+    uint32_t    period_us;      // 0 for function slots
+    uint32_t    count;
+    uint32_t    min_cycles;
+    uint32_t    avg_cycles;
+    uint32_t    max_cycles;
+    uint32_t    p99_cycles;     // over the latest SYS_PERF_WINDOW_SIZE samples
+    uint32_t    deadline_miss;  // body still running at the next release
+    uint32_t    max_late_us;
+    uint16_t    jitter[SYS_PERF_JITTER_BUCKETS];
+} sys_perf_record_S;
+
+/**
+ * binary dump layout:
+ *   uint16 magic, uint8 version, uint8 slot count, uint16 cpu MHz,
+ *   sys_perf_record_S x slot count, uint16 fletcher16 over everything before it
+ */
+#define SYS_PERF_DUMP_HEADER_SIZE       (6U)
+#define SYS_PERF_DUMP_SIZE              (SYS_PERF_DUMP_HEADER_SIZE + SYS_PERF_SLOT_COUNT * sizeof(sys_perf_record_S) + 2U)
+
+static inline uint32_t sys_perf_ccount(void)
+{
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+}
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void sys_perf_init(void);
+void sys_perf_begin(sys_perf_slot_E slot, sys_perf_stamp_S * stamp);
+/**
+ * @brief record one run of 'slot'
+ * @note  ccount is per core, each slot must begin and end on the same core,
+ *        a preempted run includes the time spent in the higher priority tasks
+ */
+void sys_perf_end(sys_perf_slot_E slot, const sys_perf_stamp_S * stamp);
+void sys_perf_reset(void);
+bool sys_perf_get_record(sys_perf_slot_E slot, sys_perf_record_S * record);
+const char * sys_perf_get_name(sys_perf_slot_E slot);
+/**
+ * @brief fill 'buffer' with the binary dump
+ * @return bytes written, 0 when 'size' is below SYS_PERF_DUMP_SIZE
+ */
+size_t sys_perf_dump(uint8_t * buffer, size_t size);
+
+#if (FEATURE_SYS_PERF)
+#   define SYS_PERF_MEASURE(slot, call) \
+        do { sys_perf_stamp_S perf_stamp; sys_perf_begin((slot), &perf_stamp); call; sys_perf_end((slot), &perf_stamp); } while (0)
+#else
+#   define SYS_PERF_MEASURE(slot, call) \
+        do { call; } while (0)
+#endif // (FEATURE_SYS_PERF)
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_PERF_H
@@ -0,0 +1,180 @@
+/**
+ * @file    sys_probe.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the aggregation of the cycle counter probes,
+ * a record is a few compares and one histogram increment under the lock
+ */
+
+#include "sys_probe.h"
+
+#if (FEATURE_SYS_PROBE)
+// Std. Lib
+#include <string.h>
+
+// SDK config
+#include "sdkconfig.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+typedef struct{
+    uint32_t        count;
+    uint32_t        min_cycles;
+    uint32_t        max_cycles;
+    uint64_t        sum_cycles;
+    uint32_t        hist[SYS_PROBE_HIST_BUCKETS];
+} sys_probe_slot_S;
+
+typedef struct{
+    portMUX_TYPE        mux;        // probes on both cores and the hazard path vs. the cli reader
+    sys_probe_slot_S    slot[SYS_PROBE_COUNT];
+} sys_probe_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static uint16_t sys_probe_private_fletcher16(const uint8_t * data, size_t size);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static const char * const sys_probe_names[SYS_PROBE_COUNT] = {
+    [SYS_PROBE_SLAM_LOCALIZATION    ] = "slam_localization",
+    [SYS_PROBE_SLAM_LOCAL_MAP       ] = "slam_local_map",
+    [SYS_PROBE_SLAM_GLOBAL_MAP      ] = "slam_global_map",
+    [SYS_PROBE_SLAM_OBSTACLE        ] = "slam_obstacle",
+    [SYS_PROBE_SLAM_PATH            ] = "slam_path",
+    [SYS_PROBE_SLAM_MOTION          ] = "slam_motion",
+    [SYS_PROBE_SLAM_MAP_TILES       ] = "slam_map_tiles",
+    [SYS_PROBE_SLAM_SCAN_MATCH      ] = "slam_scan_match",
+    [SYS_PROBE_SLAM_TABLE_MODEL     ] = "slam_table_model",
+    [SYS_PROBE_AVR_DRIVER_I2C_WRITE ] = "avr_driver_i2c_write",
+    [SYS_PROBE_AVR_DRIVER_I2C_READ  ] = "avr_driver_i2c_read",
+    [SYS_PROBE_TOF_I2C_READY        ] = "tof_i2c_ready",
+    [SYS_PROBE_TOF_I2C_READ         ] = "tof_i2c_read",
+    [SYS_PROBE_TOF_I2C_ROI          ] = "tof_i2c_roi",
+    [SYS_PROBE_TOF_I2C_CLEAR        ] = "tof_i2c_clear",
+    [SYS_PROBE_SUPER_FETCH_STATE    ] = "super_fetch_state",
+    [SYS_PROBE_SUPER_NEXT_STATE     ] = "super_next_state",
+};
+
+static sys_probe_data_S sys_probe_data = {
+    .mux    = portMUX_INITIALIZER_UNLOCKED,
+    .slot   = {{0}},
+};
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static uint16_t sys_probe_private_fletcher16(const uint8_t * data, size_t size)
+{
+    uint16_t sum1 = 0U;
+    uint16_t sum2 = 0U;
+    for (size_t i = 0; i < size; i++)
+    {
+        sum1 = (sum1 + data[i]) % 255U;
+        sum2 = (sum2 + sum1) % 255U;
+    }
+    return (uint16_t)((sum2 << 8) | sum1);
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_probe_record(sys_probe_E probe, uint32_t cycles)
+{
+    if (probe >= SYS_PROBE_COUNT)
+    {
+        return;
+    }
+    uint8_t bucket = (uint8_t)(31 - __builtin_clz(cycles | 1U));
+    if (bucket >= SYS_PROBE_HIST_BUCKETS)
+    {
+        bucket = SYS_PROBE_HIST_BUCKETS - 1U;
+    }
+    sys_probe_slot_S * slot = &sys_probe_data.slot[probe];
+
+    portENTER_CRITICAL(&sys_probe_data.mux);
+    // min_cycles is 0 while count is, the first run sets both ends
+    if ((cycles < slot->min_cycles) || (slot->count == 0U))
+    {
+        slot->min_cycles = cycles;
+    }
+    if (cycles > slot->max_cycles)
+    {
+        slot->max_cycles = cycles;
+    }
+    slot->count ++;
+    slot->sum_cycles += cycles;
+    slot->hist[bucket] ++;
+    portEXIT_CRITICAL(&sys_probe_data.mux);
+}
+
+void sys_probe_reset(void)
+{
+    portENTER_CRITICAL(&sys_probe_data.mux);
+    memset(sys_probe_data.slot, 0, sizeof(sys_probe_data.slot));
+    portEXIT_CRITICAL(&sys_probe_data.mux);
+}
+
+bool sys_probe_get_record(sys_probe_E probe, sys_probe_record_S * record)
+{
+    if (probe >= SYS_PROBE_COUNT)
+    {
+        return false;
+    }
+    const sys_probe_slot_S * slot = &sys_probe_data.slot[probe];
+
+    portENTER_CRITICAL(&sys_probe_data.mux);
+    record->probe       = (uint8_t)probe;
+    record->count       = slot->count;
+    record->min_cycles  = slot->min_cycles;
+    record->max_cycles  = slot->max_cycles;
+    record->sum_cycles  = slot->sum_cycles;
+    memcpy(record->hist, slot->hist, sizeof(record->hist));
+    portEXIT_CRITICAL(&sys_probe_data.mux);
+    return true;
+}
+
+const char * sys_probe_get_name(sys_probe_E probe)
+{
+    return (probe < SYS_PROBE_COUNT) ? sys_probe_names[probe] : "unknown";
+}
+
+size_t sys_probe_dump(uint8_t * buffer, size_t size)
+{
+    size_t length = 0U;
+    if (size < SYS_PROBE_DUMP_SIZE)
+    {
+        return 0U;
+    }
+    const uint16_t magic = SYS_PROBE_DUMP_MAGIC;
+    const uint16_t cpu_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+    memcpy(&buffer[length], &magic, sizeof(magic));
+    length += sizeof(magic);
+    buffer[length++] = SYS_PROBE_DUMP_VERSION;
+    buffer[length++] = SYS_PROBE_COUNT;
+    memcpy(&buffer[length], &cpu_mhz, sizeof(cpu_mhz));
+    length += sizeof(cpu_mhz);
+
+    for (uint8_t probe = 0; probe < SYS_PROBE_COUNT; probe++)
+    {
+        sys_probe_record_S record;
+        sys_probe_get_record((sys_probe_E)probe, &record);
+        memcpy(&buffer[length], &record, sizeof(record));
+        length += sizeof(record);
+    }
+
+    const uint16_t checksum = sys_probe_private_fletcher16(buffer, length);
+    memcpy(&buffer[length], &checksum, sizeof(checksum));
+    length += sizeof(checksum);
+    return length;
+}
+#endif // (FEATURE_SYS_PROBE)
@@ -0,0 +1,117 @@
+/**
+ * @file    sys_probe.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the scoped cycle counter probes:
+ *      SYS_PROBE_BEGIN / SYS_PROBE_END around a block in C, SYS_PROBE_SCOPE for the rest of a scope in C++,
+ *      each probe aggregates count, min, max, sum and a log2 histogram of its cycles.
+ *      Nothing is left of them when FEATURE_SYS_PROBE is disabled.
+ */
+
+#ifndef SYS_PROBE_H
+#define SYS_PROBE_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// TableUV Lib
+#include "../../include/common.h"
+#include "sys_perf.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_PROBE_HIST_BUCKETS          (24U) // bucket i counts a run of [2^i, 2^(i+1)) cycles, the last one anything longer
+#define SYS_PROBE_DUMP_MAGIC            (0x5250U) // "PR" little endian
+#define SYS_PROBE_DUMP_VERSION          (1U)
+
+typedef enum{
+    SYS_PROBE_SLAM_LOCALIZATION,
+    SYS_PROBE_SLAM_LOCAL_MAP,
+    SYS_PROBE_SLAM_GLOBAL_MAP,
+    SYS_PROBE_SLAM_OBSTACLE,
+    SYS_PROBE_SLAM_PATH,
+    SYS_PROBE_SLAM_MOTION,
+    SYS_PROBE_SLAM_MAP_TILES,
+    SYS_PROBE_SLAM_SCAN_MATCH,
+    SYS_PROBE_SLAM_TABLE_MODEL,
+    SYS_PROBE_AVR_DRIVER_I2C_WRITE,
+    SYS_PROBE_AVR_DRIVER_I2C_READ,
+    SYS_PROBE_TOF_I2C_READY,
+    SYS_PROBE_TOF_I2C_READ,
+    SYS_PROBE_TOF_I2C_ROI,
+    SYS_PROBE_TOF_I2C_CLEAR,
+    SYS_PROBE_SUPER_FETCH_STATE,
+    SYS_PROBE_SUPER_NEXT_STATE,
+    SYS_PROBE_COUNT
+} sys_probe_E;
+
+// one probe of the binary dump, little endian
+typedef struct __attribute__((packed)){
+    uint8_t     probe;
+    uint32_t    count;
+    uint32_t    min_cycles;
+    uint32_t    max_cycles;
+    uint64_t    sum_cycles;
+    uint32_t    hist[SYS_PROBE_HIST_BUCKETS];
+} sys_probe_record_S;
+
+/**
+ * binary dump layout:
+ *   uint16 magic, uint8 version, uint8 probe count, uint16 cpu MHz,
+ *   sys_probe_record_S x probe count, uint16 fletcher16 over everything before it
+ */
+#define SYS_PROBE_DUMP_HEADER_SIZE      (6U)
+#define SYS_PROBE_DUMP_SIZE             (SYS_PROBE_DUMP_HEADER_SIZE + SYS_PROBE_COUNT * sizeof(sys_probe_record_S) + 2U)
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+#if (FEATURE_SYS_PROBE)
+/**
+ * @brief aggregate one run of 'probe'
+ * @note  ccount is per core, a block must begin and end on the same core (every task is pinned),
+ *        a preempted run includes the time spent in the higher priority tasks
+ */
+void sys_probe_record(sys_probe_E probe, uint32_t cycles);
+void sys_probe_reset(void);
+bool sys_probe_get_record(sys_probe_E probe, sys_probe_record_S * record);
+const char * sys_probe_get_name(sys_probe_E probe);
+/**
+ * @brief fill 'buffer' with the binary dump
+ * @return bytes written, 0 when 'size' is below SYS_PROBE_DUMP_SIZE
+ */
+size_t sys_probe_dump(uint8_t * buffer, size_t size);
+
+#   define SYS_PROBE_BEGIN(probe)       const uint32_t probe##_ccount = sys_perf_ccount()
+#   define SYS_PROBE_END(probe)         sys_probe_record((probe), sys_perf_ccount() - probe##_ccount)
+#else
+#   define SYS_PROBE_BEGIN(probe)       do { } while (0)
+#   define SYS_PROBE_END(probe)         do { } while (0)
+#endif // (FEATURE_SYS_PROBE)
+
+# ifdef __cplusplus
+}
+
+#if (FEATURE_SYS_PROBE)
+// records from construction to the end of the enclosing scope, early returns included
+class sys_probe_scope_C{
+public:
+    explicit sys_probe_scope_C(sys_probe_E probe) : scope_probe(probe), scope_ccount(sys_perf_ccount()) {}
+    ~sys_probe_scope_C() { sys_probe_record(scope_probe, sys_perf_ccount() - scope_ccount); }
+private:
+    const sys_probe_E   scope_probe;
+    const uint32_t      scope_ccount;
+};
+#   define SYS_PROBE_SCOPE(probe)       sys_probe_scope_C probe##_scope(probe)
+#else
+#   define SYS_PROBE_SCOPE(probe)       do { } while (0)
+#endif // (FEATURE_SYS_PROBE)
+# endif
+#endif //SYS_PROBE_H
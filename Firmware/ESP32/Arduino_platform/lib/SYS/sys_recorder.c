@@ -0,0 +1,345 @@
+/**
+ * @file    sys_recorder.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the raw input recorder:
+ *      the dev layer hands over every raw input as it is read, records are packed with their time
+ *      into self contained blocks, and the cli poll moves closed blocks to the serial port or to flash.
+ */
+
+#include "sys_recorder.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <string.h>
+
+// TableUV Lib
+#include "../../include/common.h"
+#include "sys_telemetry.h"
+#include "sys_time.h"
+
+// ESP-IDF
+#include "esp_partition.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define RECORDER_RING_MASK              (SYS_RECORDER_RING_SIZE - 1U)
+#define RECORDER_VARINT_MAX             (5U)
+#define RECORDER_DUMP_BLOCKS_PER_POLL   (4U)
+
+_Static_assert((SYS_RECORDER_RING_SIZE & RECORDER_RING_MASK) == 0U, "ring size is a power of 2");
+_Static_assert(sizeof(sys_recorder_block_S) == SYS_RECORDER_BLOCK_SIZE, "block is one flash write");
+_Static_assert(SYS_RECORDER_BLOCK_SIZE <= SYS_TELEMETRY_PAYLOAD_MAX, "a block is one telemetry record");
+
+typedef struct{
+    portMUX_TYPE            mux;
+    volatile bool           recording;
+    sys_recorder_sink_E     sink;                           // where closed blocks go, kept after a stop to drain the ring
+    sys_recorder_block_S    open;                           // Protected By: 'mux'
+    uint8_t                 open_records;                   // Protected By: 'mux'
+    int64_t                 last_us;                        // Protected By: 'mux', stamp of the last record in 'open'
+    uint16_t                sequence;                       // Protected By: 'mux'
+    uint32_t                lost;                           // Protected By: 'mux', records dropped since the last closed block
+    sys_recorder_block_S    ring[SYS_RECORDER_RING_SIZE];   // slot 'tail' is read by the poll outside the lock
+    uint32_t                head;                           // Protected By: 'mux', free running
+    uint32_t                tail;                           // Protected By: 'mux', free running
+    sys_recorder_stats_S    stats;                          // Protected By: 'mux'
+    const esp_partition_t * partition;
+    uint32_t                flash_offset;                   // poll only
+    bool                    dumping;                        // poll only
+    uint32_t                dump_offset;
+    uint16_t                dump_sequence;
+} sys_recorder_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static uint8_t  sys_recorder_private_encodeVarint(uint32_t value, uint8_t * output);
+static void     sys_recorder_private_closeBlock(void);
+static void     sys_recorder_private_append(sys_recorder_type_E type, const void * payload);
+static bool     sys_recorder_private_sink(const sys_recorder_block_S * block);
+static void     sys_recorder_private_dumpStep(void);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static sys_recorder_data_S recorder_data = {
+    .mux            = portMUX_INITIALIZER_UNLOCKED,
+    .recording      = false,
+    .sink           = SYS_RECORDER_SINK_OFF,
+    .open           = {0},
+    .open_records   = 0U,
+    .last_us        = 0,
+    .sequence       = 0U,
+    .lost           = 0U,
+    .ring           = {{0}},
+    .head           = 0U,
+    .tail           = 0U,
+    .stats          = {0},
+    .partition      = NULL,
+    .flash_offset   = 0U,
+    .dumping        = false,
+    .dump_offset    = 0U,
+    .dump_sequence  = 0U,
+};
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+// 7 bits per byte, low group first, the top bit marks one more byte
+static uint8_t sys_recorder_private_encodeVarint(uint32_t value, uint8_t * output)
+{
+    uint8_t length = 0U;
+    while (value >= 0x80U)
+    {
+        output[length++] = (uint8_t)(value | 0x80U);
+        value >>= 7;
+    }
+    output[length++] = (uint8_t)value;
+    return length;
+}
+
+// call under 'mux', a full ring drops the block just closed and reports it in the next one
+static void sys_recorder_private_closeBlock(void)
+{
+    if (recorder_data.open.length == 0U)
+    {
+        return;
+    }
+    if ((recorder_data.head - recorder_data.tail) >= SYS_RECORDER_RING_SIZE)
+    {
+        recorder_data.lost          += recorder_data.open_records;
+        recorder_data.stats.dropped += recorder_data.open_records;
+    }
+    else
+    {
+        recorder_data.open.magic    = SYS_RECORDER_BLOCK_MAGIC;
+        recorder_data.open.sequence = recorder_data.sequence ++;
+        recorder_data.open.dropped  = (recorder_data.lost > UINT8_MAX) ? UINT8_MAX : (uint8_t)recorder_data.lost;
+        recorder_data.lost = 0U;
+        recorder_data.ring[recorder_data.head & RECORDER_RING_MASK] = recorder_data.open;
+        recorder_data.head ++;
+    }
+    recorder_data.open.length  = 0U;
+    recorder_data.open_records = 0U;
+}
+
+// call under 'mux', the stamp is taken in the lock so records stay in time order across tasks and cores
+static void sys_recorder_private_append(sys_recorder_type_E type, const void * payload)
+{
+    uint8_t delta[RECORDER_VARINT_MAX];
+    const uint8_t size = sys_recorder_payload_size(type);
+    const int64_t now_us = sys_time_us();
+    if (size == 0xFFU)
+    {
+        return;
+    }
+    uint8_t delta_length = sys_recorder_private_encodeVarint((uint32_t)(now_us - recorder_data.last_us), delta);
+    if ((recorder_data.open.length != 0U)
+        && ((recorder_data.open.length + 1U + delta_length + size) > sizeof(recorder_data.open.records)))
+    {
+        sys_recorder_private_closeBlock();
+    }
+    if (recorder_data.open.length == 0U)
+    {
+        recorder_data.open.stamp_us = now_us;
+        delta_length = sys_recorder_private_encodeVarint(0U, delta);
+    }
+    uint8_t * record = &recorder_data.open.records[recorder_data.open.length];
+    record[0] = (uint8_t)type;
+    memcpy(&record[1], delta, delta_length);
+    if (size != 0U)
+    {
+        memcpy(&record[1U + delta_length], payload, size);
+    }
+    recorder_data.open.length += (uint8_t)(1U + delta_length + size);
+    recorder_data.open_records ++;
+    recorder_data.last_us = now_us;
+    recorder_data.stats.records ++;
+}
+
+// poll only, false keeps the block for the next poll
+static bool sys_recorder_private_sink(const sys_recorder_block_S * block)
+{
+    switch (recorder_data.sink)
+    {
+        case (SYS_RECORDER_SINK_SERIAL):
+            return sys_telemetry_publish(SYS_TELEMETRY_RECORDER, block, sizeof(*block));
+        case (SYS_RECORDER_SINK_FLASH):
+            if ((recorder_data.flash_offset + sizeof(*block)) > recorder_data.partition->size)
+            {
+                if (recorder_data.recording)
+                {
+                    sys_recorder_stop();
+                    PRINTF("[ REC ] flash full at %u bytes\n", (unsigned)recorder_data.flash_offset);
+                }
+                return true;
+            }
+            // already erased by the start, a page program stalls the cache for well under 1ms
+            esp_partition_write(recorder_data.partition, recorder_data.flash_offset, block, sizeof(*block));
+            recorder_data.flash_offset += sizeof(*block);
+            return true;
+        case (SYS_RECORDER_SINK_OFF):
+        default:
+            return true;
+    }
+}
+
+// stops at the first erased or stale block, paced by the telemetry rate
+static void sys_recorder_private_dumpStep(void)
+{
+    sys_recorder_block_S block;
+    for (uint8_t i = 0; i < RECORDER_DUMP_BLOCKS_PER_POLL; i++)
+    {
+        if (((recorder_data.dump_offset + sizeof(block)) > recorder_data.partition->size)
+            || (esp_partition_read(recorder_data.partition, recorder_data.dump_offset, &block, sizeof(block)) != ESP_OK)
+            || (block.magic != SYS_RECORDER_BLOCK_MAGIC) || (block.sequence != recorder_data.dump_sequence))
+        {
+            recorder_data.dumping = false;
+            PRINTF("[ REC ] dump done: %u blocks\n", (unsigned)recorder_data.dump_sequence);
+            return;
+        }
+        if (!sys_telemetry_publish(SYS_TELEMETRY_RECORDER, &block, sizeof(block)))
+        {
+            return; // retry on the next poll
+        }
+        recorder_data.dump_offset += sizeof(block);
+        recorder_data.dump_sequence ++;
+    }
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_recorder_init(void)
+{
+    recorder_data.partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+}
+
+bool sys_recorder_start(sys_recorder_sink_E sink)
+{
+    if ((sink == SYS_RECORDER_SINK_OFF) || ((sink == SYS_RECORDER_SINK_FLASH) && (recorder_data.partition == NULL)))
+    {
+        return false;
+    }
+    sys_recorder_stop();
+    recorder_data.dumping = false;
+    if (sink == SYS_RECORDER_SINK_FLASH)
+    {
+        // erase up front, a sector erase while running would stall both cores for ~45ms
+        if (esp_partition_erase_range(recorder_data.partition, 0U, recorder_data.partition->size) != ESP_OK)
+        {
+            return false;
+        }
+        recorder_data.flash_offset = 0U;
+    }
+    portENTER_CRITICAL(&recorder_data.mux);
+    recorder_data.sink          = sink;
+    recorder_data.open.length   = 0U;
+    recorder_data.open_records  = 0U;
+    recorder_data.sequence      = 0U;
+    recorder_data.lost          = 0U;
+    recorder_data.tail          = recorder_data.head;
+    memset(&recorder_data.stats, 0, sizeof(recorder_data.stats));
+    recorder_data.recording     = true;
+    portEXIT_CRITICAL(&recorder_data.mux);
+    return true;
+}
+
+// the closed blocks still go to the sink on the next polls
+void sys_recorder_stop(void)
+{
+    portENTER_CRITICAL(&recorder_data.mux);
+    recorder_data.recording = false;
+    sys_recorder_private_closeBlock();
+    portEXIT_CRITICAL(&recorder_data.mux);
+}
+
+void sys_recorder_record(sys_recorder_type_E type, const void * payload)
+{
+    if (!recorder_data.recording)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&recorder_data.mux);
+    if (recorder_data.recording)
+    {
+        sys_recorder_private_append(type, payload);
+    }
+    portEXIT_CRITICAL(&recorder_data.mux);
+}
+
+void sys_recorder_record_from_isr(sys_recorder_type_E type, const void * payload)
+{
+    if (!recorder_data.recording)
+    {
+        return;
+    }
+    portENTER_CRITICAL_ISR(&recorder_data.mux);
+    if (recorder_data.recording)
+    {
+        sys_recorder_private_append(type, payload);
+    }
+    portEXIT_CRITICAL_ISR(&recorder_data.mux);
+}
+
+void sys_recorder_poll(void)
+{
+    portENTER_CRITICAL(&recorder_data.mux);
+    if ((recorder_data.open.length != 0U) && ((sys_time_us() - recorder_data.open.stamp_us) >= SYS_RECORDER_FLUSH_US))
+    {
+        sys_recorder_private_closeBlock();
+    }
+    uint32_t tail = recorder_data.tail;
+    const uint32_t head = recorder_data.head;
+    portEXIT_CRITICAL(&recorder_data.mux);
+
+    // the producers never touch a slot between tail and head
+    while (tail != head)
+    {
+        if (!sys_recorder_private_sink(&recorder_data.ring[tail & RECORDER_RING_MASK]))
+        {
+            break;
+        }
+        tail ++;
+        portENTER_CRITICAL(&recorder_data.mux);
+        recorder_data.tail = tail;
+        recorder_data.stats.blocks ++;
+        portEXIT_CRITICAL(&recorder_data.mux);
+    }
+
+    if (recorder_data.dumping)
+    {
+        sys_recorder_private_dumpStep();
+    }
+}
+
+bool sys_recorder_dump(void)
+{
+    if (recorder_data.partition == NULL)
+    {
+        return false;
+    }
+    sys_recorder_stop();
+    recorder_data.dump_offset   = 0U;
+    recorder_data.dump_sequence = 0U;
+    recorder_data.dumping       = true;
+    return true;
+}
+
+void sys_recorder_get_stats(sys_recorder_stats_S * stats)
+{
+    portENTER_CRITICAL(&recorder_data.mux);
+    *stats = recorder_data.stats;
+    portEXIT_CRITICAL(&recorder_data.mux);
+    stats->sink         = recorder_data.recording ? recorder_data.sink : SYS_RECORDER_SINK_OFF;
+    stats->flash_offset = recorder_data.flash_offset;
+    stats->flash_size   = (recorder_data.partition != NULL) ? recorder_data.partition->size : 0U;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file    sys_recorder.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the raw input recorder, its log is replayed on the host by host/replay
+ */
+
+#ifndef SYS_RECORDER_H
+#define SYS_RECORDER_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../include/avr_driver_common.h"
+#include "../../include/avr_sensor_common.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_RECORDER_BLOCK_SIZE         (128U) // 32 blocks per flash sector
+#define SYS_RECORDER_BLOCK_MAGIC        (0x5255U) // "UR", erased flash reads 0xFFFF
+#define SYS_RECORDER_RING_SIZE          (8U)   // closed blocks waiting for the sink, power of 2
+#define SYS_RECORDER_FLUSH_US           (250000LL) // a partial block is closed after this long
+#define SYS_RECORDER_IMU_AXIS_COUNT     (9U)   // IMU_AXIS_IMU_COUNT
+
+typedef enum{
+    SYS_RECORDER_SINK_OFF,
+    SYS_RECORDER_SINK_SERIAL,       // blocks as SYS_TELEMETRY_RECORDER records
+    SYS_RECORDER_SINK_FLASH,        // blocks written to the "spiffs" data partition, read back with "rec dump"
+} sys_recorder_sink_E;
+
+/**
+ * a block is self contained, the host can start decoding at any of them:
+ *   header, then records of uint8 type, varint delta [us] from the previous record (the block stamp for the first), payload
+ * payload sizes are fixed per type, see sys_recorder_payload_size()
+ */
+typedef enum{
+    SYS_RECORDER_DRIVER_STATUS,     // uint8 side, the raw status frame as read from the avr driver
+    SYS_RECORDER_TOF,               // sys_recorder_tof_S, every sample with data ready, stored or not
+    SYS_RECORDER_AVR_SENSOR,        // the raw frame from sync to crc, good frames only
+    SYS_RECORDER_IMU,               // float[SYS_RECORDER_IMU_AXIS_COUNT], in IMU_AXIS_E order
+    SYS_RECORDER_BATTERY,           // int32 raw adc
+    SYS_RECORDER_BUTTON,            // debounced press, no payload
+    SYS_RECORDER_TYPE_COUNT
+} sys_recorder_type_E;
+
+typedef struct __attribute__((packed)){
+    uint8_t     sensor;
+    uint8_t     frame;
+    uint8_t     label;
+    uint8_t     status;
+    uint16_t    dist_mm;
+} sys_recorder_tof_S;
+
+typedef struct __attribute__((packed)){
+    uint16_t    magic;
+    uint16_t    sequence;   // a gap on the host is a block lost to a full ring or the link
+    int64_t     stamp_us;   // esp_timer time of the first record
+    uint8_t     length;     // bytes of records
+    uint8_t     dropped;    // records lost since the previous block, saturated
+    uint8_t     records[SYS_RECORDER_BLOCK_SIZE - 14U];
+} sys_recorder_block_S;
+
+typedef struct{
+    sys_recorder_sink_E sink;
+    uint32_t            records;
+    uint32_t            blocks;         // handed to the sink
+    uint32_t            dropped;        // records lost, ring full
+    uint32_t            flash_offset;   // bytes written to the partition
+    uint32_t            flash_size;
+} sys_recorder_stats_S;
+
+static inline uint8_t sys_recorder_payload_size(sys_recorder_type_E type)
+{
+    switch (type)
+    {
+        case (SYS_RECORDER_DRIVER_STATUS):  return 1U + AVR_DRIVER_FRAME_SIZE;
+        case (SYS_RECORDER_TOF):            return sizeof(sys_recorder_tof_S);
+        case (SYS_RECORDER_AVR_SENSOR):     return AVR_SENSOR_FRAME_SIZE;
+        case (SYS_RECORDER_IMU):            return SYS_RECORDER_IMU_AXIS_COUNT * sizeof(float);
+        case (SYS_RECORDER_BATTERY):        return sizeof(int32_t);
+        case (SYS_RECORDER_BUTTON):         return 0U;
+        default:                            return 0xFFU;
+    }
+}
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void sys_recorder_init(void);
+/**
+ * @brief select where the blocks go, starting the flash sink erases the whole partition first (~15s, park the robot)
+ * @return false when the sink is not available
+ */
+bool sys_recorder_start(sys_recorder_sink_E sink);
+void sys_recorder_stop(void);
+/**
+ * @brief append one input to the open block, never blocks, a no-op while the recorder is off
+ * @param payload: sys_recorder_payload_size(type) bytes
+ */
+void sys_recorder_record(sys_recorder_type_E type, const void * payload);
+void sys_recorder_record_from_isr(sys_recorder_type_E type, const void * payload);
+/**
+ * @brief hand closed blocks to the sink and pace a flash dump, call from the cli poll
+ */
+void sys_recorder_poll(void);
+/**
+ * @brief stream the flash log back as SYS_TELEMETRY_RECORDER records, recording stops
+ */
+bool sys_recorder_dump(void);
+void sys_recorder_get_stats(sys_recorder_stats_S * stats);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_RECORDER_H
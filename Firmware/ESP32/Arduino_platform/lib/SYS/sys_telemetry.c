@@ -0,0 +1,289 @@
+/**
+ * @file    sys_telemetry.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    26 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the binary telemetry channel:
+ *      typed records are rate limited per type, COBS framed into a ring,
+ *      and drained to the serial port by the cli without blocking the publishers.
+ */
+
+#include "sys_telemetry.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <string.h>
+
+// TableUV Lib
+#include "sys_time.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define TELEMETRY_HEADER_SIZE           (6U)
+#define TELEMETRY_RAW_MAX               (TELEMETRY_HEADER_SIZE + SYS_TELEMETRY_PAYLOAD_MAX + 1U)
+#define TELEMETRY_FRAME_BOUND(raw)      ((raw) + ((raw) / 254U) + 3U) // cobs overhead + both delimiters
+#define TELEMETRY_FRAME_MAX             (TELEMETRY_FRAME_BOUND(TELEMETRY_RAW_MAX))
+#define TELEMETRY_TOKEN_SCALE           (1000U)
+
+_Static_assert(sizeof(sys_telemetry_map_tile_S) <= SYS_TELEMETRY_PAYLOAD_MAX, "map tile exceeds the payload");
+_Static_assert(sizeof(sys_telemetry_dump_S) <= SYS_TELEMETRY_PAYLOAD_MAX, "dump chunk exceeds the payload");
+_Static_assert((SYS_TELEMETRY_RING_SIZE & (SYS_TELEMETRY_RING_SIZE - 1U)) == 0U, "ring size is a power of 2");
+
+// ~11.5KB/s at 115200 baud, the rates below add up to ~6KB/s with the map at 100 delta tiles/s,
+// ~9KB/s while the recorder streams
+typedef struct{
+    uint16_t        rate_hz;
+    uint16_t        burst;
+} sys_telemetry_limit_S;
+
+typedef struct{
+    uint32_t        tokens;         // in 1/TELEMETRY_TOKEN_SCALE records
+    int64_t         refill_us;
+} sys_telemetry_bucket_S;
+
+typedef struct{
+    portMUX_TYPE            mux;
+    volatile bool           enabled;
+    uint8_t                 sequence;
+    sys_telemetry_bucket_S  bucket[SYS_TELEMETRY_COUNT];    // Protected By: 'mux'
+    sys_telemetry_stats_S   stats[SYS_TELEMETRY_COUNT];     // Protected By: 'mux'
+    uint8_t                 ring[SYS_TELEMETRY_RING_SIZE];
+    uint32_t                head;       // Protected By: 'mux', free running
+    uint32_t                tail;       // Protected By: 'mux', free running
+    uint32_t                reserved;   // Protected By: 'mux', ring space promised to frames being encoded
+} sys_telemetry_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static bool     sys_telemetry_private_takeToken(sys_telemetry_type_E type, int64_t now_us);
+static uint8_t  sys_telemetry_private_crc8(const uint8_t * data, size_t size);
+static size_t   sys_telemetry_private_cobsEncode(const uint8_t * input, size_t size, uint8_t * output);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static const sys_telemetry_limit_S sys_telemetry_limit[SYS_TELEMETRY_COUNT] = {
+    [SYS_TELEMETRY_POSE       ] = { 10U,  2U},
+    [SYS_TELEMETRY_ENCODER    ] = { 10U,  2U},
+    [SYS_TELEMETRY_TOF        ] = {100U, 15U}, // one full 15 sample scan per burst
+    [SYS_TELEMETRY_SUPER_STATE] = { 20U,  4U},
+    [SYS_TELEMETRY_MAP_TILE   ] = {100U, 16U}, // delta tiles, ~30B each
+    [SYS_TELEMETRY_DRIVER     ] = {  5U,  1U},
+    [SYS_TELEMETRY_RECORDER   ] = { 24U,  8U}, // 136B framed blocks, ~16/s with every input in
+    [SYS_TELEMETRY_DUMP       ] = { 20U,  4U}, // 200B framed chunks, a probe dump in ~0.5s
+};
+
+static sys_telemetry_data_S telemetry_data = {
+    .mux        = portMUX_INITIALIZER_UNLOCKED,
+    .enabled    = true,
+    .sequence   = 0U,
+    .bucket     = {{0}},
+    .stats      = {{0}},
+    .ring       = {0},
+    .head       = 0U,
+    .tail       = 0U,
+    .reserved   = 0U,
+};
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+// token bucket, call under 'mux'
+static bool sys_telemetry_private_takeToken(sys_telemetry_type_E type, int64_t now_us)
+{
+    sys_telemetry_bucket_S * bucket = &telemetry_data.bucket[type];
+    const sys_telemetry_limit_S * limit = &sys_telemetry_limit[type];
+    const uint32_t capacity = (uint32_t)limit->burst * TELEMETRY_TOKEN_SCALE;
+    const int64_t elapsed_us = now_us - bucket->refill_us;
+    // rate [1/s] * elapsed [us] / 1000 = milli-records
+    const int64_t refill = ((int64_t)limit->rate_hz * elapsed_us) / 1000;
+    if (((int64_t)bucket->tokens + refill) >= (int64_t)capacity)
+    {
+        bucket->tokens = capacity;
+        bucket->refill_us = now_us;
+    }
+    else
+    {
+        // only the time of the whole milli-records credited, the rest carries to the next call
+        bucket->tokens += (uint32_t)refill;
+        bucket->refill_us += (refill * 1000 + limit->rate_hz - 1) / limit->rate_hz;
+    }
+    if (bucket->tokens < TELEMETRY_TOKEN_SCALE)
+    {
+        return false;
+    }
+    bucket->tokens -= TELEMETRY_TOKEN_SCALE;
+    return true;
+}
+
+static uint8_t sys_telemetry_private_crc8(const uint8_t * data, size_t size)
+{
+    uint8_t crc = 0U;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8U; bit++)
+        {
+            crc = (crc & 0x80U) ? (uint8_t)((crc << 1) ^ 0x07U) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// consistent overhead byte stuffing, the output holds no 0x00 until the appended delimiter
+static size_t sys_telemetry_private_cobsEncode(const uint8_t * input, size_t size, uint8_t * output)
+{
+    size_t code_index = 0U;
+    size_t out = 1U;
+    uint8_t code = 1U;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (input[i] == 0U)
+        {
+            output[code_index] = code;
+            code_index = out++;
+            code = 1U;
+        }
+        else
+        {
+            output[out++] = input[i];
+            code ++;
+            if (code == 0xFFU)
+            {
+                output[code_index] = code;
+                code_index = out++;
+                code = 1U;
+            }
+        }
+    }
+    output[code_index] = code;
+    output[out++] = 0U;
+    return out;
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_telemetry_init(void)
+{
+    const int64_t now_us = sys_time_us();
+    portENTER_CRITICAL(&telemetry_data.mux);
+    for (uint8_t type = 0; type < SYS_TELEMETRY_COUNT; type++)
+    {
+        telemetry_data.bucket[type].tokens    = (uint32_t)sys_telemetry_limit[type].burst * TELEMETRY_TOKEN_SCALE;
+        telemetry_data.bucket[type].refill_us = now_us;
+    }
+    telemetry_data.head = 0U;
+    telemetry_data.tail = 0U;
+    telemetry_data.reserved = 0U;
+    portEXIT_CRITICAL(&telemetry_data.mux);
+}
+
+void sys_telemetry_enable(bool enabled)
+{
+    telemetry_data.enabled = enabled;
+}
+
+bool sys_telemetry_is_enabled(void)
+{
+    return telemetry_data.enabled;
+}
+
+// framing runs on the caller's stack, only the copy into the ring is under the lock
+bool sys_telemetry_publish(sys_telemetry_type_E type, const void * payload, uint8_t size)
+{
+    uint8_t raw[TELEMETRY_RAW_MAX];
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    if ((!telemetry_data.enabled) || (type >= SYS_TELEMETRY_COUNT) || (size > SYS_TELEMETRY_PAYLOAD_MAX))
+    {
+        return false;
+    }
+    const int64_t now_us = sys_time_us();
+    const uint32_t stamp_ms = (uint32_t)(now_us / 1000);
+    const uint32_t bound = TELEMETRY_FRAME_BOUND(TELEMETRY_HEADER_SIZE + size + 1U);
+
+    // the ring space is reserved before the sequence is taken, a frame numbered is a frame sent;
+    // a gap in the sequence on the host is then a frame lost on the wire, a full ring is counted here
+    portENTER_CRITICAL(&telemetry_data.mux);
+    bool allowed = sys_telemetry_private_takeToken(type, now_us);
+    if (!allowed)
+    {
+        telemetry_data.stats[type].rate_drop ++;
+    }
+    else if ((SYS_TELEMETRY_RING_SIZE - (telemetry_data.head - telemetry_data.tail) - telemetry_data.reserved) < bound)
+    {
+        telemetry_data.stats[type].full_drop ++;
+        allowed = false;
+    }
+    else
+    {
+        telemetry_data.reserved += bound;
+    }
+    const uint8_t sequence = allowed ? telemetry_data.sequence ++ : 0U;
+    portEXIT_CRITICAL(&telemetry_data.mux);
+    if (!allowed)
+    {
+        return false;
+    }
+
+    raw[0] = (uint8_t)type;
+    raw[1] = sequence;
+    memcpy(&raw[2], &stamp_ms, sizeof(stamp_ms));
+    memcpy(&raw[TELEMETRY_HEADER_SIZE], payload, size);
+    raw[TELEMETRY_HEADER_SIZE + size] = sys_telemetry_private_crc8(raw, TELEMETRY_HEADER_SIZE + size);
+    // leading delimiter too, so stray text before the frame is cut off instead of corrupting it
+    frame[0] = 0U;
+    const size_t length = 1U + sys_telemetry_private_cobsEncode(raw, TELEMETRY_HEADER_SIZE + size + 1U, &frame[1]);
+
+    portENTER_CRITICAL(&telemetry_data.mux);
+    for (size_t i = 0; i < length; i++)
+    {
+        telemetry_data.ring[(telemetry_data.head + i) & (SYS_TELEMETRY_RING_SIZE - 1U)] = frame[i];
+    }
+    telemetry_data.head += length;
+    telemetry_data.reserved -= bound;
+    telemetry_data.stats[type].sent ++;
+    portEXIT_CRITICAL(&telemetry_data.mux);
+    return true;
+}
+
+size_t sys_telemetry_peek(const uint8_t ** data, size_t max)
+{
+    portENTER_CRITICAL(&telemetry_data.mux);
+    const uint32_t tail = telemetry_data.tail & (SYS_TELEMETRY_RING_SIZE - 1U);
+    size_t pending = telemetry_data.head - telemetry_data.tail;
+    portEXIT_CRITICAL(&telemetry_data.mux);
+
+    if (pending > (SYS_TELEMETRY_RING_SIZE - tail))
+    {
+        pending = SYS_TELEMETRY_RING_SIZE - tail; // up to the wrap, the rest on the next call
+    }
+    *data = &telemetry_data.ring[tail];
+    return (pending < max) ? pending : max;
+}
+
+// single consumer, the peeked bytes are not overwritten before this
+void sys_telemetry_consume(size_t size)
+{
+    portENTER_CRITICAL(&telemetry_data.mux);
+    telemetry_data.tail += size;
+    portEXIT_CRITICAL(&telemetry_data.mux);
+}
+
+void sys_telemetry_get_stats(sys_telemetry_type_E type, sys_telemetry_stats_S * stats)
+{
+    if (type >= SYS_TELEMETRY_COUNT)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&telemetry_data.mux);
+    *stats = telemetry_data.stats[type];
+    portEXIT_CRITICAL(&telemetry_data.mux);
+}
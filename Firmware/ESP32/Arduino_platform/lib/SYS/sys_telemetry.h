@@ -0,0 +1,133 @@
+/**
+ * @file    sys_telemetry.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    26 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the binary telemetry channel
+ */
+
+#ifndef SYS_TELEMETRY_H
+#define SYS_TELEMETRY_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_TELEMETRY_PAYLOAD_MAX       (192U)
+#define SYS_TELEMETRY_RING_SIZE         (4096U)
+#define SYS_TELEMETRY_MAP_TILE_CELLS    (64U)  // 8 x 8 cells per tile
+#define SYS_TELEMETRY_DUMP_CHUNK        (SYS_TELEMETRY_PAYLOAD_MAX - 6U)
+
+/**
+ * frame on the wire, COBS encoded between two 0x00 delimiters:
+ *   uint8 type, uint8 sequence, uint32 stamp [ms], payload, uint8 crc8 (poly 0x07) over all before it
+ * payloads are the packed little endian structs below, tools/telemetry_decoder.py mirrors them
+ */
+typedef enum{
+    SYS_TELEMETRY_POSE,
+    SYS_TELEMETRY_ENCODER,
+    SYS_TELEMETRY_TOF,
+    SYS_TELEMETRY_SUPER_STATE,
+    SYS_TELEMETRY_MAP_TILE,
+    SYS_TELEMETRY_DRIVER,
+    SYS_TELEMETRY_RECORDER,     // sys_recorder_block_S, raw input log of lib/SYS/sys_recorder
+    SYS_TELEMETRY_DUMP,         // one chunk of a "perf dump" / "probe dump" of the cli
+    SYS_TELEMETRY_COUNT
+} sys_telemetry_type_E;
+
+typedef struct __attribute__((packed)){
+    float       x_mm;
+    float       y_mm;
+    float       theta_rad;
+} sys_telemetry_pose_S;
+
+typedef struct __attribute__((packed)){
+    uint8_t     count;
+    int16_t     left[3];    // DEV_AVR_DRIVER_ENC_BUFFER_SIZE, only 'count' are valid
+    int16_t     right[3];
+} sys_telemetry_encoder_S;
+
+typedef struct __attribute__((packed)){
+    uint8_t     sensor;
+    uint8_t     frame;
+    uint8_t     label;
+    uint8_t     status;
+    uint16_t    dist_mm;
+} sys_telemetry_tof_S;
+
+typedef struct __attribute__((packed)){
+    uint8_t     state;
+    uint8_t     avr_sensor;
+    uint16_t    slam_flag;
+    uint32_t    fault;
+    uint32_t    events;
+    uint16_t    battery_mv;
+} sys_telemetry_super_state_S;
+
+// one changed tile of the memory map, re-center on the host with the center pixel
+typedef struct __attribute__((packed)){
+    uint16_t    frame;      // slam cycle the tile was sampled in
+    uint8_t     tile_x;
+    uint8_t     tile_y;
+    uint8_t     tile_edge;  // [cells], tiles on the last row / column are clipped by the map edge
+    uint8_t     map_edge;   // [cells]
+    int16_t     center_x;
+    int16_t     center_y;
+    uint8_t     length;     // bytes of rle, only 'length' are sent
+    uint8_t     rle[2U * SYS_TELEMETRY_MAP_TILE_CELLS]; // (run, int8 cell) pairs, row major over the clipped tile
+} sys_telemetry_map_tile_S;
+
+typedef struct __attribute__((packed)){
+    uint16_t    message[2];
+    int32_t     encoder[2];
+    uint16_t    frame_error[2];
+    uint16_t    frame_lost[2];
+    uint16_t    comm_timeout[2];
+} sys_telemetry_driver_S;
+
+// the binary dumps outgrow one frame, the host joins the chunks back by 'offset'
+typedef struct __attribute__((packed)){
+    uint16_t    magic;      // of the whole dump, SYS_PERF_DUMP_MAGIC or SYS_PROBE_DUMP_MAGIC
+    uint16_t    offset;     // [bytes] of 'data' in the dump
+    uint16_t    total;      // [bytes] of the dump
+    uint8_t     data[SYS_TELEMETRY_DUMP_CHUNK]; // only up to the end of the dump are sent
+} sys_telemetry_dump_S;
+
+typedef struct{
+    uint32_t    sent;
+    uint32_t    rate_drop;      // over the record rate
+    uint32_t    full_drop;      // ring full, the uart could not keep up
+} sys_telemetry_stats_S;
+
+#define SYS_TELEMETRY_MAP_TILE_SIZE(length) (offsetof(sys_telemetry_map_tile_S, rle) + (length))
+#define SYS_TELEMETRY_DUMP_SIZE(length)     (offsetof(sys_telemetry_dump_S, data) + (length))
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void sys_telemetry_init(void);
+void sys_telemetry_enable(bool enabled);
+bool sys_telemetry_is_enabled(void);
+/**
+ * @brief frame a record into the ring, never blocks
+ * @return false when dropped by the rate limiter or a full ring
+ */
+bool sys_telemetry_publish(sys_telemetry_type_E type, const void * payload, uint8_t size);
+/**
+ * @brief contiguous bytes waiting to be sent, at most 'max'
+ */
+size_t sys_telemetry_peek(const uint8_t ** data, size_t max);
+void sys_telemetry_consume(size_t size);
+void sys_telemetry_get_stats(sys_telemetry_type_E type, sys_telemetry_stats_S * stats);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_TELEMETRY_H
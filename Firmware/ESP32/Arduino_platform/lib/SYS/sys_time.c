@@ -0,0 +1,99 @@
+/**
+ * @file    sys_time.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level files
+ *
+ * This document will contains the delays and periodic releases on top of the FreeRTOS ticks,
+ * and the late release fault used to check how the app layer rides through an overrun
+ */
+
+#include "sys_time.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#if (FEATURE_SYS_TIME_FAULT)
+typedef struct{
+    TickType_t  late;
+    uint16_t    count;
+} sys_time_fault_S;
+
+typedef struct{
+    portMUX_TYPE        mux;
+    sys_time_fault_S    fault[SYS_TIME_PERIOD_COUNT];   // Protected By: 'mux'
+} sys_time_data_S;
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static const char * const sys_time_period_names[SYS_TIME_PERIOD_COUNT] = {
+    "50ms",
+    "1000ms",
+    "slam",
+};
+
+#if (FEATURE_SYS_TIME_FAULT)
+static sys_time_data_S time_data = {
+    .mux    = portMUX_INITIALIZER_UNLOCKED,
+    .fault  = {{0}},
+};
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void sys_time_delay_ms(uint32_t ms)
+{
+    vTaskDelay(SYS_TIME_MS_TO_TICK(ms));
+}
+
+void sys_time_period_start(sys_time_period_S * period, sys_time_period_E id, TickType_t ticks)
+{
+    period->last_wake = xTaskGetTickCount();
+    period->period    = ticks;
+    period->id        = id;
+}
+
+void sys_time_period_wait(sys_time_period_S * period)
+{
+    vTaskDelayUntil(&period->last_wake, period->period);
+#if (FEATURE_SYS_TIME_FAULT)
+    TickType_t late = 0U;
+    if (period->id < SYS_TIME_PERIOD_COUNT)
+    {
+        portENTER_CRITICAL(&time_data.mux);
+        sys_time_fault_S * fault = &time_data.fault[period->id];
+        if (fault->count > 0U)
+        {
+            fault->count --;
+            late = fault->late;
+        }
+        portEXIT_CRITICAL(&time_data.mux);
+    }
+    if (late > 0U)
+    {
+        vTaskDelay(late);
+    }
+#endif // (FEATURE_SYS_TIME_FAULT)
+}
+
+const char * sys_time_period_name(sys_time_period_E id)
+{
+    return (id < SYS_TIME_PERIOD_COUNT) ? sys_time_period_names[id] : "unknown";
+}
+
+#if (FEATURE_SYS_TIME_FAULT)
+void sys_time_fault_late(sys_time_period_E id, uint32_t late_ms, uint16_t count)
+{
+    if (id >= SYS_TIME_PERIOD_COUNT)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&time_data.mux);
+    time_data.fault[id].late  = SYS_TIME_MS_TO_TICK(late_ms);
+    time_data.fault[id].count = count;
+    portEXIT_CRITICAL(&time_data.mux);
+}
+#endif // (FEATURE_SYS_TIME_FAULT)
@@ -0,0 +1,88 @@
+/**
+ * @file    sys_time.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    28 Mar 2021
+ * @brief   System level
+ *
+ * This document will contains the time base every module goes through:
+ *      esp_timer for timestamps, FreeRTOS ticks for delays and periodic tasks,
+ *      the host build maps both onto the virtual clock of its scheduler.
+ */
+
+#ifndef SYS_TIME_H
+#define SYS_TIME_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+// TableUV Lib
+#include "../../include/common.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define SYS_TIME_MS_TO_TICK(ms)         ((TickType_t)((ms) / portTICK_PERIOD_MS))
+#define SYS_TIME_HZ_TO_TICK(hz)         (SYS_TIME_MS_TO_TICK(1000U / (hz))) // Range: [ < 1 kHz]
+
+// periodic task bodies, a timing fault targets one of them
+typedef enum{
+    SYS_TIME_PERIOD_50MS,
+    SYS_TIME_PERIOD_1000MS,
+    SYS_TIME_PERIOD_SLAM,
+    SYS_TIME_PERIOD_COUNT,
+    SYS_TIME_PERIOD_UNKNOWN
+} sys_time_period_E;
+
+typedef struct{
+    TickType_t          last_wake;
+    TickType_t          period;
+    sys_time_period_E   id;
+} sys_time_period_S;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+static inline int64_t sys_time_us(void)
+{
+    return esp_timer_get_time();
+}
+
+static inline TickType_t sys_time_ticks(void)
+{
+    return xTaskGetTickCount();
+}
+
+/**
+ * @brief block the calling task, never busy waits (arduino delay() is the same call on the esp32)
+ */
+void sys_time_delay_ms(uint32_t ms);
+/**
+ * @brief start a periodic task body from now, call once from the task before its loop
+ */
+void sys_time_period_start(sys_time_period_S * period, sys_time_period_E id, TickType_t ticks);
+/**
+ * @brief block until the next release, releases stay on the grid of sys_time_period_start()
+ */
+void sys_time_period_wait(sys_time_period_S * period);
+const char * sys_time_period_name(sys_time_period_E id);
+
+#if (FEATURE_SYS_TIME_FAULT)
+/**
+ * @brief make the next 'count' releases of a periodic body 'late_ms' late, the grid is kept
+ *        so the release after a late one comes early, as a real overrun would
+ */
+void sys_time_fault_late(sys_time_period_E id, uint32_t late_ms, uint16_t count);
+#endif // (FEATURE_SYS_TIME_FAULT)
+
+# ifdef __cplusplus
+}
+# endif
+#endif //SYS_TIME_H
@@ -0,0 +1,203 @@
+/**
+ * @file    app_hazard.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    22 Mar 2021
+ * @brief   App level files
+ *
+ * This document will contains the hazard e-stop fast path:
+ *      sensor frame -> rx task -> hazard task -> e-stop I2C write to both drivers,
+ *      without waiting for the supervisor tick or the 20ms driver update.
+ */
+
+#include "app_hazard.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+// TableUV Lib
+#include "common.h"
+#include "dev_avr_sensor.h"
+#include "dev_avr_driver.h"
+#include "sys_time.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define HAZARD_EVENT_SENSOR_FRAME       (1U << 0)
+#define HAZARD_SENSOR_MASK              (DEV_AVR_ALL_SENSORS)  // same set that sends the supervisor to e-stop
+#define HAZARD_STATS_PERIOD_US          (1000000LL)
+#define HAZARD_MUTEX_BLOCK_TIME_MS      (SYS_TIME_MS_TO_TICK(20U)) // covers one e-stop write to both drivers
+#define HAZARD_HIST_BUCKETS             (16U) // bucket i counts [2^i, 2^(i+1)) us, last one is open ended
+
+// hops of the fast path, every frame is measured up to the task, trips to the I2C write
+typedef enum{
+    HAZARD_HOP_RX_TO_TASK,      // uart rx event -> hazard task running
+    HAZARD_HOP_TASK_TO_LEFT,    // hazard task -> left driver written
+    HAZARD_HOP_TASK_TO_RIGHT,   // hazard task -> right driver written
+    HAZARD_HOP_RX_TO_ESTOP,     // end to end on the esp32
+    HAZARD_HOP_COUNT
+} hazard_hop_E;
+
+typedef struct{
+    uint32_t    bucket[HAZARD_HIST_BUCKETS];
+    uint32_t    samples;
+    uint32_t    max_us;
+} hazard_histogram_S;
+
+typedef struct{
+    SemaphoreHandle_t   arm_mutex;      // trip decision and e-stop write vs. (dis)arming
+    volatile bool       armed;          // written under 'arm_mutex', re-checked there before a trip
+    volatile bool       tripped;
+    uint32_t            tripCount;
+    uint32_t            estopFailCount; // trips where a driver did not ack the write
+    int64_t             stats_stamp_us;
+    hazard_histogram_S  hop[HAZARD_HOP_COUNT];
+} app_hazard_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void app_hazard_private_record(hazard_hop_E hop, int64_t elapsed_us);
+static void app_hazard_private_trip(const dev_avr_sensor_frame_S * frame, int64_t wake_us);
+static void app_hazard_private_print_stats(void);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static app_hazard_data_S hazard_data = {
+    .arm_mutex      = NULL,
+    .armed          = false,
+    .tripped        = false,
+    .tripCount      = 0,
+    .estopFailCount = 0,
+    .stats_stamp_us = 0,
+    .hop            = {{{0}}},
+};
+
+#if (DEBUG_FPRINT_APP_HAZARD)
+static const char * const hazard_hop_name[HAZARD_HOP_COUNT] = {
+    [HAZARD_HOP_RX_TO_TASK   ] = "rx>task",
+    [HAZARD_HOP_TASK_TO_LEFT ] = "task>left",
+    [HAZARD_HOP_TASK_TO_RIGHT] = "task>right",
+    [HAZARD_HOP_RX_TO_ESTOP  ] = "rx>estop",
+};
+#endif // (DEBUG_FPRINT_APP_HAZARD)
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void app_hazard_private_record(hazard_hop_E hop, int64_t elapsed_us)
+{
+    hazard_histogram_S * hist = &hazard_data.hop[hop];
+    const uint32_t us = (elapsed_us > 0) ? (uint32_t)elapsed_us : 0U;
+    uint8_t bucket = (uint8_t)(31 - __builtin_clz(us | 1U));
+    if (bucket >= HAZARD_HIST_BUCKETS)
+    {
+        bucket = HAZARD_HIST_BUCKETS - 1U;
+    }
+    hist->bucket[bucket] ++;
+    hist->samples ++;
+    if (us > hist->max_us)
+    {
+        hist->max_us = us;
+    }
+}
+
+static void app_hazard_private_trip(const dev_avr_sensor_frame_S * frame, int64_t wake_us)
+{
+    int64_t done_us[NUM_AVR_DRIVER];
+    if (xSemaphoreTake(hazard_data.arm_mutex, HAZARD_MUTEX_BLOCK_TIME_MS) != pdTRUE)
+    {
+        return;
+    }
+    if (hazard_data.armed)
+    {
+        // one shot, the supervisor takes over with its e-stop recovery script
+        hazard_data.armed   = false;
+        hazard_data.tripped = true;
+        hazard_data.tripCount ++;
+        if (dev_avr_driver_Estop_now(done_us) != NUM_AVR_DRIVER)
+        {
+            hazard_data.estopFailCount ++;
+        }
+        app_hazard_private_record(HAZARD_HOP_TASK_TO_LEFT,  done_us[LEFT_AVR_DRIVER]  - wake_us);
+        app_hazard_private_record(HAZARD_HOP_TASK_TO_RIGHT, done_us[RIGHT_AVR_DRIVER] - wake_us);
+        app_hazard_private_record(HAZARD_HOP_RX_TO_ESTOP,   done_us[RIGHT_AVR_DRIVER] - frame->stamp_us);
+    }
+    xSemaphoreGive(hazard_data.arm_mutex);
+}
+
+static void app_hazard_private_print_stats(void)
+{
+#if (DEBUG_FPRINT_APP_HAZARD)
+    PRINTF("[ HAZARD ] trips: %d, estop fail: %d, armed: %d\n", hazard_data.tripCount, hazard_data.estopFailCount, hazard_data.armed);
+    for (uint8_t hop = 0; hop < HAZARD_HOP_COUNT; hop++)
+    {
+        const hazard_histogram_S * hist = &hazard_data.hop[hop];
+        PRINTF("[ HAZARD ] %-10s n:%6d max:%6dus log2(us):", hazard_hop_name[hop], hist->samples, hist->max_us);
+        for (uint8_t i = 0; i < HAZARD_HIST_BUCKETS; i++)
+        {
+            PRINTF(" %d", hist->bucket[i]);
+        }
+        PRINTF("%s", "\n");
+    }
+#endif // (DEBUG_FPRINT_APP_HAZARD)
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void app_hazard_init(void)
+{
+    hazard_data.arm_mutex   = xSemaphoreCreateMutex();
+}
+
+void app_hazard_run(void)
+{
+    dev_avr_sensor_frame_S frame;
+    uint32_t events;
+    dev_avr_sensor_register_notify(DEV_AVR_SENSOR_SUB_HAZARD, xTaskGetCurrentTaskHandle(), HAZARD_EVENT_SENSOR_FRAME);
+    for( ;; )
+    {
+        xTaskNotifyWait(0U, UINT32_MAX, &events, SYS_TIME_MS_TO_TICK(HAZARD_STATS_PERIOD_US / 1000));
+        const int64_t wake_us = sys_time_us();
+
+        while (dev_avr_sensor_frame_pop(DEV_AVR_SENSOR_SUB_HAZARD, &frame))
+        {
+            app_hazard_private_record(HAZARD_HOP_RX_TO_TASK, wake_us - frame.stamp_us);
+            if ((frame.flags & HAZARD_SENSOR_MASK) && (hazard_data.armed))
+            {
+                app_hazard_private_trip(&frame, wake_us);
+            }
+        }
+
+        if ((wake_us - hazard_data.stats_stamp_us) >= HAZARD_STATS_PERIOD_US)
+        {
+            hazard_data.stats_stamp_us = wake_us;
+            app_hazard_private_print_stats();
+        }
+    }
+}
+
+void app_hazard_arm(bool armed)
+{
+    if (xSemaphoreTake(hazard_data.arm_mutex, HAZARD_MUTEX_BLOCK_TIME_MS) == pdTRUE)
+    {
+        hazard_data.armed   = armed;
+        hazard_data.tripped = false;
+        dev_avr_driver_release_Estop_latch();
+        xSemaphoreGive(hazard_data.arm_mutex);
+    }
+}
+
+bool app_hazard_is_tripped(void)
+{
+    return hazard_data.tripped;
+}
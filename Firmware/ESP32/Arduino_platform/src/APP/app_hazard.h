@@ -0,0 +1,37 @@
+/**
+ * @file    app_hazard.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    22 Mar 2021
+ * @brief   App level
+ *
+ * This document will contains the hazard e-stop fast path
+ */
+
+#ifndef APP_HAZARD_H
+#define APP_HAZARD_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void app_hazard_init(void);
+/**
+ * @brief hazard task body, blocks on sensor frames and never returns
+ */
+void app_hazard_run(void);
+/**
+ * @brief arm or disarm the fast e-stop, both clear the trip and release the driver e-stop latch
+ * @note trips once per arming, the supervisor re-arms when it is back in autonomy
+ */
+void app_hazard_arm(bool armed);
+bool app_hazard_is_tripped(void);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //APP_HAZARD_H
@@ -0,0 +1,207 @@
+/**
+ * @file    app_motion_script.c
+ * @author  Jianxiang (Jack) Xu
+ * @date    24 Mar 2021
+ * @brief   App level files
+ *
+ * This document will contains the motion script interpreter:
+ *      runs a table of app_motion_step_S from the driver poll task, right after the status frames
+ *      came in, each step issues its wheel command once and ends on its duration or its guard.
+ */
+
+#include "app_motion_script.h"
+
+// Std. Lib
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// TableUV Lib
+#include "common.h"
+#include "dev_avr_driver.h"
+#include "dev_avr_sensor.h"
+#include "sys_time.h"
+
+// FreeRTOS
+#include "freertos/semphr.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+#define MOTION_SCRIPT_RAD_TO_DEG        (57.29578F)
+
+_Static_assert(sizeof(app_motion_step_S) == 8U, "motion step is an 8 byte bytecode");
+
+typedef struct{
+    SemaphoreHandle_t           mutex;
+    const app_motion_step_S *   script;         // Protected By: 'mutex'
+    const app_motion_step_S *   step;           // Protected By: 'mutex', NULL when idle
+    // a step is entered under 'mutex', so no script command lands after app_motion_script_stop()
+    int64_t                     step_start_us;
+    int32_t                     step_start_count[NUM_AVR_DRIVER];
+    TaskHandle_t                notify_task;
+    uint32_t                    notify_bit;
+} app_motion_script_data_S;
+
+/////////////////////////////////////////
+///////   PRIVATE PROTOTYPE     /////////
+/////////////////////////////////////////
+static void app_motion_script_private_enterStep(const app_motion_step_S * step);
+static void app_motion_script_private_printStep(const app_motion_step_S * step);
+static bool app_motion_script_private_guardHolds(const app_motion_step_S * step);
+
+///////////////////////////
+///////   DATA     ////////
+///////////////////////////
+static app_motion_script_data_S motion_script_data = {
+    .mutex              = NULL,
+    .script             = NULL,
+    .step               = NULL,
+    .step_start_us      = 0,
+    .step_start_count   = {0},
+    .notify_task        = NULL,
+    .notify_bit         = 0,
+};
+
+////////////////////////////////////////
+///////   PRIVATE FUNCTION     /////////
+////////////////////////////////////////
+static void app_motion_script_private_enterStep(const app_motion_step_S * step)
+{
+    motion_script_data.step_start_us = sys_time_us();
+    for (uint8_t side = LEFT_AVR_DRIVER; side < NUM_AVR_DRIVER; side++)
+    {
+        motion_script_data.step_start_count[side] = dev_avr_driver_get_EncoderCount(side);
+    }
+
+    switch (step->op)
+    {
+        case (MOTION_OP_PWM):
+            dev_avr_driver_set_req_Robot_motion((robot_motion_mode_E)step->mode,
+                (motor_pwm_duty_E)step->left, (motor_pwm_duty_E)step->right);
+            break;
+        case (MOTION_OP_SPEED):
+            dev_avr_driver_set_req_Robot_speed(step->left, step->right);
+            break;
+        case (MOTION_OP_END):
+        default:
+            dev_avr_driver_set_req_Robot_motion(ROBOT_MOTION_BREAK, MOTOR_PWM_DUTY_0_PERCENT, MOTOR_PWM_DUTY_0_PERCENT);
+            break;
+    }
+}
+
+static void app_motion_script_private_printStep(const app_motion_step_S * step)
+{
+#if (DEBUG_FPRINT_APP_SUPER_CHOREOGRAPHY)
+    PRINTF("[ MOTION ] step [%d] op:%d m:%d, l:%d, r:%d, guard:%d/%d, %dms\n",
+        (int)(step - motion_script_data.script), step->op, step->mode, step->left, step->right,
+        step->guard, step->guard_value, step->duration_ms);
+#endif // (DEBUG_FPRINT_APP_SUPER_CHOREOGRAPHY)
+}
+
+// encoder counts follow the status poll, so distance and heading guards resolve to that
+static bool app_motion_script_private_guardHolds(const app_motion_step_S * step)
+{
+    const int32_t dl = dev_avr_driver_get_EncoderCount(LEFT_AVR_DRIVER)  - motion_script_data.step_start_count[LEFT_AVR_DRIVER];
+    const int32_t dr = dev_avr_driver_get_EncoderCount(RIGHT_AVR_DRIVER) - motion_script_data.step_start_count[RIGHT_AVR_DRIVER];
+    bool holds = false;
+    switch (step->guard)
+    {
+        case (MOTION_GUARD_DISTANCE_MM):
+            holds = (fabsf((float)(dr + dl) * DEV_AVR_DRIVER_WHEEL_MM_PER_TICK_SCALED) >= (float)step->guard_value);
+            break;
+        case (MOTION_GUARD_HEADING_DEG):
+            holds = (fabsf((float)(dr - dl) * DEV_AVR_DRIVER_INVERSE_DIST_BW_WHEELS_MM_SCALED * MOTION_SCRIPT_RAD_TO_DEG)
+                        >= (float)step->guard_value);
+            break;
+        case (MOTION_GUARD_SENSOR_CLEAR):
+            holds = ((dev_avr_sensor_uart_get() & step->guard_value) == 0U);
+            break;
+        case (MOTION_GUARD_SENSOR_SET):
+            holds = ((dev_avr_sensor_uart_get() & step->guard_value) != 0U);
+            break;
+        case (MOTION_GUARD_NONE):
+        default:
+            break;
+    }
+    return holds;
+}
+
+///////////////////////////////////////
+///////   PUBLIC FUNCTION     /////////
+///////////////////////////////////////
+void app_motion_script_init(void)
+{
+    motion_script_data.mutex = xSemaphoreCreateMutex();
+}
+
+void app_motion_script_start(const app_motion_step_S * script)
+{
+    if ((script == NULL) || (script->op == MOTION_OP_END))
+    {
+        app_motion_script_stop();
+        return;
+    }
+    xSemaphoreTake(motion_script_data.mutex, portMAX_DELAY);
+    motion_script_data.script = script;
+    motion_script_data.step   = script;
+    app_motion_script_private_enterStep(script);
+    xSemaphoreGive(motion_script_data.mutex);
+    app_motion_script_private_printStep(script);
+}
+
+// stops interpreting, the last wheel command stays with the caller
+void app_motion_script_stop(void)
+{
+    xSemaphoreTake(motion_script_data.mutex, portMAX_DELAY);
+    motion_script_data.step = NULL;
+    xSemaphoreGive(motion_script_data.mutex);
+}
+
+bool app_motion_script_is_running(void)
+{
+    bool running;
+    xSemaphoreTake(motion_script_data.mutex, portMAX_DELAY);
+    running = (motion_script_data.step != NULL);
+    xSemaphoreGive(motion_script_data.mutex);
+    return running;
+}
+
+// the encoder guards only move with the status frames, so a step never ends between two polls
+void app_motion_script_update(void)
+{
+    const app_motion_step_S * step = NULL;
+    bool finished = false;
+
+    xSemaphoreTake(motion_script_data.mutex, portMAX_DELAY);
+    const app_motion_step_S * current = motion_script_data.step;
+    if (current != NULL)
+    {
+        const int64_t elapsed_us = sys_time_us() - motion_script_data.step_start_us;
+        const bool timed_out = (current->duration_ms != 0U) && (elapsed_us >= ((int64_t)current->duration_ms * 1000));
+        if (timed_out || app_motion_script_private_guardHolds(current))
+        {
+            step = current + 1;
+            app_motion_script_private_enterStep(step);
+            finished = (step->op == MOTION_OP_END);
+            motion_script_data.step = finished ? NULL : step;
+        }
+    }
+    xSemaphoreGive(motion_script_data.mutex);
+
+    if (step == NULL)
+    {
+        return;
+    }
+    app_motion_script_private_printStep(step);
+    if (finished && (motion_script_data.notify_task != NULL))
+    {
+        xTaskNotify(motion_script_data.notify_task, motion_script_data.notify_bit, eSetBits);
+    }
+}
+
+void app_motion_script_register_notify(TaskHandle_t task, uint32_t bit)
+{
+    motion_script_data.notify_bit  = bit;
+    motion_script_data.notify_task = task;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file    app_motion_script.h
+ * @author  Jianxiang (Jack) Xu
+ * @date    24 Mar 2021
+ * @brief   App level
+ *
+ * This document will contains the motion script interpreter
+ */
+
+#ifndef APP_MOTION_SCRIPT_H
+#define APP_MOTION_SCRIPT_H
+# ifdef __cplusplus
+extern "C"{
+# endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/////////////////////////////////
+///////   DEFINITION     ////////
+/////////////////////////////////
+typedef enum{
+    MOTION_OP_END,          // script done, motors are left braked
+    MOTION_OP_PWM,          // 'mode' is a robot_motion_mode_E, 'left'/'right' are motor_pwm_duty_E
+    MOTION_OP_SPEED,        // closed loop, 'left'/'right' are signed wheel speeds [mm/s]
+    MOTION_OP_COUNT
+} app_motion_op_E;
+
+// a step ends on its duration, or earlier once its guard holds
+typedef enum{
+    MOTION_GUARD_NONE,
+    MOTION_GUARD_DISTANCE_MM,   // |travelled| since step start >= value [mm]
+    MOTION_GUARD_HEADING_DEG,   // |turned| since step start >= value [deg]
+    MOTION_GUARD_SENSOR_CLEAR,  // none of the avr sensor bits in value is tripped
+    MOTION_GUARD_SENSOR_SET,    // any of the avr sensor bits in value is tripped
+    MOTION_GUARD_COUNT
+} app_motion_guard_E;
+
+// one step of bytecode, 8 bytes
+typedef struct{
+    uint8_t     op;             // app_motion_op_E
+    uint8_t     mode;           // robot_motion_mode_E, MOTION_OP_PWM only
+    int8_t      left;
+    int8_t      right;
+    uint8_t     guard;          // app_motion_guard_E
+    uint8_t     guard_value;
+    uint16_t    duration_ms;    // timeout of the step, 0 waits on the guard only
+} app_motion_step_S;
+
+///////////////////////////////////////
+///////   PUBLIC PROTOTYPE    /////////
+///////////////////////////////////////
+void app_motion_script_init(void);
+/**
+ * @brief start a script, a running one is replaced
+ * @param script steps terminated by MOTION_OP_END, must stay valid while running
+ */
+void app_motion_script_start(const app_motion_step_S * script);
+void app_motion_script_stop(void);
+bool app_motion_script_is_running(void);
+/**
+ * @brief step the running script, call from the driver poll task after its status frames
+ */
+void app_motion_script_update(void);
+/**
+ * @brief set 'bit' in the notification value of 'task' when a script finishes
+ */
+void app_motion_script_register_notify(TaskHandle_t task, uint32_t bit);
+
+# ifdef __cplusplus
+}
+# endif
+#endif //APP_MOTION_SCRIPT_H
@@ -15,10 +15,15 @@
 
 // TableUV Lib
 #include "common.h"
+#include "mem_budget.h"
 #include "dev_ToF_Lidar.h"
 #include "slam_math.h"
 #include "dev_avr_sensor.h"
 #include "dev_avr_driver.h"
+#include "sys_telemetry.h"
+#include "sys_time.h"
+#include "sys_bench.h"
+#include "sys_probe.h"
 
 // SDK config 
 #include "sdkconfig.h"
@@ -28,6 +33,9 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
+// single precision only, see slam_math.c
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
 //////////////////////////////
 ///////   TYPEDEF     ////////
 //////////////////////////////
@@ -109,6 +117,7 @@ typedef enum {
 #define VEHICLE_EDGE_NODE_PI                (VEHICLE_EDGE_NODE_14)
 #define VEHICLE_EDGE_NODE_FOV               (0.2243994753F)//(float)((CONST_M_PI) / (int32_t)(VEHICLE_EDGE_NODE_PI))
 #define VEHICLE_EDGE_NODE_FOV_2             (0.1121997376F)//(float)(VEHICLE_EDGE_NODE_FOV/2)
+#define VEHICLE_EDGE_NODE_PER_RAD           (4.4563384065F)//(float)(1/VEHICLE_EDGE_NODE_FOV), a multiply where a divide costs ~10x on the fpu
 #define VEHICLE_COLLISION_START_NODE        (VEHICLE_EDGE_NODE_0)
 #define VEHICLE_COLLISION_NUM_NODES         (5)
 #define VEHICLE_AVOIDANCE_R_PIXEL           (4)
@@ -119,12 +128,51 @@ typedef enum {
 # define VEHICLE_TOF_OBSTACLE_DIST_MIN           (30U) // [mm]
 # define VEHICLE_TOF_OBSTACLE_DIST_MIN_CORNER    (10U) // [mm]
 #endif // (FEATURE_DEMO_TOF_OBSTACLE)
+#if (FEATURE_SLAM_SCAN_MATCH)
+// scan match: same mount as host/sim_table.cpp, not measured on the robot
+# define SCAN_MATCH_TOF_MOUNT_RAD                (0.4363323130F) // 25 deg, L and R off the center
+# define SCAN_MATCH_TOF_COLUMN_RAD               (0.0294524311F) // 27 deg over 16 spad columns
+# define SCAN_MATCH_TOF_ORIGIN_MM                (50.0F) // sensors sit on the rim
+# define SCAN_MATCH_TOF_RANGE_MIN_MM             (20U)
+# define SCAN_MATCH_TOF_RANGE_MAX_MM             (640U) // within GMAP_VISIBILITY_RANGE_MAX, the search window to spare
+# define SCAN_MATCH_SWEEP_SIZE                   (DEV_TOF_TOTAL_POINTS_PER_SCAN) // one firing sequence of every sensor
+# define SCAN_MATCH_SWEEP_KEEP_MM                (SCAN_MATCH_TOF_ORIGIN_MM + (float)SCAN_MATCH_TOF_RANGE_MAX_MM) // farthest a fresh return lands
+# define SCAN_MATCH_WINDOW_PIXEL                 (7) // translation search [-7, 7] cells around the odometry pose
+# define SCAN_MATCH_THETA_STEPS                  (4) // rotation search [-4, 4] steps
+# define SCAN_MATCH_THETA_STEP_RAD               (0.015F) // < 1 cell at SCAN_MATCH_TOF_RANGE_MAX_MM
+# define SCAN_MATCH_MIN_POINTS                   (6U)
+# define SCAN_MATCH_MIN_GAIN                     (30U) // over the odometry pose, ~ one more point on a confirmed cell
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+#if (FEATURE_SLAM_TABLE_MODEL)
+// table model: the straight edges of a rectangular table from the IR edge hits
+# define TABLE_HIT_BUFFER_SIZE                   (64U)
+# define TABLE_HIT_SPACING_MM                    (10.0F) // a hit closer than this to a buffered one adds nothing
+# define TABLE_EDGE_MAX                          (4U)    // rectangle
+# define TABLE_EDGE_INLIER_MM                    (15.0F) // point to line, fitting
+# define TABLE_EDGE_ASSOCIATE_MM                 (40.0F) // point to line, a known edge seen again after some drift
+# define TABLE_EDGE_MIN_INLIERS                  (5U)
+# define TABLE_EDGE_MIN_SPAN_MM                  (150.0F)
+# define TABLE_EDGE_MERGE_MM                     (50.0F) // a parallel line closer than this is the same edge
+# define TABLE_EDGE_AXIS_TOLERANCE_RAD           (0.1F)  // edges meet at right angles
+# define TABLE_EDGE_REFINE_COUNT                 (8U)    // hits refining a new edge, then it holds still as a heading reference
+# define TABLE_RANSAC_ITERATIONS                 (24U)   // per cycle
+# define TABLE_RANSAC_SEED                       (0x7AB1EUL) // fixed, the replay stays deterministic
+# define TABLE_TRACK_SIZE                        (16U)
+# define TABLE_TRACK_ASSOCIATE_MM                (100.0F) // point to line, an edge after the drift of a pass
+# define TABLE_TRACK_MIN_HITS                    (3U)
+# define TABLE_TRACK_MIN_SPAN_MM                 (300.0F)
+# define TABLE_TRACK_TRAVEL_MM                   (4000.0F) // hits of one pass, the drift has not moved them apart yet
+# define TABLE_HEADING_MIN_RAD                   (0.1F)  // smaller is within what the IR hit scatter turns a 3 hit pass by
+# define TABLE_HEADING_MAX_RAD                   (0.4F)  // larger is a wrong association, not drift
+# define TABLE_HEADING_GAIN                      (0.7F)
+# define TABLE_CLIP_MARGIN_MM                    (20.0F) // cells this far past an edge are off the table
+#endif // (FEATURE_SLAM_TABLE_MODEL)
 
 /*** (parameterization) ***/
 // Robot Characteristics 
 #define ROBOT_SIZE_D_MM                     (100U)  // 100 [mm] => boundary would be (100 + 10/2 + 10/2) = 110 [mm]
 // Global Map
-#define GMAP_SQUARE_EDGE_SIZE_MM            (1000U) // 1   [m]
+#define GMAP_SQUARE_EDGE_SIZE_MM            (MEM_BUDGET_GMAP_EDGE_MM) // 1.6 [m]
 #define GMAP_UNIT_GRID_STEP_SIZE_MM         (10U)   // 10  [mm]
 
 // Grid Occupancy
@@ -141,6 +189,7 @@ typedef enum {
 // Rating in: 1~20 + 100 => must not intrude!
 #define GRID_CELL_EDGE_MIN_PROB             (101)
 #define GRID_CELL_EDGE_DEFAULT_PROB         (110)
+#define GRID_CELL_EDGE_CLIP_PROB            (105) // past a table edge by the model, not sensed: undone when the edge moves
 #define GRID_CELL_EDGE_MAX_PROB             (120)
 
 // 20 <= val <= 20 : walkable
@@ -160,7 +209,7 @@ typedef enum {
 #define VELOCITY_SOFT_MM_S                  (30) // 30 mm/s
 #define VELOCITY_MAX_MM_S                   (60) // 60 mm/s
 
-#define MP_MUTEX_BLOCK_TIME_MS              ((1U)/portTICK_PERIOD_MS)
+#define MP_MUTEX_BLOCK_TIME_MS              (SYS_TIME_MS_TO_TICK(1U))
 
 /*** (Pre-compile const.) ***/
 // Robot Characteristics 
@@ -173,6 +222,16 @@ typedef enum {
 #define GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL  ((GMAP_GRID_EDGE_SIZE_PIXEL) / (2U))
 #define GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL  ((GMAP_GRID_EDGE_SIZE_PIXEL) / (2U))
 #define GMAP_VISIBILITY_RANGE_MAX           ((GMAP_SQUARE_EDGE_SIZE_MM)  / (2U))
+#define GMAP_TILE_EDGE_SHIFT                (3U)    // 8 x 8 pixel dirty tiles
+#define GMAP_TILE_EDGE_PIXEL                (1U << (GMAP_TILE_EDGE_SHIFT))
+#define GMAP_TILE_WN                        (((GMAP_WN_PIXEL) + (GMAP_TILE_EDGE_PIXEL) - (1U)) >> (GMAP_TILE_EDGE_SHIFT))
+#define GMAP_TILE_HN                        (((GMAP_HN_PIXEL) + (GMAP_TILE_EDGE_PIXEL) - (1U)) >> (GMAP_TILE_EDGE_SHIFT))
+#define GMAP_TILE_COUNT                     ((GMAP_TILE_WN) * (GMAP_TILE_HN))
+#define GMAP_TILE_WORD_COUNT                (((GMAP_TILE_COUNT) + (31U)) >> (5U))
+#define LMAP_L2_SHIFT                       (2U)    // 4 x 4 pixel blocks
+#define LMAP_L3_SHIFT                       (GMAP_TILE_EDGE_SHIFT) // one dirty tile
+#define LMAP_L4_SHIFT                       (4U)    // 16 x 16, the search root
+#define LMAP_N(shift)                       (((GMAP_WN_PIXEL) + (1U << (shift)) - (1U)) >> (shift))
 // Others
 #define CONST_M_2PI                         (6.283185307179586F)
 #define CONST_M_PI		                    (3.14159265358979323846F)
@@ -181,6 +240,7 @@ typedef enum {
 // Unit Conversion
 #define GMAP_MM_TO_UNIT_PIXEL(x_mm)             (int32_t)((x_mm)/(GMAP_UNIT_GRID_STEP_SIZE_MM)) // -ve Ceiling => -1, +ve Flooring => 1
 #define GMAP_UNIT_PIXEL_TO_MM(x_pixel)          (float)((x_pixel) * (float)(GMAP_UNIT_GRID_STEP_SIZE_MM))
+#define GMAP_MM_TO_NEAREST_PIXEL(x_mm)          (int32_t)floorf((x_mm) * (1.0F / (float)(GMAP_UNIT_GRID_STEP_SIZE_MM)) + 0.5F)
 #define ANGLE_WRAP_NPI_TO_PI(ang_rad)           (((ang_rad) < (- CONST_M_PI)?((CONST_M_2PI) + (ang_rad)):(((ang_rad) > (CONST_M_PI))?((ang_rad) - (CONST_M_2PI)):(ang_rad))))
 
 // GMap dynamic accessor compensator
@@ -191,13 +251,19 @@ typedef enum {
 #define GRID_CELL_MAX_SATURATION(value)         (map_pixel_data_t)(((value) <= (GRID_CELL_EDGE_MAX_PROB))?(value):(GRID_CELL_EDGE_MAX_PROB))
 #define GRID_CELL_DECAY(value)                  (map_pixel_data_t)(((value) <= (GRID_CELL_NEUTRAL))?(value):((value) + (GRID_CELL_BETA_DECAY)))
 
-#define EDGE_NODE_MAPPING(theta_rad)            (vehicle_edge_node_E)(((theta_rad) + (CONST_M_PI) + (VEHICLE_EDGE_NODE_FOV_2)) / (VEHICLE_EDGE_NODE_FOV)) // Assume: theta \in [-pi, pi]
+#define EDGE_NODE_MAPPING(theta_rad)            (vehicle_edge_node_E)(((theta_rad) + (CONST_M_PI) + (VEHICLE_EDGE_NODE_FOV_2)) * (VEHICLE_EDGE_NODE_PER_RAD)) // Assume: theta \in [-pi, pi]
 #define EDGE_NODE_WRAPPING(node_integer)        (vehicle_edge_node_E)( ((node_integer) < 0) ? ((node_integer) + VEHICLE_EDGE_NODE_COUNT) : ( ((node_integer) >= (int8_t)(VEHICLE_EDGE_NODE_COUNT))?((node_integer) - VEHICLE_EDGE_NODE_COUNT):(node_integer) ) )
 
 // Assumptions:
 #if !(GMAP_WN_PIXEL == GMAP_HN_PIXEL)
     #error "GMAP_WN_PIXEL != GMAP_HN_PIXEL"
 #endif
+#if ((GMAP_WN_PIXEL * GMAP_HN_PIXEL) > MEM_BUDGET_GMAP)
+    #error "global map exceeds MEM_BUDGET_GMAP"
+#endif
+#if (FEATURE_SLAM_SCAN_MATCH) && (SCAN_MATCH_WINDOW_PIXEL >= (1 << (LMAP_L4_SHIFT - 1U)))
+    #error "SCAN_MATCH_WINDOW_PIXEL exceeds the search root"
+#endif
 
 /* === === [ Global Grid Occupancy Map ] === ===
  *
@@ -222,6 +288,98 @@ typedef struct{
     vehicle_edge_node_E          orientation_node;
 } dynamic_map_S;
 
+#if (FEATURE_SLAM_SCAN_MATCH)
+/* === === [ Likelihood Pyramid ] === ===
+ * level k holds the max likelihood of each aligned 2^k x 2^k block of the global map, in its memory layout,
+ * level 0 is the map itself; rebuilt tile by tile from the cells changed since the last search
+ */
+typedef struct{
+    uint8_t                      l2[LMAP_N(LMAP_L2_SHIFT) * LMAP_N(LMAP_L2_SHIFT)];
+    uint8_t                      l3[LMAP_N(LMAP_L3_SHIFT) * LMAP_N(LMAP_L3_SHIFT)];
+    uint8_t                      l4[LMAP_N(LMAP_L4_SHIFT) * LMAP_N(LMAP_L4_SHIFT)];
+    uint32_t                     dirty_tile[GMAP_TILE_WORD_COUNT]; // tiles changed since the pyramid was last updated
+} likelihood_map_S;
+
+typedef struct{
+    math_cart_coord_float_S      point_mm[SCAN_MATCH_SWEEP_SIZE]; // map aligned, relative to the vehicle
+    uint8_t                      count;
+    uint8_t                      head;   // next slot to write
+    uint8_t                      fresh;  // added this cycle, the last ones before 'head'
+    // the cells the latest returns marked into the map and their values before, a ring:
+    // the sweep is scored without them, or it would find its own marks and confirm itself
+    uint16_t                     mark_index[SCAN_MATCH_SWEEP_SIZE];
+    map_pixel_data_t             mark_prior[SCAN_MATCH_SWEEP_SIZE];
+    uint8_t                      mark_count;
+    uint8_t                      mark_head;
+} scan_sweep_S;
+
+_Static_assert((GMAP_WN_PIXEL * GMAP_HN_PIXEL) <= (UINT16_MAX + 1U), "a marked cell is kept as a uint16 map index");
+
+_Static_assert(((int32_t)SCAN_MATCH_SWEEP_KEEP_MM / (int32_t)GMAP_UNIT_GRID_STEP_SIZE_MM + 1 + (1 << LMAP_L4_SHIFT)) < (int32_t)GMAP_WN_PIXEL,
+    "a sweep cell plus the search root must stay within one wrap of the map");
+
+typedef struct{
+    int32_t                      x_pixel[SCAN_MATCH_SWEEP_SIZE]; // the sweep rotated by one candidate, unwrapped map cells
+    int32_t                      y_pixel[SCAN_MATCH_SWEEP_SIZE];
+    uint32_t                     bound; // score bound of the search root
+} scan_match_cells_S;
+
+typedef struct{
+    int32_t                      dx_pixel;
+    int32_t                      dy_pixel;
+    int8_t                       theta_step;
+    uint32_t                     score;
+} scan_match_result_S;
+
+_Static_assert((sizeof(likelihood_map_S) + sizeof(scan_sweep_S)) <= MEM_BUDGET_SCAN_MATCH, "scan match exceeds MEM_BUDGET_SCAN_MATCH");
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+
+#if (FEATURE_SLAM_TABLE_MODEL)
+typedef struct{
+    math_cart_coord_float_S      point_mm; // world, the frame of 'vehicle_state'
+    uint8_t                      edge;     // TABLE_EDGE_MAX: not on an edge yet
+} table_hit_S;
+
+// moments of a point set, about its first point to keep the float sums small
+typedef struct{
+    math_cart_coord_float_S      origin_mm;
+    float                        sx, sy, sxx, sxy, syy;
+    uint16_t                     count;
+} table_moments_S;
+
+typedef struct{
+    table_moments_S              moments;
+    math_cart_coord_float_S      normal;        // unit, towards the table
+    float                        distance_mm;   // on the table: normal . p >= distance_mm
+    bool                         confirmed;     // settled, then seen again by a later pass or across a perpendicular edge
+} table_edge_S;
+
+typedef struct{
+    math_cart_coord_float_S      point_mm;
+    float                        travel_mm;     // odometer at the hit
+    uint8_t                      edge;
+} table_track_S;
+
+typedef struct{
+    table_hit_S                  hit[TABLE_HIT_BUFFER_SIZE];
+    uint8_t                      hit_count;
+    uint8_t                      hit_head;      // next slot to write
+    table_edge_S                 edge[TABLE_EDGE_MAX];
+    uint8_t                      edge_count;
+    float                        axis_rad;      // direction of the first edge, the others are at right angles to it
+    table_track_S                track[TABLE_TRACK_SIZE]; // latest hits near an edge, since the last heading correction
+    uint8_t                      track_count;
+    uint8_t                      track_head;    // next slot to write
+    float                        travel_mm;     // odometer, distance driven since the map reset
+    float                        turn_rad;      // heading correction of the last pass, turned at the start of the next cycle
+    bool                         turn_pending;
+    uint8_t                      clip_tile_row; // next row of tiles to clip
+    uint32_t                     ransac_seed;
+} table_model_S;
+
+_Static_assert(sizeof(table_model_S) <= MEM_BUDGET_TABLE_MODEL, "table model exceeds MEM_BUDGET_TABLE_MODEL");
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+
 typedef struct{
     const int8_t                edge_node_x_pixel[VEHICLE_EDGE_NODE_COUNT];
     const int8_t                edge_node_y_pixel[VEHICLE_EDGE_NODE_COUNT];
@@ -242,6 +400,8 @@ typedef struct{
     bool                        collision_end_node[COLLISION_COUNT];
     uint8_t                     obstacle_count; // store obstacle result
     uint16_t                    tof_dangerous_zone;
+    TaskHandle_t                danger_zone_notify_task;
+    uint32_t                    danger_zone_notify_bit;
 
     SemaphoreHandle_t           motion_profile_mutex;
     motion_profile_S            motion_profile;
@@ -251,6 +411,14 @@ typedef struct{
 
     // global map info.
     dynamic_map_S               gMap;
+    uint32_t                    gMap_dirty_tile[GMAP_TILE_WORD_COUNT]; // tiles changed since they were last streamed
+#if (FEATURE_SLAM_SCAN_MATCH)
+    likelihood_map_S            lMap;
+    scan_sweep_S                sweep;
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+#if (FEATURE_SLAM_TABLE_MODEL)
+    table_model_S               table;
+#endif // (FEATURE_SLAM_TABLE_MODEL)
 
     // sensor configuration
     const edge_sensor_config_S * sensor_config;
@@ -276,6 +444,37 @@ static INLINE void app_slam_private_resetGlobalMap(void);
 static void app_slam_private_translateGlobalMap(int32_t dx, int32_t dy);
 static void app_slam_private_clearVehicleRegion(void);
 static void app_slam_private_updateEdgeRegion(void);
+static INLINE void app_slam_private_markTileDirty(int32_t x_pixel, int32_t y_pixel);
+#if (FEATURE_SLAM_SCAN_MATCH || FEATURE_SLAM_TABLE_MODEL)
+static void app_slam_private_correctHeading(float dtheta_rad);
+#endif // (FEATURE_SLAM_SCAN_MATCH || FEATURE_SLAM_TABLE_MODEL)
+#if (FEATURE_SLAM_SCAN_MATCH)
+static INLINE uint8_t app_slam_private_likelihood(map_pixel_data_t value);
+static void app_slam_private_updateLikelihoodMap(void);
+static void app_slam_private_updateSweep(float dx_mm, float dy_mm, float theta_rad, float dtheta_rad);
+static void app_slam_private_scanMatchCells(int8_t theta_step, scan_match_cells_S * cells);
+static uint32_t app_slam_private_scanMatchBound(const scan_match_cells_S * cells, uint32_t shift, int32_t dx_pixel, int32_t dy_pixel);
+static uint32_t app_slam_private_scanMatchScore(const scan_match_cells_S * cells, int32_t dx_pixel, int32_t dy_pixel);
+static void app_slam_private_scanMatchBranch(const scan_match_cells_S * cells, uint32_t shift, int32_t dx_pixel, int32_t dy_pixel,
+    int8_t theta_step, scan_match_result_S * best);
+static void app_slam_private_scanMatchHideMarks(map_pixel_data_t * saved);
+static void app_slam_private_scanMatchShowMarks(const map_pixel_data_t * saved);
+static bool app_slam_private_scanMatchSearch(scan_match_result_S * result);
+static void app_slam_private_scanMatch(void);
+static void app_slam_private_updateGmapFromToF(void);
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+#if (FEATURE_SLAM_TABLE_MODEL)
+static void app_slam_private_momentsAdd(table_moments_S * moments, const math_cart_coord_float_S * point_mm);
+static float app_slam_private_momentsFit(const table_moments_S * moments, math_cart_coord_float_S * mean_mm);
+static void app_slam_private_tableEdgeFit(table_edge_S * edge, const math_cart_coord_float_S * inside_mm);
+static void app_slam_private_tableEdgeHit(int32_t node_x_pixel, int32_t node_y_pixel);
+static void app_slam_private_tableTrack(const math_cart_coord_float_S * point_mm);
+static void app_slam_private_tableTurn(void);
+static void app_slam_private_tableFindEdge(void);
+static void app_slam_private_tableConfirm(void);
+static void app_slam_private_tableClip(void);
+static void app_slam_private_updateTableModel(void);
+#endif // (FEATURE_SLAM_TABLE_MODEL)
 
 ///////////////////////////
 ///////   DATA     ////////
@@ -356,6 +555,17 @@ static const edge_sensor_config_S edge_sensor_config = {
         [IR_LR] = VEHICLE_EDGE_NODE_8,
     },
 };
+
+#if (FEATURE_SLAM_SCAN_MATCH)
+// geometrical region r is seen by sensor group r / 5 (R, C, L), ROI column r % 5 of dev_ToF_Lidar.cpp, right to left
+static const float scan_match_group_mount_rad[DEV_TOF_LIDAR_COUNT] = {
+    - SCAN_MATCH_TOF_MOUNT_RAD, 0.0F, SCAN_MATCH_TOF_MOUNT_RAD,
+};
+static const float scan_match_roi_bearing_rad[DEV_TOF_FIRING_KEYFRAME_COUNT] = {
+    -5.5F * SCAN_MATCH_TOF_COLUMN_RAD, -2.5F * SCAN_MATCH_TOF_COLUMN_RAD, 0.5F * SCAN_MATCH_TOF_COLUMN_RAD,
+     2.5F * SCAN_MATCH_TOF_COLUMN_RAD,  5.5F * SCAN_MATCH_TOF_COLUMN_RAD,
+};
+#endif // (FEATURE_SLAM_SCAN_MATCH)
 ////////////////////////////////////////
 ///////   PRIVATE FUNCTION     /////////
 ////////////////////////////////////////
@@ -363,14 +573,21 @@ static void app_slam_private_localization(void)
 {
     // TODO: intake  IMU, Encoder => EKF
     uint8_t buffer_size = dev_avr_driver_get_encoder_buffers(slam_data.left_enc_buf, slam_data.right_enc_buf);
-    slam_data.encoder_delta_mm = slam_math_get_enc_pose(slam_data.left_enc_buf, slam_data.right_enc_buf, buffer_size);
-    slam_data.encoder_delta_theta_rad = slam_math_get_theta(slam_data.encoder_delta_mm);
-#if (DEBUG_FPRINT_APP_SLAM_PRINT)
+    slam_data.encoder_delta_mm = slam_math_get_enc_odometry(slam_data.left_enc_buf, slam_data.right_enc_buf, buffer_size,
+        &slam_data.encoder_delta_theta_rad);
+#if (FEATURE_SYS_TELEMETRY)
+    sys_telemetry_encoder_S encoder = {
+        .count = buffer_size,
+    };
+    memcpy(encoder.left,  slam_data.left_enc_buf,  sizeof(encoder.left));
+    memcpy(encoder.right, slam_data.right_enc_buf, sizeof(encoder.right));
+    sys_telemetry_publish(SYS_TELEMETRY_ENCODER, &encoder, sizeof(encoder));
+#elif (DEBUG_FPRINT_APP_SLAM_PRINT)
     for (int i = 0; i < buffer_size ; i ++)
     {
         PRINTF("[ APP:SLAM ] # encoder fused: [%d/%d] [%5d, %5d]\n", i, buffer_size, slam_data.left_enc_buf[i], slam_data.right_enc_buf[i]);
     }
-#endif (DEBUG_FPRINT_APP_SLAM_PRINT)
+#endif // (DEBUG_FPRINT_APP_SLAM_PRINT)
 }
 
 /**
@@ -392,6 +609,11 @@ static void app_slam_private_localMapUpdate(void)
     // 2. Grab IR + Collision Data
 #if (FEATURE_SLAM_AVR_SENSOR)
     uint8_t avr_sensor_data = dev_avr_sensor_uart_get();
+    dev_avr_sensor_frame_S avr_sensor_frame;
+    while (dev_avr_sensor_frame_pop(DEV_AVR_SENSOR_SUB_SLAM, &avr_sensor_frame))
+    {
+        avr_sensor_data |= avr_sensor_frame.flags; // keep short trips between map updates
+    }
     bool* ir_node = slam_data.ir_node;
     bool* cn_node = slam_data.collision_end_node;
     // Interpret:
@@ -417,6 +639,7 @@ static void app_slam_private_localMapUpdate(void)
 #endif //(FEATURE_SLAM_AVR_SENSOR)
 
 #if (FEATURE_DEMO_TOF_OBSTACLE)
+    const uint16_t last_dangerous_zone = slam_data.tof_dangerous_zone;
     slam_data.tof_dangerous_zone = APP_SLAM_TOF_DANGER_ZONE_FLAG_NULL;
     // TOF threshold detection
     for (int i = 0; i < lidar_data->data_counter; i ++)
@@ -439,6 +662,10 @@ static void app_slam_private_localMapUpdate(void)
             }
         }
     }
+    if ((slam_data.tof_dangerous_zone != last_dangerous_zone) && (slam_data.danger_zone_notify_task != NULL))
+    {
+        xTaskNotify(slam_data.danger_zone_notify_task, slam_data.danger_zone_notify_bit, eSetBits);
+    }
 #endif //(FEATURE_DEMO_TOF_OBSTACLE)
 }
 
@@ -447,6 +674,26 @@ static INLINE void app_slam_private_resetGlobalMap(void)
     memset(&slam_data.gMap, 0, sizeof(dynamic_map_S));
     slam_data.gMap.map_center_pixel.x = GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL;
     slam_data.gMap.map_center_pixel.y = GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL;
+    memset(slam_data.gMap_dirty_tile, 0xFF, sizeof(slam_data.gMap_dirty_tile));
+#if (FEATURE_SLAM_SCAN_MATCH)
+    memset(slam_data.lMap.dirty_tile, 0xFF, sizeof(slam_data.lMap.dirty_tile));
+    memset(&slam_data.sweep, 0, sizeof(scan_sweep_S));
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+#if (FEATURE_SLAM_TABLE_MODEL)
+    memset(&slam_data.table, 0, sizeof(table_model_S));
+    slam_data.table.ransac_seed = TABLE_RANSAC_SEED;
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+}
+
+// x, y \in [0, GMAP_WN_PIXEL), only called when a cell value actually changes
+static INLINE void app_slam_private_markTileDirty(int32_t x_pixel, int32_t y_pixel)
+{
+    const uint32_t tile = ((uint32_t)(y_pixel) >> GMAP_TILE_EDGE_SHIFT) * GMAP_TILE_WN
+                        + ((uint32_t)(x_pixel) >> GMAP_TILE_EDGE_SHIFT);
+    slam_data.gMap_dirty_tile[tile >> 5U] |= (1UL << (tile & 31U));
+#if (FEATURE_SLAM_SCAN_MATCH)
+    slam_data.lMap.dirty_tile[tile >> 5U] |= (1UL << (tile & 31U));
+#endif // (FEATURE_SLAM_SCAN_MATCH)
 }
 
 /**
@@ -484,7 +731,11 @@ static void app_slam_private_translateGlobalMap(int32_t dx_pixel, int32_t dy_pix
             for (int32_t i = start; i < end; i ++)
             {
                 x_index = i + MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(i), 0, GMAP_WN_PIXEL)];
-                mdata[y_index + x_index] = GRID_CELL_NEUTRAL;
+                if (mdata[y_index + x_index] != GRID_CELL_NEUTRAL)
+                {
+                    mdata[y_index + x_index] = GRID_CELL_NEUTRAL;
+                    app_slam_private_markTileDirty(x_index, j);
+                }
             }
             y_index += GMAP_WN_PIXEL;
         }
@@ -504,11 +755,15 @@ static void app_slam_private_translateGlobalMap(int32_t dx_pixel, int32_t dy_pix
         }
         for (int32_t j = start; j < end; j ++)
         {
-            y_index = j + MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(j), 0, GMAP_HN_PIXEL)];
-            y_index *= GMAP_WN_PIXEL;
+            const int32_t y = j + MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(j), 0, GMAP_HN_PIXEL)];
+            y_index = y * GMAP_WN_PIXEL;
             for (int32_t i = 0; i < GMAP_WN_PIXEL; i ++)
             {
-                mdata[y_index + i] = GRID_CELL_NEUTRAL;
+                if (mdata[y_index + i] != GRID_CELL_NEUTRAL)
+                {
+                    mdata[y_index + i] = GRID_CELL_NEUTRAL;
+                    app_slam_private_markTileDirty(i, y);
+                }
             }
         }
     }
@@ -534,7 +789,7 @@ static void app_slam_private_clearVehicleRegion(void)
     const int32_t cy_offsetted = mc_pixel->y - (ROBOT_SIZE_R_PIXEL);
     // const int8_t PADDING[ROBOT_SIZE_D_PIXEL + 1U] = {4, 2, 1, 1, 0, 0, 0, 1, 1, 2, 4}; // space skip
     const int8_t PADDING[ROBOT_SIZE_D_PIXEL + 1U] = {5, 3, 2, 2, 1, 1, 1, 2, 2, 3, 5}; // space skip + 1 space padding
-    int32_t x,y,dx_pad;
+    int32_t x,y,y_index,dx_pad;
 
     map_pixel_data_t* mdata = (slam_data.gMap.data);
 
@@ -542,7 +797,7 @@ static void app_slam_private_clearVehicleRegion(void)
     {
         y = cy_offsetted + j;
         y += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(y), 0, GMAP_HN_PIXEL)];
-        y *= GMAP_WN_PIXEL;
+        y_index = y * GMAP_WN_PIXEL;
         dx_pad = PADDING[j];
 
         for (int32_t i = dx_pad; i <= (ROBOT_SIZE_D_PIXEL - dx_pad); i ++)
@@ -550,7 +805,11 @@ static void app_slam_private_clearVehicleRegion(void)
             x = cx_offsetted + i;
             x += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(x), 0, GMAP_WN_PIXEL)];
             // set cell visited
-            mdata[y + x] = GRID_CELL_VISITED;
+            if (mdata[y_index + x] != GRID_CELL_VISITED)
+            {
+                mdata[y_index + x] = GRID_CELL_VISITED;
+                app_slam_private_markTileDirty(x, y);
+            }
         }
     }
 }
@@ -594,6 +853,10 @@ static void app_slam_private_updateEdgeRegion(void)
         // update
         old_val = mdata[index];
         mdata[index] = GRID_CELL_UPDATE(old_val, new_val);
+        if (mdata[index] != old_val)
+        {
+            app_slam_private_markTileDirty(x, y);
+        }
     }
 
     new_val = (cn_node[COLLISION_R]) ? GRID_CELL_OCCUPANCY_MAX_PROB : GRID_CELL_VISITED_SENSOR;
@@ -609,6 +872,10 @@ static void app_slam_private_updateEdgeRegion(void)
         // update
         old_val = mdata[index];
         mdata[index] = GRID_CELL_UPDATE(old_val, new_val);
+        if (mdata[index] != old_val)
+        {
+            app_slam_private_markTileDirty(x, y);
+        }
     }
 
     // Update IR:
@@ -625,206 +892,1240 @@ static void app_slam_private_updateEdgeRegion(void)
         // update
         old_val = mdata[index];
         mdata[index] = GRID_CELL_UPDATE(old_val, new_val);
+        if (mdata[index] != old_val)
+        {
+            app_slam_private_markTileDirty(x, y);
+        }
+#if (FEATURE_SLAM_TABLE_MODEL)
+        if (ir_node[i])
+        {
+            app_slam_private_tableEdgeHit(config_node_x_pixel[node], config_node_y_pixel[node]);
+        }
+#endif // (FEATURE_SLAM_TABLE_MODEL)
     }
 }
 
-static void app_slam_private_globalMapUpdate(void)
+#if (FEATURE_SLAM_SCAN_MATCH || FEATURE_SLAM_TABLE_MODEL)
+// turn the vehicle by 'dtheta_rad' in place, what it senses turns with it
+static void app_slam_private_correctHeading(float dtheta_rad)
 {
-    //// Fetch Data ====== ====== ======
-    // TODO: Assume we get (dx, dy) from localization (@Alex)
-#if(FEATURE_SLAM_ENCODER)
-    float dx_mm = slam_data.encoder_delta_mm.x;
-    float dy_mm = slam_data.encoder_delta_mm.y;
-    float theta = slam_data.encoder_delta_theta_rad;
-#elif (MOCK)
-    float dx_mm = 0.0f; // 1mm / 0.1s => 10mm / s
-    float dy_mm = 1.0f;
-    float theta = 0.0f; // Assume: < pi
-#endif // (MOCK)
-    //// Update Dynamic Map ===== ======
-    // accumulate global coord:
-    slam_data.gMap.vehicle_state.x += dx_mm;
-    slam_data.gMap.vehicle_state.y += dy_mm;
-    // accumulate leftover float bits from previous update
-    dx_mm += slam_data.gMap.map_offset_mm.x;
-    dy_mm += slam_data.gMap.map_offset_mm.y;
-    theta += slam_data.gMap.vehicle_orientation_rad;
-    // translate translation to pixel space:
-    const int32_t dx_pixel = GMAP_MM_TO_UNIT_PIXEL(dx_mm);
-    const int32_t dy_pixel = GMAP_MM_TO_UNIT_PIXEL(dy_mm);
-    // translate dynamic map
-    app_slam_private_translateGlobalMap(dx_pixel, dy_pixel);
-    // compute leftover float bits (-10, 10) mm
-    dx_mm -= (GMAP_UNIT_PIXEL_TO_MM(dx_pixel));
-    dy_mm -= (GMAP_UNIT_PIXEL_TO_MM(dy_pixel));
-    // saturate theta to [-pi, pi]
+#if (FEATURE_SLAM_SCAN_MATCH)
+    const float cos_theta = slam_math_cosf(dtheta_rad);
+    const float sin_theta = slam_math_sinf(dtheta_rad);
+    scan_sweep_S * sweep = &(slam_data.sweep);
+    for (uint8_t i = 0U; i < sweep->count; i ++)
+    {
+        const math_cart_coord_float_S point = sweep->point_mm[i];
+        sweep->point_mm[i].x = point.x * cos_theta - point.y * sin_theta;
+        sweep->point_mm[i].y = point.x * sin_theta + point.y * cos_theta;
+    }
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+    float theta = slam_data.gMap.vehicle_orientation_rad + dtheta_rad;
     theta = ANGLE_WRAP_NPI_TO_PI(theta);
-    // map robot pose theta => one of the 28 edge nodes:
-    const vehicle_edge_node_E orientation_node = EDGE_NODE_MAPPING(theta);
-    // store leftover bit
-    slam_data.gMap.map_offset_mm.x = dx_mm;
-    slam_data.gMap.map_offset_mm.y = dy_mm;
     slam_data.gMap.vehicle_orientation_rad = theta;
-    slam_data.gMap.orientation_node = orientation_node;
-
-#if (DEBUG_FPRINT_APP_SLAM_PRINT)
-    PRINTF("[ APP:SLAM ] x,y,theta: (%.3f mm, %.3f mm, %.3f rad)\n", 
-        slam_data.gMap.vehicle_state.x, slam_data.gMap.vehicle_state.y, theta);
-#endif (DEBUG_FPRINT_APP_SLAM_PRINT)
-    
-    //// Update Map Content ===== ======
-    // Clear Vehicle Region
-    app_slam_private_clearVehicleRegion();
-    
-    // Map edge IR sensors + collision sensors to map
-    app_slam_private_updateEdgeRegion();
-
-    // Map tof obstacles to map
-#if (FEATURE_LIDAR)
-    // TODO: app_slam_private_updateGmapFromToF();
-#endif //(FEATURE_LIDAR)
+    slam_data.gMap.orientation_node = EDGE_NODE_MAPPING(theta);
 }
+#endif // (FEATURE_SLAM_SCAN_MATCH || FEATURE_SLAM_TABLE_MODEL)
 
-static void app_slam_private_obstacleDetection(void)
+#if (FEATURE_SLAM_SCAN_MATCH)
+// how well a cell explains a tof return: occupied cells only, edges are seen by the IR, not the tof
+static INLINE uint8_t app_slam_private_likelihood(map_pixel_data_t value)
 {
-    // Cache data pointers
-    map_pixel_data_t *              mdata = (slam_data.gMap.data);
-
-    // const data
-    const int32_t cx_pixel = slam_data.gMap.map_center_pixel.x;
-    const int32_t cy_pixel = slam_data.gMap.map_center_pixel.y;
+    return ((value > GRID_CELL_WALKABLE_THRESHOLD_MAX) && (value <= GRID_CELL_OCCUPANCY_MAX_PROB))
+        ? (uint8_t)(value - GRID_CELL_WALKABLE_THRESHOLD_MAX) : 0U;
+}
 
-    // intermediate storage
-    int32_t x, y, index;
-    
-    // collision detection
-    uint8_t obstacle_count = 0;
+/**
+ * @brief Bring the likelihood pyramid up to date with the global map
+ * 
+ * Only the tiles changed since the last call, a tile is one level 3 block
+ */
+static void app_slam_private_updateLikelihoodMap(void)
+{
+    likelihood_map_S *              lmap = &(slam_data.lMap);
+    const map_pixel_data_t *        mdata = (slam_data.gMap.data);
+    const uint32_t                  l2_n = LMAP_N(LMAP_L2_SHIFT);
+    const uint32_t                  l4_n = LMAP_N(LMAP_L4_SHIFT);
 
-    for (int32_t j = - VEHICLE_AVOIDANCE_R_PIXEL; j <= VEHICLE_AVOIDANCE_R_PIXEL; j ++)
+    for (uint32_t word = 0U; word < GMAP_TILE_WORD_COUNT; word ++)
     {
-        y = cy_pixel + j;
-        y += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(y), 0, GMAP_HN_PIXEL)];
-        index = y * GMAP_WN_PIXEL;
-
-        for (int32_t i = - VEHICLE_AVOIDANCE_R_PIXEL; i <= VEHICLE_AVOIDANCE_R_PIXEL; i ++)
+        uint32_t bits = lmap->dirty_tile[word];
+        lmap->dirty_tile[word] = 0U;
+        while (bits != 0U)
         {
-            x = cx_pixel + i;
-            x += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(x), 0, GMAP_WN_PIXEL)];
-            
-            // check
-            if (mdata[index + x] > GRID_CELL_WALKABLE_THRESHOLD_MAX)
+            const uint32_t tile = (word << 5U) + (uint32_t)__builtin_ctz(bits);
+            bits &= (bits - 1U);
+            if (tile >= GMAP_TILE_COUNT)
             {
-                obstacle_count ++;
+                break;
+            }
+            const uint32_t tile_x = tile % GMAP_TILE_WN;
+            const uint32_t tile_y = tile / GMAP_TILE_WN;
+
+            // level 2 blocks of the tile, from the map
+            uint8_t tile_max = 0U;
+            for (uint32_t by = (tile_y << 1U); (by < ((tile_y << 1U) + 2U)) && (by < l2_n); by ++)
+            {
+                for (uint32_t bx = (tile_x << 1U); (bx < ((tile_x << 1U) + 2U)) && (bx < l2_n); bx ++)
+                {
+                    uint8_t block_max = 0U;
+                    for (uint32_t y = (by << LMAP_L2_SHIFT); (y < ((by + 1U) << LMAP_L2_SHIFT)) && (y < GMAP_HN_PIXEL); y ++)
+                    {
+                        for (uint32_t x = (bx << LMAP_L2_SHIFT); (x < ((bx + 1U) << LMAP_L2_SHIFT)) && (x < GMAP_WN_PIXEL); x ++)
+                        {
+                            const uint8_t value = app_slam_private_likelihood(mdata[y * GMAP_WN_PIXEL + x]);
+                            block_max = (value > block_max) ? value : block_max;
+                        }
+                    }
+                    lmap->l2[by * l2_n + bx] = block_max;
+                    tile_max = (block_max > tile_max) ? block_max : tile_max;
+                }
+            }
+            lmap->l3[tile] = tile_max;
+
+            // level 4 block over the tile and its siblings, the last dirty sibling leaves it right
+            const uint32_t qx = (tile_x >> 1U);
+            const uint32_t qy = (tile_y >> 1U);
+            uint8_t quad_max = 0U;
+            for (uint32_t ty = (qy << 1U); (ty < ((qy << 1U) + 2U)) && (ty < GMAP_TILE_HN); ty ++)
+            {
+                for (uint32_t tx = (qx << 1U); (tx < ((qx << 1U) + 2U)) && (tx < GMAP_TILE_WN); tx ++)
+                {
+                    const uint8_t value = lmap->l3[ty * GMAP_TILE_WN + tx];
+                    quad_max = (value > quad_max) ? value : quad_max;
+                }
             }
+            lmap->l4[qy * l4_n + qx] = quad_max;
         }
     }
-
-    // Store solution:
-    slam_data.obstacle_count = obstacle_count;
 }
 
-static void app_slam_private_pathPlanning(void)
+/**
+ * @brief Motion compensated tof sweep
+ * 
+ * The older points move with the vehicle, a new return is placed along this cycle's motion by its arrival order
+ * (the firing frames are evenly spaced), in the edge node frame: theta 0 in front at -y, +theta towards +x
+ */
+static void app_slam_private_updateSweep(float dx_mm, float dy_mm, float theta_rad, float dtheta_rad)
 {
-    // TODO: if need to generate new path, do partial path planning
+    scan_sweep_S *                      sweep = &(slam_data.sweep);
+    const dev_tof_lidar_sensor_data_S * lidar_data = &(slam_data.lidar_data);
+
+    // older returns the vehicle drove away from leave the sweep, so every cell of a candidate stays one wrap off the map;
+    // the rest restart at slot 0 oldest first, the points in use are always [0, count)
+    math_cart_coord_float_S kept_mm[SCAN_MATCH_SWEEP_SIZE];
+    const uint8_t oldest = (uint8_t)((sweep->head + SCAN_MATCH_SWEEP_SIZE - sweep->count) % SCAN_MATCH_SWEEP_SIZE);
+    uint8_t kept = 0U;
+    for (uint8_t i = 0U; i < sweep->count; i ++)
+    {
+        math_cart_coord_float_S point = sweep->point_mm[(oldest + i) % SCAN_MATCH_SWEEP_SIZE];
+        point.x -= dx_mm;
+        point.y -= dy_mm;
+        if ((fabsf(point.x) <= SCAN_MATCH_SWEEP_KEEP_MM) && (fabsf(point.y) <= SCAN_MATCH_SWEEP_KEEP_MM))
+        {
+            kept_mm[kept ++] = point;
+        }
+    }
+    memcpy(sweep->point_mm, kept_mm, kept * sizeof(math_cart_coord_float_S));
+    sweep->count = kept;
+    sweep->head = (uint8_t)(kept % SCAN_MATCH_SWEEP_SIZE);
+
+    sweep->fresh = 0U;
+    const uint8_t data_count = lidar_data->data_counter;
+    for (uint8_t i = 0U; i < data_count; i ++)
+    {
+        const uint8_t label = lidar_data->keyframe_label[i];
+        const uint16_t dist_mm = lidar_data->dist_mm[i];
+        if ((label >= DEV_TOF_FIRING_GEOMETRICAL_COUNT) || (dist_mm < SCAN_MATCH_TOF_RANGE_MIN_MM) || (dist_mm > SCAN_MATCH_TOF_RANGE_MAX_MM))
+        {
+            continue; // no return
+        }
+        const float elapsed = (float)(i + 1U) / (float)data_count; // share of the motion done on arrival
+        const float remaining = 1.0F - elapsed;
+        const float mount_rad = theta_rad + elapsed * dtheta_rad + scan_match_group_mount_rad[label / DEV_TOF_FIRING_KEYFRAME_COUNT];
+        const float bearing_rad = mount_rad + scan_match_roi_bearing_rad[label % DEV_TOF_FIRING_KEYFRAME_COUNT];
+        math_cart_coord_float_S * point = &(sweep->point_mm[sweep->head]);
+        point->x =   SCAN_MATCH_TOF_ORIGIN_MM * slam_math_sinf(mount_rad) + (float)dist_mm * slam_math_sinf(bearing_rad) - remaining * dx_mm;
+        point->y = - SCAN_MATCH_TOF_ORIGIN_MM * slam_math_cosf(mount_rad) - (float)dist_mm * slam_math_cosf(bearing_rad) - remaining * dy_mm;
+
+        sweep->head = (uint8_t)((sweep->head + 1U) % SCAN_MATCH_SWEEP_SIZE);
+        sweep->count = (sweep->count < SCAN_MATCH_SWEEP_SIZE) ? (sweep->count + 1U) : SCAN_MATCH_SWEEP_SIZE;
+        sweep->fresh = (sweep->fresh < SCAN_MATCH_SWEEP_SIZE) ? (sweep->fresh + 1U) : SCAN_MATCH_SWEEP_SIZE;
+    }
 }
 
-static void app_slam_private_motionPlanning(void)
+// map cells of the sweep rotated by 'theta_step' about the vehicle
+static void app_slam_private_scanMatchCells(int8_t theta_step, scan_match_cells_S * cells)
 {
-    // TODO: improve motion planning from path planning
-    // TODO: motion feedback:
-#if (MOCK)
-    bool mock_robot_was_stationary_previously = FALSE;
-#endif // (MOCK)
-    // Currently: simple obstacle avoidance logic
-    const uint8_t obstacle_count = slam_data.obstacle_count;
-    int8_t * Vl_motor_mm_s_50ms = slam_data.motion_profile.left_motor_velocity_mm_s_per_50ms;
-    int8_t * Vr_motor_mm_s_50ms = slam_data.motion_profile.right_motor_velocity_mm_s_per_50ms;
+    const scan_sweep_S *            sweep = &(slam_data.sweep);
+    const float                     cos_theta = slam_math_cosf((float)theta_step * SCAN_MATCH_THETA_STEP_RAD);
+    const float                     sin_theta = slam_math_sinf((float)theta_step * SCAN_MATCH_THETA_STEP_RAD);
+    const math_cart_coord_float_S * offset_mm = &(slam_data.gMap.map_offset_mm);
+    const math_cart_coord_int32_S * mc_pixel = &(slam_data.gMap.map_center_pixel);
 
-    if (obstacle_count > OBSTACLE_TOLERANCE)
+    for (uint8_t i = 0U; i < sweep->count; i ++)
     {
-#if DEBUG_FPRINT_FEATURE_OBSTACLES
-        PRINTF("[ APP:SLAM ] Collision Detected (# %d)\n", obstacle_count);
-#endif
-        // update velocity to rotation
-        if (xSemaphoreTake(slam_data.motion_profile_mutex, MP_MUTEX_BLOCK_TIME_MS) == pdTRUE) {            
-            // rotate:
-            Vl_motor_mm_s_50ms[0U] = - VELOCITY_MIN_MM_S;
-            Vr_motor_mm_s_50ms[0U] =   VELOCITY_MIN_MM_S;
-            Vl_motor_mm_s_50ms[1U] = - VELOCITY_SOFT_MM_S;
-            Vr_motor_mm_s_50ms[1U] =   VELOCITY_SOFT_MM_S;
-            // in case class update incomplete => keep spinning
-            Vl_motor_mm_s_50ms[2U] = - VELOCITY_SOFT_MM_S;
-            Vr_motor_mm_s_50ms[2U] =   VELOCITY_SOFT_MM_S;
-            Vl_motor_mm_s_50ms[3U] = - VELOCITY_SOFT_MM_S;
-            Vr_motor_mm_s_50ms[3U] =   VELOCITY_SOFT_MM_S;
-            slam_data.motion_profile.update_stamp_100ms += 1;
-            xSemaphoreGive(slam_data.motion_profile_mutex); // release lock
-        }
+        const math_cart_coord_float_S * point = &(sweep->point_mm[i]);
+        cells->x_pixel[i] = mc_pixel->x + GMAP_MM_TO_NEAREST_PIXEL(offset_mm->x + point->x * cos_theta - point->y * sin_theta);
+        cells->y_pixel[i] = mc_pixel->y + GMAP_MM_TO_NEAREST_PIXEL(offset_mm->y + point->x * sin_theta + point->y * cos_theta);
     }
-    else
+}
+
+/**
+ * @brief Score bound of every translation in [dx, dx + 2^shift) x [dy, dy + 2^shift)
+ * 
+ * A point's cells span at most two blocks per axis, three across the seam of the map (the last block is partial)
+ */
+static uint32_t app_slam_private_scanMatchBound(const scan_match_cells_S * cells, uint32_t shift, int32_t dx_pixel, int32_t dy_pixel)
+{
+    const uint8_t *     level = (shift == LMAP_L4_SHIFT) ? slam_data.lMap.l4 : ((shift == LMAP_L3_SHIFT) ? slam_data.lMap.l3 : slam_data.lMap.l2);
+    const int32_t       n = (int32_t)LMAP_N(shift);
+    const int32_t       span = (1 << shift) - 1;
+    uint32_t            bound = 0U;
+    int32_t             bx[3], by[3];
+    uint8_t             nx, ny;
+    int32_t             first, last;
+
+    for (uint8_t i = 0U; i < slam_data.sweep.count; i ++)
     {
-        // update velocity to rotation
-        if (xSemaphoreTake(slam_data.motion_profile_mutex, MP_MUTEX_BLOCK_TIME_MS) == pdTRUE) {
-            if (mock_robot_was_stationary_previously)
+        first = cells->x_pixel[i] + dx_pixel;
+        last = first + span;
+        first += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(first), 0, GMAP_WN_PIXEL)];
+        last += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(last), 0, GMAP_WN_PIXEL)];
+        nx = 0U;
+        for (int32_t b = (first >> shift); ; b = ((b + 1) < n) ? (b + 1) : 0)
+        {
+            bx[nx ++] = b;
+            if (b == (last >> shift))
             {
-                // Soft-start
-                Vl_motor_mm_s_50ms[0U] = VELOCITY_MIN_MM_S;
-                Vr_motor_mm_s_50ms[0U] = VELOCITY_MIN_MM_S;
-                Vl_motor_mm_s_50ms[1U] = VELOCITY_SOFT_MM_S;
-                Vr_motor_mm_s_50ms[1U] = VELOCITY_SOFT_MM_S;
+                break;
             }
-            else
+        }
+
+        first = cells->y_pixel[i] + dy_pixel;
+        last = first + span;
+        first += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(first), 0, GMAP_HN_PIXEL)];
+        last += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(last), 0, GMAP_HN_PIXEL)];
+        ny = 0U;
+        for (int32_t b = (first >> shift); ; b = ((b + 1) < n) ? (b + 1) : 0)
+        {
+            by[ny ++] = b;
+            if (b == (last >> shift))
             {
-                // Forward
-                Vl_motor_mm_s_50ms[0U] = VELOCITY_MAX_MM_S;
-                Vr_motor_mm_s_50ms[0U] = VELOCITY_MAX_MM_S;
-                Vl_motor_mm_s_50ms[1U] = VELOCITY_MAX_MM_S;
-                Vr_motor_mm_s_50ms[1U] = VELOCITY_MAX_MM_S;
+                break;
+            }
+        }
 
+        uint8_t point_max = 0U;
+        for (uint8_t j = 0U; j < ny; j ++)
+        {
+            for (uint8_t k = 0U; k < nx; k ++)
+            {
+                const uint8_t value = level[by[j] * n + bx[k]];
+                point_max = (value > point_max) ? value : point_max;
             }
-            // in case class update incomplete, stop motor:
-            Vl_motor_mm_s_50ms[2U] = VELOCITY_ZERO_MM_S;
-            Vr_motor_mm_s_50ms[2U] = VELOCITY_ZERO_MM_S;
-            Vl_motor_mm_s_50ms[3U] = VELOCITY_ZERO_MM_S;
-            Vr_motor_mm_s_50ms[3U] = VELOCITY_ZERO_MM_S;
-            slam_data.motion_profile.update_stamp_100ms += 1;
-            xSemaphoreGive(slam_data.motion_profile_mutex); // release lock
         }
+        bound += point_max;
     }
+    return bound;
 }
 
-#if (DEBUG_FPRINT_FEATURE_MAP)
-static dynamic_map_S temp_gMap;
-#define PUBLISH_PERIOD (10)
-#define PUBLISH_LENGTH_PER_CYCLE (GMAP_WN_PIXEL/5)
-static void app_slam_private_debugPrintMap(bool central)
+// exact score of one translation, level 0
+static uint32_t app_slam_private_scanMatchScore(const scan_match_cells_S * cells, int32_t dx_pixel, int32_t dy_pixel)
 {
-    static int count = 0;
-    static int frame_count = -1;
-    if (count == PUBLISH_PERIOD)
+    const map_pixel_data_t *    mdata = (slam_data.gMap.data);
+    uint32_t                    score = 0U;
+    int32_t                     x, y;
+
+    for (uint8_t i = 0U; i < slam_data.sweep.count; i ++)
     {
-        count = 0;
+        x = cells->x_pixel[i] + dx_pixel;
+        y = cells->y_pixel[i] + dy_pixel;
+        x += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(x), 0, GMAP_WN_PIXEL)];
+        y += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(y), 0, GMAP_HN_PIXEL)];
+        score += app_slam_private_likelihood(mdata[y * GMAP_WN_PIXEL + x]);
     }
+    return score;
+}
 
-    if (count == 0)
+/**
+ * @brief Depth first branch and bound below one search node
+ * 
+ * Children are visited best bound first and dropped once their bound cannot beat 'best',
+ * level 2 nodes expand straight into their 16 translations
+ */
+static void app_slam_private_scanMatchBranch(const scan_match_cells_S * cells, uint32_t shift, int32_t dx_pixel, int32_t dy_pixel,
+    int8_t theta_step, scan_match_result_S * best)
+{
+    if (shift == LMAP_L2_SHIFT)
     {
-        // copy latest map
-        memcpy(&temp_gMap, &slam_data.gMap, sizeof(dynamic_map_S));
-        frame_count ++;
-        if (central)
+        for (int32_t j = dy_pixel; j < (dy_pixel + (1 << LMAP_L2_SHIFT)); j ++)
         {
-            PRINTF("MAP-Centered:,%d, \n", frame_count);
+            for (int32_t i = dx_pixel; i < (dx_pixel + (1 << LMAP_L2_SHIFT)); i ++)
+            {
+                if ((i < - SCAN_MATCH_WINDOW_PIXEL) || (i > SCAN_MATCH_WINDOW_PIXEL) || (j < - SCAN_MATCH_WINDOW_PIXEL) || (j > SCAN_MATCH_WINDOW_PIXEL))
+                {
+                    continue;
+                }
+                const uint32_t score = app_slam_private_scanMatchScore(cells, i, j);
+                if (score > best->score)
+                {
+                    best->dx_pixel = i;
+                    best->dy_pixel = j;
+                    best->theta_step = theta_step;
+                    best->score = score;
+                }
+            }
         }
-        else
+        return;
+    }
+
+    const uint32_t child_shift = shift - 1U;
+    const int32_t child_size = (1 << child_shift);
+    int32_t child_x[4], child_y[4];
+    uint32_t child_bound[4];
+    for (uint8_t c = 0U; c < 4U; c ++)
+    {
+        // insertion by bound, best first
+        const int32_t x = dx_pixel + ((c & 1U) ? child_size : 0);
+        const int32_t y = dy_pixel + ((c & 2U) ? child_size : 0);
+        const uint32_t bound = app_slam_private_scanMatchBound(cells, child_shift, x, y);
+        uint8_t k = c;
+        while ((k > 0U) && (child_bound[k - 1U] < bound))
         {
-            PRINTF("MAP-Memory:,%d, \n", frame_count);
+            child_x[k] = child_x[k - 1U];
+            child_y[k] = child_y[k - 1U];
+            child_bound[k] = child_bound[k - 1U];
+            k --;
         }
+        child_x[k] = x;
+        child_y[k] = y;
+        child_bound[k] = bound;
     }
-    else
+    for (uint8_t c = 0U; (c < 4U) && (child_bound[c] > best->score); c ++)
     {
-        // [0, W | H )
-        const int32_t cx= temp_gMap.map_center_pixel.x - GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL;
-        const int32_t cy= temp_gMap.map_center_pixel.y - GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL;
+        app_slam_private_scanMatchBranch(cells, child_shift, child_x[c], child_y[c], theta_step, best);
+    }
+}
+
+/**
+ * @brief Put the cells the sweep marked back to their values before, 'saved' keeps what the map holds
+ * 
+ * Newest first, so a cell marked twice ends on its oldest prior; a cell cleared since keeps the lower value.
+ * The pyramid is left as is, it stays an upper bound of the scores.
+ */
+static void app_slam_private_scanMatchHideMarks(map_pixel_data_t * saved)
+{
+    scan_sweep_S *      sweep = &(slam_data.sweep);
+    map_pixel_data_t *  mdata = (slam_data.gMap.data);
+
+    for (uint8_t n = 1U; n <= sweep->mark_count; n ++)
+    {
+        const uint8_t k = (uint8_t)((sweep->mark_head + SCAN_MATCH_SWEEP_SIZE - n) % SCAN_MATCH_SWEEP_SIZE);
+        const uint16_t index = sweep->mark_index[k];
+        saved[k] = mdata[index];
+        mdata[index] = (sweep->mark_prior[k] < mdata[index]) ? sweep->mark_prior[k] : mdata[index];
+    }
+}
+
+// undo app_slam_private_scanMatchHideMarks(), oldest first
+static void app_slam_private_scanMatchShowMarks(const map_pixel_data_t * saved)
+{
+    const scan_sweep_S *    sweep = &(slam_data.sweep);
+    map_pixel_data_t *      mdata = (slam_data.gMap.data);
+
+    for (uint8_t n = sweep->mark_count; n >= 1U; n --)
+    {
+        const uint8_t k = (uint8_t)((sweep->mark_head + SCAN_MATCH_SWEEP_SIZE - n) % SCAN_MATCH_SWEEP_SIZE);
+        mdata[sweep->mark_index[k]] = saved[k];
+    }
+}
+
+/**
+ * @brief Best pose correction of the sweep within the search window
+ * 
+ * One search root (16 x 16 translations) per rotation, the odometry pose is the score to beat by SCAN_MATCH_MIN_GAIN;
+ * scored against the map as it was before the sweep marked it
+ * @return TRUE when a correction was found
+ */
+static bool app_slam_private_scanMatchSearch(scan_match_result_S * result)
+{
+    scan_match_cells_S  cells[2 * SCAN_MATCH_THETA_STEPS + 1];
+    int8_t              order[2 * SCAN_MATCH_THETA_STEPS + 1];
+    const int32_t       root_pixel = - (1 << (LMAP_L4_SHIFT - 1U));
+
+    if (slam_data.sweep.count < SCAN_MATCH_MIN_POINTS)
+    {
+        return FALSE;
+    }
+
+    for (int8_t step = - SCAN_MATCH_THETA_STEPS; step <= SCAN_MATCH_THETA_STEPS; step ++)
+    {
+        scan_match_cells_S * root = &cells[step + SCAN_MATCH_THETA_STEPS];
+        app_slam_private_scanMatchCells(step, root);
+        root->bound = app_slam_private_scanMatchBound(root, LMAP_L4_SHIFT, root_pixel, root_pixel);
+        // insertion by bound, best first
+        int8_t k = step + SCAN_MATCH_THETA_STEPS;
+        while ((k > 0) && (cells[order[k - 1]].bound < root->bound))
+        {
+            order[k] = order[k - 1];
+            k --;
+        }
+        order[k] = step + SCAN_MATCH_THETA_STEPS;
+    }
+
+    map_pixel_data_t saved[SCAN_MATCH_SWEEP_SIZE];
+    app_slam_private_scanMatchHideMarks(saved);
+    const uint32_t odometry_score = app_slam_private_scanMatchScore(&cells[SCAN_MATCH_THETA_STEPS], 0, 0);
+    result->dx_pixel = 0;
+    result->dy_pixel = 0;
+    result->theta_step = 0;
+    result->score = odometry_score + SCAN_MATCH_MIN_GAIN - 1U;
+    for (uint8_t r = 0U; (r < (2U * SCAN_MATCH_THETA_STEPS + 1U)) && (cells[order[r]].bound > result->score); r ++)
+    {
+        app_slam_private_scanMatchBranch(&cells[order[r]], LMAP_L4_SHIFT, root_pixel, root_pixel,
+            (int8_t)(order[r] - SCAN_MATCH_THETA_STEPS), result);
+    }
+    app_slam_private_scanMatchShowMarks(saved);
+    return (result->score >= (odometry_score + SCAN_MATCH_MIN_GAIN));
+}
+
+/**
+ * @brief Correct the odometry pose against the global map
+ * 
+ * Assume: sweep updated, map translated by the odometry
+ */
+static void app_slam_private_scanMatch(void)
+{
+    scan_match_result_S result;
+    app_slam_private_updateLikelihoodMap();
+    if (!app_slam_private_scanMatchSearch(&result))
+    {
+        return;
+    }
+
+    app_slam_private_correctHeading((float)result.theta_step * SCAN_MATCH_THETA_STEP_RAD);
+    // and the map moves under the vehicle
+    app_slam_private_translateGlobalMap(result.dx_pixel, result.dy_pixel);
+    slam_data.gMap.vehicle_state.x += GMAP_UNIT_PIXEL_TO_MM(result.dx_pixel);
+    slam_data.gMap.vehicle_state.y += GMAP_UNIT_PIXEL_TO_MM(result.dy_pixel);
+}
+
+// the new returns of the sweep into the map, edges stay as the IR left them; the cells changed are kept for the next search
+static void app_slam_private_updateGmapFromToF(void)
+{
+    scan_sweep_S *                  sweep = &(slam_data.sweep);
+    const math_cart_coord_float_S * offset_mm = &(slam_data.gMap.map_offset_mm);
+    map_pixel_data_t *              mdata = (slam_data.gMap.data);
+    map_pixel_data_t                old_val;
+    int32_t                         x, y, index;
+
+    for (uint8_t n = 1U; n <= sweep->fresh; n ++)
+    {
+        const math_cart_coord_float_S * point = &(sweep->point_mm[(sweep->head + SCAN_MATCH_SWEEP_SIZE - n) % SCAN_MATCH_SWEEP_SIZE]);
+        x = slam_data.gMap.map_center_pixel.x + GMAP_MM_TO_NEAREST_PIXEL(offset_mm->x + point->x);
+        y = slam_data.gMap.map_center_pixel.y + GMAP_MM_TO_NEAREST_PIXEL(offset_mm->y + point->y);
+        x += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(x), 0, GMAP_WN_PIXEL)];
+        y += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(y), 0, GMAP_HN_PIXEL)];
+        index = y * GMAP_WN_PIXEL + x;
+        old_val = mdata[index];
+        if (old_val > GRID_CELL_OCCUPANCY_MAX_PROB)
+        {
+            continue;
+        }
+        mdata[index] = GRID_CELL_UPDATE(old_val, GRID_CELL_OCCUPANCY_MAX_PROB);
+        if (mdata[index] != old_val)
+        {
+            app_slam_private_markTileDirty(x, y);
+            sweep->mark_index[sweep->mark_head] = (uint16_t)index;
+            sweep->mark_prior[sweep->mark_head] = old_val;
+            sweep->mark_head = (uint8_t)((sweep->mark_head + 1U) % SCAN_MATCH_SWEEP_SIZE);
+            sweep->mark_count = (sweep->mark_count < SCAN_MATCH_SWEEP_SIZE) ? (sweep->mark_count + 1U) : SCAN_MATCH_SWEEP_SIZE;
+        }
+    }
+}
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+
+#if (FEATURE_SLAM_TABLE_MODEL)
+static void app_slam_private_momentsAdd(table_moments_S * moments, const math_cart_coord_float_S * point_mm)
+{
+    if (moments->count == 0U)
+    {
+        moments->origin_mm = *point_mm;
+    }
+    const float x = point_mm->x - moments->origin_mm.x;
+    const float y = point_mm->y - moments->origin_mm.y;
+    moments->sx  += x;
+    moments->sy  += y;
+    moments->sxx += x * x;
+    moments->sxy += x * y;
+    moments->syy += y * y;
+    moments->count ++;
+}
+
+// least squares line: direction of the principal axis, through the mean
+static float app_slam_private_momentsFit(const table_moments_S * moments, math_cart_coord_float_S * mean_mm)
+{
+    const float inv_count = 1.0F / (float)moments->count;
+    const float mx = moments->sx * inv_count;
+    const float my = moments->sy * inv_count;
+    const float cxx = moments->sxx * inv_count - mx * mx;
+    const float cxy = moments->sxy * inv_count - mx * my;
+    const float cyy = moments->syy * inv_count - my * my;
+    mean_mm->x = moments->origin_mm.x + mx;
+    mean_mm->y = moments->origin_mm.y + my;
+    return 0.5F * slam_math_atan2f(2.0F * cxy, cxx - cyy);
+}
+
+// edge line from its moments, the normal facing 'inside_mm'
+static void app_slam_private_tableEdgeFit(table_edge_S * edge, const math_cart_coord_float_S * inside_mm)
+{
+    math_cart_coord_float_S mean_mm;
+    const float direction_rad = app_slam_private_momentsFit(&(edge->moments), &mean_mm);
+    edge->normal.x = - slam_math_sinf(direction_rad);
+    edge->normal.y =   slam_math_cosf(direction_rad);
+    edge->distance_mm = edge->normal.x * mean_mm.x + edge->normal.y * mean_mm.y;
+    if ((edge->normal.x * inside_mm->x + edge->normal.y * inside_mm->y) < edge->distance_mm)
+    {
+        edge->normal.x = - edge->normal.x;
+        edge->normal.y = - edge->normal.y;
+        edge->distance_mm = - edge->distance_mm;
+    }
+}
+
+/**
+ * @brief One IR edge hit, in the frame of 'vehicle_state'
+ * 
+ * A hit on a new edge refines it, the others wait in the buffer for the next edge search;
+ * every hit also goes to the heading track, which keeps those near any edge
+ */
+static void app_slam_private_tableEdgeHit(int32_t node_x_pixel, int32_t node_y_pixel)
+{
+    table_model_S * table = &(slam_data.table);
+    const math_cart_coord_float_S point_mm = {
+        .x = slam_data.gMap.vehicle_state.x + GMAP_UNIT_PIXEL_TO_MM(node_x_pixel),
+        .y = slam_data.gMap.vehicle_state.y + GMAP_UNIT_PIXEL_TO_MM(node_y_pixel),
+    };
+
+    // the vehicle parked on an edge trips the same spot every cycle
+    for (uint8_t i = 0U; i < table->hit_count; i ++)
+    {
+        if ((fabsf(table->hit[i].point_mm.x - point_mm.x) < TABLE_HIT_SPACING_MM)
+            && (fabsf(table->hit[i].point_mm.y - point_mm.y) < TABLE_HIT_SPACING_MM))
+        {
+            return;
+        }
+    }
+
+    uint8_t nearest = TABLE_EDGE_MAX;
+    float nearest_mm = TABLE_EDGE_ASSOCIATE_MM;
+    for (uint8_t e = 0U; e < table->edge_count; e ++)
+    {
+        const table_edge_S * edge = &(table->edge[e]);
+        const float residual_mm = fabsf(edge->normal.x * point_mm.x + edge->normal.y * point_mm.y - edge->distance_mm);
+        if (residual_mm <= nearest_mm)
+        {
+            nearest = e;
+            nearest_mm = residual_mm;
+        }
+    }
+
+    uint8_t label = TABLE_EDGE_MAX;
+    if (nearest < TABLE_EDGE_MAX)
+    {
+        table_edge_S * edge = &(table->edge[nearest]);
+        if (edge->moments.count >= TABLE_EDGE_REFINE_COUNT)
+        {
+            label = nearest;
+        }
+        else if (nearest_mm <= TABLE_EDGE_INLIER_MM)
+        {
+            app_slam_private_momentsAdd(&(edge->moments), &point_mm);
+            app_slam_private_tableEdgeFit(edge, &(slam_data.gMap.vehicle_state));
+            label = nearest;
+        }
+    }
+
+    if (table->edge_count > 0U)
+    {
+        app_slam_private_tableTrack(&point_mm);
+    }
+
+    table->hit[table->hit_head].point_mm = point_mm;
+    table->hit[table->hit_head].edge = label;
+    table->hit_head = (uint8_t)((table->hit_head + 1U) % TABLE_HIT_BUFFER_SIZE);
+    table->hit_count = (table->hit_count < TABLE_HIT_BUFFER_SIZE) ? (table->hit_count + 1U) : TABLE_HIT_BUFFER_SIZE;
+}
+
+/**
+ * @brief Heading relocalization along a known edge
+ * 
+ * Heading drift turns the dead reckoned track, so the hits of a new pass along a known edge
+ * run at an angle to it, the vehicle is turned back by part of that angle on the next cycle; a pass is the newest
+ * hits near one edge within TABLE_TRACK_TRAVEL_MM of driving that stay on one line, the drift
+ * may have moved them off the edge by more than refining it would take, but not turned them much
+ */
+static void app_slam_private_tableTrack(const math_cart_coord_float_S * point_mm)
+{
+    table_model_S * table = &(slam_data.table);
+    if (table->turn_pending)
+    {
+        return; // the next pass starts in the frame after the turn
+    }
+
+    uint8_t nearest = TABLE_EDGE_MAX;
+    float nearest_mm = TABLE_TRACK_ASSOCIATE_MM;
+    for (uint8_t e = 0U; e < table->edge_count; e ++)
+    {
+        const table_edge_S * edge = &(table->edge[e]);
+        const float residual_mm = fabsf(edge->normal.x * point_mm->x + edge->normal.y * point_mm->y - edge->distance_mm);
+        if (residual_mm <= nearest_mm)
+        {
+            nearest = e;
+            nearest_mm = residual_mm;
+        }
+    }
+    if (nearest == TABLE_EDGE_MAX)
+    {
+        return;
+    }
+    table->track[table->track_head].point_mm = *point_mm;
+    table->track[table->track_head].travel_mm = table->travel_mm;
+    table->track[table->track_head].edge = nearest;
+    table->track_head = (uint8_t)((table->track_head + 1U) % TABLE_TRACK_SIZE);
+    table->track_count = (table->track_count < TABLE_TRACK_SIZE) ? (table->track_count + 1U) : TABLE_TRACK_SIZE;
+
+    // newest first, as long as the hits on this edge stay on one line
+    uint8_t run[TABLE_TRACK_SIZE];
+    uint8_t run_count = 0U;
+    float direction_rad = 0.0F;
+    float span_mm = 0.0F;
+    table_moments_S moments = {0};
+    for (uint8_t n = 0U; n < table->track_count; n ++)
+    {
+        const uint8_t index = (uint8_t)((table->track_head + TABLE_TRACK_SIZE - 1U - n) % TABLE_TRACK_SIZE);
+        const table_track_S * track = &(table->track[index]);
+        if ((table->travel_mm - track->travel_mm) > TABLE_TRACK_TRAVEL_MM)
+        {
+            break;
+        }
+        if (track->edge != nearest)
+        {
+            continue;
+        }
+        table_moments_S grown = moments;
+        app_slam_private_momentsAdd(&grown, &(track->point_mm));
+        math_cart_coord_float_S mean_mm;
+        const float fit_rad = app_slam_private_momentsFit(&grown, &mean_mm);
+        const float cos_fit = slam_math_cosf(fit_rad);
+        const float sin_fit = slam_math_sinf(fit_rad);
+        float along_min_mm = 0.0F, along_max_mm = 0.0F;
+        bool on_line = true;
+        run[run_count] = index;
+        for (uint8_t k = 0U; k <= run_count; k ++)
+        {
+            const table_track_S * other = &(table->track[run[k]]);
+            const float dx = other->point_mm.x - mean_mm.x;
+            const float dy = other->point_mm.y - mean_mm.y;
+            const float along_mm = dx * cos_fit + dy * sin_fit;
+            on_line = on_line && (fabsf(dy * cos_fit - dx * sin_fit) <= TABLE_EDGE_INLIER_MM);
+            along_min_mm = ((k == 0U) || (along_mm < along_min_mm)) ? along_mm : along_min_mm;
+            along_max_mm = ((k == 0U) || (along_mm > along_max_mm)) ? along_mm : along_max_mm;
+        }
+        if (!on_line)
+        {
+            break;
+        }
+        moments = grown;
+        direction_rad = fit_rad;
+        span_mm = along_max_mm - along_min_mm;
+        run_count ++;
+    }
+    if ((run_count < TABLE_TRACK_MIN_HITS) || (span_mm < TABLE_TRACK_MIN_SPAN_MM))
+    {
+        return;
+    }
+
+    table_edge_S * edge = &(table->edge[nearest]);
+    float drift_rad = direction_rad - slam_math_atan2f(edge->normal.x, - edge->normal.y);
+    while (drift_rad > SLAM_MATH_PI_2)
+    {
+        drift_rad -= SLAM_MATH_PI;
+    }
+    while (drift_rad <= - SLAM_MATH_PI_2)
+    {
+        drift_rad += SLAM_MATH_PI;
+    }
+    // the pass is in the frame before the turn, a new one starts from here
+    table->track_count = 0U;
+    if ((fabsf(drift_rad) > TABLE_HEADING_MAX_RAD) || (edge->moments.count < TABLE_EDGE_REFINE_COUNT))
+    {
+        return; // a new edge still moves with its own hits, no reference yet
+    }
+    edge->confirmed = true;
+    if (fabsf(drift_rad) >= TABLE_HEADING_MIN_RAD)
+    {
+        table->turn_rad = - TABLE_HEADING_GAIN * drift_rad;
+        table->turn_pending = true;
+    }
+}
+
+// the turn the last pass asked for, before this cycle draws anything with the heading
+static void app_slam_private_tableTurn(void)
+{
+    table_model_S * table = &(slam_data.table);
+    if (table->turn_pending)
+    {
+        app_slam_private_correctHeading(table->turn_rad);
+        table->turn_pending = false;
+    }
+}
+
+/**
+ * @brief RANSAC for one more table edge among the hits on none yet
+ * 
+ * The best line through two random hits, refitted by least squares over its inliers;
+ * kept when long enough, at right angles to the edges already known, and not one of them
+ */
+static void app_slam_private_tableFindEdge(void)
+{
+    table_model_S *             table = &(slam_data.table);
+    const table_hit_S *         hit = table->hit;
+    uint8_t                     free_index[TABLE_HIT_BUFFER_SIZE];
+    uint8_t                     free_count = 0U;
+
+    for (uint8_t i = 0U; i < table->hit_count; i ++)
+    {
+        if (hit[i].edge == TABLE_EDGE_MAX)
+        {
+            free_index[free_count ++] = i;
+        }
+    }
+    if ((table->edge_count >= TABLE_EDGE_MAX) || (free_count < TABLE_EDGE_MIN_INLIERS))
+    {
+        return;
+    }
+
+    math_cart_coord_float_S best_normal = {0.0F, 0.0F};
+    float best_distance_mm = 0.0F;
+    uint8_t best_inliers = 0U;
+    for (uint8_t n = 0U; n < TABLE_RANSAC_ITERATIONS; n ++)
+    {
+        uint32_t seed = table->ransac_seed; // xorshift32
+        seed ^= seed << 13U;
+        seed ^= seed >> 17U;
+        seed ^= seed << 5U;
+        table->ransac_seed = seed;
+        const math_cart_coord_float_S * a = &(hit[free_index[seed % free_count]].point_mm);
+        const math_cart_coord_float_S * b = &(hit[free_index[(seed >> 16U) % free_count]].point_mm);
+        const float dx = b->x - a->x;
+        const float dy = b->y - a->y;
+        const float length2 = dx * dx + dy * dy;
+        if (length2 < (4.0F * TABLE_EDGE_INLIER_MM * TABLE_EDGE_INLIER_MM))
+        {
+            continue;
+        }
+        const float inv_length = 1.0F / sqrtf(length2);
+        const math_cart_coord_float_S normal = {- dy * inv_length, dx * inv_length};
+        const float distance_mm = normal.x * a->x + normal.y * a->y;
+        uint8_t inliers = 0U;
+        for (uint8_t i = 0U; i < free_count; i ++)
+        {
+            const math_cart_coord_float_S * p = &(hit[free_index[i]].point_mm);
+            inliers += (fabsf(normal.x * p->x + normal.y * p->y - distance_mm) <= TABLE_EDGE_INLIER_MM);
+        }
+        if (inliers > best_inliers)
+        {
+            best_normal = normal;
+            best_distance_mm = distance_mm;
+            best_inliers = inliers;
+        }
+    }
+    if (best_inliers < TABLE_EDGE_MIN_INLIERS)
+    {
+        return;
+    }
+
+    table_edge_S candidate = {0};
+    for (uint8_t i = 0U; i < free_count; i ++)
+    {
+        const math_cart_coord_float_S * p = &(hit[free_index[i]].point_mm);
+        if (fabsf(best_normal.x * p->x + best_normal.y * p->y - best_distance_mm) <= TABLE_EDGE_INLIER_MM)
+        {
+            app_slam_private_momentsAdd(&(candidate.moments), p);
+        }
+    }
+    app_slam_private_tableEdgeFit(&candidate, &(slam_data.gMap.vehicle_state));
+
+    // the refitted inliers, their extent along the edge
+    float along_min_mm = 0.0F, along_max_mm = 0.0F;
+    uint8_t inliers = 0U;
+    for (uint8_t i = 0U; i < free_count; i ++)
+    {
+        const math_cart_coord_float_S * p = &(hit[free_index[i]].point_mm);
+        if (fabsf(candidate.normal.x * p->x + candidate.normal.y * p->y - candidate.distance_mm) <= TABLE_EDGE_INLIER_MM)
+        {
+            const float along_mm = candidate.normal.x * p->y - candidate.normal.y * p->x;
+            along_min_mm = ((inliers == 0U) || (along_mm < along_min_mm)) ? along_mm : along_min_mm;
+            along_max_mm = ((inliers == 0U) || (along_mm > along_max_mm)) ? along_mm : along_max_mm;
+            inliers ++;
+        }
+    }
+    if ((inliers < TABLE_EDGE_MIN_INLIERS) || ((along_max_mm - along_min_mm) < TABLE_EDGE_MIN_SPAN_MM))
+    {
+        return;
+    }
+
+    const float direction_rad = slam_math_atan2f(candidate.normal.x, - candidate.normal.y);
+    uint8_t label = table->edge_count;
+    if (table->edge_count > 0U)
+    {
+        float skew_rad = direction_rad - table->axis_rad;
+        while (skew_rad > (0.5F * SLAM_MATH_PI_2))
+        {
+            skew_rad -= SLAM_MATH_PI_2;
+        }
+        while (skew_rad <= (-0.5F * SLAM_MATH_PI_2))
+        {
+            skew_rad += SLAM_MATH_PI_2;
+        }
+        if (fabsf(skew_rad) > TABLE_EDGE_AXIS_TOLERANCE_RAD)
+        {
+            return;
+        }
+        for (uint8_t e = 0U; e < table->edge_count; e ++)
+        {
+            const table_edge_S * edge = &(table->edge[e]);
+            if (((edge->normal.x * candidate.normal.x + edge->normal.y * candidate.normal.y) > 0.0F)
+                && (fabsf(edge->distance_mm - candidate.distance_mm) < TABLE_EDGE_MERGE_MM))
+            {
+                label = e; // seen before, its hits just drifted off it
+            }
+        }
+    }
+    else
+    {
+        table->axis_rad = direction_rad;
+    }
+
+    if (label < table->edge_count)
+    {
+        // the drifted hits refine it like single ones would, until it settles
+        table_edge_S * edge = &(table->edge[label]);
+        for (uint8_t i = 0U; (i < free_count) && (edge->moments.count < TABLE_EDGE_REFINE_COUNT); i ++)
+        {
+            const math_cart_coord_float_S * p = &(hit[free_index[i]].point_mm);
+            if (fabsf(candidate.normal.x * p->x + candidate.normal.y * p->y - candidate.distance_mm) <= TABLE_EDGE_INLIER_MM)
+            {
+                app_slam_private_momentsAdd(&(edge->moments), p);
+            }
+        }
+        app_slam_private_tableEdgeFit(edge, &(slam_data.gMap.vehicle_state));
+    }
+    else
+    {
+        table->edge[label] = candidate;
+        table->edge_count ++;
+#if (DEBUG_FPRINT_APP_SLAM_PRINT)
+        PRINTF("[ APP:SLAM ] table edge %d: normal (%.3f, %.3f) distance %.1f mm, %d hits\n", label,
+            (double)candidate.normal.x, (double)candidate.normal.y, (double)candidate.distance_mm, inliers);
+#endif // (DEBUG_FPRINT_APP_SLAM_PRINT)
+    }
+    for (uint8_t i = 0U; i < free_count; i ++)
+    {
+        table_hit_S * h = &(table->hit[free_index[i]]);
+        if (fabsf(candidate.normal.x * h->point_mm.x + candidate.normal.y * h->point_mm.y - candidate.distance_mm) <= TABLE_EDGE_INLIER_MM)
+        {
+            h->edge = label;
+        }
+    }
+}
+
+// a settled edge at right angles to another settled one is where the rectangle says, not a stray line
+static void app_slam_private_tableConfirm(void)
+{
+    table_model_S * table = &(slam_data.table);
+
+    for (uint8_t a = 0U; a < table->edge_count; a ++)
+    {
+        table_edge_S * edge = &(table->edge[a]);
+        for (uint8_t b = 0U; (b < table->edge_count) && !edge->confirmed && (edge->moments.count >= TABLE_EDGE_REFINE_COUNT); b ++)
+        {
+            const table_edge_S * other = &(table->edge[b]);
+            // the normals' dot is the cosine between them, the sine of how far off a right angle they are
+            edge->confirmed = (other->moments.count >= TABLE_EDGE_REFINE_COUNT)
+                && (fabsf(edge->normal.x * other->normal.x + edge->normal.y * other->normal.y) <= slam_math_sinf(TABLE_EDGE_AXIS_TOLERANCE_RAD));
+        }
+    }
+}
+
+/**
+ * @brief Clip one row of map tiles to the confirmed table edges
+ * 
+ * Unexplored and tof occupied cells past an edge become clip cells, so nothing plans or drives there;
+ * visited cells are left alone, the vehicle has been on them. A clip cell back on the table after
+ * an edge moved is unexplored again, so the clipping follows the edges a pass over the map later
+ */
+static void app_slam_private_tableClip(void)
+{
+    table_model_S *                 table = &(slam_data.table);
+    const math_cart_coord_int32_S * mc_pixel = &(slam_data.gMap.map_center_pixel);
+    map_pixel_data_t *              mdata = (slam_data.gMap.data);
+    const int32_t                   half_x = (int32_t)GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL;
+    const int32_t                   half_y = (int32_t)GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL;
+    int32_t                         rx, ry, index;
+
+    if (table->edge_count == 0U)
+    {
+        return;
+    }
+    const uint32_t tile_row = table->clip_tile_row;
+    table->clip_tile_row = (uint8_t)((tile_row + 1U) % GMAP_TILE_HN);
+
+    // the center cell, in the frame of 'vehicle_state'
+    const float x00_mm = slam_data.gMap.vehicle_state.x - slam_data.gMap.map_offset_mm.x;
+    const float y00_mm = slam_data.gMap.vehicle_state.y - slam_data.gMap.map_offset_mm.y;
+    for (int32_t y = (int32_t)(tile_row << GMAP_TILE_EDGE_SHIFT); (y < (int32_t)((tile_row + 1U) << GMAP_TILE_EDGE_SHIFT)) && (y < GMAP_HN_PIXEL); y ++)
+    {
+        ry = y - mc_pixel->y;
+        ry += (ry > half_y) ? - (int32_t)GMAP_HN_PIXEL : ((ry < - half_y) ? (int32_t)GMAP_HN_PIXEL : 0);
+        const float y_mm = y00_mm + GMAP_UNIT_PIXEL_TO_MM(ry);
+        for (int32_t x = 0; x < GMAP_WN_PIXEL; x ++)
+        {
+            index = y * GMAP_WN_PIXEL + x;
+            const bool clipped = (mdata[index] == GRID_CELL_EDGE_CLIP_PROB);
+            if (!clipped && ((mdata[index] < GRID_CELL_NEUTRAL) || (mdata[index] > GRID_CELL_OCCUPANCY_MAX_PROB)))
+            {
+                continue;
+            }
+            rx = x - mc_pixel->x;
+            rx += (rx > half_x) ? - (int32_t)GMAP_WN_PIXEL : ((rx < - half_x) ? (int32_t)GMAP_WN_PIXEL : 0);
+            const float x_mm = x00_mm + GMAP_UNIT_PIXEL_TO_MM(rx);
+            bool past = FALSE;
+            for (uint8_t e = 0U; (e < table->edge_count) && !past; e ++)
+            {
+                const table_edge_S * edge = &(table->edge[e]);
+                past = edge->confirmed && ((edge->normal.x * x_mm + edge->normal.y * y_mm - edge->distance_mm) < - TABLE_CLIP_MARGIN_MM);
+            }
+            if (past != clipped)
+            {
+                mdata[index] = (past) ? GRID_CELL_EDGE_CLIP_PROB : GRID_CELL_NEUTRAL;
+                app_slam_private_markTileDirty(x, y);
+            }
+        }
+    }
+}
+
+static void app_slam_private_updateTableModel(void)
+{
+    app_slam_private_tableFindEdge();
+    app_slam_private_tableConfirm();
+    app_slam_private_tableClip();
+}
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+
+static void app_slam_private_globalMapUpdate(void)
+{
+    //// Fetch Data ====== ====== ======
+    // TODO: Assume we get (dx, dy) from localization (@Alex)
+#if(FEATURE_SLAM_ENCODER)
+    const math_cart_coord_float_S odometry_mm = slam_data.encoder_delta_mm; // robot frame: x forward, y left
+    float theta = slam_data.encoder_delta_theta_rad;
+#elif (MOCK)
+    const math_cart_coord_float_S odometry_mm = {1.0f, 0.0f}; // 1mm / 0.1s => 10mm / s, forward
+    float theta = 0.0f; // Assume: < pi
+#endif // (MOCK)
+#if (FEATURE_SLAM_TABLE_MODEL)
+    app_slam_private_tableTurn();
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+    // into the map frame, on the heading the chord started from: forward (sin, -cos), left (cos, sin)
+    const float cos_heading = slam_math_cosf(slam_data.gMap.vehicle_orientation_rad);
+    const float sin_heading = slam_math_sinf(slam_data.gMap.vehicle_orientation_rad);
+    float dx_mm = odometry_mm.x * sin_heading + odometry_mm.y * cos_heading;
+    float dy_mm = odometry_mm.y * sin_heading - odometry_mm.x * cos_heading;
+#if (FEATURE_SLAM_TABLE_MODEL)
+    slam_data.table.travel_mm += sqrtf(odometry_mm.x * odometry_mm.x + odometry_mm.y * odometry_mm.y);
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+#if (FEATURE_SLAM_SCAN_MATCH)
+    app_slam_private_updateSweep(dx_mm, dy_mm, slam_data.gMap.vehicle_orientation_rad, theta);
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+    //// Update Dynamic Map ===== ======
+    // accumulate global coord:
+    slam_data.gMap.vehicle_state.x += dx_mm;
+    slam_data.gMap.vehicle_state.y += dy_mm;
+    // accumulate leftover float bits from previous update
+    dx_mm += slam_data.gMap.map_offset_mm.x;
+    dy_mm += slam_data.gMap.map_offset_mm.y;
+    theta += slam_data.gMap.vehicle_orientation_rad;
+    // translate translation to pixel space:
+    const int32_t dx_pixel = GMAP_MM_TO_UNIT_PIXEL(dx_mm);
+    const int32_t dy_pixel = GMAP_MM_TO_UNIT_PIXEL(dy_mm);
+    // translate dynamic map
+    app_slam_private_translateGlobalMap(dx_pixel, dy_pixel);
+    // compute leftover float bits (-10, 10) mm
+    dx_mm -= (GMAP_UNIT_PIXEL_TO_MM(dx_pixel));
+    dy_mm -= (GMAP_UNIT_PIXEL_TO_MM(dy_pixel));
+    // saturate theta to [-pi, pi]
+    theta = ANGLE_WRAP_NPI_TO_PI(theta);
+    // map robot pose theta => one of the 28 edge nodes:
+    const vehicle_edge_node_E orientation_node = EDGE_NODE_MAPPING(theta);
+    // store leftover bit
+    slam_data.gMap.map_offset_mm.x = dx_mm;
+    slam_data.gMap.map_offset_mm.y = dy_mm;
+    slam_data.gMap.vehicle_orientation_rad = theta;
+    slam_data.gMap.orientation_node = orientation_node;
+
+#if (FEATURE_SLAM_SCAN_MATCH)
+    // odometry drift, corrected against the map before anything is drawn into it
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_SCAN_MATCH);
+    app_slam_private_scanMatch();
+    SYS_PROBE_END(SYS_PROBE_SLAM_SCAN_MATCH);
+    theta = slam_data.gMap.vehicle_orientation_rad;
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+
+#if (FEATURE_SYS_TELEMETRY)
+    const sys_telemetry_pose_S pose = {
+        .x_mm       = slam_data.gMap.vehicle_state.x,
+        .y_mm       = slam_data.gMap.vehicle_state.y,
+        .theta_rad  = theta,
+    };
+    sys_telemetry_publish(SYS_TELEMETRY_POSE, &pose, sizeof(pose));
+#elif (DEBUG_FPRINT_APP_SLAM_PRINT)
+    PRINTF("[ APP:SLAM ] x,y,theta: (%.3f mm, %.3f mm, %.3f rad)\n", 
+        (double)slam_data.gMap.vehicle_state.x, (double)slam_data.gMap.vehicle_state.y, (double)theta);
+#endif // (DEBUG_FPRINT_APP_SLAM_PRINT)
+    
+    //// Update Map Content ===== ======
+    // Clear Vehicle Region
+    app_slam_private_clearVehicleRegion();
+    
+    // Map edge IR sensors + collision sensors to map
+    app_slam_private_updateEdgeRegion();
+
+    // Map tof obstacles to map
+#if (FEATURE_SLAM_SCAN_MATCH)
+    app_slam_private_updateGmapFromToF();
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+
+    // Fit table edges to the IR edge hits, clip the map to them
+#if (FEATURE_SLAM_TABLE_MODEL)
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_TABLE_MODEL);
+    app_slam_private_updateTableModel();
+    SYS_PROBE_END(SYS_PROBE_SLAM_TABLE_MODEL);
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+}
+
+static void app_slam_private_obstacleDetection(void)
+{
+    // Cache data pointers
+    map_pixel_data_t *              mdata = (slam_data.gMap.data);
+
+    // const data
+    const int32_t cx_pixel = slam_data.gMap.map_center_pixel.x;
+    const int32_t cy_pixel = slam_data.gMap.map_center_pixel.y;
+
+    // intermediate storage
+    int32_t x, y, index;
+    
+    // collision detection
+    uint8_t obstacle_count = 0;
+
+    for (int32_t j = - VEHICLE_AVOIDANCE_R_PIXEL; j <= VEHICLE_AVOIDANCE_R_PIXEL; j ++)
+    {
+        y = cy_pixel + j;
+        y += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(y), 0, GMAP_HN_PIXEL)];
+        index = y * GMAP_WN_PIXEL;
+
+        for (int32_t i = - VEHICLE_AVOIDANCE_R_PIXEL; i <= VEHICLE_AVOIDANCE_R_PIXEL; i ++)
+        {
+            x = cx_pixel + i;
+            x += MAP_OFFSET[ARG_RANGE_INCLUSIVE((int32_t)(x), 0, GMAP_WN_PIXEL)];
+            
+            // check
+            if (mdata[index + x] > GRID_CELL_WALKABLE_THRESHOLD_MAX)
+            {
+                obstacle_count ++;
+            }
+        }
+    }
+
+    // Store solution:
+    slam_data.obstacle_count = obstacle_count;
+}
+
+static void app_slam_private_pathPlanning(void)
+{
+    // TODO: if need to generate new path, do partial path planning
+}
+
+static void app_slam_private_motionPlanning(void)
+{
+    // TODO: improve motion planning from path planning
+    // TODO: motion feedback:
+#if (MOCK)
+    bool mock_robot_was_stationary_previously = FALSE;
+#endif // (MOCK)
+    // Currently: simple obstacle avoidance logic
+    const uint8_t obstacle_count = slam_data.obstacle_count;
+    int8_t * Vl_motor_mm_s_50ms = slam_data.motion_profile.left_motor_velocity_mm_s_per_50ms;
+    int8_t * Vr_motor_mm_s_50ms = slam_data.motion_profile.right_motor_velocity_mm_s_per_50ms;
+
+    if (obstacle_count > OBSTACLE_TOLERANCE)
+    {
+#if DEBUG_FPRINT_FEATURE_OBSTACLES
+        PRINTF("[ APP:SLAM ] Collision Detected (# %d)\n", obstacle_count);
+#endif
+        // update velocity to rotation
+        if (xSemaphoreTake(slam_data.motion_profile_mutex, MP_MUTEX_BLOCK_TIME_MS) == pdTRUE) {            
+            // rotate:
+            Vl_motor_mm_s_50ms[0U] = - VELOCITY_MIN_MM_S;
+            Vr_motor_mm_s_50ms[0U] =   VELOCITY_MIN_MM_S;
+            Vl_motor_mm_s_50ms[1U] = - VELOCITY_SOFT_MM_S;
+            Vr_motor_mm_s_50ms[1U] =   VELOCITY_SOFT_MM_S;
+            // in case class update incomplete => keep spinning
+            Vl_motor_mm_s_50ms[2U] = - VELOCITY_SOFT_MM_S;
+            Vr_motor_mm_s_50ms[2U] =   VELOCITY_SOFT_MM_S;
+            Vl_motor_mm_s_50ms[3U] = - VELOCITY_SOFT_MM_S;
+            Vr_motor_mm_s_50ms[3U] =   VELOCITY_SOFT_MM_S;
+            slam_data.motion_profile.update_stamp_100ms += 1;
+            xSemaphoreGive(slam_data.motion_profile_mutex); // release lock
+        }
+    }
+    else
+    {
+        // update velocity to rotation
+        if (xSemaphoreTake(slam_data.motion_profile_mutex, MP_MUTEX_BLOCK_TIME_MS) == pdTRUE) {
+            if (mock_robot_was_stationary_previously)
+            {
+                // Soft-start
+                Vl_motor_mm_s_50ms[0U] = VELOCITY_MIN_MM_S;
+                Vr_motor_mm_s_50ms[0U] = VELOCITY_MIN_MM_S;
+                Vl_motor_mm_s_50ms[1U] = VELOCITY_SOFT_MM_S;
+                Vr_motor_mm_s_50ms[1U] = VELOCITY_SOFT_MM_S;
+            }
+            else
+            {
+                // Forward
+                Vl_motor_mm_s_50ms[0U] = VELOCITY_MAX_MM_S;
+                Vr_motor_mm_s_50ms[0U] = VELOCITY_MAX_MM_S;
+                Vl_motor_mm_s_50ms[1U] = VELOCITY_MAX_MM_S;
+                Vr_motor_mm_s_50ms[1U] = VELOCITY_MAX_MM_S;
+
+            }
+            // in case class update incomplete, stop motor:
+            Vl_motor_mm_s_50ms[2U] = VELOCITY_ZERO_MM_S;
+            Vr_motor_mm_s_50ms[2U] = VELOCITY_ZERO_MM_S;
+            Vl_motor_mm_s_50ms[3U] = VELOCITY_ZERO_MM_S;
+            Vr_motor_mm_s_50ms[3U] = VELOCITY_ZERO_MM_S;
+            slam_data.motion_profile.update_stamp_100ms += 1;
+            xSemaphoreGive(slam_data.motion_profile_mutex); // release lock
+        }
+    }
+}
+
+#if (FEATURE_SYS_TELEMETRY)
+#define MAP_TILE_MAX_PER_CYCLE (16U)
+_Static_assert((GMAP_TILE_EDGE_PIXEL * GMAP_TILE_EDGE_PIXEL) <= SYS_TELEMETRY_MAP_TILE_CELLS, "map tile exceeds a telemetry tile");
+_Static_assert(GMAP_WN_PIXEL <= UINT8_MAX, "map edge is sent as uint8");
+_Static_assert(DEV_AVR_DRIVER_ENC_BUFFER_SIZE == 3U, "sys_telemetry_encoder_S holds 3 samples");
+// run length encodes one tile of the memory map, clipped by the map edge
+static uint8_t app_slam_private_encodeMapTile(uint32_t tile_x, uint32_t tile_y, uint8_t * rle)
+{
+    const uint32_t x0 = tile_x << GMAP_TILE_EDGE_SHIFT;
+    const uint32_t y0 = tile_y << GMAP_TILE_EDGE_SHIFT;
+    const uint32_t x1 = ((x0 + GMAP_TILE_EDGE_PIXEL) < GMAP_WN_PIXEL) ? (x0 + GMAP_TILE_EDGE_PIXEL) : GMAP_WN_PIXEL;
+    const uint32_t y1 = ((y0 + GMAP_TILE_EDGE_PIXEL) < GMAP_HN_PIXEL) ? (y0 + GMAP_TILE_EDGE_PIXEL) : GMAP_HN_PIXEL;
+    uint8_t length = 0U;
+    for (uint32_t y = y0; y < y1; y ++)
+    {
+        const map_pixel_data_t * row = &slam_data.gMap.data[y * GMAP_WN_PIXEL];
+        for (uint32_t x = x0; x < x1; x ++)
+        {
+            // runs never exceed the 64 cells of a tile
+            if ((length > 0U) && ((map_pixel_data_t)rle[length - 1U] == row[x]))
+            {
+                rle[length - 2U] ++;
+            }
+            else
+            {
+                rle[length ++] = 1U;
+                rle[length ++] = (uint8_t)row[x];
+            }
+        }
+    }
+    return length;
+}
+
+// streams the tiles changed since they were last sent, round robin so a busy area cannot starve the rest
+static void app_slam_private_publishMapTiles(void)
+{
+    static uint16_t frame = 0U;
+    static uint16_t cursor = 0U;
+    static uint16_t refresh = 0U;
+    uint32_t * dirty = slam_data.gMap_dirty_tile;
+    sys_telemetry_map_tile_S tile;
+
+    // re-send one tile per cycle anyway, a host attached late converges to the full map
+    dirty[refresh >> 5U] |= (1UL << (refresh & 31U));
+    refresh = (refresh + 1U < GMAP_TILE_COUNT) ? (refresh + 1U) : 0U;
+
+    uint8_t sent = 0U;
+    for (uint16_t n = 0; (n < GMAP_TILE_COUNT) && (sent < MAP_TILE_MAX_PER_CYCLE); n ++)
+    {
+        const uint16_t t = cursor;
+        if (dirty[t >> 5U] & (1UL << (t & 31U)))
+        {
+            tile.frame     = frame;
+            tile.tile_x    = (uint8_t)(t % GMAP_TILE_WN);
+            tile.tile_y    = (uint8_t)(t / GMAP_TILE_WN);
+            tile.tile_edge = GMAP_TILE_EDGE_PIXEL;
+            tile.map_edge  = GMAP_WN_PIXEL;
+            tile.center_x  = (int16_t)slam_data.gMap.map_center_pixel.x;
+            tile.center_y  = (int16_t)slam_data.gMap.map_center_pixel.y;
+            tile.length    = app_slam_private_encodeMapTile(tile.tile_x, tile.tile_y, tile.rle);
+            if (!sys_telemetry_publish(SYS_TELEMETRY_MAP_TILE, &tile, SYS_TELEMETRY_MAP_TILE_SIZE(tile.length)))
+            {
+                break; // still dirty, resume from this tile on the next cycle
+            }
+            dirty[t >> 5U] &= ~(1UL << (t & 31U));
+            sent ++;
+        }
+        cursor = (t + 1U < GMAP_TILE_COUNT) ? (t + 1U) : 0U;
+    }
+    frame ++;
+}
+#elif (DEBUG_FPRINT_FEATURE_MAP)
+static dynamic_map_S temp_gMap;
+#define PUBLISH_PERIOD (10)
+#define PUBLISH_LENGTH_PER_CYCLE (GMAP_WN_PIXEL/5)
+static void app_slam_private_debugPrintMap(bool central)
+{
+    static int count = 0;
+    static int frame_count = -1;
+    if (count == PUBLISH_PERIOD)
+    {
+        count = 0;
+    }
+
+    if (count == 0)
+    {
+        // copy latest map
+        memcpy(&temp_gMap, &slam_data.gMap, sizeof(dynamic_map_S));
+        frame_count ++;
+        if (central)
+        {
+            PRINTF("MAP-Centered:,%d, \n", frame_count);
+        }
+        else
+        {
+            PRINTF("MAP-Memory:,%d, \n", frame_count);
+        }
+    }
+    else
+    {
+        // [0, W | H )
+        const int32_t cx= temp_gMap.map_center_pixel.x - GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL;
+        const int32_t cy= temp_gMap.map_center_pixel.y - GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL;
         map_pixel_data_t* mdata = (temp_gMap.data);
         int32_t x,y;
         int32_t end = (PUBLISH_LENGTH_PER_CYCLE * count);
@@ -864,6 +2165,315 @@ static void app_slam_private_debugPrintMap(bool central)
 }
 #endif
 
+#if (FEATURE_BENCH_MODE)
+typedef math_cart_coord_float_S (*app_slam_bench_enc_pose_t)(int16_t* l_enc_buf, int16_t* r_enc_buf, const uint8_t buffer_size);
+
+typedef struct{
+    int32_t dx_pixel;
+    int32_t dy_pixel;
+} app_slam_bench_shift_S;
+
+static const app_slam_bench_enc_pose_t app_slam_bench_enc_pose[3] = {
+    slam_math_get_enc_pose,
+    slam_math_get_enc_pose_optimized,
+    slam_math_get_enc_pose_reduced,
+};
+static const app_slam_bench_shift_S app_slam_bench_shift[7] = {
+    { 1,  0}, { 0,  1}, { 1,  1}, {-1, -1}, { 3,  3}, {10, 10}, {80, 80},
+};
+static const bool app_slam_bench_edge[2] = {FALSE, TRUE};
+#if (FEATURE_SLAM_SCAN_MATCH)
+static const bool app_slam_bench_pyramid = TRUE;
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+
+// a mix of visited, sensed, occupied and edge cells, no neutral one so every clear writes
+static void app_slam_bench_private_fillMap(void * arg)
+{
+    static const map_pixel_data_t pattern[5] = {
+        GRID_CELL_VISITED, GRID_CELL_VISITED_SENSOR, GRID_CELL_WALKABLE_THRESHOLD_MAX, GRID_CELL_OCCUPANCY_MAX_PROB, GRID_CELL_EDGE_DEFAULT_PROB,
+    };
+    map_pixel_data_t * mdata = slam_data.gMap.data;
+    for (int32_t y = 0; y < GMAP_HN_PIXEL; y ++)
+    {
+        for (int32_t x = 0; x < GMAP_WN_PIXEL; x ++)
+        {
+            mdata[y * GMAP_WN_PIXEL + x] = pattern[(x * 7 + y * 13) % 5];
+        }
+    }
+    slam_data.gMap.map_center_pixel.x = GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL;
+    slam_data.gMap.map_center_pixel.y = GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL;
+    slam_data.gMap.orientation_node = VEHICLE_EDGE_NODE_3;
+    memset(slam_data.gMap_dirty_tile, 0x00, sizeof(slam_data.gMap_dirty_tile));
+}
+
+static void app_slam_bench_private_resetMap(void * arg)
+{
+    app_slam_private_resetGlobalMap();
+}
+
+// a full encoder buffer at cruise speed, slightly turning
+static void app_slam_bench_private_fillEncoder(void * arg)
+{
+    for (uint8_t i = 0U; i < DEV_AVR_DRIVER_ENC_BUFFER_SIZE; i ++)
+    {
+        slam_data.left_enc_buf[i]  = (int16_t)(12 + i);
+        slam_data.right_enc_buf[i] = (int16_t)(14 - i);
+    }
+}
+
+static void app_slam_bench_private_setEdge(void * arg)
+{
+    const bool tripped = *(const bool *)arg;
+    app_slam_bench_private_fillMap(NULL);
+    for (uint8_t i = 0U; i < IR_COUNT; i ++)
+    {
+        slam_data.ir_node[i] = tripped;
+    }
+    slam_data.collision_end_node[COLLISION_R] = tripped;
+    slam_data.collision_end_node[COLLISION_L] = tripped;
+}
+
+static void app_slam_bench_private_encPose(void * arg)
+{
+    const app_slam_bench_enc_pose_t enc_pose = *(const app_slam_bench_enc_pose_t *)arg;
+    slam_data.encoder_delta_mm = enc_pose(slam_data.left_enc_buf, slam_data.right_enc_buf, DEV_AVR_DRIVER_ENC_BUFFER_SIZE);
+}
+
+// one map row per call, the new value flips so every cell keeps changing
+static void app_slam_bench_private_gridCellUpdate(void * arg)
+{
+    map_pixel_data_t * row = &slam_data.gMap.data[GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL * GMAP_WN_PIXEL];
+    const map_pixel_data_t new_val = (row[0] > GRID_CELL_NEUTRAL) ? GRID_CELL_VISITED_SENSOR : GRID_CELL_EDGE_DEFAULT_PROB;
+    for (int32_t x = 0; x < GMAP_WN_PIXEL; x ++)
+    {
+        row[x] = GRID_CELL_UPDATE(row[x], new_val);
+    }
+}
+
+static void app_slam_bench_private_translateGlobalMap(void * arg)
+{
+    const app_slam_bench_shift_S * shift = (const app_slam_bench_shift_S *)arg;
+    app_slam_private_translateGlobalMap(shift->dx_pixel, shift->dy_pixel);
+}
+
+static void app_slam_bench_private_clearVehicleRegion(void * arg)
+{
+    app_slam_private_clearVehicleRegion();
+}
+
+static void app_slam_bench_private_updateEdgeRegion(void * arg)
+{
+    app_slam_private_updateEdgeRegion();
+}
+
+static void app_slam_bench_private_obstacleDetection(void * arg)
+{
+    app_slam_private_obstacleDetection();
+}
+
+#if (FEATURE_SLAM_SCAN_MATCH)
+/**
+ * two walls 600 mm off the vehicle, the sweep on them turned by -2 rotation steps and shifted by (+20, -30) mm,
+ * the search has to bring it back; far enough out that one rotation step moves the far points by a cell
+ */
+static void app_slam_bench_private_scanScene(void * arg)
+{
+    scan_sweep_S * sweep = &(slam_data.sweep);
+    map_pixel_data_t * mdata = slam_data.gMap.data;
+    app_slam_private_resetGlobalMap();
+    for (int32_t k = -55; k <= 55; k ++)
+    {
+        mdata[(GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL + k) * GMAP_WN_PIXEL + (GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL + 60)] = 75;
+        mdata[(GMAP_DEFAULT_CENTRAL_Y_INDEX_PIXEL - 60) * GMAP_WN_PIXEL + (GMAP_DEFAULT_CENTRAL_X_INDEX_PIXEL + k)] = 75;
+    }
+    const float cos_theta = slam_math_cosf(-2.0F * SCAN_MATCH_THETA_STEP_RAD);
+    const float sin_theta = slam_math_sinf(-2.0F * SCAN_MATCH_THETA_STEP_RAD);
+    for (uint8_t i = 0U; i < SCAN_MATCH_SWEEP_SIZE; i ++)
+    {
+        const float x = (i < 9U) ? 600.0F : (-500.0F + 100.0F * (float)(i - 9U));
+        const float y = (i < 9U) ? (-400.0F + 100.0F * (float)i) : -600.0F;
+        sweep->point_mm[i].x = x * cos_theta - y * sin_theta + 20.0F;
+        sweep->point_mm[i].y = x * sin_theta + y * cos_theta - 30.0F;
+    }
+    sweep->count = SCAN_MATCH_SWEEP_SIZE;
+    sweep->head = 0U;
+    sweep->fresh = 0U;
+    if ((arg != NULL) && (*(const bool *)arg))
+    {
+        app_slam_private_updateLikelihoodMap();
+    }
+}
+
+static void app_slam_bench_private_updateLikelihoodMap(void * arg)
+{
+    app_slam_private_updateLikelihoodMap();
+}
+
+static void app_slam_bench_private_scanMatchSearch(void * arg)
+{
+    scan_match_result_S result;
+    app_slam_private_scanMatchSearch(&result);
+}
+
+// every candidate of the search window scored at level 0, the first best in (theta, dy, dx) order
+static uint32_t app_slam_bench_private_scanMatchBrute(scan_match_result_S * best)
+{
+    scan_match_cells_S cells;
+    uint32_t ties = 0U; // candidates on the best score
+    memset(best, 0x00, sizeof(scan_match_result_S));
+    for (int8_t step = - SCAN_MATCH_THETA_STEPS; step <= SCAN_MATCH_THETA_STEPS; step ++)
+    {
+        app_slam_private_scanMatchCells(step, &cells);
+        for (int32_t j = - SCAN_MATCH_WINDOW_PIXEL; j <= SCAN_MATCH_WINDOW_PIXEL; j ++)
+        {
+            for (int32_t i = - SCAN_MATCH_WINDOW_PIXEL; i <= SCAN_MATCH_WINDOW_PIXEL; i ++)
+            {
+                const uint32_t score = app_slam_private_scanMatchScore(&cells, i, j);
+                if (score > best->score)
+                {
+                    best->dx_pixel = i;
+                    best->dy_pixel = j;
+                    best->theta_step = step;
+                    best->score = score;
+                    ties = 0U;
+                }
+                ties += (score == best->score) ? 1U : 0U;
+            }
+        }
+    }
+    return ties;
+}
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+
+#if (FEATURE_SLAM_TABLE_MODEL)
+static const bool app_slam_bench_table_edges = TRUE;
+
+/**
+ * edge hits along two sides of a table 250 mm off the vehicle, a few strays among them,
+ * none assigned yet, or both edges already found for the clip
+ */
+static void app_slam_bench_private_tableScene(void * arg)
+{
+    table_model_S * table = &(slam_data.table);
+    app_slam_private_resetGlobalMap();
+    for (uint8_t i = 0U; i < TABLE_HIT_BUFFER_SIZE; i ++)
+    {
+        const float along_mm = -200.0F + 20.0F * (float)(i % 21U);
+        table->hit[i].point_mm.x = (i < 21U) ? 250.0F : ((i < 42U) ? along_mm : (float)(i * 37U % 400U) - 200.0F);
+        table->hit[i].point_mm.y = (i < 21U) ? along_mm : ((i < 42U) ? -250.0F : (float)(i * 53U % 400U) - 200.0F);
+        table->hit[i].edge = TABLE_EDGE_MAX;
+    }
+    table->hit_count = TABLE_HIT_BUFFER_SIZE;
+    if ((arg != NULL) && (*(const bool *)arg))
+    {
+        app_slam_private_tableFindEdge();
+        app_slam_private_tableFindEdge();
+    }
+}
+
+static void app_slam_bench_private_tableFindEdge(void * arg)
+{
+    app_slam_private_tableFindEdge();
+}
+
+static void app_slam_bench_private_tableClip(void * arg)
+{
+    app_slam_private_tableClip();
+}
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+
+// the angle steps through a few turns so neither libm nor the tables see a constant, the sink keeps the call
+static volatile float app_slam_bench_trig_sink;
+static float app_slam_bench_trig_angle;
+
+static inline float app_slam_bench_private_nextAngle(void)
+{
+    app_slam_bench_trig_angle += 0.0173F;
+    if (app_slam_bench_trig_angle > 4.0F * SLAM_MATH_PI)
+    {
+        app_slam_bench_trig_angle -= 8.0F * SLAM_MATH_PI;
+    }
+    return app_slam_bench_trig_angle;
+}
+
+static void app_slam_bench_private_cosDouble(void * arg)
+{
+    app_slam_bench_trig_sink = (float)cos((double)app_slam_bench_private_nextAngle());
+}
+
+static void app_slam_bench_private_cosf(void * arg)
+{
+    app_slam_bench_trig_sink = cosf(app_slam_bench_private_nextAngle());
+}
+
+static void app_slam_bench_private_cosLut(void * arg)
+{
+    app_slam_bench_trig_sink = slam_math_cosf(app_slam_bench_private_nextAngle());
+}
+
+static void app_slam_bench_private_atan2f(void * arg)
+{
+    const float angle = app_slam_bench_private_nextAngle();
+    app_slam_bench_trig_sink = atan2f(angle - 1.0F, 2.0F - angle);
+}
+
+static void app_slam_bench_private_atan2Lut(void * arg)
+{
+    const float angle = app_slam_bench_private_nextAngle();
+    app_slam_bench_trig_sink = slam_math_atan2f(angle - 1.0F, 2.0F - angle);
+}
+
+// leave the slam state as app_slam_init() did
+static void app_slam_bench_private_resetSlam(void)
+{
+    app_slam_private_resetGlobalMap();
+    memset(slam_data.ir_node, 0x00, sizeof(slam_data.ir_node));
+    memset(slam_data.collision_end_node, 0x00, sizeof(slam_data.collision_end_node));
+    memset(slam_data.left_enc_buf, 0x00, sizeof(slam_data.left_enc_buf));
+    memset(slam_data.right_enc_buf, 0x00, sizeof(slam_data.right_enc_buf));
+    slam_data.encoder_delta_mm.x = 0.0F;
+    slam_data.encoder_delta_mm.y = 0.0F;
+    slam_data.obstacle_count = 0U;
+}
+
+/**
+ * kernels of the 10 Hz path, a kernel that consumes its map (translate, first clear) runs once per sample
+ * on a freshly filled map, the others are calibrated
+ */
+static const sys_bench_case_S app_slam_bench_cases[] = {
+    {"slam_math_get_enc_pose",              app_slam_bench_private_fillEncoder, app_slam_bench_private_encPose,             (void *)&app_slam_bench_enc_pose[0], 0U, 1U},
+    {"slam_math_get_enc_pose_optimized",    app_slam_bench_private_fillEncoder, app_slam_bench_private_encPose,             (void *)&app_slam_bench_enc_pose[1], 0U, 1U},
+    {"slam_math_get_enc_pose_reduced",      app_slam_bench_private_fillEncoder, app_slam_bench_private_encPose,             (void *)&app_slam_bench_enc_pose[2], 0U, 1U},
+    {"GRID_CELL_UPDATE",                    app_slam_bench_private_fillMap,     app_slam_bench_private_gridCellUpdate,      NULL,                               0U, GMAP_WN_PIXEL},
+    {"translateGlobalMap dx 1 dy 0",        app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[0],   1U, 1U},
+    {"translateGlobalMap dx 0 dy 1",        app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[1],   1U, 1U},
+    {"translateGlobalMap dx 1 dy 1",        app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[2],   1U, 1U},
+    {"translateGlobalMap dx -1 dy -1",      app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[3],   1U, 1U},
+    {"translateGlobalMap dx 3 dy 3",        app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[4],   1U, 1U},
+    {"translateGlobalMap dx 10 dy 10",      app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[5],   1U, 1U},
+    {"translateGlobalMap dx 80 dy 80",      app_slam_bench_private_fillMap,     app_slam_bench_private_translateGlobalMap,  (void *)&app_slam_bench_shift[6],   1U, 1U},
+    {"clearVehicleRegion fresh",            app_slam_bench_private_fillMap,     app_slam_bench_private_clearVehicleRegion,  NULL,                               1U, 1U},
+    {"clearVehicleRegion revisit",          app_slam_bench_private_fillMap,     app_slam_bench_private_clearVehicleRegion,  NULL,                               0U, 1U},
+    {"updateEdgeRegion clear",              app_slam_bench_private_setEdge,     app_slam_bench_private_updateEdgeRegion,    (void *)&app_slam_bench_edge[0],    0U, 1U},
+    {"updateEdgeRegion tripped",            app_slam_bench_private_setEdge,     app_slam_bench_private_updateEdgeRegion,    (void *)&app_slam_bench_edge[1],    0U, 1U},
+    {"obstacleDetection empty",             app_slam_bench_private_resetMap,    app_slam_bench_private_obstacleDetection,   NULL,                               0U, 1U},
+    {"obstacleDetection filled",            app_slam_bench_private_fillMap,     app_slam_bench_private_obstacleDetection,   NULL,                               0U, 1U},
+#if (FEATURE_SLAM_SCAN_MATCH)
+    {"updateLikelihoodMap all tiles",       app_slam_bench_private_scanScene,   app_slam_bench_private_updateLikelihoodMap, NULL,                               1U, 1U},
+    {"scanMatchSearch",                     app_slam_bench_private_scanScene,   app_slam_bench_private_scanMatchSearch,     (void *)&app_slam_bench_pyramid,    0U, 1U},
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+#if (FEATURE_SLAM_TABLE_MODEL)
+    {"tableFindEdge",                       app_slam_bench_private_tableScene,  app_slam_bench_private_tableFindEdge,       NULL,                               1U, 1U},
+    {"tableClip one tile row",              app_slam_bench_private_tableScene,  app_slam_bench_private_tableClip,           (void *)&app_slam_bench_table_edges, 0U, 1U},
+#endif // (FEATURE_SLAM_TABLE_MODEL)
+    {"cos double (libm)",                   NULL,                               app_slam_bench_private_cosDouble,           NULL,                               0U, 1U},
+    {"cosf (libm)",                         NULL,                               app_slam_bench_private_cosf,                NULL,                               0U, 1U},
+    {"slam_math_cosf (lut)",                NULL,                               app_slam_bench_private_cosLut,              NULL,                               0U, 1U},
+    {"atan2f (libm)",                       NULL,                               app_slam_bench_private_atan2f,              NULL,                               0U, 1U},
+    {"slam_math_atan2f (lut)",              NULL,                               app_slam_bench_private_atan2Lut,            NULL,                               0U, 1U},
+};
+#endif // (FEATURE_BENCH_MODE)
+
 ///////////////////////////////////////
 ///////   PUBLIC FUNCTION     /////////
 ///////////////////////////////////////
@@ -874,6 +2484,7 @@ void app_slam_init(void)
     app_slam_private_resetGlobalMap();
 
     // init
+    slam_math_init();
     slam_data.sensor_config = & edge_sensor_config;
     slam_data.motion_profile_mutex = xSemaphoreCreateBinary();
     xSemaphoreGive(slam_data.motion_profile_mutex); // release mutex for usage
@@ -890,14 +2501,30 @@ void app_slam_run100ms(void)
         app_slam_private_resetGlobalMap();
         slam_data.mapResetRequested = FALSE;
     }
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_LOCALIZATION);
     app_slam_private_localization();
+    SYS_PROBE_END(SYS_PROBE_SLAM_LOCALIZATION);
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_LOCAL_MAP);
     app_slam_private_localMapUpdate();
+    SYS_PROBE_END(SYS_PROBE_SLAM_LOCAL_MAP);
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_GLOBAL_MAP);
     app_slam_private_globalMapUpdate();
+    SYS_PROBE_END(SYS_PROBE_SLAM_GLOBAL_MAP);
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_OBSTACLE);
     app_slam_private_obstacleDetection();
+    SYS_PROBE_END(SYS_PROBE_SLAM_OBSTACLE);
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_PATH);
     app_slam_private_pathPlanning();
+    SYS_PROBE_END(SYS_PROBE_SLAM_PATH);
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_MOTION);
     app_slam_private_motionPlanning();
+    SYS_PROBE_END(SYS_PROBE_SLAM_MOTION);
     
-#   if (DEBUG_FPRINT_FEATURE_MAP)
+#   if (FEATURE_SYS_TELEMETRY)
+    SYS_PROBE_BEGIN(SYS_PROBE_SLAM_MAP_TILES);
+    app_slam_private_publishMapTiles();
+    SYS_PROBE_END(SYS_PROBE_SLAM_MAP_TILES);
+#   elif (DEBUG_FPRINT_FEATURE_MAP)
         app_slam_private_debugPrintMap(DEBUG_FPRINT_FEATURE_MAP_CENTERED);
 #   endif
 #endif //(FEATURE_SLAM)
@@ -924,11 +2551,24 @@ uint8_t app_slam_getMotionVelocity(int8_t * left_motor_mm_s_50ms, int8_t * right
     return frame_stamp;
 }
 
+void app_slam_getVehiclePose(float * x_mm, float * y_mm, float * theta_rad)
+{
+    * x_mm      = slam_data.gMap.vehicle_state.x;
+    * y_mm      = slam_data.gMap.vehicle_state.y;
+    * theta_rad = slam_data.gMap.vehicle_orientation_rad;
+}
+
 void app_slam_requestToResetMap(void)
 {
     slam_data.mapResetRequested = TRUE;
 }
 
+void app_slam_registerDangerZoneNotify(TaskHandle_t task, uint32_t bit)
+{
+    slam_data.danger_zone_notify_bit  = bit;
+    slam_data.danger_zone_notify_task = task;
+}
+
 uint16_t app_slam_requestToFDangerZone(void)
 {
     uint16_t status = APP_SLAM_TOF_DANGER_ZONE_FLAG_NULL;
@@ -937,3 +2577,34 @@ uint16_t app_slam_requestToFDangerZone(void)
 #endif //(FEATURE_DEMO_TOF_OBSTACLE)
     return status;
 }
+
+#if (FEATURE_BENCH_MODE)
+void app_slam_bench(sys_bench_report_t report)
+{
+    sys_bench_run_all(app_slam_bench_cases, (uint8_t)(sizeof(app_slam_bench_cases) / sizeof(app_slam_bench_cases[0])), report);
+    app_slam_bench_private_resetSlam();
+}
+
+bool app_slam_bench_check(sys_bench_report_t report)
+{
+    bool pass = TRUE;
+#if (FEATURE_SLAM_SCAN_MATCH)
+    char line[SYS_BENCH_LINE_SIZE];
+    scan_match_result_S search, brute;
+    app_slam_bench_private_scanScene((void *)&app_slam_bench_pyramid);
+    const bool found = app_slam_private_scanMatchSearch(&search);
+    const uint32_t ties = app_slam_bench_private_scanMatchBrute(&brute);
+    // the scene is built off by (+20, -30) mm and -2 steps, the best is the one way back and nothing ties it
+    const bool ok = found && (search.dx_pixel == -2) && (search.dy_pixel == 3) && (search.theta_step == 2)
+        && (brute.dx_pixel == search.dx_pixel) && (brute.dy_pixel == search.dy_pixel) && (brute.theta_step == search.theta_step)
+        && (brute.score == search.score) && (ties == 1U);
+    snprintf(line, sizeof(line), "[ CHECK ] scanMatchSearch (%d, %d, %d) score %u, brute force (%d, %d, %d) score %u ties %u: %s",
+        (int)search.dx_pixel, (int)search.dy_pixel, (int)search.theta_step, (unsigned)search.score,
+        (int)brute.dx_pixel, (int)brute.dy_pixel, (int)brute.theta_step, (unsigned)brute.score, (unsigned)ties, ok ? "ok" : "FAIL");
+    report(line);
+    pass = pass && ok;
+#endif // (FEATURE_SLAM_SCAN_MATCH)
+    app_slam_bench_private_resetSlam();
+    return pass;
+}
+#endif // (FEATURE_BENCH_MODE)
@@ -15,6 +15,13 @@ extern "C"{
 
 #include <stdint.h>
 #include <stdbool.h>
+
+// TableUV Lib
+#include "sys_bench.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 /////////////////////////////////
 ///////   DEFINITION     ////////
 /////////////////////////////////
@@ -27,6 +34,10 @@ void app_slam_init(void);
 void app_slam_run100ms(void);
 void app_slam_requestToResetMap(void);
 uint16_t app_slam_requestToFDangerZone(void);
+/**
+ * @brief set 'bit' in the notification value of 'task' whenever the ToF danger zone changes
+ */
+void app_slam_registerDangerZoneNotify(TaskHandle_t task, uint32_t bit);
 
 /**
  * @brief get motion velocity
@@ -38,6 +49,27 @@ uint16_t app_slam_requestToFDangerZone(void);
  * return frame_stamp
  */
 uint8_t app_slam_getMotionVelocity(int8_t * left_motor_mm_s_50ms, int8_t * right_motor_mm_s_50ms, uint8_t frame_stamp);
+/**
+ * @brief pose of the last slam cycle: x to the left of the start heading, y behind it [mm], theta CCW from it [rad]
+ * @note  not locked against the slam task, read it from that core between cycles (the host simulator)
+ */
+void app_slam_getVehiclePose(float * x_mm, float * y_mm, float * theta_rad);
+
+#if (FEATURE_BENCH_MODE)
+/**
+ * @brief time the kernels of the 10 Hz path on the slam map, one line per kernel through 'report'
+ *
+ * Nothing else may touch the slam state meanwhile, the map is left reset.
+ */
+void app_slam_bench(sys_bench_report_t report);
+/**
+ * @brief check the results the benched kernels rely on, one line per check through 'report'
+ *
+ * The scan match has to recover the known offset of its bench scene and agree with a brute force search.
+ * @return TRUE when every check passes, the map is left reset
+ */
+bool app_slam_bench_check(sys_bench_report_t report);
+#endif // (FEATURE_BENCH_MODE)
 
 # ifdef __cplusplus  
 }
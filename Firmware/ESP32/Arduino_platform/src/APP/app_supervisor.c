@@ -23,6 +23,15 @@
 #include "dev_battery.h"
 #include "app_slam.h"
 #include "dev_uv.h"
+#include "app_hazard.h"
+#include "app_motion_script.h"
+#include "sys_telemetry.h"
+#include "sys_time.h"
+#include "sys_probe.h"
+
+// FreeRTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 /////////////////////////////////
 ///////   DEFINITION     ////////
@@ -31,6 +40,21 @@
 #define UV_PWM                      (500)
 #define UV_DAC                      (64)
 
+// time based steps (motion profile) run on this tick, everything else on events
+#define SUPER_TICK_MS               (50U)
+// states without time based steps still re-check their inputs at this rate
+#define SUPER_IDLE_TICK_MS          (1000U)
+
+// task notification bits, set by the producers
+typedef enum {
+    SUPER_EVENT_TICK            = (1U << 0U), // local, deadline of the periodic tick
+    SUPER_EVENT_BUTTON          = (1U << 1U),
+    SUPER_EVENT_AVR_SENSOR      = (1U << 2U),
+    SUPER_EVENT_SLAM_DANGER     = (1U << 3U),
+    SUPER_EVENT_BATTERY         = (1U << 4U),
+    SUPER_EVENT_MOTION_DONE     = (1U << 5U),
+} app_supervisor_event_E;
+
 typedef enum {
     APP_STATE_IDLE,
     APP_STATE_AUTONOMY,
@@ -58,39 +82,20 @@ typedef enum {
     APP_FAULTS_INVALID_STATE        = (1<<30U),
 } app_faults_E;
 
-#if (FEATURE_SUPER_USE_HARDCODE_CHORE)
-#define CHOREOGRAPHY_BASE_TICK_50MS    (4U) // base ticK 4*50ms
-
-typedef enum{
-    APP_CHOREOGRAPHY_INIT,
-    APP_CHOREOGRAPHY_STEP_1,
-    APP_CHOREOGRAPHY_STEP_2,
-    APP_CHOREOGRAPHY_STEP_3,
-    APP_CHOREOGRAPHY_STEP_4,
-    APP_CHOREOGRAPHY_STEP_5,
-    APP_CHOREOGRAPHY_STEP_6,
-    APP_CHOREOGRAPHY_STEP_7,
-    APP_CHOREOGRAPHY_STEP_8,
-    APP_CHOREOGRAPHY_STEP_9,
-    APP_CHOREOGRAPHY_STEP_COUNT,
-    APP_CHOREOGRAPHY_STEP_UNKNOWN,
-} app_choreography_E;
-#endif // (FEATURE_SUPER_USE_HARDCODE_CHORE)
-
 typedef struct{
     app_state_E         current_state;
+    TickType_t          last_tick;
     uint32_t            fault_flag;
     bool                button_pressed;
     uint8_t             avr_sensor_data;
     float               battery_voltage;
     uint16_t            app_slam_EFlag;
-#if (FEATURE_SUPER_USE_HARDCODE_CHORE)
-    uint32_t                estop_chorography_tick_20ms;
-    app_choreography_E      estop_choreography_wip;
-    const motor_pwm_duty_E  estop_choreography_sequence_l[APP_CHOREOGRAPHY_STEP_COUNT];
-    const motor_pwm_duty_E  estop_choreography_sequence_r[APP_CHOREOGRAPHY_STEP_COUNT];
-    const motor_pwm_duty_E  estop_choreography_sequence_mode[APP_CHOREOGRAPHY_STEP_COUNT];
-#endif // (FEATURE_SUPER_USE_HARDCODE_CHORE)
+    bool                hazard_tripped;
+#if (FEATURE_SUPER_USE_PROFILED_MOTIONS)
+    uint8_t             motion_frame_stamp;
+    int8_t              left_velocity_mm_s;
+    int8_t              right_velocity_mm_s;
+#endif // (FEATURE_SUPER_USE_PROFILED_MOTIONS)
 } app_supervisor_data_S;
 
 /////////////////////////////////////////
@@ -98,7 +103,7 @@ typedef struct{
 /////////////////////////////////////////
 static bool app_supervisor_private_exitCurrentState(app_state_E state);
 static bool app_supervisor_private_stateAction(app_state_E state);
-static void app_supervisor_private_fetchState(void);
+static bool app_supervisor_private_fetchState(uint32_t events);
 static bool app_supervisor_private_transitToNewState(app_state_E state);
 static app_state_E app_supervisor_private_getNextState(app_state_E state);
 
@@ -107,52 +112,32 @@ static app_state_E app_supervisor_private_getNextState(app_state_E state);
 ///////////////////////////
 static app_supervisor_data_S supervisor_data = {
     .current_state   = APP_STATE_IDLE,
+    .last_tick       = 0,
     .fault_flag      = 0,
     .button_pressed  = false,
     .avr_sensor_data = 0,
     .battery_voltage = 12.6,
     .app_slam_EFlag  = APP_SLAM_TOF_DANGER_ZONE_FLAG_NULL,
-#if (FEATURE_SUPER_USE_HARDCODE_CHORE)
-    .estop_chorography_tick_20ms = 0U,
-    .estop_choreography_wip      = APP_CHOREOGRAPHY_STEP_UNKNOWN,
-    .estop_choreography_sequence_l = {
-        [APP_CHOREOGRAPHY_INIT  ] = MOTOR_PWM_DUTY_0_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_1] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_2] = MOTOR_PWM_DUTY_40_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_3] = MOTOR_PWM_DUTY_40_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_4] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_5] = MOTOR_PWM_DUTY_0_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_6] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_7] = MOTOR_PWM_DUTY_40_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_8] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_9] = MOTOR_PWM_DUTY_0_PERCENT,
-    },
-    .estop_choreography_sequence_r = {
-        [APP_CHOREOGRAPHY_INIT  ] = MOTOR_PWM_DUTY_0_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_1] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_2] = MOTOR_PWM_DUTY_40_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_3] = MOTOR_PWM_DUTY_40_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_4] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_5] = MOTOR_PWM_DUTY_0_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_6] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_7] = MOTOR_PWM_DUTY_40_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_8] = MOTOR_PWM_DUTY_30_PERCENT,
-        [APP_CHOREOGRAPHY_STEP_9] = MOTOR_PWM_DUTY_0_PERCENT,
-    },
-    .estop_choreography_sequence_mode = {
-        [APP_CHOREOGRAPHY_INIT  ] = ROBOT_MOTION_BREAK,
-        [APP_CHOREOGRAPHY_STEP_1] = ROBOT_MOTION_REV_BREAK,
-        [APP_CHOREOGRAPHY_STEP_2] = ROBOT_MOTION_REV_BREAK,
-        [APP_CHOREOGRAPHY_STEP_3] = ROBOT_MOTION_REV_BREAK,
-        [APP_CHOREOGRAPHY_STEP_4] = ROBOT_MOTION_BREAK,
-        [APP_CHOREOGRAPHY_STEP_5] = ROBOT_MOTION_BREAK,
-        [APP_CHOREOGRAPHY_STEP_6] = ROBOT_MOTION_CW_ROTATION,
-        [APP_CHOREOGRAPHY_STEP_7] = ROBOT_MOTION_CW_ROTATION,
-        [APP_CHOREOGRAPHY_STEP_8] = ROBOT_MOTION_CW_ROTATION,
-        [APP_CHOREOGRAPHY_STEP_9] = ROBOT_MOTION_BREAK,
-    },
-#endif // (FEATURE_SUPER_USE_HARDCODE_CHORE)
+    .hazard_tripped  = false,
+#if (FEATURE_SUPER_USE_PROFILED_MOTIONS)
+    .motion_frame_stamp  = 0U,
+    .left_velocity_mm_s  = 0,
+    .right_velocity_mm_s = 0,
+#endif // (FEATURE_SUPER_USE_PROFILED_MOTIONS)
+};
+
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+// back off the hazard, then turn away from it, each move ends early once far enough
+static const app_motion_step_S estop_recovery_script[] = {
+    // op               mode                        left                        right                       guard                       value   ms
+    {MOTION_OP_PWM,     ROBOT_MOTION_BREAK,         MOTOR_PWM_DUTY_0_PERCENT,   MOTOR_PWM_DUTY_0_PERCENT,   MOTION_GUARD_NONE,          0U,     150U},
+    {MOTION_OP_PWM,     ROBOT_MOTION_REV_BREAK,     MOTOR_PWM_DUTY_40_PERCENT,  MOTOR_PWM_DUTY_40_PERCENT,  MOTION_GUARD_DISTANCE_MM,   30U,    600U},
+    {MOTION_OP_PWM,     ROBOT_MOTION_BREAK,         MOTOR_PWM_DUTY_0_PERCENT,   MOTOR_PWM_DUTY_0_PERCENT,   MOTION_GUARD_NONE,          0U,     150U},
+    {MOTION_OP_PWM,     ROBOT_MOTION_CW_ROTATION,   MOTOR_PWM_DUTY_40_PERCENT,  MOTOR_PWM_DUTY_40_PERCENT,  MOTION_GUARD_HEADING_DEG,   60U,    600U},
+    {MOTION_OP_PWM,     ROBOT_MOTION_BREAK,         MOTOR_PWM_DUTY_0_PERCENT,   MOTOR_PWM_DUTY_0_PERCENT,   MOTION_GUARD_NONE,          0U,     200U},
+    {MOTION_OP_END,     ROBOT_MOTION_BREAK,         0,                          0,                          MOTION_GUARD_NONE,          0U,     0U  },
 };
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
 
 ////////////////////////////////////////
 ///////   PRIVATE FUNCTION     /////////
@@ -188,7 +173,7 @@ static app_state_E app_supervisor_private_getNextState(app_state_E state)
                 supervisor_data.fault_flag |= APP_FAULTS_ROBOT_IN_THE_AIR;
                 nextState = APP_STATE_HALT;
             }
-            else if (supervisor_data.avr_sensor_data & DEV_AVR_ALL_SENSORS)
+            else if ((supervisor_data.avr_sensor_data & DEV_AVR_ALL_SENSORS) || supervisor_data.hazard_tripped)
             {
                 nextState = APP_STATE_AUTONOMY_ESTOPPED;
             }
@@ -213,15 +198,12 @@ static app_state_E app_supervisor_private_getNextState(app_state_E state)
                 supervisor_data.fault_flag |= APP_FAULTS_ROBOT_IN_THE_AIR;
                 nextState = APP_STATE_HALT;
             }
-#if (FEATURE_SUPER_USE_HARDCODE_CHORE)
-            else if (supervisor_data.estop_choreography_wip < APP_CHOREOGRAPHY_STEP_COUNT)
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+            else if (app_motion_script_is_running())
             {
-                // choreography still in progress
-#   if (DEBUG_FPRINT_FEATURE_CHOREOGRAPHY)
-                PRINTF("[ CHOREOGRAPHY ]: %d \n", supervisor_data.estop_choreography_wip);
-#   endif//(DEBUG_FPRINT_FEATURE_CHOREOGRAPHY)
+                // recovery still in progress, its end posts SUPER_EVENT_MOTION_DONE
             }
-#endif // (FEATURE_SUPER_USE_HARDCODE_CHORE)
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
             else if (supervisor_data.avr_sensor_data == DEV_AVR_NO_SENSOR)
             {
                 nextState = APP_STATE_AUTONOMY;
@@ -271,13 +253,15 @@ static bool app_supervisor_private_transitToNewState(app_state_E state)
             dev_uv_fw_shutdown_clear();
             dev_uv_set_row(UV_PWM, UV_DAC);
 #endif            
+#if (FEATURE_HAZARD_FAST_ESTOP)
+            app_hazard_arm(true);
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
             break;
 
         case (APP_STATE_AUTONOMY_ESTOPPED):
-#if (FEATURE_SUPER_USE_HARDCODE_CHORE)
-            supervisor_data.estop_chorography_tick_20ms = APP_CHOREOGRAPHY_INIT;
-            supervisor_data.estop_choreography_wip = APP_CHOREOGRAPHY_INIT;
-#endif // (FEATURE_SUPER_USE_HARDCODE_CHORE)
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT && FEATURE_SUPER_CMD_DEV_DRIVER)
+            app_motion_script_start(estop_recovery_script);
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT && FEATURE_SUPER_CMD_DEV_DRIVER)
 #if (FEATURE_PERIPHERALS)               
             dev_led_clear_leds();
             dev_led_red_set(true);
@@ -303,9 +287,25 @@ static bool app_supervisor_private_exitCurrentState(app_state_E state)
 #endif //(FEATURE_SLAM)
             break;
 
+        case (APP_STATE_AUTONOMY):
+#if (FEATURE_HAZARD_FAST_ESTOP)
+            app_hazard_arm(false); // hands the e-stop latch back to the next state
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
+#if (FEATURE_UV)
+            dev_uv_fw_shutdown();
+#endif
+            break;
+
         case (APP_STATE_AUTONOMY_ESTOPPED):
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+            app_motion_script_stop(); // the next state takes the wheels over
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
+#if (FEATURE_UV)
+            dev_uv_fw_shutdown();
+#endif
+            break;
+
         case (APP_STATE_HALT):
-        case (APP_STATE_AUTONOMY):
         case (APP_STATE_COUNT):            
         case (APP_STATE_UNKNOWN):
         default:
@@ -318,37 +318,25 @@ static bool app_supervisor_private_exitCurrentState(app_state_E state)
     return true;
 }
 
+// commands are re-sent on every call
 static bool app_supervisor_private_stateAction(app_state_E state)
 {
-#if (FEATURE_SUPER_USE_HARDCODE_CHORE)
-    const uint8_t index = supervisor_data.estop_choreography_wip;
-    const uint8_t mode  = supervisor_data.estop_choreography_sequence_mode[index];
-    const uint8_t model = supervisor_data.estop_choreography_sequence_l   [index];
-    const uint8_t moder = supervisor_data.estop_choreography_sequence_r   [index];
-    const uint16_t tof  = supervisor_data.app_slam_EFlag;
     switch (state)
     {
         case (APP_STATE_AUTONOMY_ESTOPPED):
-            if (index < APP_CHOREOGRAPHY_STEP_COUNT)
-            {
-#   if (DEBUG_FPRINT_APP_SUPER_CHOREOGRAPHY)
-                PRINTF("[ SUPER ] >> choreography output [%d] m:%d, l:%d, r:%d, tof:%d\n", index, mode, model, moder, tof);
-#   endif // (DEBUG_FPRINT_APP_SUPER_STATE)
-                // perform action sequence:
-#   if (FEATURE_SUPER_CMD_DEV_DRIVER)    
-                dev_avr_driver_set_req_Robot_motion(mode, model, moder);
-#   endif //(FEATURE_SUPER_CMD_DEV_DRIVER)    
-                supervisor_data.estop_chorography_tick_20ms ++;
-                supervisor_data.estop_choreography_wip = supervisor_data.estop_chorography_tick_20ms/CHOREOGRAPHY_BASE_TICK_50MS;
-            }
+            // wheels are driven by the recovery motion script
             break;
 
         case (APP_STATE_AUTONOMY):
 #if (FEATURE_SUPER_CMD_DEV_DRIVER)    
+#   if (FEATURE_SUPER_USE_PROFILED_MOTIONS)
+            // wheel speed is closed loop on the avr drivers, follow the slam motion profile
+            dev_avr_driver_set_req_Robot_speed(supervisor_data.left_velocity_mm_s, supervisor_data.right_velocity_mm_s);
+#   else
             dev_avr_driver_set_req_Robot_motion(ROBOT_MOTION_FW_BREAK, MOTOR_PWM_DUTY_40_PERCENT, MOTOR_PWM_DUTY_40_PERCENT);
+#   endif // (FEATURE_SUPER_USE_PROFILED_MOTIONS)
 #endif // (FEATURE_SUPER_CMD_DEV_DRIVER)    
             break;
-            break;
 
         case (APP_STATE_HALT):
         case (APP_STATE_IDLE):
@@ -361,26 +349,38 @@ static bool app_supervisor_private_stateAction(app_state_E state)
         default:
             break;
     }
-#endif // (FEATURE_SUPER_USE_HARDCODE_CHORE)
     return true;
 }
 
-static void app_supervisor_private_fetchState(void)
+// returns true when any input changed since the last fetch
+static bool app_supervisor_private_fetchState(uint32_t events)
 {
+    const uint8_t  last_avr_sensor_data = supervisor_data.avr_sensor_data;
+    const bool     last_battery_low     = (supervisor_data.battery_voltage < BATTERY_STATUS);
+    const uint16_t last_app_slam_EFlag  = supervisor_data.app_slam_EFlag;
+    const bool     last_hazard_tripped  = supervisor_data.hazard_tripped;
 #if (FEATURE_PERIPHERALS)
-    supervisor_data.button_pressed = dev_button_update_50ms();
+    supervisor_data.button_pressed = dev_button_take_press();
 #endif
 #if (FEATURE_SENSOR_AVR)
+    // latest level, plus any sensor tripped in a frame received since the last tick
     supervisor_data.avr_sensor_data = dev_avr_sensor_uart_get();
+    dev_avr_sensor_frame_S avr_sensor_frame;
+    while (dev_avr_sensor_frame_pop(DEV_AVR_SENSOR_SUB_SUPERVISOR, &avr_sensor_frame))
+    {
+        supervisor_data.avr_sensor_data |= avr_sensor_frame.flags;
+    }
 #   if (DEBUG_FPRINT_APP_SUPER_AVR_SENSOR)
-    PRINTF("[ SUPER ] AVR SENSOR RAW: %c%c%c%c%c%c%c%c\n", BYTE_TO_BINARY(supervisor_data.avr_sensor_data));
+    PRINTF("[ SUPER ] AVR SENSOR RAW: %c%c%c%c%c%c%c%c stale:%d\n", BYTE_TO_BINARY(supervisor_data.avr_sensor_data), dev_avr_sensor_is_stale());
 #   endif
 #endif
-#if (FEATURE_SUPER_USE_PROFILED_MOTIONS | MOCK)
-    // uint8_t frame=0U;
-    // int8_t rmotor, lmotor;
-    // frame = app_slam_getMotionVelocity(& lmotor, & rmotor, frame);
-    // PRINTF("[MOTOR] R:%3d, L:%3d (f:%3d) \n", lmotor, rmotor, frame);
+#if (FEATURE_SUPER_USE_PROFILED_MOTIONS)
+    // the profile is consumed one 50ms slot per call
+    if (events & SUPER_EVENT_TICK)
+    {
+        supervisor_data.motion_frame_stamp = app_slam_getMotionVelocity(
+            & supervisor_data.left_velocity_mm_s, & supervisor_data.right_velocity_mm_s, supervisor_data.motion_frame_stamp);
+    }
 #endif
     // TODO: battery status
 #if (FEATURE_BATTERY)
@@ -390,6 +390,17 @@ static void app_supervisor_private_fetchState(void)
 
     // APP_SLAM
     supervisor_data.app_slam_EFlag = app_slam_requestToFDangerZone();
+
+#if (FEATURE_HAZARD_FAST_ESTOP)
+    // motors are already stopped, this only catches frames this tick may have missed
+    supervisor_data.hazard_tripped = app_hazard_is_tripped();
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
+
+    return supervisor_data.button_pressed
+        || (supervisor_data.avr_sensor_data != last_avr_sensor_data)
+        || ((supervisor_data.battery_voltage < BATTERY_STATUS) != last_battery_low)
+        || (supervisor_data.app_slam_EFlag != last_app_slam_EFlag)
+        || (supervisor_data.hazard_tripped != last_hazard_tripped);
 }
 
 ///////////////////////////////////////
@@ -400,14 +411,62 @@ void app_supervisor_init(void)
     // do nothing
 }
 
-// TODO: Rename to 20ms
-void app_supervisor_run50ms(void)
+// call from the supervisor task before waiting, producers notify the calling task
+void app_supervisor_registerTask(void)
+{
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+#if (FEATURE_PERIPHERALS)
+    dev_button_register_notify(task, SUPER_EVENT_BUTTON);
+#endif
+#if (FEATURE_SENSOR_AVR)
+    dev_avr_sensor_register_notify(DEV_AVR_SENSOR_SUB_SUPERVISOR, task, SUPER_EVENT_AVR_SENSOR);
+#endif
+#if (FEATURE_BATTERY)
+    dev_battery_register_notify(task, SUPER_EVENT_BATTERY, BATTERY_STATUS);
+#endif
+    app_slam_registerDangerZoneNotify(task, SUPER_EVENT_SLAM_DANGER);
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+    app_motion_script_register_notify(task, SUPER_EVENT_MOTION_DONE);
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
+    supervisor_data.last_tick = sys_time_ticks();
+}
+
+// block until a producer posts an event or the tick of the current state is due
+uint32_t app_supervisor_waitForEvents(void)
+{
+    uint32_t events = 0U;
+    const bool timed_state = (supervisor_data.current_state == APP_STATE_AUTONOMY);
+    const TickType_t period  = timed_state ? SYS_TIME_MS_TO_TICK(SUPER_TICK_MS) : SYS_TIME_MS_TO_TICK(SUPER_IDLE_TICK_MS);
+    const TickType_t elapsed = sys_time_ticks() - supervisor_data.last_tick;
+
+    xTaskNotifyWait(0U, UINT32_MAX, &events, (elapsed >= period) ? 0U : (period - elapsed));
+
+    const TickType_t now = sys_time_ticks();
+    if ((TickType_t)(now - supervisor_data.last_tick) >= period)
+    {
+        supervisor_data.last_tick = now;
+        events |= SUPER_EVENT_TICK;
+    }
+    return events;
+}
+
+void app_supervisor_process(uint32_t events)
 {
     app_state_E current_state = supervisor_data.current_state;
+    // a finished script changes nothing fetchState looks at, but may end the e-stop
+    const bool tick = (events & (SUPER_EVENT_TICK | SUPER_EVENT_MOTION_DONE));
 
-    app_supervisor_private_fetchState();
+    SYS_PROBE_BEGIN(SYS_PROBE_SUPER_FETCH_STATE);
+    const bool changed = app_supervisor_private_fetchState(events);
+    SYS_PROBE_END(SYS_PROBE_SUPER_FETCH_STATE);
+    if ((!changed) && (!tick))
+    {
+        return; // woken, but nothing the state machine looks at has changed
+    }
 
+    SYS_PROBE_BEGIN(SYS_PROBE_SUPER_NEXT_STATE);
     app_state_E next_state = app_supervisor_private_getNextState(current_state);
+    SYS_PROBE_END(SYS_PROBE_SUPER_NEXT_STATE);
 
     if (next_state != current_state)
     {
@@ -418,10 +477,21 @@ void app_supervisor_run50ms(void)
         app_supervisor_private_transitToNewState(next_state);
         supervisor_data.current_state = next_state;
     }
-    app_supervisor_private_stateAction(current_state);
-
-#if (DEBUG_FPRINT_APP_SUPER_STATE)
-        PRINTF("[ SUPER ] STATE: [%d] FAULT: [%d]\n", current_state, supervisor_data.fault_flag);
+    // act on the state just entered, the old one would command one more step after an e-stop
+    app_supervisor_private_stateAction(supervisor_data.current_state);
+
+#if (FEATURE_SYS_TELEMETRY)
+    const sys_telemetry_super_state_S state = {
+        .state      = (uint8_t)supervisor_data.current_state,
+        .avr_sensor = supervisor_data.avr_sensor_data,
+        .slam_flag  = supervisor_data.app_slam_EFlag,
+        .fault      = supervisor_data.fault_flag,
+        .events     = events,
+        .battery_mv = (uint16_t)(supervisor_data.battery_voltage * 1000.0F),
+    };
+    sys_telemetry_publish(SYS_TELEMETRY_SUPER_STATE, &state, sizeof(state));
+#elif (DEBUG_FPRINT_APP_SUPER_STATE)
+        PRINTF("[ SUPER ] STATE: [%d] FAULT: [%d] EVENTS: [0x%02x]\n", current_state, supervisor_data.fault_flag, events);
 #endif //(DEBUG_FPRINT_APP_SUPER_STATE)
 }
 
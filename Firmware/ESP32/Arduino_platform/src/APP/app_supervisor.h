@@ -13,8 +13,16 @@
 extern "C"{
 # endif 
 
+#include <stdint.h>
+
 void app_supervisor_init(void);
-void app_supervisor_run50ms(void);
+void app_supervisor_registerTask(void);
+/**
+ * @brief blocks the calling task until a producer event or the periodic tick
+ * @return app_supervisor_event bits
+ */
+uint32_t app_supervisor_waitForEvents(void);
+void app_supervisor_process(uint32_t events);
 
 
 # ifdef __cplusplus  
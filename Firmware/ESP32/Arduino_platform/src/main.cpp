@@ -33,10 +33,20 @@
 
 // TableUV Lib
 #include "common.h"
+#include "mem_budget.h"
 #include "dev_config.h"
 #include "io_ping_map.h"
 #include "APP/app_slam.h"
 #include "APP/app_supervisor.h"
+#include "APP/app_hazard.h"
+#include "APP/app_motion_script.h"
+#include "dev_avr_sensor.h"
+#include "sys_perf.h"
+#include "sys_cli.h"
+#include "sys_telemetry.h"
+#include "sys_log.h"
+#include "sys_recorder.h"
+#include "sys_time.h"
 
 // SDK config 
 #include "sdkconfig.h"
@@ -51,14 +61,32 @@
 #define ESP32_CORE_LOW_LEVEL        (0U)
 #define ESP32_CORE_HIGH_LEVEL       (1U)
 
-#define TASK_SLAM_TASK_TICK             (TASK_HZ_TO_TASK_TICK(  10/*[Hz]*/))
-#define TASK_20HZ_TASK_TICK             (TASK_HZ_TO_TASK_TICK(  20/*[Hz]*/))
-#define TASK_1HZ_TASK_TICK              (TASK_HZ_TO_TASK_TICK(   1/*[Hz]*/))
+#define TASK_SLAM_TASK_TICK             (SYS_TIME_HZ_TO_TICK(  10/*[Hz]*/))
+#define TASK_20HZ_TASK_TICK             (SYS_TIME_HZ_TO_TICK(  20/*[Hz]*/))
+#define TASK_1HZ_TASK_TICK              (SYS_TIME_HZ_TO_TICK(   1/*[Hz]*/))
 
-#define T_50MS_TASK_TICK                (MS_TO_TASK_TICK(      50/*[ms]*/))
+#define T_50MS_TASK_MS                  (50/*[ms]*/)
+#define T_BOOT_SETTLE_MS                (500/*[ms]*/)
 
-#define MS_TO_TASK_TICK(x)              (TickType_t)((x)/(portTICK_PERIOD_MS))
-#define TASK_HZ_TO_TASK_TICK(x)         (MS_TO_TASK_TICK(1000/(x))) // Range: [ < 1 kHz]
+#define T_CLI_POLL_TASK_MS              (10/*[ms]*/) // 128B tx fifo per poll ~ 12.8KB/s > 115200 baud
+#define T_LOG_DRAIN_TASK_MS             (20/*[ms]*/) // 32 records per core per drain
+
+#define BENCH_BAUD_RATE                 (115200U)
+
+#if !(configSUPPORT_STATIC_ALLOCATION)
+#   error "tasks are statically allocated, enable CONFIG_SUPPORT_STATIC_ALLOCATION"
+#endif
+
+typedef enum{
+    ESP32_TASK_AVR_SENSOR_RX,
+    ESP32_TASK_HAZARD,
+    ESP32_TASK_SUPERVISOR,
+    ESP32_TASK_50MS,
+    ESP32_TASK_1000MS,
+    ESP32_TASK_SLAM,
+    ESP32_TASK_LOG,
+    ESP32_TASK_COUNT
+} esp32_task_E;
 
 /////////////////////////////////////////
 ///////   PRIVATE PROTOTYPE     /////////
@@ -68,110 +96,293 @@ static void esp32_task_init(void);
 static void core0_task_run50ms(void * pvParameters);
 static void core0_task_run1000ms(void * pvParameters);
 static void core1_task_runSLAM(void * pvParameters);
-static void core1_task_runSupervisor(void * pvParameters);
+static void core0_task_runSupervisor(void * pvParameters);
+static void core0_task_runAvrSensorRx(void * pvParameters);
+static void core0_task_runHazard(void * pvParameters);
+#if (DEBUG_FPRINT && FEATURE_SYS_LOG)
+static void core0_task_runLog(void * pvParameters);
+#endif // (DEBUG_FPRINT && FEATURE_SYS_LOG)
+#if (FEATURE_SYS_STACK_WATERMARK)
+static void esp32_task_logStackWatermark(void);
+#endif // (FEATURE_SYS_STACK_WATERMARK)
+#if (FEATURE_BENCH_MODE)
+static void esp32_bench_report(const char * line);
+#endif // (FEATURE_BENCH_MODE)
 
 ///////////////////////////
 ///////   DATA     ////////
 ///////////////////////////
+// stacks and TCBs live in .bss, sized by mem_budget.h
+#if (FEATURE_SENSOR_AVR)
+static StackType_t  task_stack_avr_sensor_rx[MEM_BUDGET_STACK_AVR_SENSOR_RX];
+#endif // (FEATURE_SENSOR_AVR)
+#if (FEATURE_HAZARD_FAST_ESTOP)
+static StackType_t  task_stack_hazard       [MEM_BUDGET_STACK_HAZARD];
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
+static StackType_t  task_stack_supervisor   [MEM_BUDGET_STACK_SUPERVISOR];
+static StackType_t  task_stack_50ms         [MEM_BUDGET_STACK_50MS];
+static StackType_t  task_stack_1000ms       [MEM_BUDGET_STACK_1000MS];
+static StackType_t  task_stack_slam         [MEM_BUDGET_STACK_SLAM];
+#if (DEBUG_FPRINT && FEATURE_SYS_LOG)
+static StackType_t  task_stack_log          [MEM_BUDGET_STACK_LOG];
+#endif // (DEBUG_FPRINT && FEATURE_SYS_LOG)
+static StaticTask_t task_tcb   [ESP32_TASK_COUNT];
+static TaskHandle_t task_handle[ESP32_TASK_COUNT] = {NULL};
+#if (FEATURE_SYS_STACK_WATERMARK)
+static const uint32_t task_stack_size[ESP32_TASK_COUNT] = {
+    MEM_BUDGET_STACK_AVR_SENSOR_RX,
+    MEM_BUDGET_STACK_HAZARD,
+    MEM_BUDGET_STACK_SUPERVISOR,
+    MEM_BUDGET_STACK_50MS,
+    MEM_BUDGET_STACK_1000MS,
+    MEM_BUDGET_STACK_SLAM,
+    MEM_BUDGET_STACK_LOG,
+};
+#endif // (FEATURE_SYS_STACK_WATERMARK)
 
 ////////////////////////////////////////
 ///////   PRIVATE FUNCTION     /////////
 ////////////////////////////////////////
 static void core0_task_run50ms(void * pvParameters)
 {
-    TickType_t xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount ();
+    sys_time_period_S period;
+    sys_time_period_start(&period, SYS_TIME_PERIOD_50MS, TASK_20HZ_TASK_TICK);
     for( ;; )
     {
         /* Do sth at */
-        {
+        SYS_PERF_MEASURE(SYS_PERF_TASK_50MS, {
             //  add task
-            app_supervisor_run50ms();
-            dev_run50ms();
-        }
-        vTaskDelayUntil(&xLastWakeTime, TASK_20HZ_TASK_TICK);
+            SYS_PERF_MEASURE(SYS_PERF_FUNC_DEV_RUN50MS, dev_run50ms());
+        });
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+        app_motion_script_update(); // after the driver poll, its guards see the fresh counts
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
+        sys_time_period_wait(&period);
     }
 }
 static void core0_task_run1000ms(void * pvParameters)
 {
-    TickType_t xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount ();
+    sys_time_period_S period;
+    sys_time_period_start(&period, SYS_TIME_PERIOD_1000MS, TASK_1HZ_TASK_TICK);
     for( ;; )
     {
         /* Do sth at */
-        {
+        SYS_PERF_MEASURE(SYS_PERF_TASK_1000MS, {
             //  add task
-            dev_run1000ms();
-        }
-        vTaskDelayUntil(&xLastWakeTime, TASK_1HZ_TASK_TICK);
+            SYS_PERF_MEASURE(SYS_PERF_FUNC_DEV_RUN1000MS, dev_run1000ms());
+        });
+#if (FEATURE_SYS_STACK_WATERMARK)
+        esp32_task_logStackWatermark();
+#endif // (FEATURE_SYS_STACK_WATERMARK)
+        sys_time_period_wait(&period);
     }
 }
 
+// event driven, wakes up on every uart rx event of the sensor avr
+static void core0_task_runAvrSensorRx(void * pvParameters)
+{
+    for( ;; )
+    {
+        dev_avr_sensor_uart_process(portMAX_DELAY);
+    }
+}
+
+// event driven, sleeps until a producer posts an event or the autonomy tick is due
+static void core0_task_runSupervisor(void * pvParameters)
+{
+    app_supervisor_registerTask();
+    for( ;; )
+    {
+        const uint32_t events = app_supervisor_waitForEvents();
+        SYS_PERF_MEASURE(SYS_PERF_FUNC_SUPERVISOR_PROCESS, app_supervisor_process(events));
+    }
+}
+
+// event driven, e-stops the drivers as soon as a hazard frame lands
+static void core0_task_runHazard(void * pvParameters)
+{
+    app_hazard_run();
+}
+
+#if (DEBUG_FPRINT && FEATURE_SYS_LOG)
+// lowest priority, formats and prints what the control tasks logged, keeps libc and the uart out of their timing
+static void core0_task_runLog(void * pvParameters)
+{
+    for( ;; )
+    {
+        sys_log_drain();
+        sys_time_delay_ms(T_LOG_DRAIN_TASK_MS);
+    }
+}
+#endif // (DEBUG_FPRINT && FEATURE_SYS_LOG)
+
 static void core1_task_runSLAM(void * pvParameters)
 {
-    TickType_t xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount ();
+    sys_time_period_S period;
+    sys_time_period_start(&period, SYS_TIME_PERIOD_SLAM, TASK_SLAM_TASK_TICK);
     for( ;; )
     {
         /* Do sth at */
-        {
+        SYS_PERF_MEASURE(SYS_PERF_TASK_SLAM, {
             //  add task (High Level)
-            app_slam_run100ms();
-        }
-        vTaskDelayUntil(&xLastWakeTime, TASK_SLAM_TASK_TICK);
+            SYS_PERF_MEASURE(SYS_PERF_FUNC_SLAM_RUN100MS, app_slam_run100ms());
+        });
+        sys_time_period_wait(&period);
     }
 }
 
 static void esp32_task_init()
 {
+#if (FEATURE_SENSOR_AVR)
+    task_handle[ESP32_TASK_AVR_SENSOR_RX] = xTaskCreateStaticPinnedToCore(
+        core0_task_runAvrSensorRx,      /* Function to implement the task */
+        "core0_task_runAvrSensorRx",    /* Name of the task */
+        MEM_BUDGET_STACK_AVR_SENSOR_RX, /* Stack size in bytes */
+        NULL,                   /* Task input parameter */
+        5,                      /* Priority of the task */
+        task_stack_avr_sensor_rx,       /* Stack buffer */
+        &task_tcb[ESP32_TASK_AVR_SENSOR_RX], /* Task control block */
+        ESP32_CORE_LOW_LEVEL    /* Core where the task should run */
+    );
+#endif // (FEATURE_SENSOR_AVR)
+
+#if (FEATURE_HAZARD_FAST_ESTOP)
+    task_handle[ESP32_TASK_HAZARD] = xTaskCreateStaticPinnedToCore(
+        core0_task_runHazard,   /* Function to implement the task */
+        "core0_task_runHazard", /* Name of the task */
+        MEM_BUDGET_STACK_HAZARD,/* Stack size in bytes */
+        NULL,                   /* Task input parameter */
+        6,                      /* Priority of the task */
+        task_stack_hazard,      /* Stack buffer */
+        &task_tcb[ESP32_TASK_HAZARD], /* Task control block */
+        ESP32_CORE_LOW_LEVEL    /* Core where the task should run */
+    );
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
+
+    task_handle[ESP32_TASK_SUPERVISOR] = xTaskCreateStaticPinnedToCore(
+        core0_task_runSupervisor,   /* Function to implement the task */
+        "core0_task_runSupervisor", /* Name of the task */
+        MEM_BUDGET_STACK_SUPERVISOR,/* Stack size in bytes */
+        NULL,                   /* Task input parameter */
+        4,                      /* Priority of the task */
+        task_stack_supervisor,  /* Stack buffer */
+        &task_tcb[ESP32_TASK_SUPERVISOR], /* Task control block */
+        ESP32_CORE_LOW_LEVEL    /* Core where the task should run */
+    );
+
     // Low Level Core Init.
-    xTaskCreatePinnedToCore(
+    task_handle[ESP32_TASK_50MS] = xTaskCreateStaticPinnedToCore(
         core0_task_run50ms,     /* Function to implement the task */
         "core0_task_run50ms",   /* Name of the task */
-        15000,                  /* Stack size in words */
+        MEM_BUDGET_STACK_50MS,  /* Stack size in bytes */
         NULL,                   /* Task input parameter */
         1,                      /* Priority of the task */
-        NULL,                   /* Task handle. */
+        task_stack_50ms,        /* Stack buffer */
+        &task_tcb[ESP32_TASK_50MS], /* Task control block */
         ESP32_CORE_LOW_LEVEL    /* Core where the task should run */
     );  
-    vTaskDelay(T_50MS_TASK_TICK);
+    sys_time_delay_ms(T_50MS_TASK_MS);
 
-    xTaskCreatePinnedToCore(
+    task_handle[ESP32_TASK_1000MS] = xTaskCreateStaticPinnedToCore(
         core0_task_run1000ms,   /* Function to implement the task */
         "core0_task_run1000ms", /* Name of the task */
-        10000,                  /* Stack size in words */
+        MEM_BUDGET_STACK_1000MS,/* Stack size in bytes */
         NULL,                   /* Task input parameter */
         3,                      /* Priority of the task */
-        NULL,                   /* Task handle. */
+        task_stack_1000ms,      /* Stack buffer */
+        &task_tcb[ESP32_TASK_1000MS], /* Task control block */
         ESP32_CORE_LOW_LEVEL    /* Core where the task should run */
     );  
-    vTaskDelay(T_50MS_TASK_TICK);
+    sys_time_delay_ms(T_50MS_TASK_MS);
 
     //  High Level Core Init.
-    xTaskCreatePinnedToCore(
+    task_handle[ESP32_TASK_SLAM] = xTaskCreateStaticPinnedToCore(
         core1_task_runSLAM,    /* Function to implement the task */
         "core1_task_runSLAM",  /* Name of the task */
-        20000,                  /* Stack size in words */
+        MEM_BUDGET_STACK_SLAM,  /* Stack size in bytes */
         NULL,                   /* Task input parameter */
         1,                      /* Priority of the task */
-        NULL,                   /* Task handle. */
+        task_stack_slam,        /* Stack buffer */
+        &task_tcb[ESP32_TASK_SLAM], /* Task control block */
         ESP32_CORE_HIGH_LEVEL   /* Core where the task should run */
     );  
-    vTaskDelay(T_50MS_TASK_TICK);
+    sys_time_delay_ms(T_50MS_TASK_MS);
+
+#if (DEBUG_FPRINT && FEATURE_SYS_LOG)
+    //  Log drain, core 0 only runs short periodic or event driven work while slam fills core 1
+    task_handle[ESP32_TASK_LOG] = xTaskCreateStaticPinnedToCore(
+        core0_task_runLog,      /* Function to implement the task */
+        "core0_task_runLog",    /* Name of the task */
+        MEM_BUDGET_STACK_LOG,   /* Stack size in bytes */
+        NULL,                   /* Task input parameter */
+        tskIDLE_PRIORITY,       /* Priority of the task */
+        task_stack_log,         /* Stack buffer */
+        &task_tcb[ESP32_TASK_LOG], /* Task control block */
+        ESP32_CORE_LOW_LEVEL    /* Core where the task should run */
+    );
+#endif // (DEBUG_FPRINT && FEATURE_SYS_LOG)
 }
 
+#if (FEATURE_SYS_STACK_WATERMARK)
+// lowest free stack seen so far per task, run the worst case (map prints, e-stop recovery) while logging
+static void esp32_task_logStackWatermark(void)
+{
+    for (uint8_t task = 0; task < ESP32_TASK_COUNT; task++)
+    {
+        if (task_handle[task] != NULL)
+        {
+            PRINTF("[ STACK ] %-26s free: %5d / %5d bytes\n", pcTaskGetTaskName(task_handle[task]),
+                uxTaskGetStackHighWaterMark(task_handle[task]), task_stack_size[task]);
+        }
+    }
+}
+#endif // (FEATURE_SYS_STACK_WATERMARK)
+
+#if (FEATURE_BENCH_MODE)
+static void esp32_bench_report(const char * line)
+{
+    Serial.println(line);
+}
+#endif // (FEATURE_BENCH_MODE)
+
 ///////////////////////////////////////
 ///////   PUBLIC FUNCTION     /////////
 ///////////////////////////////////////
 void setup() {
     // put your setup code here, to run once:
     // device initialization
-    delay(500);
+    sys_time_delay_ms(T_BOOT_SETTLE_MS);
+#if (FEATURE_BENCH_MODE)
+    // kernels only, from the arduino loop task on core 1 as slam, no device or app task competes with the counter
+    Serial.begin(BENCH_BAUD_RATE);
+    app_slam_init();
+    app_slam_bench(esp32_bench_report);
+    app_slam_bench_check(esp32_bench_report);
+    Serial.println("[ BENCH ] done");
+#else
+#if (FEATURE_SYS_PERF)
+    sys_perf_init();
+#endif // (FEATURE_SYS_PERF)
+#if (FEATURE_SYS_TELEMETRY)
+    sys_telemetry_init();
+#endif // (FEATURE_SYS_TELEMETRY)
+#if (FEATURE_SYS_RECORDER)
+    sys_recorder_init();
+#endif // (FEATURE_SYS_RECORDER)
+#if (FEATURE_SYS_CLI)
+    sys_cli_init();
+#endif // (FEATURE_SYS_CLI)
     dev_init();
 
     // app level init
     app_slam_init();
     app_supervisor_init();
+#if (FEATURE_SUPER_USE_MOTION_SCRIPT)
+    app_motion_script_init();
+#endif // (FEATURE_SUPER_USE_MOTION_SCRIPT)
+#if (FEATURE_HAZARD_FAST_ESTOP)
+    app_hazard_init();
+#endif // (FEATURE_HAZARD_FAST_ESTOP)
 
     // esp32 task initialization
     esp32_task_init();
@@ -179,8 +390,14 @@ void setup() {
     // report status:
     PRINTF("[SYS] %s\n", (PROJECT_MODE_SELECTION==PROJECT_MODE_PRODUCTION) ? ("PRODUCTION"):\
         ((PROJECT_MODE_SELECTION==PROJECT_MODE_DEVELOPMENT) ? ("DEVELOPMENT"):("UNKNOWN")));
+#endif // (FEATURE_BENCH_MODE)
 }
 
 void loop() {
+#if (FEATURE_SYS_CLI && !FEATURE_BENCH_MODE)
+    // serial commands and telemetry are served from the arduino loop task, next to the slam task on core 1
+    sys_cli_poll();
+#endif // (FEATURE_SYS_CLI && !FEATURE_BENCH_MODE)
+    sys_time_delay_ms(T_CLI_POLL_TASK_MS);
 }
 
@@ -0,0 +1,296 @@
+#!/usr/bin/env python
+"""
+Decoder for the COBS framed binary telemetry of lib/SYS/sys_telemetry.
+
+    python telemetry_decoder.py --port /dev/cu.usbserial-14420 --out ./tlm
+    python telemetry_decoder.py --file capture.bin --out ./tlm --plot
+    python telemetry_decoder.py --port /dev/cu.usbserial-14420 --live
+    python telemetry_decoder.py --file sim.bin --out ./tlm --truth path.csv
+
+Frames are COBS blocks between 0x00 delimiters, of:
+    uint8 type, uint8 sequence, uint32 stamp [ms], payload, uint8 crc8 (poly 0x07)
+Text lines that still reach the port fall between frames and are counted as garbage.
+The record layouts below must follow the packed structs in sys_telemetry.h.
+The map only streams the 8x8 tiles that changed, run length encoded, the live map is rebuilt here.
+Recorder blocks ("rec serial" / "rec dump" on the cli) are also appended as-is to recorder.bin,
+the input log of host/replay.
+"perf dump" / "probe dump" chunks are joined back into perf_dump.bin / probe_dump.bin (layout in sys_perf.h / sys_probe.h).
+--truth compares the pose records with the path csv of host/simulate (simulate --telemetry sim.bin --path path.csv).
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+import numpy as np
+
+HEADER = struct.Struct('<BBI')
+
+# type: (name, struct format, csv columns), the map tile has a variable tail
+RECORDS = {
+    0: ('pose',        '<fff',        ['x_mm', 'y_mm', 'theta_rad']),
+    1: ('encoder',     '<B3h3h',      ['count', 'l0', 'l1', 'l2', 'r0', 'r1', 'r2']),
+    2: ('tof',         '<BBBBH',      ['sensor', 'frame', 'label', 'status', 'dist_mm']),
+    3: ('super_state', '<BBHIIH',     ['state', 'avr_sensor', 'slam_flag', 'fault', 'events', 'battery_mv']),
+    4: ('map_tile',    '<HBBBBhhB',   ['frame', 'tile_x', 'tile_y', 'tile_edge', 'map_edge',
+                                       'center_x', 'center_y', 'length']),
+    5: ('driver',      '<2H2i2H2H2H', ['msg_l', 'msg_r', 'enc_l', 'enc_r', 'err_l', 'err_r',
+                                       'lost_l', 'lost_r', 'timeout_l', 'timeout_r']),
+    6: ('recorder',    '<HHqBB',      ['magic', 'block', 'stamp_us', 'length', 'dropped']),
+    7: ('dump',        '<HHH',        ['magic', 'offset', 'total']),
+}
+MAP_TILE = 4
+RECORDER = 6
+DUMP = 7
+RECORDER_BLOCK_SIZE = 128
+DUMP_NAMES = {0x4650: 'perf_dump.bin', 0x5250: 'probe_dump.bin'}
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if (crc & 0x80) else (crc << 1) & 0xFF
+    return crc
+
+
+def rle_decode(rle):
+    cells = []
+    for i in range(0, len(rle) - 1, 2):
+        cells += [rle[i + 1]] * rle[i]
+    return np.array(cells, dtype=np.uint8).view(np.int8)
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block) + 1:
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+class TelemetryDecoder:
+    def __init__(self, out_dir):
+        self.out_dir = out_dir
+        self.buffer = bytearray()
+        self.writers = {}
+        self.files = []
+        self.last_sequence = None
+        self.stats = {'frames': 0, 'garbage': 0, 'lost': 0}
+        self.poses = []
+        self.pose_log = []
+        self.map = None
+        self.map_center = (0, 0)
+        self.recorder = None
+        self.dumps = {}
+        os.makedirs(out_dir, exist_ok=True)
+
+    def writer(self, record_type, columns):
+        if record_type not in self.writers:
+            name = RECORDS[record_type][0]
+            f = open(os.path.join(self.out_dir, name + '.csv'), 'w', newline='')
+            self.files.append(f)
+            w = csv.writer(f)
+            w.writerow(['stamp_ms', 'sequence'] + columns)
+            self.writers[record_type] = w
+        return self.writers[record_type]
+
+    def feed(self, data):
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b'\x00')
+            if end < 0:
+                break
+            block = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if block:
+                self.handle(block)
+
+    def handle(self, block):
+        raw = cobs_decode(block)
+        if raw is None or len(raw) < HEADER.size + 1 or crc8(raw[:-1]) != raw[-1]:
+            self.stats['garbage'] += 1
+            return
+        record_type, sequence, stamp_ms = HEADER.unpack_from(raw)
+        if record_type not in RECORDS:
+            self.stats['garbage'] += 1
+            return
+        if self.last_sequence is not None:
+            self.stats['lost'] += (sequence - self.last_sequence - 1) & 0xFF
+        self.last_sequence = sequence
+        self.stats['frames'] += 1
+
+        name, fmt, columns = RECORDS[record_type]
+        payload = raw[HEADER.size:-1]
+        fixed = struct.calcsize(fmt)
+        if len(payload) < fixed:
+            self.stats['garbage'] += 1
+            return
+        values = list(struct.unpack_from(fmt, payload))
+        if record_type == MAP_TILE:
+            frame, tx, ty, edge, map_edge, cx, cy, length = values
+            x0, y0 = tx * edge, ty * edge
+            w, h = min(edge, map_edge - x0), min(edge, map_edge - y0)
+            cells = rle_decode(payload[fixed:fixed + length])
+            if w <= 0 or h <= 0 or len(cells) != w * h:
+                self.stats['garbage'] += 1
+                return
+            if self.map is None or self.map.shape[0] != map_edge:
+                self.map = np.zeros((map_edge, map_edge), dtype=np.int8)
+            self.map[y0:y0 + h, x0:x0 + w] = cells.reshape(h, w)
+            self.map_center = (cx, cy)
+            values.append(' '.join(str(c) for c in cells))
+            columns = columns + ['cells']
+        elif record_type == RECORDER:
+            if len(payload) != RECORDER_BLOCK_SIZE:
+                self.stats['garbage'] += 1
+                return
+            if self.recorder is None:
+                self.recorder = open(os.path.join(self.out_dir, 'recorder.bin'), 'wb')
+                self.files.append(self.recorder)
+            self.recorder.write(payload)
+        elif record_type == DUMP:
+            self.dump_chunk(*values[:3], payload[fixed:])
+        elif record_type == 0:
+            self.poses.append(values[:2])
+            self.pose_log.append([stamp_ms] + values)
+        self.writer(record_type, columns).writerow([stamp_ms, sequence] + values)
+
+    def dump_chunk(self, magic, offset, total, data):
+        # a chunk out of order (lost, or a new dump) restarts it, only a whole dump is written
+        dump = self.dumps.get(magic)
+        if offset == 0 or dump is None or len(dump) != offset:
+            dump = bytearray() if offset == 0 else None
+        if dump is None:
+            self.dumps.pop(magic, None)
+            return
+        dump += data
+        if len(dump) < total:
+            self.dumps[magic] = dump
+            return
+        self.dumps.pop(magic, None)
+        with open(os.path.join(self.out_dir, DUMP_NAMES.get(magic, 'dump_%04x.bin' % magic)), 'wb') as f:
+            f.write(dump[:total])
+
+    def memory_map(self):
+        return self.map
+
+    def centered_map(self):
+        grid = self.memory_map()
+        if grid is None:
+            return None
+        # the memory map is circular, roll the vehicle center back to the middle
+        h, w = grid.shape
+        cx, cy = self.map_center
+        return np.roll(np.roll(grid, (h // 2) - cy, axis=0), (w // 2) - cx, axis=1)
+
+    def close(self):
+        for f in self.files:
+            f.close()
+
+
+def pose_error(pose_log, truth_csv):
+    """
+    Error of the slam pose against the simulated truth, at each pose record.
+    The truth is in the table frame, heading CCW from x; the slam map starts at the vehicle,
+    x to its left, y behind it, theta CCW from its start heading.
+    """
+    truth = np.genfromtxt(truth_csv, delimiter=',', names=True)
+    pose = np.array(pose_log)
+    if len(truth) == 0 or len(pose) == 0:
+        return None
+    t_ms = truth['t_s'] * 1000.0
+    x = np.interp(pose[:, 0], t_ms, truth['x_mm']) - truth['x_mm'][0]
+    y = np.interp(pose[:, 0], t_ms, truth['y_mm']) - truth['y_mm'][0]
+    heading = np.interp(pose[:, 0], t_ms, np.unwrap(truth['heading_rad'])) - truth['heading_rad'][0]
+    c, s = np.cos(truth['heading_rad'][0]), np.sin(truth['heading_rad'][0])
+    forward, left = x * c + y * s, y * c - x * s
+    position_mm = np.hypot(pose[:, 1] - left, pose[:, 2] + forward)
+    heading_rad = np.abs(np.angle(np.exp(1j * (pose[:, 3] - heading))))
+    return position_mm, heading_rad
+
+
+def draw(decoder, ax_pose, ax_map):
+    ax_pose.clear()
+    ax_map.clear()
+    if decoder.poses:
+        pose = np.array(decoder.poses)
+        ax_pose.plot(pose[:, 0], pose[:, 1], '.-')
+    ax_pose.set_title('pose [mm]')
+    ax_pose.axis('equal')
+    grid = decoder.centered_map()
+    if grid is not None:
+        ax_map.imshow(grid, cmap='RdYlGn_r', vmin=-50, vmax=120)
+    ax_map.set_title('global map (centered)')
+
+
+def plot(decoder):
+    import matplotlib.pyplot as plt
+    _, (ax_pose, ax_map) = plt.subplots(1, 2, figsize=(12, 6))
+    draw(decoder, ax_pose, ax_map)
+    plt.show()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode the TableUV binary telemetry into csv')
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='serial port to read from')
+    source.add_argument('--file', help='raw capture to decode')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--out', default='telemetry', help='directory for the csv files')
+    parser.add_argument('--save', help='also write the raw stream to this file (--port only)')
+    parser.add_argument('--plot', action='store_true', help='plot the pose and the map when done')
+    parser.add_argument('--live', action='store_true', help='redraw the pose and the map while reading (--port only)')
+    parser.add_argument('--truth', help='path csv of host/simulate, report the pose error against it')
+    args = parser.parse_args()
+
+    decoder = TelemetryDecoder(args.out)
+    try:
+        if args.file:
+            with open(args.file, 'rb') as f:
+                decoder.feed(f.read())
+        else:
+            import serial
+            capture = open(args.save, 'wb') if args.save else None
+            if args.live:
+                import matplotlib.pyplot as plt
+                plt.ion()
+                _, (ax_pose, ax_map) = plt.subplots(1, 2, figsize=(12, 6))
+            with serial.Serial(args.port, args.baud, timeout=0.5) as port:
+                print('Decoding ' + args.port + ' at ' + str(args.baud) + ' BAUD, Ctrl-C to stop.')
+                while True:
+                    data = port.read(4096)
+                    if capture:
+                        capture.write(data)
+                    decoder.feed(data)
+                    if args.live:
+                        draw(decoder, ax_pose, ax_map)
+                        plt.pause(0.01)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        decoder.close()
+    print('frames: {frames}, lost: {lost}, garbage: {garbage}'.format(**decoder.stats), file=sys.stderr)
+    if args.truth:
+        error = pose_error(decoder.pose_log, args.truth)
+        if error is None:
+            print('pose error: no pose or no truth', file=sys.stderr)
+        else:
+            position_mm, heading_rad = error
+            print('pose error: position mean {:.0f} max {:.0f} final {:.0f} mm, heading mean {:.3f} max {:.3f} final {:.3f} rad'.format(
+                position_mm.mean(), position_mm.max(), position_mm[-1], heading_rad.mean(), heading_rad.max(), heading_rad[-1]))
+    if args.plot:
+        plot(decoder)
+
+
+if __name__ == '__main__':
+    main()